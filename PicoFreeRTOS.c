@@ -13,7 +13,10 @@
 #include "pico/stdlib.h"         // Pico SDK core functionality
 #include "FreeRTOS.h"            // FreeRTOS core
 #include "task.h"                // FreeRTOS task management
+#include "timers.h"              // FreeRTOS software timers
+#include "semphr.h"              // FreeRTOS mutexes
 #include <stdio.h>               // Standard I/O
+#include <string.h>              // memcpy
 #include "lib/ws2812b.h"         // WS2812B LED matrix control
 #include "pico/bootrom.h"        // Boot ROM utilities
 #include "hardware/clocks.h"     // Clock control
@@ -21,245 +24,2408 @@
 #include "lib/mlt8530.h"         // Buzzer control
 #include "lib/oledgfx.h"         // OLED display graphics
 #include "lib/push_button.h"     // Button handling
+#include "lib/stack_profile.h"   // Stack high-water profiling build
+#include "lib/telemetry.h"       // Binary telemetry over USB
+#include "lib/cpu_stats.h"       // Per-task CPU usage
+#include "lib/supervisor.h"      // Watchdog supervisor and heartbeats
+#include "lib/msg_pool.h"        // Fixed-block pools and zero-copy queues
+#include "lib/ring_bench.h"      // SPSC ring vs. queue benchmark build
+#include "lib/phase_engine.h"    // Table-driven phase engine
+#include "lib/phase_plans.h"     // Phase plans (timings and sequence)
+#include "lib/adc_sampler.h"     // Free-running ADC sampled by DMA
+#include "lib/detector.h"        // Vehicle presence filter
+#include "lib/shell.h"           // USB command shell
+#include "lib/config_store.h"    // Settings kept in flash
+#include "hardware/flash.h"      // Flash erase/program
+#include "pico/flash.h"          // flash_safe_execute (other core parked)
+#include "lib/event_log.h"       // Binary event log in flash
+#include "lib/conflict_monitor.h" // Output readback checked against the head compatibility
+#include "lib/input_log.h"       // Controller inputs recorded for replay on Linux
+#include "hardware/timer.h"      // Hardware alarm of the conflict monitor
+#include "lib/schedule.h"        // Weekly calendar of day, peak and night programs
 
 // Hardware pin definitions
 #define led_pin_red 12           // Red LED pin (unused in current implementation)
 #define botaoB 6                 // Button B pin
 
-// Semaphore timing configuration (in seconds)
-#define SEMAPHORE_GREEN_DURATION_SEC    9  
-#define SEMAPHORE_RED_DURATION_SEC      6  
-#define SEMAPHORE_YELLOW_DURATION_SEC   3
-#define SEMAPHORE_DURATION_TIMEOUT      0   // Value when countdown reaches zero
-
-// Semaphore state definitions
-#define SEMAPHORE_GREEN_STATE  1
-#define SEMAPHORE_RED_STATE    2
-#define SEMAPHORE_YELLOW_STATE 0
+// Semaphore state definitions (the signal of the current phase)
+#define SEMAPHORE_GREEN_STATE  PHASE_SIGNAL_GREEN
+#define SEMAPHORE_RED_STATE    PHASE_SIGNAL_RED
+#define SEMAPHORE_YELLOW_STATE PHASE_SIGNAL_YELLOW
 
 // LED color codes
 #define SEMAPHORE_LED_COLOR_RED    0
 #define SEMAPHORE_LED_COLOR_GREEN  1
 #define SEMAPHORE_LED_COLOR_YELLOW 3
 
-// Operation modes
-#define SEMAPHORE_DAILY_MODE 0    // Normal day mode with full cycle
-#define SEMAPHORE_NIGHT_MODE 1    // Night mode (yellow blinking)
+// Operation modes
+#define SEMAPHORE_DAILY_MODE 0    // Normal day mode with full cycle
+#define SEMAPHORE_NIGHT_MODE 1    // Night mode (yellow blinking)
+
+// ==================== Hardware Configuration ====================
+
+/// I2C port used for OLED communication
+#define I2C_PORT i2c1
+
+/// OLED display pin configuration
+#define OLED_SDA 14      ///< Serial data pin
+#define OLED_SCL 15      ///< Serial clock pin
+#define OLED_ADDR 0x3C   ///< I2C address of OLED
+#define OLED_BAUDRATE 400000  ///< I2C communication speed
+
+/// Joystick pin configuration (the axes are the vehicle detectors, see lib/adc_sampler.h)
+#define JOYSTICK_VRX 27  ///< X-axis analog input (ADC1, detector 1: cross street)
+#define JOYSTICK_VRY 26  ///< Y-axis analog input (ADC0, detector 0: this approach)
+#define JOYSTICK_PB  22  ///< Push button input (pedestrian call)
+
+/// Buzzer pin configuration
+#define BUZZER_A 10      ///< Primary buzzer pin
+#define BUZZER_B 21      ///< Secondary buzzer pin (unused)
+
+/// RGB LED pin configuration
+#define RED_PIN   13     ///< Red LED PWM pin
+#define BLUE_PIN  12     ///< Blue LED PWM pin (unused)
+#define GREEN_PIN 11     ///< Green LED PWM pin
+
+/// Button definitions
+#define BUTTON_A 5       ///< Mode switch button
+
+/// Emergency vehicle preemption input: a contact to GND (e.g. the output of an
+/// optical or radio detector) held closed while the vehicle approaches
+#define PREEMPT_PIN 16
+
+/// Core affinity masks (only honoured by the SMP build, see TRAFFIC_SMP).
+/// The timer service task, which runs the phase, buzzer and button timers, is
+/// pinned to the real-time core by configTIMER_SERVICE_TASK_CORE_AFFINITY.
+#define REALTIME_CORE_MASK (1u << 0)  ///< Phase control, LED matrix, RGB LED and buzzer
+#define IO_CORE_MASK       (1u << 1)  ///< OLED, logging and USB stdio
+
+/// TRAFFIC_INTERSECTION is set by CMake (option TRAFFIC_INTERSECTION)
+#ifndef TRAFFIC_INTERSECTION
+#define TRAFFIC_INTERSECTION 0
+#endif
+
+/// Software timer periods
+#if TRAFFIC_INTERSECTION
+#define PHASE_TICK_MS    100     ///< Controller step (intersection timings are in tenths of a second)
+#else
+#define PHASE_TICK_MS    1000    ///< Countdown step of the phase timer
+#endif
+#define BUTTON_POLL_MS   100     ///< Button A polling period (also the debounce)
+#define DETECTOR_POLL_MS 50      ///< Detector filter step (drains the ADC ring)
+
+/// Longest the shell sleeps without a USB characters callback
+#define SHELL_POLL_MS 1000
+
+/// Largest phase duration the single-digit matrix can count down
+#define PHASE_DISPLAY_MAX_S 9
+
+// Flash regions at the end of the flash: the event log ring, then the settings
+// store (its sectors rotated for wear levelling)
+#define FLASH_LOCKOUT_MS 100          ///< Longest wait for the other core to park
+#define CONFIG_FLASH_SECTORS 4
+#define CONFIG_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - CONFIG_FLASH_SECTORS * FLASH_SECTOR_SIZE)
+#define EVENT_LOG_FLASH_SECTORS 16
+#define EVENT_LOG_FLASH_OFFSET (CONFIG_FLASH_OFFSET - EVENT_LOG_FLASH_SECTORS * FLASH_SECTOR_SIZE)
+
+/// Longest a partly filled event log page stays in RAM
+#define EVENT_LOG_FLUSH_MS 60000
+
+// Conflict monitor: output readback period
+#define CONFLICT_MONITOR_PERIOD_US 1000
+
+// Flashing operation (night yellow and fail-safe red): 54.5 flashes per
+// minute, lit for exactly half of each period on the 1 µs hardware timer
+#define FLASH_PERIOD_US 1100000
+#define FLASH_ON_US 550000
+
+// Settings keys (the intersection build keeps its own phase keys; the peak
+// plan keeps its own too, 0x40 above the day plan)
+#define CONFIG_KEY_BRIGHTNESS 0x0001
+#define CONFIG_KEY_UTC_OFFSET 0x0002
+#define CONFIG_KEY_SCHEDULE 0x0003
+#if TRAFFIC_INTERSECTION
+#define CONFIG_KEY_PHASE(i) (0x0200 + (i))
+#else
+#define CONFIG_KEY_PHASE(i) (0x0100 + (i))
+#endif
+#define CONFIG_KEY_PLAN_PHASE(plan, i) (CONFIG_KEY_PHASE(i) + 0x40 * (plan))
+
+// Weekly calendar: local time is the host time plus the UTC offset (Brasília by default)
+#define SCHEDULE_UTC_OFFSET_MIN (-180)
+#define SCHEDULE_UTC_OFFSET_MAX_MIN 840
+
+/// Buzzer tones (pedestrian cues use a higher pitch than the vehicle phases)
+#define BUZZER_FREQUENCY_HZ     300
+#define BUZZER_PED_FREQUENCY_HZ 880
+
+/// Matrix LED showing the pedestrian crossing in the intersection build (centre)
+#define PED_PIXEL 12
+
+/// Period of the telemetry reports (CPU usage and transition latency)
+#define TELEMETRY_REPORT_PERIOD_MS 2000
+
+/// Period of the kernel trace dumps (TRAFFIC_TRACE builds only)
+#define TRACE_DUMP_PERIOD_MS 5000
+
+/// TRAFFIC_BENCH is set by CMake (option TRAFFIC_BENCH)
+#ifndef TRAFFIC_BENCH
+#define TRAFFIC_BENCH 0
+#endif
+#define RING_BENCH_TASK_STACK_DEPTH (configMINIMAL_STACK_SIZE * 2)
+
+/// Log events in flight between the timer callbacks and the log task
+#define LOG_EVENT_POOL_SIZE 8
+
+/// Heartbeat deadlines checked by the watchdog supervisor
+#define DISPLAY_HEARTBEAT_MS  1000   ///< Longest the display task waits without a change
+#define PHASE_DEADLINE_MS     (PHASE_TICK_MS + 500)
+#define DISPLAY_DEADLINE_MS   (DISPLAY_HEARTBEAT_MS + 500)
+#define LOG_DEADLINE_MS       (TELEMETRY_REPORT_PERIOD_MS + 1000)
+
+/// Task stack depths (in words). The profiling build gives every task the same
+/// oversized stack; other builds take the measured sizes from
+/// generated/task_stacks.h (pulled in by FreeRTOSConfig.h) when it exists.
+#if TRAFFIC_STACK_PROFILE
+#define TASK_STACK_DEPTH_DEFAULT  STACK_PROFILE_TASK_DEPTH
+#else
+#define TASK_STACK_DEPTH_DEFAULT  configMINIMAL_STACK_SIZE
+#endif
+#ifndef DISPLAY_TASK_STACK_DEPTH
+#define DISPLAY_TASK_STACK_DEPTH  TASK_STACK_DEPTH_DEFAULT
+#endif
+#ifndef LOG_TASK_STACK_DEPTH
+#define LOG_TASK_STACK_DEPTH      TASK_STACK_DEPTH_DEFAULT
+#endif
+#ifndef SUPERVISOR_TASK_STACK_DEPTH
+#define SUPERVISOR_TASK_STACK_DEPTH TASK_STACK_DEPTH_DEFAULT
+#endif
+#ifndef SHELL_TASK_STACK_DEPTH
+#define SHELL_TASK_STACK_DEPTH    TASK_STACK_DEPTH_DEFAULT
+#endif
+
+/// Declares the statically allocated stack and TCB of a task
+#define STATIC_TASK_BUFFERS(name, depth)     \
+    static StackType_t name##_stack[depth];  \
+    static StaticTask_t name##_tcb
+
+// Peripherals (file scope: main()'s stack is reused once the scheduler starts)
+static ws2812b_t ws;   // LED matrix
+static rgb_t rgb;      // RGB LED
+static ssd1306_t ssd;  // OLED display
+
+// Task and timer memory (no FreeRTOS heap, see configSUPPORT_DYNAMIC_ALLOCATION)
+STATIC_TASK_BUFFERS(display_task, DISPLAY_TASK_STACK_DEPTH);
+STATIC_TASK_BUFFERS(log_task, LOG_TASK_STACK_DEPTH);
+STATIC_TASK_BUFFERS(supervisor_task, SUPERVISOR_TASK_STACK_DEPTH);
+STATIC_TASK_BUFFERS(shell_task, SHELL_TASK_STACK_DEPTH);
+static StaticTimer_t phase_timer_buffer;
+static StaticTimer_t buzzer_timer_buffer;
+static StaticTimer_t button_timer_buffer;
+static StaticTimer_t detector_timer_buffer;
+static StaticTimer_t preempt_timer_buffer;
+
+// Display task, woken on phase and mode changes
+static TaskHandle_t g_display_task;
+
+// Shell task, woken when USB characters arrive, and its line buffer
+static TaskHandle_t g_shell_task;
+static shell_t g_shell;
+
+/**
+ * @brief Phase or mode change passed to the log task
+ *
+ * Allocated from g_log_event_pool by the producer and freed by the log task;
+ * only the pointer goes through g_log_queue.
+ */
+typedef struct {
+    uint32_t timestamp_ms;
+    uint32_t transition_seq;
+    uint8_t state;
+    uint8_t mode;
+    uint8_t ped;
+} log_event_t;
+
+MSG_POOL_STORAGE(log_event_pool_storage, sizeof(log_event_t), LOG_EVENT_POOL_SIZE);
+MSG_QUEUE_STORAGE(log_queue_storage, LOG_EVENT_POOL_SIZE);
+static msg_pool_t g_log_event_pool;
+static msg_queue_t g_log_queue;
+
+/// Vehicle detectors: a joystick axis or loop output must move this far from its
+/// rest level (ADC counts, filtered) to place a call
+static const detector_config_t DETECTOR_CONFIG = {
+    .on_level = 600,
+    .off_level = 300,
+    .baseline_samples = 64,
+};
+static detector_t g_detectors[ADC_SAMPLER_CHANNELS];
+static uint16_t detector_samples[ADC_SAMPLER_RING_SAMPLES];   // Drained by the detector timer only
+static volatile uint8_t g_detector_presence = 0;              // Bit n = detector n sees a vehicle
+
+// Watchdog supervisor heartbeats and the record of the previous reset
+static int g_phase_heartbeat = -1;
+static int g_display_heartbeat = -1;
+static int g_log_heartbeat = -1;
+static supervisor_record_t g_boot_record;
+
+/**
+ * @brief Buzzer cadence of a phase (tone and silence intervals)
+ */
+typedef struct {
+    uint16_t on_ms;
+    uint16_t off_ms;
+} buzzer_cadence_t;
+
+/// Day mode cadences, indexed by semaphore state
+static const buzzer_cadence_t BUZZER_CADENCE[] = {
+    [SEMAPHORE_YELLOW_STATE] = { 250, 250 },   // Rapid intermittent beeps
+    [SEMAPHORE_GREEN_STATE]  = { 250, 750 },   // Short beep once per second
+    [SEMAPHORE_RED_STATE]    = { 500, 1500 },  // Longer beep every 2 seconds
+};
+
+/// Night mode cadence
+static const buzzer_cadence_t BUZZER_NIGHT_CADENCE = { 500, 2000 };
+
+/// Pedestrian cadences: rapid tick while walking, slow beep (in step with the
+/// flashing countdown) during the clearance
+static const buzzer_cadence_t BUZZER_WALK_CADENCE = { 100, 100 };
+static const buzzer_cadence_t BUZZER_CLEARANCE_CADENCE = { 500, 500 };
+
+#if TRAFFIC_STACK_PROFILE
+STATIC_TASK_BUFFERS(stack_profile_task, STACK_PROFILE_TASK_DEPTH);
+#endif
+#if TRAFFIC_BENCH
+STATIC_TASK_BUFFERS(ring_bench_task, RING_BENCH_TASK_STACK_DEPTH);
+#endif
+
+/// Matrix colour of each signal
+static const uint8_t SIGNAL_LED_COLOR[] = {
+    [SEMAPHORE_YELLOW_STATE] = SEMAPHORE_LED_COLOR_YELLOW,
+    [SEMAPHORE_GREEN_STATE]  = SEMAPHORE_LED_COLOR_GREEN,
+    [SEMAPHORE_RED_STATE]    = SEMAPHORE_LED_COLOR_RED,
+};
+
+// Day and peak plans in RAM, copied from lib/phase_plans.c at boot so the
+// shell can change the durations, the one running and the engine running it
+// (all written only inside critical sections)
+#if TRAFFIC_INTERSECTION
+static rb_phase_def_t g_plan_phases[PLAN_COUNT][RB_MAX_PHASES];
+static rb_plan_t g_plans[PLAN_COUNT];
+static rb_plan_t *g_plan = &g_plans[PLAN_DAY];
+static rb_controller_t g_rb_controller;
+#else
+static phase_def_t g_plan_phases[PLAN_COUNT][PHASE_ENGINE_MAX_PHASES];
+static phase_plan_t g_plans[PLAN_COUNT];
+static phase_plan_t *g_plan = &g_plans[PLAN_DAY];
+static phase_engine_t g_phase_engine;
+#endif
+static uint8_t g_plan_id = PLAN_DAY;                            // Plan running (plan_id_t)
+
+// Weekly calendar, checked by the phase timer against the precomputed next
+// switch (written only inside critical sections)
+static bool g_schedule_enabled = true;                          // Off: the mode and plan are manual only
+static int16_t g_utc_offset_min = SCHEDULE_UTC_OFFSET_MIN;      // Local time minus UTC
+static uint64_t g_schedule_next_ms = 0;                         // Host time of the next switch (0: evaluate now)
+static uint8_t g_schedule_next_program = SCHEDULE_NO_PROGRAM;   // Program that starts then
+static uint8_t g_schedule_program = SCHEDULE_NO_PROGRAM;        // Program the calendar is in
+static uint8_t g_schedule_target = SCHEDULE_NO_PROGRAM;         // Program waiting for the end of the cycle
+static volatile uint32_t g_schedule_switches = 0;               // Programs applied by the calendar
+
+// Matrix brightness in percent (set from the shell)
+static volatile uint8_t g_matrix_intensity = 1;
+
+// Settings saved by the shell, restored at boot (written only by the shell task)
+static config_store_t g_config;
+static bool g_config_discarded = false;                         // Saved durations did not fit the plan
+
+// Event log: added from anywhere, flushed to flash and dumped by the log task
+static event_log_t g_event_log;
+static volatile bool g_event_log_dump = false;                  // The shell asked for a dump
+static volatile bool g_event_log_urgent = false;                // A fault was logged: write it now
+
+// Input log: every call to the controller, recorded inside the critical
+// section that makes it and dumped by the log task (tools/input_log.py)
+static input_log_t g_input_log;
+static volatile bool g_input_log_dump = false;                  // The shell asked for a dump
+static uint8_t g_input_log_copy[INPUT_LOG_BLOCK_SIZE];          // Block being sent (log task only)
+
+// Conflict monitor, run by a hardware alarm IRQ on the I/O core. The outputs
+// are written by show_phase_outputs() in the timer service task, which keeps
+// g_output_seq odd while writing, and by the flasher, a second alarm IRQ on the
+// same core that draws each edge of the flashing modes. The flasher raises
+// g_flash_drawing before looking at g_output_seq, so one of the two always
+// backs off; once g_fail_safe is latched the alarm IRQs own the outputs.
+// Neither alarm runs during a flash operation (flash_run_locked()), so a fault
+// and a flashing edge can be late by up to one sector erase.
+static conflict_monitor_config_t g_monitor_config;
+static conflict_monitor_t g_monitor;
+static absolute_time_t g_monitor_next;
+static absolute_time_t g_flash_next;                            // Next flashing edge
+static volatile uint32_t g_output_seq = 0;                      // Odd while the outputs are being written
+static volatile bool g_output_flash = false;                    // The outputs show the night mode
+static volatile bool g_fail_safe = false;                       // Monitor fault: flashing red until reset
+static volatile bool g_flash_drawing = false;                   // The flasher is writing the outputs
+static bool g_flash_redraw = false;                             // A flashing frame is due (alarm IRQs only)
+
+// Serializes flash_safe_execute() between the shell and the log task
+static StaticSemaphore_t flash_mutex_buffer;
+static SemaphoreHandle_t g_flash_mutex;
+
+// Global state variables (published from g_phase_engine by update_semaphore_counter)
+static volatile uint16_t g_semaphore_counter = 0;                              // Current countdown value
+static volatile uint8_t g_sempahore_state = SEMAPHORE_GREEN_STATE;            // Current light state
+static volatile uint8_t g_semaphore_led_color = SEMAPHORE_LED_COLOR_GREEN;    // Current LED color
+static volatile uint8_t g_semaphore_mode = SEMAPHORE_DAILY_MODE;              // Current operation mode
+static volatile uint16_t g_semaphore_heads = 0;                                // Intersection heads, 2 bits each
+static volatile uint8_t g_semaphore_ped = PHASE_PED_DONT_WALK;                 // Pedestrian indication (phase_ped_t)
+
+// Pedestrian call: latched by the button IRQ, cleared when the walk phase starts
+static volatile bool g_ped_waiting = false;                     // Call latched and not served yet
+static volatile uint64_t g_ped_request_us = 0;                  // Instant the pending call was latched
+static volatile uint32_t g_ped_requests = 0;                    // Calls latched since boot
+static volatile uint32_t g_ped_served = 0;                      // Calls served (walk started)
+static volatile uint32_t g_ped_latency_last_ms = 0;             // Request-to-walk time of the last call
+static volatile uint32_t g_ped_latency_max_ms = 0;              // Worst request-to-walk time since boot
+static bool g_ped_flash_on = true;                              // Clearance countdown visible (buzzer timer only)
+
+// Absolute time base for cycle/offset coordination, set by the host
+static volatile bool g_time_synced = false;                     // The host has sent the time
+static uint64_t g_time_sync_host_ms = 0;                        // Host time (ms since 1970) at the last sync
+static uint32_t g_time_sync_local_ms = 0;                       // phase_clock_ms() at the last sync
+static volatile uint32_t g_time_syncs = 0;                      // Syncs received since boot
+
+// Transition latency instrumentation (ideal transition instant vs. outputs updated)
+static volatile uint32_t g_transition_seq = 0;                 // Incremented on every phase transition
+static volatile uint64_t g_transition_deadline_us = 0;         // Ideal instant of the last transition
+static volatile uint32_t g_transition_latency_max_us = 0;      // Worst case observed since boot
+static uint64_t g_phase_start_us = 0;                           // Instant the phase timer was started
+static uint32_t g_shown_seq = 0;                                // Last transition shown (timer service task only)
+
+// Emergency preemption (input pin or shell), served in the timer service task
+static TimerHandle_t g_preempt_timer;                           // One-shot: next step of the preemption path
+static volatile bool g_preempt_pending = false;                 // A preempt_service() call is queued
+static volatile uint64_t g_preempt_edge_us = 0;                 // Input edge or shell command being served
+static volatile uint8_t g_preempt_shell_phase = PHASE_NO_PHASE; // Target asked by the shell, or none
+static volatile bool g_preempt_active = false;                  // The plan is being preempted
+static uint64_t g_preempt_request_us = 0;                       // Instant of the active request
+static bool g_preempt_green_pending = false;                    // Target green not shown yet
+static volatile uint32_t g_preempt_requests = 0;                // Preemptions started since boot
+static volatile uint32_t g_preempt_latency_max_us = 0;          // Worst request-to-outputs time (service run)
+static volatile uint32_t g_preempt_green_last_ms = 0;           // Request-to-target-green time of the last preemption
+static volatile uint32_t g_preempt_green_max_ms = 0;            // Worst request-to-target-green time since boot
+
+/**
+ * @brief Consistent copy of the shared semaphore state
+ *
+ * Tasks running on different cores must never read the globals field by field,
+ * otherwise a transition in the middle of the reads yields a mixed state.
+ */
+typedef struct {
+    uint16_t counter;
+    uint8_t state;
+    uint8_t led_color;
+    uint8_t mode;
+    uint16_t heads;
+    uint8_t ped;
+    bool ped_waiting;
+    bool preempt;
+    uint32_t transition_seq;
+} semaphore_snapshot_t;
+
+/**
+ * @brief Takes a snapshot of the shared semaphore state
+ * @return Copy of the state taken inside a critical section
+ */
+static semaphore_snapshot_t semaphore_get_snapshot(void)
+{
+    semaphore_snapshot_t snapshot;
+    taskENTER_CRITICAL();
+    snapshot.counter = g_semaphore_counter;
+    snapshot.state = g_sempahore_state;
+    snapshot.led_color = g_semaphore_led_color;
+    snapshot.mode = g_semaphore_mode;
+    snapshot.heads = g_semaphore_heads;
+    snapshot.ped = g_semaphore_ped;
+    snapshot.ped_waiting = g_ped_waiting;
+    snapshot.preempt = g_preempt_active;
+    snapshot.transition_seq = g_transition_seq;
+    taskEXIT_CRITICAL();
+    return snapshot;
+}
+
+/**
+ * @brief Records how late an output showed the current phase
+ *
+ * Called by each output right after it reflects a new transition; the worst
+ * value across outputs is the transition latency.
+ */
+static void record_transition_latency(void)
+{
+    uint32_t latency_us = (uint32_t) (time_us_64() - g_transition_deadline_us);
+    taskENTER_CRITICAL();
+    if(latency_us > g_transition_latency_max_us) g_transition_latency_max_us = latency_us;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Restricts a task to the given cores
+ * @param task Task handle
+ * @param core_mask Bit mask of allowed cores
+ */
+static void pin_task_to_cores(TaskHandle_t task, UBaseType_t core_mask)
+{
+#if ( configNUMBER_OF_CORES > 1 )
+    vTaskCoreAffinitySet(task, core_mask);
+#else
+    (void) task;
+    (void) core_mask;
+#endif
+}
+
+/**
+ * @brief Clock of the phase engine
+ * @return Milliseconds since the scheduler started (tick count)
+ */
+static uint32_t phase_clock_ms(void)
+{
+    return (uint32_t) (xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+/**
+ * @brief Copies the day and peak plans from lib/phase_plans.c to RAM
+ * @note Called from main() before the scheduler starts
+ */
+static void load_plans(void)
+{
+    for(uint8_t plan = 0; plan < PLAN_COUNT; plan++)
+    {
+#if TRAFFIC_INTERSECTION
+        g_plans[plan] = *RB_PLANS[plan];
+        memcpy(g_plan_phases[plan], RB_PLANS[plan]->phases, RB_PLANS[plan]->phase_count * sizeof(g_plan_phases[0][0]));
+#else
+        g_plans[plan] = *PHASE_PLANS[plan];
+        memcpy(g_plan_phases[plan], PHASE_PLANS[plan]->phases, PHASE_PLANS[plan]->count * sizeof(g_plan_phases[0][0]));
+#endif
+        g_plans[plan].phases = g_plan_phases[plan];
+    }
+}
+
+/**
+ * @brief Adds a fault to the event log and has the log task write it to flash
+ * @param fault event_log_fault_t
+ * @param value Detail of the fault
+ */
+static void log_fault(uint8_t fault, uint32_t value)
+{
+    event_log_add(&g_event_log, EVENT_LOG_FAULT, fault, value);
+    g_event_log_urgent = true;
+}
+
+/**
+ * @brief Adds the durations of a phase of the running plan to the input log
+ * @param index Phase (or ring-barrier phase) number
+ * @param durations Minimum, maximum and default duration
+ * @note Must be called inside a critical section
+ */
+static void log_phase_durations(uint8_t index, const uint16_t durations[3])
+{
+    input_log_record_t record = {
+        .kind = INPUT_LOG_DURATIONS, .arg = index, .time_ms = phase_clock_ms(), .time_us = time_us_64(),
+        .durations = { durations[0], durations[1], durations[2] },
+    };
+    input_log_add(&g_input_log, &record);
+}
+
+/**
+ * @brief Changes the durations of a phase of a plan
+ * @param plan plan_id_t
+ * @param index Phase (or ring-barrier phase) number
+ * @param durations Minimum, maximum and default duration (seconds; tenths in
+ *        the intersection build)
+ * @return false, with the phase unchanged, if the plan would become invalid
+ * @note Must be called inside a critical section (or before the scheduler starts)
+ */
+static bool set_phase_durations(uint8_t plan, uint8_t index, const uint16_t durations[3])
+{
+    bool valid;
+#if TRAFFIC_INTERSECTION
+    rb_phase_def_t *phase = &g_plan_phases[plan][index];
+    rb_phase_def_t saved = *phase;
+    phase->min_green_ds = durations[0];
+    phase->max_green_ds = durations[1];
+    phase->green_ds = durations[2];
+    valid = rb_plan_is_valid(&g_plans[plan]);
+#else
+    phase_def_t *phase = &g_plan_phases[plan][index];
+    phase_def_t saved = *phase;
+    phase->min_s = durations[0];
+    phase->max_s = durations[1];
+    phase->default_s = durations[2];
+    valid = durations[1] <= PHASE_DISPLAY_MAX_S && phase_plan_is_valid(&g_plans[plan]);
+#endif
+    if(!valid) *phase = saved;
+    else if(plan == g_plan_id) log_phase_durations(index, durations);
+    return valid;
+}
+
+/**
+ * @brief Flash operation run by flash_safe_execute()
+ */
+typedef struct {
+    uint32_t offset;        // Offset from the start of the flash
+    const uint8_t *page;    // Page to program (NULL: erase a sector)
+} flash_op_t;
+
+/**
+ * @brief Erases one sector or programs one page, with the other core parked
+ * @param param flash_op_t
+ * @note Runs from RAM with interrupts off, while XIP is unavailable
+ */
+static void __not_in_flash_func(flash_op_locked)(void *param)
+{
+    const flash_op_t *op = (const flash_op_t *) param;
+
+    if(op->page) flash_range_program(op->offset, op->page, FLASH_PAGE_SIZE);
+    else flash_range_erase(op->offset, FLASH_SECTOR_SIZE);
+}
+
+/**
+ * @brief Runs one flash operation with the other core parked
+ * @note The mutex keeps the shell (settings) and the log task (event log)
+ *       from entering flash_safe_execute() at the same time
+ * @note Both cores stop for the operation, with interrupts off: the monitor and
+ *       flasher alarms fire late and the outputs hold. A page program takes up
+ *       to 3 ms and a sector erase 45 ms typically, 400 ms at most (W25Q16JV
+ *       datasheet, not measured on the board); moving the caller to the other
+ *       core would not help, since the parked core spins with interrupts off too
+ */
+static bool flash_run_locked(flash_op_t *op)
+{
+    bool ok;
+
+    xSemaphoreTake(g_flash_mutex, portMAX_DELAY);
+    ok = flash_safe_execute(flash_op_locked, op, FLASH_LOCKOUT_MS) == PICO_OK;
+    xSemaphoreGive(g_flash_mutex);
+    return ok;
+}
+
+/**
+ * @brief flash_region_t erase callback: one sector per lockout
+ */
+static bool flash_region_erase(const flash_region_t *region, uint32_t offset)
+{
+    flash_op_t op = { region->offset + offset, NULL };
+    return flash_run_locked(&op);
+}
+
+/**
+ * @brief flash_region_t program callback: one page per lockout
+ */
+static bool flash_region_program(const flash_region_t *region, uint32_t offset, const uint8_t *page)
+{
+    flash_op_t op = { region->offset + offset, page };
+    return flash_run_locked(&op);
+}
+
+/// Flash region of the settings, at the end of the flash
+static const flash_region_t CONFIG_FLASH = {
+    .base = (const uint8_t *) (XIP_BASE + CONFIG_FLASH_OFFSET),
+    .offset = CONFIG_FLASH_OFFSET,
+    .sectors = CONFIG_FLASH_SECTORS,
+    .erase = flash_region_erase,
+    .program = flash_region_program,
+};
+
+/// Flash region of the event log, right before the settings
+static const flash_region_t EVENT_LOG_FLASH = {
+    .base = (const uint8_t *) (XIP_BASE + EVENT_LOG_FLASH_OFFSET),
+    .offset = EVENT_LOG_FLASH_OFFSET,
+    .sectors = EVENT_LOG_FLASH_SECTORS,
+    .erase = flash_region_erase,
+    .program = flash_region_program,
+};
+
+/**
+ * @brief Restores the settings saved by the shell over the plans
+ * @note Called from main() after load_plans(), before the scheduler
+ *       starts; only reads the flash
+ */
+static void load_saved_settings(void)
+{
+    uint16_t durations[3];
+    uint8_t intensity, enabled;
+    int16_t offset_min;
+    bool valid = true;
+
+    config_store_init(&g_config, &CONFIG_FLASH);
+    if(config_store_get(&g_config, CONFIG_KEY_BRIGHTNESS, &intensity, sizeof(intensity)) && intensity >= 1 && intensity <= 100)
+        g_matrix_intensity = intensity;
+    if(config_store_get(&g_config, CONFIG_KEY_UTC_OFFSET, &offset_min, sizeof(offset_min))
+        && offset_min >= -SCHEDULE_UTC_OFFSET_MAX_MIN && offset_min <= SCHEDULE_UTC_OFFSET_MAX_MIN)
+        g_utc_offset_min = offset_min;
+    if(config_store_get(&g_config, CONFIG_KEY_SCHEDULE, &enabled, sizeof(enabled))) g_schedule_enabled = enabled != 0;
+    for(uint8_t plan = 0; plan < PLAN_COUNT; plan++)
+    {
+#if TRAFFIC_INTERSECTION
+        uint8_t count = g_plans[plan].phase_count;
+#else
+        uint8_t count = g_plans[plan].count;
+#endif
+        for(uint8_t i = 0; i < count; i++)
+            if(config_store_get(&g_config, CONFIG_KEY_PLAN_PHASE(plan, i), durations, sizeof(durations)))
+                valid = set_phase_durations(plan, i, durations) && valid;
+    }
+    // All or nothing: a plan changed by a new firmware starts from its defaults
+    if(!valid)
+    {
+        load_plans();
+        g_config_discarded = true;
+        log_fault(EVENT_FAULT_CONFIG_DISCARDED, 0);
+    }
+}
+
+/**
+ * @brief Publishes the current phase of the engine in the global state
+ * @param now_ms Phase engine clock
+ * @note Must be called inside a critical section
+ */
+static void publish_phase(uint32_t now_ms)
+{
+#if TRAFFIC_INTERSECTION
+    // Head 0 stands for the whole intersection on the RGB LED, OLED, buzzer and log
+    uint8_t heads[RB_MAX_HEADS];
+    uint16_t packed = 0;
+    uint16_t remaining_s = (uint16_t) ((rb_controller_remaining_ds(&g_rb_controller, 0, now_ms) + 9u) / 10u);
+
+    rb_controller_heads(&g_rb_controller, heads);
+    for(uint8_t i = 0; i < g_rb_controller.plan->head_count; i++) packed |= (uint16_t) (heads[i] << (2u * i));
+    g_semaphore_heads = packed;
+    g_semaphore_counter = (remaining_s > 9u) ? 9u : remaining_s;
+    g_sempahore_state = heads[0];
+    g_semaphore_led_color = SIGNAL_LED_COLOR[heads[0]];
+    g_semaphore_ped = rb_controller_ped(&g_rb_controller);
+#else
+    const phase_def_t *phase = phase_engine_current(&g_phase_engine);
+
+    g_semaphore_counter = phase_engine_remaining_s(&g_phase_engine, now_ms);
+    g_sempahore_state = phase->signal;
+    g_semaphore_led_color = SIGNAL_LED_COLOR[phase->signal];
+    g_semaphore_ped = phase->ped;
+#endif
+    // The walk starting serves the pending call
+    if(g_semaphore_ped == PHASE_PED_WALK && g_ped_waiting)
+    {
+        g_ped_latency_last_ms = (uint32_t) ((time_us_64() - g_ped_request_us) / 1000u);
+        if(g_ped_latency_last_ms > g_ped_latency_max_ms) g_ped_latency_max_ms = g_ped_latency_last_ms;
+        g_ped_served++;
+        g_ped_waiting = false;
+        event_log_add(&g_event_log, EVENT_LOG_PED_WALK, 0, g_ped_latency_last_ms);
+    }
+}
+
+/**
+ * @brief Adds a call to the controller to the input log
+ * @param kind input_log_kind_t
+ * @param arg Short argument of the record
+ * @param value Long argument of the record
+ * @param now_ms Phase engine clock
+ * @param time_us Instant of the input (external inputs only)
+ * @note Must be called inside a critical section, right before the call it records
+ */
+static void log_input(uint8_t kind, uint8_t arg, uint64_t value, uint32_t now_ms, uint64_t time_us)
+{
+    input_log_record_t record = { .kind = kind, .arg = arg, .time_ms = now_ms, .time_us = time_us, .value = value };
+    input_log_add(&g_input_log, &record);
+}
+
+/**
+ * @brief Adds the phase just published to the event log and the input log
+ * @param now_ms Phase engine clock
+ * @note Must be called inside a critical section, after publish_phase()
+ */
+static void log_phase_event(uint32_t now_ms)
+{
+    uint8_t phase;
+#if TRAFFIC_INTERSECTION
+    uint32_t value = input_log_rb_output(&g_rb_controller, &phase);
+#else
+    uint32_t value = input_log_engine_output(&g_phase_engine, &phase);
+#endif
+    event_log_add(&g_event_log, EVENT_LOG_PHASE, phase, value);
+    log_input(INPUT_LOG_OUTPUT, phase, value, now_ms, 0);  // Checked by the replay
+}
+
+/**
+ * @brief Hands the pending pedestrian call to the plan
+ * @param now_ms Phase engine clock
+ * @param time_us Instant of the call
+ * @note Must be called inside a critical section
+ */
+static void place_ped_call(uint32_t now_ms, uint64_t time_us)
+{
+#if TRAFFIC_INTERSECTION
+    if(g_plan->ped_phase == RB_NO_PHASE) return;
+    log_input(INPUT_LOG_CALL, g_plan->ped_phase, 0, now_ms, time_us);
+    rb_controller_call(&g_rb_controller, g_plan->ped_phase);
+#else
+    if(g_plan->pedestrian_call == PHASE_NO_CALL) return;
+    log_input(INPUT_LOG_CALL, g_plan->pedestrian_call, 0, now_ms, time_us);
+    phase_engine_call(&g_phase_engine, g_plan->pedestrian_call);
+#endif
+}
+
+/**
+ * @brief Target of the preemption in progress
+ * @return Phase, or PHASE_NO_PHASE
+ * @note Must be called inside a critical section
+ */
+static uint8_t plan_preempt_phase(void)
+{
+#if TRAFFIC_INTERSECTION
+    return g_rb_controller.preempt;
+#else
+    return g_phase_engine.preempt;
+#endif
+}
+
+/**
+ * @brief Starts or ends the preemption of the day plan
+ * @param phase Target phase, or PHASE_NO_PHASE to end the preemption
+ * @param now_ms Phase engine clock
+ * @param time_us Instant of the request
+ * @return false if the plan cannot reach the phase
+ * @note Must be called inside a critical section
+ */
+static bool plan_preempt(uint8_t phase, uint32_t now_ms, uint64_t time_us)
+{
+    log_input(INPUT_LOG_PREEMPT, phase, 0, now_ms, time_us);
+#if TRAFFIC_INTERSECTION
+    if(phase == PHASE_NO_PHASE) rb_controller_preempt_release(&g_rb_controller, now_ms);
+    else return rb_controller_preempt(&g_rb_controller, phase, now_ms);
+#else
+    if(phase == PHASE_NO_PHASE) phase_engine_preempt_release(&g_phase_engine, now_ms);
+    else return phase_engine_preempt(&g_phase_engine, phase, now_ms);
+#endif
+    return true;
+}
+
+/**
+ * @brief Worst time from a preemption request to the green of @p phase
+ * @return Milliseconds, or UINT32_MAX if some phase cannot reach it
+ * @note Must be called inside a critical section
+ */
+static uint32_t plan_preempt_bound_ms(uint8_t phase)
+{
+#if TRAFFIC_INTERSECTION
+    return (phase < g_plan->phase_count) ? rb_controller_preempt_bound_ms(&g_rb_controller) : UINT32_MAX;
+#else
+    return phase_engine_preempt_bound_ms(&g_phase_engine, phase);
+#endif
+}
+
+/**
+ * @brief Time left until the next transition on the way to the preemption target
+ * @param now_ms Phase engine clock
+ * @return Milliseconds (at least 1), or 0 once the target holds the green and
+ *         nothing else is left to change
+ * @note Must be called inside a critical section, with a preemption in progress
+ */
+static uint32_t plan_preempt_step_ms(uint32_t now_ms)
+{
+    uint32_t step_ms = 0;
+#if TRAFFIC_INTERSECTION
+    for(uint8_t r = 0; r < RB_RINGS; r++)
+    {
+        const rb_ring_t *ring = &g_rb_controller.rings[r];
+        uint32_t elapsed = now_ms - ring->start_ms;
+        if(ring->interval == RB_INTERVAL_BARRIER) continue;
+        if(ring->interval == RB_INTERVAL_GREEN
+            && g_plan->sequence[r][g_rb_controller.group][ring->slot] == g_rb_controller.preempt)
+            continue;  // Holding the target
+        uint32_t left_ms = (elapsed < ring->duration_ms) ? ring->duration_ms - elapsed : 1u;
+        if(step_ms == 0 || left_ms < step_ms) step_ms = left_ms;
+    }
+#else
+    uint32_t elapsed = now_ms - g_phase_engine.start_ms;
+    if(g_phase_engine.phase != g_phase_engine.preempt)
+        step_ms = (elapsed < g_phase_engine.duration_ms) ? g_phase_engine.duration_ms - elapsed : 1u;
+#endif
+    return step_ms;
+}
+
+/**
+ * @brief Tells whether the preemption target has started
+ * @note Must be called inside a critical section, with a preemption in progress
+ */
+static bool plan_preempt_reached(void)
+{
+#if TRAFFIC_INTERSECTION
+    return g_rb_controller.signals[g_rb_controller.preempt] == PHASE_SIGNAL_GREEN;
+#else
+    return g_phase_engine.phase == g_phase_engine.preempt;
+#endif
+}
+
+/**
+ * @brief Anchors the plan cycle to the host time
+ * @param now_ms Phase engine clock
+ * @note Must be called inside a critical section, with g_time_synced set
+ */
+static void apply_time_base(uint32_t now_ms)
+{
+    uint64_t host_ms = g_time_sync_host_ms + (uint32_t) (now_ms - g_time_sync_local_ms);
+
+    log_input(INPUT_LOG_SET_TIME, 0, host_ms, now_ms, time_us_64());
+#if TRAFFIC_INTERSECTION
+    rb_controller_set_time(&g_rb_controller, host_ms, now_ms);
+#else
+    phase_engine_set_time(&g_phase_engine, host_ms, now_ms);
+#endif
+}
+
+/**
+ * @brief Starts the day plan from its initial phase and publishes it
+ * @param now_ms Phase engine clock
+ * @note Must be called inside a critical section (or before the scheduler starts)
+ */
+static void start_phase_plan(uint32_t now_ms)
+{
+    log_input(INPUT_LOG_START, 0, 0, now_ms, time_us_64());
+#if TRAFFIC_INTERSECTION
+    rb_controller_start(&g_rb_controller, g_plan, now_ms);
+#else
+    phase_engine_start(&g_phase_engine, g_plan, now_ms);
+#endif
+    if(g_ped_waiting) place_ped_call(now_ms, time_us_64());  // A restart must not drop a latched call
+    g_preempt_active = false;            // preempt_service() starts it again if still requested
+    if(g_time_synced) apply_time_base(now_ms);
+    publish_phase(now_ms);
+}
+
+/**
+ * @brief Switches the running plan without restarting it
+ * @param plan plan_id_t
+ * @param now_ms Phase engine clock
+ * @note Must be called inside a critical section, at the start of a cycle (or
+ *       in night mode, before the plan restarts). The durations follow the
+ *       plan record in the input log, so the replay rebuilds the same RAM
+ *       plan from lib/phase_plans.c.
+ */
+static void change_phase_plan(uint8_t plan, uint32_t now_ms)
+{
+    log_input(INPUT_LOG_PLAN, plan, 0, now_ms, time_us_64());
+    g_plan_id = plan;
+    g_plan = &g_plans[plan];
+    input_log_set_plan(&g_input_log, plan, g_plan);
+#if TRAFFIC_INTERSECTION
+    rb_controller_change_plan(&g_rb_controller, g_plan, now_ms);
+    for(uint8_t i = 0; i < g_plan->phase_count; i++)
+    {
+        const rb_phase_def_t *phase = &g_plan->phases[i];
+        uint16_t durations[3] = { phase->min_green_ds, phase->max_green_ds, phase->green_ds };
+        log_phase_durations(i, durations);
+    }
+#else
+    phase_engine_change_plan(&g_phase_engine, g_plan, now_ms);
+    for(uint8_t i = 0; i < g_plan->count; i++)
+    {
+        const phase_def_t *phase = &g_plan->phases[i];
+        uint16_t durations[3] = { phase->min_s, phase->max_s, phase->default_s };
+        log_phase_durations(i, durations);
+    }
+#endif
+    if(g_time_synced) apply_time_base(now_ms);
+}
+
+/**
+ * @brief Sets the absolute time base from a host time sync
+ * @param host_ms Host time in ms since 1970
+ * @note The running phase is not cut: the coordination corrects the cycle
+ *       smoothly from its next sync point.
+ */
+static void sync_time_base(uint64_t host_ms)
+{
+    taskENTER_CRITICAL();
+    g_time_sync_host_ms = host_ms;
+    g_time_sync_local_ms = phase_clock_ms();
+    g_time_synced = true;
+    g_time_syncs++;
+    g_schedule_next_ms = 0;  // The calendar is evaluated again at the next phase tick
+    apply_time_base(g_time_sync_local_ms);
+    taskEXIT_CRITICAL();
+    event_log_add(&g_event_log, EVENT_LOG_TIME_SYNC, 0, (uint32_t) (host_ms / 1000u));
+}
+
+/**
+ * @brief Advances the phase engine and updates the countdown and the state
+ * @param now_ms Phase engine clock
+ * @return true if the plan has just started a new cycle (initial phase, or
+ *         the barrier into group 0), with no preemption in progress
+ * @note Must be called inside a critical section. Night mode freezes the plan.
+ */
+bool update_semaphore_counter(uint32_t now_ms)
+{
+    uint32_t transitions;
+    bool cycle_start;
+
+    if(g_semaphore_mode != SEMAPHORE_DAILY_MODE) return false;
+    log_input(INPUT_LOG_UPDATE, 0, 0, now_ms, 0);
+#if TRAFFIC_INTERSECTION
+    uint8_t group = g_rb_controller.group;
+    transitions = rb_controller_update(&g_rb_controller, now_ms);
+    cycle_start = g_rb_controller.group == 0 && group != 0 && g_rb_controller.preempt == RB_NO_PHASE;
+#else
+    transitions = phase_engine_update(&g_phase_engine, now_ms);
+    cycle_start = g_phase_engine.phase == g_plan->initial && g_phase_engine.preempt == PHASE_NO_PHASE;
+#endif
+    g_transition_seq += transitions;
+    publish_phase(now_ms);
+    if(transitions) log_phase_event(now_ms);
+    return transitions && cycle_start;
+}
+
+/**
+ * @brief Takes the next program from the calendar once its switch time has passed
+ * @param now_ms Phase engine clock
+ * @note Must be called inside a critical section. Between switches this is a
+ *       single comparison with the precomputed switch time.
+ */
+static void schedule_step(uint32_t now_ms)
+{
+    if(!g_schedule_enabled || !g_time_synced) return;
+    uint64_t host_ms = g_time_sync_host_ms + (uint32_t) (now_ms - g_time_sync_local_ms);
+    if(host_ms < g_schedule_next_ms) return;
+
+    uint8_t program = schedule_program_at(&SCHEDULE_DEFAULT, host_ms, g_utc_offset_min);
+    g_schedule_next_ms = schedule_next_switch(&SCHEDULE_DEFAULT, host_ms, g_utc_offset_min, &g_schedule_next_program);
+    // A new time sync or offset lands in the same program: keep any manual override
+    if(program == g_schedule_program) return;
+    g_schedule_program = program;
+    g_schedule_target = program;
+}
+
+/**
+ * @brief Applies the program taken from the calendar
+ * @param now_ms Phase engine clock
+ * @param cycle_start The plan has just started a new cycle
+ * @return true if the mode changed (reported by the caller outside the critical section)
+ * @note Must be called inside a critical section. A running plan changes only
+ *       at the start of a cycle; from night mode the new plan starts at once.
+ */
+static bool apply_schedule(uint32_t now_ms, bool cycle_start)
+{
+    uint8_t program = g_schedule_target;
+
+    if(program == SCHEDULE_NO_PROGRAM) return false;
+    if(g_semaphore_mode == SEMAPHORE_DAILY_MODE && !cycle_start) return false;
+    g_schedule_target = SCHEDULE_NO_PROGRAM;
+    g_schedule_switches++;
+    if(program == SCHEDULE_NIGHT)
+    {
+        if(g_semaphore_mode == SEMAPHORE_NIGHT_MODE) return false;
+        g_semaphore_mode = SEMAPHORE_NIGHT_MODE;
+        return true;
+    }
+    uint8_t plan = (program == SCHEDULE_PEAK) ? PLAN_PEAK : PLAN_DAY;
+    if(plan != g_plan_id)
+    {
+        change_phase_plan(plan, now_ms);
+        event_log_add(&g_event_log, EVENT_LOG_PLAN, plan, 1);
+    }
+    if(g_semaphore_mode == SEMAPHORE_DAILY_MODE) return false;
+    start_phase_plan(now_ms);
+    g_semaphore_mode = SEMAPHORE_DAILY_MODE;
+    return true;
+}
+
+/**
+ * @brief Packs the phase into the word kept by the supervisor across watchdog resets
+ * @note Must be called inside a critical section
+ * @return phase index | counter << 8 | mode << 16 | plan << 24 (the intersection build keeps
+ *         only the mode and the plan)
+ */
+static uint32_t semaphore_pack_state(void)
+{
+#if TRAFFIC_INTERSECTION
+    return ((uint32_t) g_semaphore_mode << 16) | ((uint32_t) g_plan_id << 24);
+#else
+    return (uint32_t) g_phase_engine.phase | ((uint32_t) g_semaphore_counter << 8) | ((uint32_t) g_semaphore_mode << 16)
+        | ((uint32_t) g_plan_id << 24);
+#endif
+}
+
+/**
+ * @brief Restores the phase saved before a watchdog reset
+ * @param packed Value produced by semaphore_pack_state()
+ * @return true if the value was a valid phase of the plan and was restored
+ * @note Called from main() before the scheduler starts. The state of another
+ *       plan than the boot plan is discarded: its phase index and counter
+ *       mean nothing in this one.
+ */
+static bool semaphore_restore_state(uint32_t packed)
+{
+    uint8_t phase = (uint8_t) (packed & 0xFFu);
+    uint16_t counter = (uint16_t) ((packed >> 8) & 0xFFu);
+    uint8_t mode = (uint8_t) ((packed >> 16) & 0xFFu);
+    uint8_t plan = (uint8_t) ((packed >> 24) & 0xFFu);
+
+    if(mode != SEMAPHORE_DAILY_MODE && mode != SEMAPHORE_NIGHT_MODE) return false;
+    if(plan != g_plan_id) return false;
+#if TRAFFIC_INTERSECTION
+    // The intersection never resumes mid-cycle: it restarts with the all-red startup interval
+    (void) phase;
+    (void) counter;
+    start_phase_plan(0);
+#else
+    log_input(INPUT_LOG_RESUME, phase, counter, 0, time_us_64());
+    if(!phase_engine_resume(&g_phase_engine, g_plan, phase, counter, 0)) return false;
+    publish_phase(0);
+#endif
+    g_semaphore_mode = mode;
+    return true;
+}
+
+/**
+ * @brief Shows the same colour on every signal head of the LED matrix
+ * @param color WS2812B_COLOR_* (night mode and fail-safe), or WS2812B_COLOR_OFF
+ */
+static void draw_all_heads(uint8_t color)
+{
+#if TRAFFIC_INTERSECTION
+    uint8_t colors[25];
+    for(uint8_t i = 0; i < 25; i++) colors[i] = WS2812B_COLOR_OFF;
+    for(uint8_t i = 0; i < g_plan->head_count; i++) colors[g_plan->heads[i].pixel] = color;
+    ws2812b_draw_colors(&ws, colors, g_matrix_intensity);
+#else
+    ws2812b_draw(&ws, NUMERIC_GLYPHS[0], color, g_matrix_intensity);
+#endif
+}
+
+/**
+ * @brief Whether the flashing outputs are lit at a given time
+ * @param time_us Time since boot in µs
+ */
+static inline bool flash_lit(uint64_t time_us)
+{
+    return time_us % FLASH_PERIOD_US < FLASH_ON_US;
+}
+
+/**
+ * @brief Next flashing edge after a given time
+ * @param time_us Time since boot in µs
+ * @return Time since boot of the edge, in µs
+ */
+static inline uint64_t flash_next_edge(uint64_t time_us)
+{
+    uint64_t start = time_us - time_us % FLASH_PERIOD_US;
+    return start + (flash_lit(time_us) ? FLASH_ON_US : FLASH_PERIOD_US);
+}
+
+/**
+ * @brief Draws one frame of the flashing modes on the LED matrix and the RGB LED
+ * @param fail_safe Flashing red (fail-safe) instead of flashing yellow (night mode)
+ * @param lit Heads lit, or all off
+ */
+static void draw_flash_outputs(bool fail_safe, bool lit)
+{
+    if(!lit)
+    {
+        draw_all_heads(WS2812B_COLOR_OFF);
+        rgb_turn_off_white(&rgb);
+        return;
+    }
+    draw_all_heads(fail_safe ? WS2812B_COLOR_RED : WS2812B_COLOR_YELLOW);
+    rgb_turn_on_by_color(&rgb, fail_safe ? RGB_COLOR_RED : RGB_COLOR_YELLOW);
+}
+
+/**
+ * @brief Draws a phase on the LED matrix and the RGB LED
+ * @param snapshot State to show
+ * @note The pedestrian walk is shown in white; during the clearance it blinks
+ *       with g_ped_flash_on, toggled by the buzzer timer in step with the tone
+ */
+static void draw_phase_outputs(const semaphore_snapshot_t *snapshot)
+{
+    if(snapshot->mode == SEMAPHORE_DAILY_MODE)
+    {
+        bool ped_lit = snapshot->ped == PHASE_PED_WALK || (snapshot->ped == PHASE_PED_CLEARANCE && g_ped_flash_on);
+#if TRAFFIC_INTERSECTION
+        // One LED per head, at the position given by the plan, and the crossing in the centre
+        uint8_t colors[25];
+        for(uint8_t i = 0; i < 25; i++) colors[i] = WS2812B_COLOR_OFF;
+        for(uint8_t i = 0; i < g_plan->head_count; i++)
+            colors[g_plan->heads[i].pixel] = SIGNAL_LED_COLOR[(snapshot->heads >> (2u * i)) & 0x3u];
+        if(ped_lit) colors[PED_PIXEL] = WS2812B_COLOR_WHITE;
+        ws2812b_draw_colors(&ws, colors, g_matrix_intensity);
+#else
+        if(snapshot->ped == PHASE_PED_DONT_WALK)
+            ws2812b_draw(&ws, NUMERIC_GLYPHS[snapshot->counter], snapshot->led_color, g_matrix_intensity);
+        else if(ped_lit)
+            ws2812b_draw(&ws, NUMERIC_GLYPHS[snapshot->counter], WS2812B_COLOR_WHITE, g_matrix_intensity);
+        else
+            ws2812b_turn_off_all(&ws);
+#endif
+        if(snapshot->state == SEMAPHORE_GREEN_STATE)
+            rgb_turn_on_by_color(&rgb, RGB_COLOR_GREEN);
+        else if(snapshot->state == SEMAPHORE_YELLOW_STATE)
+            rgb_turn_on_by_color(&rgb, RGB_COLOR_YELLOW);
+        else if(snapshot->state == SEMAPHORE_RED_STATE)
+            rgb_turn_on_by_color(&rgb, RGB_COLOR_RED);
+    }
+    else
+        draw_flash_outputs(false, flash_lit(time_us_64()));  // The flasher draws the next edges
+}
+
+/**
+ * @brief Shows a phase on the real-time outputs (LED matrix and RGB LED)
+ * @param snapshot State to show
+ * @note Does nothing once the conflict monitor has latched the fail-safe. The
+ *       odd g_output_seq tells the monitor not to sample a half-written frame,
+ *       and, with the barriers, keeps the alarm IRQs from drawing in the middle
+ *       of it. A flashing frame already under way is let finish first (one
+ *       matrix frame at most).
+ */
+static void show_phase_outputs(const semaphore_snapshot_t *snapshot)
+{
+    g_output_seq++;
+    __dmb();
+    while(g_flash_drawing) tight_loop_contents();
+    if(!g_fail_safe)
+    {
+        draw_phase_outputs(snapshot);
+        g_output_flash = snapshot->mode != SEMAPHORE_DAILY_MODE;
+    }
+    __dmb();
+    g_output_seq++;
+}
+
+/**
+ * @brief Fills the conflict monitor map from the plan
+ * @note Called from main() once the plan is loaded: the heads and the ring
+ *       sequence never change at run time (the shell only changes durations)
+ */
+static void setup_conflict_monitor(void)
+{
+    conflict_monitor_config_t *config = &g_monitor_config;
+
+#if TRAFFIC_INTERSECTION
+    // One LED per head; heads may be released together when their phases are
+    // in different rings of the same concurrency group
+    config->head_count = g_plan->head_count;
+    config->rgb_head = 0;
+    config->repeat_head = CONFLICT_MONITOR_NO_HEAD;
+    config->ped_pixel = PED_PIXEL;
+    config->ped_conflicts = 0;
+    for(uint8_t i = 0; i < g_plan->head_count; i++)
+    {
+        config->pixel[i] = g_plan->heads[i].pixel;
+        config->compatible[i] = 0;
+        for(uint8_t j = 0; j < g_plan->head_count; j++)
+            if(rb_plan_phases_compatible(g_plan, g_plan->heads[i].phase, g_plan->heads[j].phase))
+                config->compatible[i] |= (uint8_t) (1u << j);
+        if(g_plan->ped_phase != RB_NO_PHASE && !rb_plan_phases_compatible(g_plan, g_plan->ped_phase, g_plan->heads[i].phase))
+            config->ped_conflicts |= (uint8_t) (1u << i);
+    }
+#else
+    // One head on the RGB LED; the countdown repeats its colour, or shows the walk in white
+    config->head_count = 1;
+    config->pixel[0] = CONFLICT_MONITOR_NO_PIXEL;
+    config->compatible[0] = 1u;
+    config->rgb_head = 0;
+    config->repeat_head = 0;
+    config->ped_pixel = CONFLICT_MONITOR_NO_PIXEL;
+    config->ped_conflicts = 1u;
+#endif
+    conflict_monitor_init(&g_monitor, config);
+}
+
+/**
+ * @brief Reads the outputs back and latches the fail-safe on a confirmed violation
+ * @note Monitor alarm IRQ only. A sample overlapping show_phase_outputs() is dropped.
+ */
+static void monitor_check_outputs(void)
+{
+    conflict_monitor_sample_t sample;
+    uint32_t seq = g_output_seq;
+
+    if(seq & 1u) return;
+    __dmb();
+    rgb_read_levels(&rgb, sample.rgb);
+    memcpy(sample.frame, ws.frame, sizeof(sample.frame));
+    sample.flash = g_output_flash;
+    __dmb();
+    if(g_output_seq != seq) return;
+    if(!conflict_monitor_check(&g_monitor, &sample)) return;
+    g_fail_safe = true;
+    g_flash_redraw = true;  // Flashing red from now, not from the next edge
+    __dmb();
+    log_fault(EVENT_FAULT_CONFLICT, g_monitor.fault | ((uint32_t) g_monitor.detail << 8));
+}
+
+/**
+ * @brief Draws the flashing frame due at a given time, if the outputs are flashing
+ * @param time_us Time since boot in µs
+ * @return false if the timer task is writing the outputs: the frame is still due
+ * @note Alarm IRQs of the I/O core only; they share a priority, so two frames
+ *       never interleave. After a frame of the timer task, show_phase_outputs()
+ *       leaves the outputs alone in the fail-safe, and draws the flashing frame
+ *       itself on entering the night mode.
+ */
+static bool draw_flash_frame(uint64_t time_us)
+{
+    bool drawn = false;
+
+    g_flash_drawing = true;
+    __dmb();
+    if(!(g_output_seq & 1u))
+    {
+        if(g_fail_safe || g_output_flash) draw_flash_outputs(g_fail_safe, flash_lit(time_us));
+        drawn = true;
+    }
+    __dmb();
+    g_flash_drawing = false;
+    return drawn;
+}
+
+/**
+ * @brief Conflict monitor alarm: checks the outputs every CONFLICT_MONITOR_PERIOD_US
+ * @param alarm Hardware alarm number
+ * @note Runs on the I/O core and makes no FreeRTOS call, so the time from a
+ *       violation to the flashing red (CONFLICT_MONITOR_DEBOUNCE periods plus
+ *       a matrix frame) does not depend on the scheduler, only on the
+ *       interrupt-off sections of that core. Also retries a flashing frame the
+ *       timer task was in the way of.
+ */
+static void monitor_alarm_callback(uint alarm)
+{
+    uint32_t enter_us = cpu_stats_isr_enter();
+    trace_isr_enter(TRACE_ISR_MONITOR);
+    if(!g_fail_safe) monitor_check_outputs();
+    if(g_flash_redraw) g_flash_redraw = !draw_flash_frame(time_us_64());
+    // Re-arm on the period grid; a missed target restarts the grid from now
+    g_monitor_next = delayed_by_us(g_monitor_next, CONFLICT_MONITOR_PERIOD_US);
+    if(hardware_alarm_set_target(alarm, g_monitor_next))
+    {
+        g_monitor_next = make_timeout_time_us(CONFLICT_MONITOR_PERIOD_US);
+        hardware_alarm_set_target(alarm, g_monitor_next);
+    }
+    trace_isr_exit(TRACE_ISR_MONITOR);
+    cpu_stats_isr_exit(CPU_STATS_ISR_MONITOR, enter_us);
+}
+
+/**
+ * @brief Flasher alarm: draws each edge of the flashing modes
+ * @param alarm Hardware alarm number
+ * @note Runs on the I/O core and makes no FreeRTOS call, so the night yellow
+ *       and the fail-safe red keep flashing with the scheduler starved. The
+ *       alarm fires on the edges of the FLASH_PERIOD_US grid of the hardware
+ *       timer, so the duty is exact up to the interrupt latency; a frame the
+ *       timer task is in the way of goes to the monitor alarm, 1 ms later.
+ */
+static void flash_alarm_callback(uint alarm)
+{
+    uint32_t enter_us = cpu_stats_isr_enter();
+    uint64_t edge_us = to_us_since_boot(g_flash_next);
+    uint64_t next_us = flash_next_edge(edge_us);
+
+    trace_isr_enter(TRACE_ISR_FLASH);
+    if(!draw_flash_frame(edge_us)) g_flash_redraw = true;
+    // A missed edge restarts from the next one after now
+    while(hardware_alarm_set_target(alarm, from_us_since_boot(next_us)))
+        next_us = flash_next_edge(time_us_64());
+    g_flash_next = from_us_since_boot(next_us);
+    trace_isr_exit(TRACE_ISR_FLASH);
+    cpu_stats_isr_exit(CPU_STATS_ISR_FLASH, enter_us);
+}
+
+/**
+ * @brief Starts the conflict monitor and flasher alarms
+ * @note The alarm IRQs are enabled on the calling core, so this must run on the I/O core
+ */
+static void start_conflict_monitor(void)
+{
+    uint alarm = (uint) hardware_alarm_claim_unused(true);
+
+    hardware_alarm_set_callback(alarm, monitor_alarm_callback);
+    g_monitor_next = make_timeout_time_us(CONFLICT_MONITOR_PERIOD_US);
+    hardware_alarm_set_target(alarm, g_monitor_next);
+
+    alarm = (uint) hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback(alarm, flash_alarm_callback);
+    g_flash_next = from_us_since_boot(flash_next_edge(time_us_64()));
+    hardware_alarm_set_target(alarm, g_flash_next);
+}
+
+/**
+ * @brief Queues a log event for the log task
+ * @param snapshot State after the change
+ * @note Never blocks: the event is dropped if the pool or the queue is full
+ *       (pool misses are counted in g_log_event_pool.alloc_failures)
+ */
+static void post_log_event(const semaphore_snapshot_t *snapshot)
+{
+    log_event_t *event = msg_pool_alloc(&g_log_event_pool);
+
+    if(!event)
+    {
+        log_fault(EVENT_FAULT_LOG_DROPPED, 0);
+        return;
+    }
+    event->timestamp_ms = to_ms_since_boot(get_absolute_time());
+    event->transition_seq = snapshot->transition_seq;
+    event->state = snapshot->state;
+    event->mode = snapshot->mode;
+    event->ped = snapshot->ped;
+    if(!msg_queue_send(&g_log_queue, event, 0))
+    {
+        msg_pool_free(event);
+        log_fault(EVENT_FAULT_LOG_DROPPED, 1);
+    }
+}
+
+/**
+ * @brief Reports a phase or mode change to the I/O tasks
+ * @param snapshot State after the change
+ */
+static void notify_io_tasks(const semaphore_snapshot_t *snapshot)
+{
+    xTaskNotifyGive(g_display_task);
+    post_log_event(snapshot);
+}
+
+/**
+ * @brief Advances the plan along the preemption path and shows it at once
+ * @note Runs in the timer service task. The one-shot preemption timer is re-armed
+ *       to the end of the current interval, so each step of the path is shown
+ *       when it happens instead of at the next phase tick.
+ */
+static void preempt_step(void)
+{
+    semaphore_snapshot_t snapshot;
+    uint32_t step_ms = 0;
+    uint8_t reached = PHASE_NO_PHASE;
+
+    taskENTER_CRITICAL();
+    uint32_t now_ms = phase_clock_ms();
+    update_semaphore_counter(now_ms);
+    if(g_preempt_active && g_semaphore_mode == SEMAPHORE_DAILY_MODE)
+    {
+        step_ms = plan_preempt_step_ms(now_ms);
+        if(g_preempt_green_pending && plan_preempt_reached())
+        {
+            g_preempt_green_pending = false;
+            reached = plan_preempt_phase();
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    snapshot = semaphore_get_snapshot();
+    show_phase_outputs(&snapshot);
+    if(snapshot.transition_seq != g_shown_seq)
+    {
+        g_shown_seq = snapshot.transition_seq;
+        notify_io_tasks(&snapshot);
+    }
+    if(reached != PHASE_NO_PHASE)
+    {
+        uint32_t green_ms = (uint32_t) ((time_us_64() - g_preempt_request_us) / 1000u);
+        g_preempt_green_last_ms = green_ms;
+        if(green_ms > g_preempt_green_max_ms) g_preempt_green_max_ms = green_ms;
+        event_log_add(&g_event_log, EVENT_LOG_PREEMPT_GREEN, reached, green_ms);
+    }
+    if(step_ms) xTimerChangePeriod(g_preempt_timer, pdMS_TO_TICKS(step_ms) ? pdMS_TO_TICKS(step_ms) : 1, 0);
+    else xTimerStop(g_preempt_timer, 0);
+}
+
+/**
+ * @brief Starts, retargets or ends the preemption from the input pin and the shell
+ * @param param Unused
+ * @param arg Unused
+ * @note Pended to the timer service task (the highest priority task, on the
+ *       real-time core) by the GPIO IRQ and the shell; a switch to day mode,
+ *       already in that task, calls it directly.
+ *       The input pin wins over the shell; night mode keeps the request for
+ *       the next switch to day mode.
+ */
+static void preempt_service(void *param, uint32_t arg)
+{
+    uint32_t job_start = cpu_stats_job_begin();
+    uint64_t edge_us = g_preempt_edge_us;
+    uint8_t target = g_preempt_shell_phase;
+    uint8_t previous, started = PHASE_NO_PHASE, ended = PHASE_NO_PHASE;
+    uint32_t bound_ms = 0, duration_ms = 0;
+
+    (void) param;
+    (void) arg;
+    g_preempt_pending = false;  // An edge from now on queues another call
+    if(!gpio_get(PREEMPT_PIN) && g_plan->preempt_phase != PHASE_NO_PHASE) target = g_plan->preempt_phase;
+
+    taskENTER_CRITICAL();
+    uint32_t now_ms = phase_clock_ms();
+    if(g_semaphore_mode == SEMAPHORE_DAILY_MODE)
+    {
+        update_semaphore_counter(now_ms);
+        previous = plan_preempt_phase();
+        if(target != previous && plan_preempt(target, now_ms, edge_us))
+        {
+            if(previous != PHASE_NO_PHASE) ended = previous;
+            if(target != PHASE_NO_PHASE)
+            {
+                started = target;
+                bound_ms = plan_preempt_bound_ms(target);
+                if(!g_preempt_active) g_preempt_request_us = edge_us;
+                g_preempt_green_pending = true;
+                g_preempt_requests++;
+            }
+            else duration_ms = (uint32_t) ((time_us_64() - g_preempt_request_us) / 1000u);
+            g_preempt_active = target != PHASE_NO_PHASE;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if(ended != PHASE_NO_PHASE && started == PHASE_NO_PHASE)
+        event_log_add(&g_event_log, EVENT_LOG_PREEMPT_END, ended, duration_ms);
+    if(started != PHASE_NO_PHASE) event_log_add(&g_event_log, EVENT_LOG_PREEMPT, started, bound_ms);
+    preempt_step();
+    // The outputs now follow the request (the first yellow may still be a minimum green away)
+    uint32_t latency_us = (uint32_t) (time_us_64() - edge_us);
+    if(latency_us > g_preempt_latency_max_us) g_preempt_latency_max_us = latency_us;
+    cpu_stats_job_end(CPU_STATS_JOB_PHASE, job_start);
+}
+
+/**
+ * @brief Queues preempt_service() after a change of the shell target or the mode
+ * @note A call already queued reads the latest state, so bursts queue only one.
+ *       The timer service task (switch to day mode) runs it in place: it must
+ *       not block on its own command queue.
+ */
+static void request_preempt_service(void)
+{
+    bool queue;
+
+    if(xTaskGetSchedulerState() == taskSCHEDULER_RUNNING
+        && xTaskGetCurrentTaskHandle() == xTimerGetTimerDaemonTaskHandle())
+    {
+        taskENTER_CRITICAL();
+        if(!g_preempt_pending) g_preempt_edge_us = time_us_64();  // Keeps the edge of a queued input change
+        taskEXIT_CRITICAL();
+        preempt_service(NULL, 0);
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    queue = !g_preempt_pending;
+    if(queue)
+    {
+        g_preempt_edge_us = time_us_64();
+        g_preempt_pending = true;
+    }
+    taskEXIT_CRITICAL();
+    if(queue && xTimerPendFunctionCall(preempt_service, NULL, 0, pdMS_TO_TICKS(100)) != pdPASS)
+        g_preempt_pending = false;
+}
 
-// ==================== Hardware Configuration ====================
+/**
+ * @brief Queues preempt_service() after an edge of the preemption input
+ * @return pdTRUE if the timer service task must run on return from the IRQ
+ * @note Called from the GPIO IRQ; contact bounce queues only one call
+ */
+static BaseType_t request_preempt_service_from_isr(void)
+{
+    BaseType_t woken = pdFALSE;
+    bool queue;
+    UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
 
-/// I2C port used for OLED communication
-#define I2C_PORT i2c1
+    queue = !g_preempt_pending;
+    if(queue)
+    {
+        g_preempt_edge_us = time_us_64();
+        g_preempt_pending = true;
+    }
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+    if(queue && xTimerPendFunctionCallFromISR(preempt_service, NULL, 0, &woken) != pdPASS)
+        g_preempt_pending = false;
+    return woken;
+}
 
-/// OLED display pin configuration
-#define OLED_SDA 14      ///< Serial data pin
-#define OLED_SCL 15      ///< Serial clock pin
-#define OLED_ADDR 0x3C   ///< I2C address of OLED
-#define OLED_BAUDRATE 400000  ///< I2C communication speed
+/**
+ * @brief Preemption timer callback: next step of the path to the target
+ * @param timer Preemption timer (one-shot, re-armed by preempt_step())
+ */
+static void vPreemptTimerCallback(TimerHandle_t timer)
+{
+    uint32_t job_start = cpu_stats_job_begin();
 
-/// Joystick pin configuration (unused in current implementation)
-#define JOYSTICK_VRX 27  ///< X-axis analog input
-#define JOYSTICK_VRY 26  ///< Y-axis analog input
-#define JOYSTICK_PB  22  ///< Push button input
+    (void) timer;
+    preempt_step();
+    cpu_stats_job_end(CPU_STATS_JOB_PHASE, job_start);
+}
 
-/// Buzzer pin configuration
-#define BUZZER_A 10      ///< Primary buzzer pin
-#define BUZZER_B 21      ///< Secondary buzzer pin (unused)
+/**
+ * @brief Reports a mode change to the event log and the I/O tasks
+ * @param mode SEMAPHORE_DAILY_MODE or SEMAPHORE_NIGHT_MODE
+ * @param scheduled The weekly calendar made the change
+ */
+static void report_semaphore_mode(uint8_t mode, bool scheduled)
+{
+    event_log_add(&g_event_log, EVENT_LOG_MODE, mode, scheduled);
+    semaphore_snapshot_t snapshot = semaphore_get_snapshot();
+    notify_io_tasks(&snapshot);
+    if(mode == SEMAPHORE_DAILY_MODE) request_preempt_service();  // A request held during the night
+}
 
-/// RGB LED pin configuration
-#define RED_PIN   13     ///< Red LED PWM pin
-#define BLUE_PIN  12     ///< Blue LED PWM pin (unused)
-#define GREEN_PIN 11     ///< Green LED PWM pin
+/**
+ * @brief Phase timer callback: advances the countdown and updates the matrix and RGB LED
+ * @param timer Phase timer (auto-reload, PHASE_TICK_MS)
+ */
+static void vPhaseTimerCallback(TimerHandle_t timer)
+{
+    static uint32_t ticks = 0;
+    uint32_t job_start = cpu_stats_job_begin();
+    semaphore_snapshot_t snapshot;
+    bool mode_changed;
 
-/// Button definitions
-#define BUTTON_A 5       ///< Mode switch button
+    // Advance the phase engine and apply the calendar at the end of the cycle, then take the value to show
+    taskENTER_CRITICAL();
+    ticks++;
+    g_transition_deadline_us = g_phase_start_us + (uint64_t) ticks * PHASE_TICK_MS * 1000u;
+    uint32_t now_ms = phase_clock_ms();
+    schedule_step(now_ms);
+    mode_changed = apply_schedule(now_ms, update_semaphore_counter(now_ms));
+    snapshot.counter = g_semaphore_counter;
+    snapshot.state = g_sempahore_state;
+    snapshot.led_color = g_semaphore_led_color;
+    snapshot.mode = g_semaphore_mode;
+    snapshot.heads = g_semaphore_heads;
+    snapshot.ped = g_semaphore_ped;
+    snapshot.ped_waiting = g_ped_waiting;
+    snapshot.preempt = g_preempt_active;
+    snapshot.transition_seq = g_transition_seq;
+    supervisor_save_state(semaphore_pack_state());
+    taskEXIT_CRITICAL();
 
-// Global state variables
-static volatile uint16_t g_semaphore_counter = SEMAPHORE_GREEN_DURATION_SEC;  // Current countdown value
-static volatile uint8_t g_sempahore_state = SEMAPHORE_GREEN_STATE;            // Current light state
-static volatile uint8_t g_semaphore_led_color = SEMAPHORE_LED_COLOR_GREEN;    // Current LED color
-static volatile uint8_t g_semaphore_mode = SEMAPHORE_DAILY_MODE;              // Current operation mode
+    supervisor_checkin(g_phase_heartbeat);
+    show_phase_outputs(&snapshot);
+    if(mode_changed) report_semaphore_mode(snapshot.mode, true);
+    if(snapshot.transition_seq != g_shown_seq)
+    {
+        g_shown_seq = snapshot.transition_seq;
+        record_transition_latency();
+        notify_io_tasks(&snapshot);
+    }
+    else if(snapshot.ped == PHASE_PED_CLEARANCE && snapshot.mode == SEMAPHORE_DAILY_MODE)
+        xTaskNotifyGive(g_display_task);  // The OLED counts the clearance down too
+    cpu_stats_job_end(CPU_STATS_JOB_PHASE, job_start);
+}
 
 /**
- * @brief Updates the semaphore counter and transitions states when timeout occurs
- * @param current_state The current semaphore state
+ * @brief Buzzer timer callback: alternates tone and silence with the cadence of the current phase
+ * @param timer Buzzer timer (one-shot, re-armed with the next interval)
  */
-void update_semaphore_counter(uint8_t current_state)
+static void vBuzzerTimerCallback(TimerHandle_t timer)
 {
-    if(g_semaphore_counter == SEMAPHORE_DURATION_TIMEOUT)
+    static bool tone_on = false;
+    uint32_t job_start = cpu_stats_job_begin();
+    semaphore_snapshot_t snapshot = semaphore_get_snapshot();
+    const buzzer_cadence_t *cadence = &BUZZER_CADENCE[snapshot.state];
+    uint16_t frequency_hz = BUZZER_FREQUENCY_HZ;
+
+    if(snapshot.mode == SEMAPHORE_NIGHT_MODE) cadence = &BUZZER_NIGHT_CADENCE;
+    else if(snapshot.ped != PHASE_PED_DONT_WALK)
     {
-        switch(current_state)
-        {
-            case SEMAPHORE_GREEN_STATE:
-                // Transition to yellow state
-                g_semaphore_counter = SEMAPHORE_YELLOW_DURATION_SEC;
-                g_sempahore_state = SEMAPHORE_YELLOW_STATE;
-                g_semaphore_led_color = SEMAPHORE_LED_COLOR_YELLOW;
-                break;
-            case SEMAPHORE_YELLOW_STATE:
-                // Transition to red state
-                g_semaphore_counter = SEMAPHORE_RED_DURATION_SEC;
-                g_sempahore_state = SEMAPHORE_RED_STATE;
-                g_semaphore_led_color = SEMAPHORE_LED_COLOR_RED;
-                break;
-            case SEMAPHORE_RED_STATE:
-                // Transition to green state (complete cycle)
-                g_semaphore_counter = SEMAPHORE_GREEN_DURATION_SEC;
-                g_sempahore_state = SEMAPHORE_GREEN_STATE;
-                g_semaphore_led_color = SEMAPHORE_LED_COLOR_GREEN;
-                break;
-        }
+        cadence = (snapshot.ped == PHASE_PED_WALK) ? &BUZZER_WALK_CADENCE : &BUZZER_CLEARANCE_CADENCE;
+        frequency_hz = BUZZER_PED_FREQUENCY_HZ;
     }
+
+    tone_on = !tone_on;
+    if(tone_on) buzzer_tone_on(BUZZER_A, frequency_hz);
+    else buzzer_tone_off(BUZZER_A);
+    // The clearance countdown blinks with the tone
+    g_ped_flash_on = tone_on;
+    if(snapshot.mode == SEMAPHORE_DAILY_MODE && snapshot.ped == PHASE_PED_CLEARANCE) show_phase_outputs(&snapshot);
+    xTimerChangePeriod(timer, pdMS_TO_TICKS(tone_on ? cadence->on_ms : cadence->off_ms), 0);
+    cpu_stats_job_end(CPU_STATS_JOB_BUZZER, job_start);
 }
 
 /**
- * @brief Task to handle button presses for mode switching
- * @param pvParameters Task parameters (unused)
+ * @brief Detector timer callback: filters the new ADC samples into vehicle presence
+ *        and extends the actuated phase (gap-out/max-out happens in the engine)
+ * @param timer Detector timer (auto-reload, DETECTOR_POLL_MS)
  */
-void vPushButtonTask(void *pvParameters)
+static void vDetectorTimerCallback(TimerHandle_t timer)
 {
-    while(1)
+    uint32_t job_start = cpu_stats_job_begin();
+    uint32_t count = adc_sampler_read(detector_samples, ADC_SAMPLER_RING_SAMPLES);
+    uint32_t presence = detector_feed_interleaved(g_detectors, ADC_SAMPLER_CHANNELS, detector_samples, count);
+    // Each new presence is a vehicle: the log keeps the arrivals for tools/sim/optimize_plan.c
+    uint32_t arrivals = presence & ~(uint32_t) g_detector_presence;
+
+    for(uint8_t i = 0; arrivals; i++, arrivals >>= 1)
+        if(arrivals & 1u) event_log_add(&g_event_log, EVENT_LOG_DETECTOR, i, 0);
+    taskENTER_CRITICAL();
+    g_detector_presence = (uint8_t) presence;
+    if(g_semaphore_mode == SEMAPHORE_DAILY_MODE)
     {
-        // Toggle mode when button A is pressed
-        if(!gpio_get(BUTTON_A))
-        {
-            if (g_semaphore_mode == SEMAPHORE_NIGHT_MODE)
-            {
-                g_semaphore_counter = SEMAPHORE_GREEN_DURATION_SEC;
-                g_semaphore_led_color = SEMAPHORE_LED_COLOR_GREEN;
-                g_sempahore_state = SEMAPHORE_GREEN_STATE;
-                g_semaphore_mode = SEMAPHORE_DAILY_MODE;
-            }
-            else g_semaphore_mode = SEMAPHORE_NIGHT_MODE;
-        }
-        vTaskDelay(pdMS_TO_TICKS(100));  // Debounce delay
+        uint32_t now_ms = phase_clock_ms();
+        if(presence) log_input(INPUT_LOG_PRESENCE, 0, presence, now_ms, time_us_64());  // An empty mask changes nothing
+#if TRAFFIC_INTERSECTION
+        rb_controller_presence(&g_rb_controller, presence, now_ms);
+#else
+        phase_engine_presence(&g_phase_engine, presence, now_ms);
+#endif
     }
+    taskEXIT_CRITICAL();
+    cpu_stats_job_end(CPU_STATS_JOB_DETECTOR, job_start);
+}
+
+/**
+ * @brief Switches between day and night mode and reports the change
+ * @param mode SEMAPHORE_DAILY_MODE or SEMAPHORE_NIGHT_MODE
+ * @note Day mode restarts the plan from its initial phase
+ */
+static void set_semaphore_mode(uint8_t mode)
+{
+    taskENTER_CRITICAL();
+    if(mode == SEMAPHORE_DAILY_MODE && g_semaphore_mode != SEMAPHORE_DAILY_MODE) start_phase_plan(phase_clock_ms());
+    g_semaphore_mode = mode;
+    taskEXIT_CRITICAL();
+    report_semaphore_mode(mode, false);
+}
+
+/**
+ * @brief Button timer callback: polls button A and toggles day/night mode
+ * @param timer Button timer (auto-reload, BUTTON_POLL_MS)
+ */
+static void vButtonTimerCallback(TimerHandle_t timer)
+{
+    uint32_t job_start = cpu_stats_job_begin();
+
+    // Toggle mode when button A is pressed
+    if(!gpio_get(BUTTON_A))
+        set_semaphore_mode((g_semaphore_mode == SEMAPHORE_NIGHT_MODE) ? SEMAPHORE_DAILY_MODE : SEMAPHORE_NIGHT_MODE);
+    cpu_stats_job_end(CPU_STATS_JOB_BUTTON, job_start);
 }
 
 /**
  * @brief Task to update the OLED display with current state messages
  * @param pvParameters Pointer to SSD1306 display structure
+ * @note Stays a task because the I2C flush blocks for ~25 ms; it only redraws
+ *       when the phase timer or the button signal a change, but wakes every
+ *       DISPLAY_HEARTBEAT_MS to check in with the supervisor, so a hung I2C
+ *       flush resets the board.
  */
 void vDisplayTask(void *pvParameters)
 {
     ssd1306_t *ssd = (ssd1306_t *) pvParameters;
+    semaphore_snapshot_t snapshot;
+    uint32_t changed = 1;
+    bool fail_safe_shown = false;
     while(1)
     {
+        supervisor_checkin(g_display_heartbeat);
+        if(g_fail_safe != fail_safe_shown) changed = 1;  // The monitor IRQ does not notify
+        if(!changed)
+        {
+            changed = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DISPLAY_HEARTBEAT_MS));
+            continue;
+        }
+        uint32_t job_start = cpu_stats_job_begin();
+        snapshot = semaphore_get_snapshot();
+        fail_safe_shown = g_fail_safe;
         oledgfx_clear_line(ssd, 40);
-        if(g_semaphore_mode == SEMAPHORE_DAILY_MODE)
+        if(fail_safe_shown)
+            ssd1306_draw_string(ssd, "Falha", 24, 40);
+        else if(snapshot.mode == SEMAPHORE_DAILY_MODE && snapshot.preempt)
+            ssd1306_draw_string(ssd, "Emergencia", 24, 40);
+        else if(snapshot.mode == SEMAPHORE_DAILY_MODE)
         {
-            if(g_sempahore_state == SEMAPHORE_GREEN_STATE) 
+            if(snapshot.state == SEMAPHORE_GREEN_STATE) 
                 ssd1306_draw_string(ssd, "Siga", 24, 40);
-            else if(g_sempahore_state == SEMAPHORE_YELLOW_STATE) 
+            else if(snapshot.state == SEMAPHORE_YELLOW_STATE) 
                 ssd1306_draw_string(ssd, "Atencao", 24, 40);
-            else if(g_sempahore_state == SEMAPHORE_RED_STATE) 
+            else if(snapshot.state == SEMAPHORE_RED_STATE) 
                 ssd1306_draw_string(ssd, "Pare", 24, 40);
         }
+        // Pedestrian line: walk, clearance countdown or a call waiting
+        oledgfx_clear_line(ssd, 52);
+        if(!fail_safe_shown && snapshot.mode == SEMAPHORE_DAILY_MODE)
+        {
+            char text[16];
+            if(snapshot.ped == PHASE_PED_WALK)
+                ssd1306_draw_string(ssd, "Atravesse", 24, 52);
+            else if(snapshot.ped == PHASE_PED_CLEARANCE)
+            {
+                snprintf(text, sizeof(text), "Termine %u", snapshot.counter);
+                ssd1306_draw_string(ssd, text, 24, 52);
+            }
+            else if(snapshot.ped_waiting)
+                ssd1306_draw_string(ssd, "Aguarde", 24, 52);
+        }
         // Display appropriate message based on current state
         oledgfx_render(ssd);  // Update display
-        vTaskDelay(pdMS_TO_TICKS(1000));  // Update once per second
+        cpu_stats_job_end(CPU_STATS_JOB_DISPLAY, job_start);
+        changed = 0;
+    }
+}
+
+/**
+ * @brief Sends the detector and gap-out/max-out counters (TELEMETRY_TYPE_ACTUATION)
+ */
+static void send_actuation_report(void)
+{
+    telemetry_actuation_t report;
+
+    taskENTER_CRITICAL();
+    report.presence = g_detector_presence;
+#if TRAFFIC_INTERSECTION
+    report.gap_outs = g_rb_controller.gap_outs;
+    report.max_outs = g_rb_controller.max_outs;
+#else
+    report.gap_outs = g_phase_engine.gap_outs;
+    report.max_outs = g_phase_engine.max_outs;
+#endif
+    for(uint8_t i = 0; i < TELEMETRY_DETECTORS; i++) report.activations[i] = g_detectors[i].activations;
+    taskEXIT_CRITICAL();
+    report.overruns = adc_sampler_overruns();
+    telemetry_send(TELEMETRY_TYPE_ACTUATION, &report, sizeof(report));
+}
+
+/**
+ * @brief Sends the pedestrian call counters and request-to-walk latency (TELEMETRY_TYPE_PEDESTRIAN)
+ */
+static void send_pedestrian_report(void)
+{
+    telemetry_pedestrian_t report;
+
+    taskENTER_CRITICAL();
+    report.waiting = g_ped_waiting;
+    report.requests = g_ped_requests;
+    report.served = g_ped_served;
+    report.latency_last_ms = g_ped_latency_last_ms;
+    report.latency_max_ms = g_ped_latency_max_ms;
+    taskEXIT_CRITICAL();
+    telemetry_send(TELEMETRY_TYPE_PEDESTRIAN, &report, sizeof(report));
+}
+
+/**
+ * @brief Sends the cycle, offset and last sync point error (TELEMETRY_TYPE_COORDINATION)
+ */
+static void send_coordination_report(void)
+{
+    telemetry_coordination_t report;
+#if TRAFFIC_INTERSECTION
+    const coord_t *coord = &g_rb_controller.coord;
+#else
+    const coord_t *coord = &g_phase_engine.coord;
+#endif
+
+    taskENTER_CRITICAL();
+    report.synced = coord->synced;
+    report.cycle_ms = coord->cycle_ms;
+    report.offset_ms = coord->offset_ms;
+    report.last_error_ms = coord->last_error_ms;
+    report.time_syncs = g_time_syncs;
+    taskEXIT_CRITICAL();
+    telemetry_send(TELEMETRY_TYPE_COORDINATION, &report, sizeof(report));
+}
+
+/**
+ * @brief Moves the event log to flash and answers dump requests
+ * @note Called by the log task only. Full pages are written as they fill; a
+ *       partly filled page waits up to EVENT_LOG_FLUSH_MS unless a fault or a
+ *       dump asks for it
+ */
+static void save_event_log(void)
+{
+    static TickType_t last_save = 0;
+    bool dump = g_event_log_dump;
+    bool partial = dump || g_event_log_urgent
+        || xTaskGetTickCount() - last_save >= pdMS_TO_TICKS(EVENT_LOG_FLUSH_MS);
+
+    g_event_log_urgent = false;
+    event_log_flush(&g_event_log, partial);
+    if(partial) last_save = xTaskGetTickCount();
+    if(dump)
+    {
+        g_event_log_dump = false;
+        event_log_dump(&g_event_log);
+    }
+}
+
+/**
+ * @brief Sends the input log, oldest block first, when the shell asks for it
+ * @note Called by the log task only. Each block is copied inside a critical
+ *       section, since the timer service task keeps writing the log; a block
+ *       started during the dump shifts the ring by one, which the replay sees
+ *       as a gap in the block sequence numbers
+ */
+static void send_input_log(void)
+{
+    input_log_frame_t frame;
+    bool copied;
+
+    if(!g_input_log_dump) return;
+    g_input_log_dump = false;
+    for(uint8_t i = 0; ; i++)
+    {
+        taskENTER_CRITICAL();
+        copied = i < input_log_block_count(&g_input_log);
+        if(copied) memcpy(g_input_log_copy, input_log_block(&g_input_log, i), INPUT_LOG_BLOCK_SIZE);
+        taskEXIT_CRITICAL();
+        if(!copied) break;
+        frame.block = i;
+        for(frame.part = 0; frame.part < INPUT_LOG_BLOCK_SIZE / INPUT_LOG_DUMP_PART; frame.part++)
+        {
+            memcpy(frame.data, &g_input_log_copy[frame.part * INPUT_LOG_DUMP_PART], INPUT_LOG_DUMP_PART);
+            telemetry_send(TELEMETRY_TYPE_INPUT_LOG, &frame, sizeof(frame));
+        }
     }
+    frame.block = INPUT_LOG_DUMP_END;
+    frame.part = 0;
+    memset(frame.data, 0, sizeof(frame.data));
+    telemetry_send(TELEMETRY_TYPE_INPUT_LOG, &frame, sizeof(frame));
 }
 
 /**
- * @brief Task to control buzzer patterns based on semaphore state
+ * @brief Task owning USB stdio: prints state changes and sends telemetry
+ * @param pvParameters Task parameters (unused)
+ * @note USB stdio and the conflict monitor alarm are started here so their
+ *       IRQs land on the I/O core
  */
-void vBuzzerTask()
+void vLogTask(void *pvParameters)
 {
+    log_event_t *event;
+    TickType_t last_report = xTaskGetTickCount();
+    bool fail_safe_reported = false;
+#if TRAFFIC_TRACE
+    TickType_t last_trace_dump = xTaskGetTickCount();
+#endif
+
+    stdio_init_all();  // Initialize stdio for debug output
+    start_conflict_monitor();
+    xTaskNotifyGive(g_shell_task);  // The shell may read USB stdio from now on
+    if(g_boot_record.watchdog_reset)
+        printf("WATCHDOG: reinicio %u causado por %s, fase %s\n", g_boot_record.resets,
+            supervisor_culprit_name(g_boot_record.culprit), g_boot_record.state_valid ? "restaurada" : "reiniciada");
+    if(g_config_discarded) printf("CONFIG: duracoes salvas invalidas para o plano, usando o padrao\n");
     while(1)
     {
-        if(g_semaphore_mode == SEMAPHORE_DAILY_MODE)
+        // Woken by state changes; the timeout keeps the periodic reports going
+        event = msg_queue_receive(&g_log_queue, pdMS_TO_TICKS(TELEMETRY_REPORT_PERIOD_MS));
+        uint32_t job_start = cpu_stats_job_begin();
+        supervisor_checkin(g_log_heartbeat);
+        if(event)
         {
-            if(g_sempahore_state == SEMAPHORE_GREEN_STATE)
-            {
-                // Green state: short beep once per second
-                buzzer_beep(BUZZER_A, 251, 300);
-                vTaskDelay(pdMS_TO_TICKS(749));
-            }
-            else if(g_sempahore_state == SEMAPHORE_YELLOW_STATE)
-            {
-                // Yellow state: rapid beeping
-                buzzer_beep(BUZZER_A, 251, 300);
-            }
-            else if(g_sempahore_state == SEMAPHORE_RED_STATE)
-            {
-                // Red state: longer beep every 1.5 seconds
-                buzzer_beep(BUZZER_A, 500, 300);
-                vTaskDelay(pdMS_TO_TICKS(1500));
-            }
+            if(event->mode == SEMAPHORE_NIGHT_MODE) printf("NOTURNO\n");
+            else if(event->state == SEMAPHORE_GREEN_STATE) printf("VERDE\n");
+            else if(event->state == SEMAPHORE_YELLOW_STATE) printf("AMARELO\n");
+            else if(event->state == SEMAPHORE_RED_STATE) printf("VERMELHO\n");
+            if(event->mode == SEMAPHORE_DAILY_MODE && event->ped == PHASE_PED_WALK) printf("TRAVESSIA\n");
+            else if(event->mode == SEMAPHORE_DAILY_MODE && event->ped == PHASE_PED_CLEARANCE) printf("LIMPEZA\n");
+            msg_pool_free(event);
         }
-        else
+        if(g_fail_safe && !fail_safe_reported)
+        {
+            fail_safe_reported = true;
+            printf("MONITOR: falha %u detalhe %04x, vermelho piscante\n", g_monitor.fault, g_monitor.detail);
+        }
+        if(xTaskGetTickCount() - last_report >= pdMS_TO_TICKS(TELEMETRY_REPORT_PERIOD_MS))
+        {
+            telemetry_latency_t latency = {
+                .cores = configNUMBER_OF_CORES,
+                .transitions = g_transition_seq,
+                .latency_max_us = g_transition_latency_max_us,
+            };
+            last_report = xTaskGetTickCount();
+            cpu_stats_report();
+            telemetry_send(TELEMETRY_TYPE_LATENCY, &latency, sizeof(latency));
+            send_actuation_report();
+            send_pedestrian_report();
+            send_coordination_report();
+        }
+        cpu_stats_job_end(CPU_STATS_JOB_LOG, job_start);
+        save_event_log();  // Outside the job: a sector erase is not part of the log WCET
+        send_input_log();
+#if TRAFFIC_TRACE
+        if(xTaskGetTickCount() - last_trace_dump >= pdMS_TO_TICKS(TRACE_DUMP_PERIOD_MS))
         {
-            buzzer_beep(BUZZER_A, 500, 300);
-            vTaskDelay(pdMS_TO_TICKS(2000));
+            last_trace_dump = xTaskGetTickCount();
+            trace_dump();
         }
+#endif
+    }
+}
+
+/**
+ * @brief Prints the commands and their arguments
+ */
+static bool cmd_help(int argc, char **argv)
+{
+    (void) argc;
+    (void) argv;
+    for(uint8_t i = 0; i < g_shell.count; i++) printf("%-9s %s\n", g_shell.commands[i].name, g_shell.commands[i].usage);
+    return true;
+}
+
+/**
+ * @brief Prints the durations of every phase of the running plan
+ */
+static bool cmd_phases(int argc, char **argv)
+{
+    (void) argc;
+    (void) argv;
+#if TRAFFIC_INTERSECTION
+    printf("plano %s (decimos de segundo)\n", g_plan->name);
+    for(uint8_t i = 0; i < g_plan->phase_count; i++)
+    {
+        const rb_phase_def_t *phase = &g_plan->phases[i];
+        printf("%u %-16s verde %u-%u padrao %u amarelo %u vermelho %u%s\n", i, phase->name, phase->min_green_ds,
+            phase->max_green_ds, phase->green_ds, phase->yellow_ds, phase->red_clear_ds,
+            (phase->detector != RB_NO_DETECTOR) ? " atuada" : "");
+    }
+#else
+    printf("plano %s (segundos)\n", g_plan->name);
+    for(uint8_t i = 0; i < g_plan->count; i++)
+    {
+        const phase_def_t *phase = &g_plan->phases[i];
+        printf("%u %-10s min %u max %u padrao %u%s\n", i, phase->name, phase->min_s, phase->max_s, phase->default_s,
+            (phase->detector != PHASE_NO_DETECTOR) ? " atuada" : "");
+    }
+#endif
+    return true;
+}
+
+/**
+ * @brief Saves a setting to flash and logs the outcome in the event log
+ * @return false if the flash write failed
+ */
+static bool save_setting(uint16_t key, const void *value, uint8_t len)
+{
+    if(!config_store_set(&g_config, key, value, len))
+    {
+        log_fault(EVENT_FAULT_FLASH, key);
+        return false;
+    }
+    event_log_add(&g_event_log, EVENT_LOG_CONFIG, 0, key);
+    return true;
+}
+
+/**
+ * @brief Changes the durations of a phase: duracao <fase> <min> <max> <padrao>
+ * @note Applies to the running plan (day or peak), takes effect the next time
+ *       the phase starts and is saved to flash under that plan; rejected if
+ *       the plan would become invalid
+ */
+static bool cmd_duration(int argc, char **argv)
+{
+    uint64_t index, min, max, value;
+    uint16_t durations[3];
+    bool valid;
+    uint8_t plan = g_plan_id;
+#if TRAFFIC_INTERSECTION
+    uint8_t count = g_plans[plan].phase_count;
+#else
+    uint8_t count = g_plans[plan].count;
+#endif
+
+    if(argc != 5 || !shell_parse_uint(argv[1], count - 1u, &index)
+        || !shell_parse_uint(argv[2], UINT16_MAX, &min) || !shell_parse_uint(argv[3], UINT16_MAX, &max)
+        || !shell_parse_uint(argv[4], UINT16_MAX, &value))
+        return false;
+    durations[0] = (uint16_t) min;
+    durations[1] = (uint16_t) max;
+    durations[2] = (uint16_t) value;
+    taskENTER_CRITICAL();
+    valid = set_phase_durations(plan, (uint8_t) index, durations);
+    taskEXIT_CRITICAL();
+    if(!valid) printf("erro: duracoes invalidas para o plano %s\n", g_plans[plan].name);
+    else if(!save_setting(CONFIG_KEY_PLAN_PHASE(plan, index), durations, sizeof(durations)))
+        printf("ok: vale a partir do proximo inicio da fase (erro ao salvar na flash)\n");
+    else printf("ok: vale a partir do proximo inicio da fase\n");
+    return true;
+}
+
+/**
+ * @brief Sets day or night mode: modo dia|noite
+ */
+static bool cmd_mode(int argc, char **argv)
+{
+    if(argc != 2) return false;
+    if(strcmp(argv[1], "dia") == 0) set_semaphore_mode(SEMAPHORE_DAILY_MODE);
+    else if(strcmp(argv[1], "noite") == 0) set_semaphore_mode(SEMAPHORE_NIGHT_MODE);
+    else return false;
+    printf("ok\n");
+    return true;
+}
+
+/**
+ * @brief Preempts the plan from the shell: preempcao <fase>|fim
+ * @note Same path as the preemption input, which wins while it is held
+ */
+static bool cmd_preempt(int argc, char **argv)
+{
+    uint64_t phase;
+    uint32_t bound_ms;
+
+    if(argc != 2) return false;
+    if(strcmp(argv[1], "fim") == 0)
+    {
+        g_preempt_shell_phase = PHASE_NO_PHASE;
+        request_preempt_service();
+        printf("ok\n");
+        return true;
+    }
+#if TRAFFIC_INTERSECTION
+    if(!shell_parse_uint(argv[1], g_plan->phase_count - 1u, &phase)) return false;
+#else
+    if(!shell_parse_uint(argv[1], g_plan->count - 1u, &phase)) return false;
+#endif
+    taskENTER_CRITICAL();
+    bound_ms = plan_preempt_bound_ms((uint8_t) phase);
+    taskEXIT_CRITICAL();
+    if(bound_ms == UINT32_MAX)
+    {
+        printf("erro: o plano nao chega a fase de todas as outras\n");
+        return true;
+    }
+    g_preempt_shell_phase = (uint8_t) phase;
+    request_preempt_service();
+    printf("ok: fase %u em ate %lu ms (modo dia)\n", (unsigned) phase, (unsigned long) bound_ms);
+    return true;
+}
+
+/**
+ * @brief Sets the LED matrix brightness: brilho <1-100>
+ * @note Saved to flash
+ */
+static bool cmd_brightness(int argc, char **argv)
+{
+    uint64_t value;
+    uint8_t intensity;
+
+    if(argc != 2 || !shell_parse_uint(argv[1], 100, &value) || value == 0) return false;
+    intensity = (uint8_t) value;
+    g_matrix_intensity = intensity;
+    printf(save_setting(CONFIG_KEY_BRIGHTNESS, &intensity, sizeof(intensity)) ? "ok\n" : "ok (erro ao salvar na flash)\n");
+    return true;
+}
+
+/**
+ * @brief Prints the current mode, phase and detector/pedestrian state
+ */
+static bool cmd_status(int argc, char **argv)
+{
+    static const char *const PED_NAMES[] = { "nao atravesse", "atravesse", "limpeza" };
+    semaphore_snapshot_t snapshot = semaphore_get_snapshot();
+    const char *phase_name;
+    uint8_t preempt;
+
+    (void) argc;
+    (void) argv;
+    taskENTER_CRITICAL();
+    preempt = plan_preempt_phase();
+#if TRAFFIC_INTERSECTION
+    phase_name = g_plan->phases[g_plan->heads[0].phase].name;
+#else
+    phase_name = phase_engine_current(&g_phase_engine)->name;
+#endif
+    taskEXIT_CRITICAL();
+    printf("modo %s plano %s fase %s restante %u s pedestre %s%s detectores %u\n",
+        (snapshot.mode == SEMAPHORE_DAILY_MODE) ? "dia" : "noite", g_plan->name, phase_name, snapshot.counter,
+        PED_NAMES[snapshot.ped], snapshot.ped_waiting ? " (chamada)" : "", g_detector_presence);
+    if(preempt != PHASE_NO_PHASE) printf("preempcao de emergencia para a fase %u\n", preempt);
+    if(g_fail_safe)
+        printf("monitor em falha %u detalhe %04x: vermelho piscante ate reiniciar\n", g_monitor.fault, g_monitor.detail);
+    return true;
+}
+
+/**
+ * @brief Prints the counters also sent in the telemetry frames
+ */
+static bool cmd_stats(int argc, char **argv)
+{
+    (void) argc;
+    (void) argv;
+#if TRAFFIC_INTERSECTION
+    const coord_t *coord = &g_rb_controller.coord;
+    uint32_t gap_outs = g_rb_controller.gap_outs, max_outs = g_rb_controller.max_outs;
+#else
+    const coord_t *coord = &g_phase_engine.coord;
+    uint32_t gap_outs = g_phase_engine.gap_outs, max_outs = g_phase_engine.max_outs;
+#endif
+    printf("transicoes %lu latencia max %lu us\n", (unsigned long) g_transition_seq,
+        (unsigned long) g_transition_latency_max_us);
+    printf("gap-out %lu max-out %lu adc perdidas %lu\n", (unsigned long) gap_outs, (unsigned long) max_outs,
+        (unsigned long) adc_sampler_overruns());
+    printf("pedestre chamadas %lu atendidas %lu espera %lu ms max %lu ms\n", (unsigned long) g_ped_requests,
+        (unsigned long) g_ped_served, (unsigned long) g_ped_latency_last_ms, (unsigned long) g_ped_latency_max_ms);
+    printf("preempcao pedidos %lu %s verde apos %lu ms max %lu ms resposta max %lu us\n",
+        (unsigned long) g_preempt_requests, g_preempt_active ? "ativa" : "inativa",
+        (unsigned long) g_preempt_green_last_ms, (unsigned long) g_preempt_green_max_ms,
+        (unsigned long) g_preempt_latency_max_us);
+    printf("coordenacao ciclo %lu ms erro %ld ms %s\n", (unsigned long) coord->cycle_ms, (long) coord->last_error_ms,
+        coord->synced ? "sincronizada" : "livre");
+    printf("log eventos perdidos %lu\n", (unsigned long) g_log_event_pool.alloc_failures);
+    printf("monitor amostras %lu violacoes %lu\n", (unsigned long) g_monitor.samples,
+        (unsigned long) g_monitor.violations);
+    printf("log na flash boot %u paginas %lu erros %lu\n", g_event_log.boot,
+        (unsigned long) g_event_log.pages_written, (unsigned long) g_event_log.flash_errors);
+    printf("log de entradas registros %lu blocos %u sobrescritos %lu\n", (unsigned long) g_input_log.records,
+        input_log_block_count(&g_input_log), (unsigned long) g_input_log.blocks_lost);
+    return true;
+}
+
+/**
+ * @brief Sends the event log as telemetry frames: eventos
+ * @note The log task writes the pending events and sends the dump within
+ *       TELEMETRY_REPORT_PERIOD_MS (tools/event_log.py)
+ */
+static bool cmd_events(int argc, char **argv)
+{
+    (void) argv;
+    if(argc != 1) return false;
+    g_event_log_dump = true;
+    return true;
+}
+
+/**
+ * @brief Sends the input log as telemetry frames: entradas
+ * @note The log task sends the dump within TELEMETRY_REPORT_PERIOD_MS
+ *       (tools/input_log.py, replayed by tools/sim/replay_inputs.c)
+ */
+static bool cmd_inputs(int argc, char **argv)
+{
+    (void) argv;
+    if(argc != 1) return false;
+    g_input_log_dump = true;
+    return true;
+}
+
+/**
+ * @brief Sets the time base of the coordination: hora <ms desde 1970>
+ * @note The line is timestamped when it arrives (tools/timesync.py)
+ */
+static bool cmd_time(int argc, char **argv)
+{
+    uint64_t host_ms;
+
+    if(argc != 2 || !shell_parse_uint(argv[1], UINT64_MAX, &host_ms)) return false;
+    sync_time_base(host_ms);
+    printf("ok\n");
+    return true;
+}
+
+/**
+ * @brief Shows or sets the weekly calendar: agenda [liga|desliga|fuso <minutos>]
+ * @note liga applies the program of the calendar at once (at the end of the
+ *       cycle), overriding a manual mode; the settings are saved to flash
+ */
+static bool cmd_schedule(int argc, char **argv)
+{
+    static const char *const PROGRAM_NAMES[SCHEDULE_PROGRAM_COUNT] = { "dia", "pico", "noite" };
+    static const char DAY_LETTERS[] = "DSTQQSS";
+    uint64_t value;
+
+    if(argc == 2 && (strcmp(argv[1], "liga") == 0 || strcmp(argv[1], "desliga") == 0))
+    {
+        uint8_t enabled = strcmp(argv[1], "liga") == 0;
+        taskENTER_CRITICAL();
+        g_schedule_enabled = enabled;
+        g_schedule_next_ms = 0;
+        g_schedule_program = SCHEDULE_NO_PROGRAM;
+        g_schedule_target = SCHEDULE_NO_PROGRAM;
+        taskEXIT_CRITICAL();
+        printf(save_setting(CONFIG_KEY_SCHEDULE, &enabled, sizeof(enabled)) ? "ok\n" : "ok (erro ao salvar na flash)\n");
+        return true;
     }
+    if(argc == 3 && strcmp(argv[1], "fuso") == 0)
+    {
+        bool negative = argv[2][0] == '-';
+        if(!shell_parse_uint(argv[2] + negative, SCHEDULE_UTC_OFFSET_MAX_MIN, &value)) return false;
+        int16_t offset_min = negative ? (int16_t) -(int16_t) value : (int16_t) value;
+        taskENTER_CRITICAL();
+        g_utc_offset_min = offset_min;
+        g_schedule_next_ms = 0;
+        taskEXIT_CRITICAL();
+        printf(save_setting(CONFIG_KEY_UTC_OFFSET, &offset_min, sizeof(offset_min)) ? "ok\n" : "ok (erro ao salvar na flash)\n");
+        return true;
+    }
+    if(argc != 1) return false;
+
+    taskENTER_CRITICAL();
+    bool enabled = g_schedule_enabled, synced = g_time_synced;
+    uint8_t program = g_schedule_program, next_program = g_schedule_next_program, target = g_schedule_target;
+    uint64_t next_ms = g_schedule_next_ms;
+    uint64_t host_ms = g_time_sync_host_ms + (uint32_t) (phase_clock_ms() - g_time_sync_local_ms);
+    const char *plan_name = g_plan->name;
+    taskEXIT_CRITICAL();
+    printf("agenda %s %s fuso %d min plano %s trocas %lu\n", SCHEDULE_DEFAULT.name, enabled ? "ligada" : "desligada",
+        g_utc_offset_min, plan_name, (unsigned long) g_schedule_switches);
+    if(enabled && !synced) printf("sem hora do host: o calendario espera o comando hora (tools/timesync.py)\n");
+    else if(enabled && program != SCHEDULE_NO_PROGRAM)
+    {
+        printf("programa %s%s", PROGRAM_NAMES[program], (target != SCHEDULE_NO_PROGRAM) ? " (no fim do ciclo)" : "");
+        if(next_ms != SCHEDULE_NEVER && next_program < SCHEDULE_PROGRAM_COUNT)
+            printf(", %s em %lu min", PROGRAM_NAMES[next_program], (unsigned long) ((next_ms - host_ms) / 60000u));
+        printf("\n");
+    }
+    for(uint8_t i = 0; i < SCHEDULE_DEFAULT.count; i++)
+    {
+        const schedule_entry_t *entry = &SCHEDULE_DEFAULT.entries[i];
+        char days[8];
+        for(uint8_t d = 0; d < 7; d++) days[d] = (entry->days & (1u << d)) ? DAY_LETTERS[d] : '-';
+        days[7] = '\0';
+        printf("%s %02u:%02u %s\n", days, entry->minute / 60u, entry->minute % 60u, PROGRAM_NAMES[entry->program]);
+    }
+    return true;
+}
+
+/**
+ * @brief Shows the settings store or erases it: config [apagar]
+ * @note After apagar the plan defaults come back at the next reset
+ */
+static bool cmd_config(int argc, char **argv)
+{
+    if(argc == 2 && strcmp(argv[1], "apagar") == 0)
+    {
+        printf(config_store_clear(&g_config) ? "ok: padroes no proximo reinicio\n" : "erro: falha na flash\n");
+        return true;
+    }
+    if(argc != 1) return false;
+    if(g_config.sector == CONFIG_STORE_NO_SECTOR) printf("config vazia (formatada na primeira gravacao)\n");
+    else printf("config setor %u serie %lu chaves %u registros livres %u\n", g_config.sector,
+        (unsigned long) g_config.sequence, g_config.count, config_store_free_records(&g_config));
+    printf("gravacoes %lu apagamentos %lu registros invalidos %lu%s\n", (unsigned long) g_config.writes,
+        (unsigned long) g_config.erases, (unsigned long) g_config.bad_records,
+        g_config_discarded ? " (duracoes salvas descartadas)" : "");
+    return true;
+}
+
+/// Commands of the USB shell
+static const shell_command_t SHELL_COMMANDS[] = {
+    { "ajuda",   "lista os comandos",                                  cmd_help },
+    { "fases",   "mostra as duracoes das fases do plano",              cmd_phases },
+    { "duracao", "<fase> <min> <max> <padrao>: altera uma fase",       cmd_duration },
+    { "modo",    "dia|noite",                                          cmd_mode },
+    { "preempcao", "<fase>|fim: preempcao de emergencia",              cmd_preempt },
+    { "brilho",  "<1-100>: brilho da matriz de LEDs",                  cmd_brightness },
+    { "estado",  "modo, fase, pedestre e detectores",                  cmd_status },
+    { "stats",   "contadores (transicoes, atuacao, pedestre, coordenacao)", cmd_stats },
+    { "hora",    "<ms desde 1970>: base de tempo da coordenacao",      cmd_time },
+    { "config",  "[apagar]: configuracao salva na flash",              cmd_config },
+    { "eventos", "envia o log de eventos (tools/event_log.py)",        cmd_events },
+    { "entradas", "envia o log de entradas (tools/input_log.py)",      cmd_inputs },
+    { "agenda",  "[liga|desliga|fuso <min>]: calendario semanal",      cmd_schedule },
+};
+
+/**
+ * @brief USB stdio callback: wakes the shell when characters arrive
+ * @param param Unused
+ * @note Runs in the USB IRQ context
+ */
+static void shell_chars_available(void *param)
+{
+    BaseType_t woken = pdFALSE;
+
+    (void) param;
+    vTaskNotifyGiveFromISR(g_shell_task, &woken);
+    portYIELD_FROM_ISR(woken);
 }
 
 /**
- * @brief Task to control RGB LED colors based on semaphore state
- * @param pvParameters Pointer to RGB LED structure
+ * @brief Task running the USB command shell
+ * @param pvParameters Task parameters (unused)
+ * @note Sleeps until characters arrive and reads them without blocking, so a
+ *       half-typed line never holds the task; the line lives in g_shell (no heap).
  */
-void vLedColorTask(void *pvParameters)
+void vShellTask(void *pvParameters)
 {
-    rgb_t *led_rgb = (rgb_t *) pvParameters;
+    int c;
+
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);  // The log task has brought USB stdio up
+    shell_init(&g_shell, SHELL_COMMANDS, sizeof(SHELL_COMMANDS) / sizeof(SHELL_COMMANDS[0]));
+    stdio_set_chars_available_callback(shell_chars_available, NULL);
     while(1)
     {
-        if(g_semaphore_mode == SEMAPHORE_DAILY_MODE)
-        {
-            if(g_sempahore_state == SEMAPHORE_GREEN_STATE)
-            {
-                printf("VERDE\n");
-                rgb_turn_on_by_color(led_rgb, RGB_COLOR_GREEN);
-            }
-            else if(g_sempahore_state == SEMAPHORE_YELLOW_STATE)
-            {
-                printf("AMARELO\n");
-                rgb_turn_on_by_color(led_rgb, RGB_COLOR_YELLOW);
-            }
-            else if(g_sempahore_state == SEMAPHORE_RED_STATE)
-            {
-                printf("VERMELHO\n");
-                rgb_turn_on_by_color(led_rgb, RGB_COLOR_RED);
-            }
-        }
-        else
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SHELL_POLL_MS));
+        while((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT)
         {
-            rgb_turn_on_by_color(led_rgb, RGB_COLOR_YELLOW);
+            uint32_t job_start = cpu_stats_job_begin();
+            shell_result_t result = shell_feed(&g_shell, (char) c);
+            if(result == SHELL_PENDING) continue;
+            if(result == SHELL_UNKNOWN) printf("erro: comando desconhecido (ajuda lista os comandos)\n");
+            else if(result == SHELL_BAD_ARGS) printf("uso: %s %s\n", g_shell.last->name, g_shell.last->usage);
+            else if(result == SHELL_TOO_LONG) printf("erro: linha longa demais\n");
+            cpu_stats_job_end(CPU_STATS_JOB_SHELL, job_start);
         }
-        vTaskDelay(pdMS_TO_TICKS(1));  // Small delay to prevent task starvation
     }
 }
 
+#if TRAFFIC_STACK_PROFILE
 /**
- * @brief Main task to control LED matrix countdown display
- * @param pvParameters Pointer to WS2812B LED matrix structure
+ * @brief Stress scenario of the stack profiling build
+ *
+ * Forces a phase transition at every step and toggles day/night mode every
+ * few steps, so every output path (including printf in the log task) runs
+ * many times while the high-water marks are sampled.
+ * @param step Step number
  */
-void vBlinkTask(void *pvParameters)
+static void stack_profile_stress_step(uint32_t step)
 {
-    ws2812b_t *ws = (ws2812b_t *) pvParameters;
-    while (true)
+    taskENTER_CRITICAL();
+#if !TRAFFIC_INTERSECTION
+    uint32_t now_ms = phase_clock_ms();
+    log_input(INPUT_LOG_EXPIRE, 0, 0, now_ms, 0);
+    phase_engine_expire(&g_phase_engine, now_ms);  // The intersection build changes phase often enough
+#endif
+    if(step % 8u == 7u)
+        g_semaphore_mode = (g_semaphore_mode == SEMAPHORE_DAILY_MODE) ? SEMAPHORE_NIGHT_MODE : SEMAPHORE_DAILY_MODE;
+    taskEXIT_CRITICAL();
+}
+#endif
+
+/**
+ * @brief Latches a pedestrian call (joystick button)
+ * @return pdTRUE if the display task must run on return from the IRQ
+ * @note Called from the GPIO IRQ. A held or bouncing button only latches once;
+ *       calls are ignored in night mode and while the walk is already on.
+ */
+static BaseType_t latch_ped_call_from_isr(void)
+{
+    BaseType_t woken = pdFALSE;
+    bool latched = false;
+    UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+
+    if(!g_ped_waiting && g_semaphore_mode == SEMAPHORE_DAILY_MODE && g_semaphore_ped != PHASE_PED_WALK)
     {
-        // Display current countdown number with appropriate color
-        if(g_semaphore_mode == SEMAPHORE_DAILY_MODE)
-            ws2812b_draw(ws, NUMERIC_GLYPHS[g_semaphore_counter--], g_semaphore_led_color, 1);
-        else
-            ws2812b_draw(ws, NUMERIC_GLYPHS[0], WS2812B_COLOR_YELLOW, 1);
-        vTaskDelay(pdMS_TO_TICKS(1000));  // Update every second
-        
-        // Check for state transitions
-        update_semaphore_counter(g_sempahore_state);
+        g_ped_waiting = true;
+        g_ped_request_us = time_us_64();
+        g_ped_requests++;
+        place_ped_call((uint32_t) (xTaskGetTickCountFromISR() * portTICK_PERIOD_MS), g_ped_request_us);
+        latched = true;
     }
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+    if(latched) event_log_add(&g_event_log, EVENT_LOG_PED_CALL, 0, 0);
+    if(latched) vTaskNotifyGiveFromISR(g_display_task, &woken);  // Show "Aguarde"
+    return woken;
 }
 
 /**
- * @brief IRQ handler for BOOTSEL button (Button B)
+ * @brief IRQ handler for BOOTSEL button (Button B), the pedestrian button and the preemption input
  * @param gpio GPIO pin that triggered the interrupt
  * @param events Type of interrupt event
  */
 void gpio_irq_handler(uint gpio, uint32_t events)
 {
-    reset_usb_boot(0, 0);  // Enter USB bootloader mode
+    BaseType_t woken = pdFALSE;
+    uint32_t enter_us = cpu_stats_isr_enter();
+    trace_isr_enter(TRACE_ISR_GPIO);
+    if(gpio == BUTTON_B) reset_usb_boot(0, 0);  // Enter USB bootloader mode
+    else if(gpio == JOYSTICK_PB) woken = latch_ped_call_from_isr();
+    else if(gpio == PREEMPT_PIN) woken = request_preempt_service_from_isr();
+    trace_isr_exit(TRACE_ISR_GPIO);
+    cpu_stats_isr_exit(CPU_STATS_ISR_GPIO, enter_us);
+    portYIELD_FROM_ISR(woken);
 }
 
 /**
@@ -267,6 +2433,25 @@ void gpio_irq_handler(uint gpio, uint32_t events)
  */
 int main()
 {
+    // Read the previous reset record and arm the watchdog before anything can hang
+    supervisor_init(&g_boot_record);
+    event_log_init(&g_event_log, &EVENT_LOG_FLASH);
+    event_log_add(&g_event_log, EVENT_LOG_BOOT, g_boot_record.watchdog_reset,
+        g_boot_record.culprit | ((uint32_t) g_boot_record.resets << 8));
+    load_plans();
+    load_saved_settings();
+    configASSERT(schedule_is_valid(&SCHEDULE_DEFAULT));
+#if TRAFFIC_INTERSECTION
+    for(uint8_t plan = 0; plan < PLAN_COUNT; plan++) configASSERT(rb_plan_is_valid(&g_plans[plan]));
+    input_log_init_rb(&g_input_log, g_plan, &g_rb_controller);
+#else
+    for(uint8_t plan = 0; plan < PLAN_COUNT; plan++) configASSERT(phase_plan_is_valid(&g_plans[plan]));
+    input_log_init_engine(&g_input_log, g_plan, &g_phase_engine);
+#endif
+    setup_conflict_monitor();
+    bool restored = g_boot_record.state_valid && semaphore_restore_state(g_boot_record.state);
+    if(!restored) start_phase_plan(0);
+
     // Configure system clock
     set_sys_clock_khz(128000, false);
     
@@ -275,20 +2460,19 @@ int main()
     pb_config_btn_b();  // Configure button B (BOOTSEL)
     pb_set_irq_callback(&gpio_irq_handler);
     pb_enable_irq(BUTTON_B);
-    
-    stdio_init_all();  // Initialize stdio for debug output
-    
-    // Initialize hardware components
-    ws2812b_t ws;  // LED matrix
-    rgb_t rgb;     // RGB LED
-    ssd1306_t ssd; // OLED display
+    pb_config(JOYSTICK_PB, true);  // Pedestrian call
+    pb_enable_irq(JOYSTICK_PB);
+    pb_config(PREEMPT_PIN, true);  // Emergency preemption: both edges, held while low
+    gpio_set_irq_enabled(PREEMPT_PIN, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true);
     
     // OLED display initialization
     oledgfx_init_all(&ssd, I2C_PORT, OLED_BAUDRATE, OLED_SDA, OLED_SCL, OLED_ADDR);
     buzzer_init(BUZZER_A);
     ws2812b_init(&ws, pio0, WS2812B_PIN);
+    for(uint8_t i = 0; i < ADC_SAMPLER_CHANNELS; i++) detector_init(&g_detectors[i], &DETECTOR_CONFIG);
+    adc_sampler_init();
     
-    // Draw initial display content
+    // Draw initial display content (the splash is skipped when resuming after a reset)
     oledgfx_clear_screen(&ssd);
     oledgfx_draw_border(&ssd, BORDER_LIGHT);
     ssd1306_line(&ssd, 3, 25, 123, 25, 1);
@@ -299,19 +2483,76 @@ int main()
     
     // Initialize RGB LED
     rgb_init_all(&rgb, RED_PIN, GREEN_PIN, BLUE_PIN, 1.0, 255);
-    oledgfx_render(&ssd);
+    if(!restored) oledgfx_render(&ssd);
     
+    // Show the first phase before the timers take over
+    semaphore_snapshot_t boot_phase = {
+        .counter = g_semaphore_counter,
+        .state = g_sempahore_state,
+        .led_color = g_semaphore_led_color,
+        .mode = g_semaphore_mode,
+        .heads = g_semaphore_heads,
+        .ped = g_semaphore_ped,
+    };
+    show_phase_outputs(&boot_phase);
+
+    // Log event pool and queue; the first event logs the boot phase
+    msg_pool_init(&g_log_event_pool, log_event_pool_storage, sizeof(log_event_t), LOG_EVENT_POOL_SIZE);
+    g_flash_mutex = xSemaphoreCreateMutexStatic(&flash_mutex_buffer);
+    msg_queue_init(&g_log_queue, log_queue_storage, LOG_EVENT_POOL_SIZE, "Log Queue");
+    post_log_event(&boot_phase);
+
     // Create FreeRTOS tasks
-    xTaskCreate(vBlinkTask, "Blink Task", 
-        configMINIMAL_STACK_SIZE, (void *) &ws, tskIDLE_PRIORITY + 4, NULL);
-    xTaskCreate(vLedColorTask, "LED RGB Task", 
-        configMINIMAL_STACK_SIZE, (void *) &rgb, tskIDLE_PRIORITY + 3, NULL);
-    xTaskCreate(vBuzzerTask, "Buzzer task", 
-        configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 2, NULL);
-    xTaskCreate(vDisplayTask, "Display Task", 
-        configMINIMAL_STACK_SIZE, (void *) &ssd, tskIDLE_PRIORITY + 1, NULL);
-        xTaskCreate(vPushButtonTask, "Change Mode Button", 
-            configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY, NULL);
+    g_display_task = xTaskCreateStatic(vDisplayTask, "Display Task", 
+        DISPLAY_TASK_STACK_DEPTH, (void *) &ssd, tskIDLE_PRIORITY + 1, display_task_stack, &display_task_tcb);
+    pin_task_to_cores(g_display_task, IO_CORE_MASK);
+    stack_profile_register(g_display_task, "DISPLAY_TASK_STACK_DEPTH", DISPLAY_TASK_STACK_DEPTH);
+    TaskHandle_t log_task = xTaskCreateStatic(vLogTask, "Log Task", 
+        LOG_TASK_STACK_DEPTH, NULL, tskIDLE_PRIORITY, log_task_stack, &log_task_tcb);
+    pin_task_to_cores(log_task, IO_CORE_MASK);
+    stack_profile_register(log_task, "LOG_TASK_STACK_DEPTH", LOG_TASK_STACK_DEPTH);
+    TaskHandle_t supervisor_task = xTaskCreateStatic(vSupervisorTask, "Supervisor", 
+        SUPERVISOR_TASK_STACK_DEPTH, NULL, tskIDLE_PRIORITY + 3, supervisor_task_stack, &supervisor_task_tcb);
+    pin_task_to_cores(supervisor_task, IO_CORE_MASK);
+    stack_profile_register(supervisor_task, "SUPERVISOR_TASK_STACK_DEPTH", SUPERVISOR_TASK_STACK_DEPTH);
+    g_shell_task = xTaskCreateStatic(vShellTask, "Shell Task",
+        SHELL_TASK_STACK_DEPTH, NULL, tskIDLE_PRIORITY, shell_task_stack, &shell_task_tcb);
+    pin_task_to_cores(g_shell_task, IO_CORE_MASK);
+    stack_profile_register(g_shell_task, "SHELL_TASK_STACK_DEPTH", SHELL_TASK_STACK_DEPTH);
+
+    // Heartbeats (registration order identifies the culprit after a reset)
+    g_phase_heartbeat = supervisor_register("Phase", PHASE_DEADLINE_MS);
+    g_display_heartbeat = supervisor_register("Display Task", DISPLAY_DEADLINE_MS);
+    g_log_heartbeat = supervisor_register("Log Task", LOG_DEADLINE_MS);
+#if TRAFFIC_STACK_PROFILE
+    TaskHandle_t task = xTaskCreateStatic(vStackProfileTask, "Stack Profile",
+        STACK_PROFILE_TASK_DEPTH, (void *) stack_profile_stress_step, tskIDLE_PRIORITY, 
+        stack_profile_task_stack, &stack_profile_task_tcb);
+    pin_task_to_cores(task, IO_CORE_MASK);
+#endif
+#if TRAFFIC_BENCH
+    TaskHandle_t bench_task = xTaskCreateStatic(vRingBenchTask, "Ring Bench",
+        RING_BENCH_TASK_STACK_DEPTH, NULL, tskIDLE_PRIORITY, ring_bench_task_stack, &ring_bench_task_tcb);
+    pin_task_to_cores(bench_task, IO_CORE_MASK);
+#endif
+
+    // Periodic outputs run as timer callbacks in the timer service task
+    TimerHandle_t phase_timer = xTimerCreateStatic("Phase", pdMS_TO_TICKS(PHASE_TICK_MS),
+        pdTRUE, NULL, vPhaseTimerCallback, &phase_timer_buffer);
+    TimerHandle_t buzzer_timer = xTimerCreateStatic("Buzzer", pdMS_TO_TICKS(BUZZER_CADENCE[SEMAPHORE_GREEN_STATE].off_ms),
+        pdFALSE, NULL, vBuzzerTimerCallback, &buzzer_timer_buffer);
+    TimerHandle_t button_timer = xTimerCreateStatic("Button", pdMS_TO_TICKS(BUTTON_POLL_MS),
+        pdTRUE, NULL, vButtonTimerCallback, &button_timer_buffer);
+    TimerHandle_t detector_timer = xTimerCreateStatic("Detector", pdMS_TO_TICKS(DETECTOR_POLL_MS),
+        pdTRUE, NULL, vDetectorTimerCallback, &detector_timer_buffer);
+    g_preempt_timer = xTimerCreateStatic("Preempt", 1, pdFALSE, NULL, vPreemptTimerCallback, &preempt_timer_buffer);
+    g_phase_start_us = time_us_64();
+    xTimerStart(phase_timer, 0);
+    xTimerStart(buzzer_timer, 0);
+    xTimerStart(button_timer, 0);
+    xTimerStart(detector_timer, 0);
+    if(!gpio_get(PREEMPT_PIN)) request_preempt_service();  // Input already held at boot
+
     // Start the RTOS scheduler
     vTaskStartScheduler();
     
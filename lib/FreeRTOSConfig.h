@@ -69,18 +69,39 @@
  #define configMESSAGE_BUFFER_LENGTH_TYPE        size_t
  
  /* Memory allocation related definitions. */
- #define configSUPPORT_STATIC_ALLOCATION         0
- #define configSUPPORT_DYNAMIC_ALLOCATION        1
- #define configTOTAL_HEAP_SIZE                   (128*1024)
+ /* Every kernel object is allocated statically (see lib/rtos_hooks.c), so no
+  * FreeRTOS heap is linked at all. */
+ #define configSUPPORT_STATIC_ALLOCATION         1
+ #define configSUPPORT_DYNAMIC_ALLOCATION        0
+ #define configTOTAL_HEAP_SIZE                   0
  #define configAPPLICATION_ALLOCATED_HEAP        0
  
  /* Hook function related definitions. */
+ /* TRAFFIC_STACK_PROFILE is set by CMake (option TRAFFIC_STACK_PROFILE). */
+ #ifndef TRAFFIC_STACK_PROFILE
+ #define TRAFFIC_STACK_PROFILE                   0
+ #endif
+ #if TRAFFIC_STACK_PROFILE
+ #define configCHECK_FOR_STACK_OVERFLOW          2
+ #else
  #define configCHECK_FOR_STACK_OVERFLOW          0
+ #endif
  #define configUSE_MALLOC_FAILED_HOOK            0
  #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
  
  /* Run time and task stats gathering related definitions. */
- #define configGENERATE_RUN_TIME_STATS           0
+ /* Run-time counter is the RP2040 64-bit microsecond timer (see lib/cpu_stats.h). */
+ #define configGENERATE_RUN_TIME_STATS           1
+ #define configRUN_TIME_COUNTER_TYPE             uint64_t
+ #ifndef __ASSEMBLER__
+ #include "hardware/timer.h"
+ #include "hardware/structs/sio.h"
+ extern volatile uint32_t cpu_stats_context_switches[];
+ #endif
+ #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+ #define portGET_RUN_TIME_COUNTER_VALUE()        time_us_64()
+ /* Context switches per core, reported in the CPU stats frame. */
+ #define cpu_stats_count_switch()                ( cpu_stats_context_switches[ sio_hw->cpuid ]++ )
  #define configUSE_TRACE_FACILITY                1
  #define configUSE_STATS_FORMATTING_FUNCTIONS    0
  
@@ -92,7 +113,19 @@
  #define configUSE_TIMERS                        1
  #define configTIMER_TASK_PRIORITY               ( configMAX_PRIORITIES - 1 )
  #define configTIMER_QUEUE_LENGTH                10
+ /* Measured stack sizes (tools/stack_header.py), absent until the first profile run. */
+ #if !TRAFFIC_STACK_PROFILE && defined( __has_include )
+ #if __has_include( "../generated/task_stacks.h" )
+ #include "../generated/task_stacks.h"
+ #endif
+ #endif
+ #if TRAFFIC_STACK_PROFILE
  #define configTIMER_TASK_STACK_DEPTH            1024
+ #elif defined( TIMER_TASK_STACK_DEPTH )
+ #define configTIMER_TASK_STACK_DEPTH            TIMER_TASK_STACK_DEPTH
+ #else
+ #define configTIMER_TASK_STACK_DEPTH            512
+ #endif
  
  /* Interrupt nesting behaviour configuration. */
  /*
@@ -102,9 +135,25 @@
  */
  
  /* SMP port only */
- #define configNUM_CORES                         1
- #define configTICK_CORE                         1
+ /* TRAFFIC_SMP is set by CMake (option TRAFFIC_SMP); 0 builds the single-core
+  * configuration used as the latency baseline. */
+ #ifndef TRAFFIC_SMP
+ #define TRAFFIC_SMP                             1
+ #endif
+ #if TRAFFIC_SMP
+ #define configNUMBER_OF_CORES                   2
+ #define configUSE_CORE_AFFINITY                 1
+ #else
+ #define configNUMBER_OF_CORES                   1
+ #endif
+ #define configNUM_CORES                         configNUMBER_OF_CORES
+ #define configTICK_CORE                         0
  #define configRUN_MULTIPLE_PRIORITIES           1
+ #define configUSE_PASSIVE_IDLE_HOOK             0
+ #if TRAFFIC_SMP
+ /* The timer service task runs the phase, buzzer and button timers. */
+ #define configTIMER_SERVICE_TASK_CORE_AFFINITY  ( 1 << 0 )
+ #endif
  
  /* RP2040 specific */
  #define configSUPPORT_PICO_SYNC_INTEROP         1
@@ -132,7 +181,19 @@
  #define INCLUDE_xTaskGetHandle                  1
  #define INCLUDE_xTaskResumeFromISR              1
  #define INCLUDE_xQueueGetMutexHolder            1
+ #define INCLUDE_xTimerGetTimerDaemonTaskHandle  1
  
  /* A header file that defines trace macro can be included here. */
+ /* TRAFFIC_TRACE is set by CMake (option TRAFFIC_TRACE). */
+ #ifndef TRAFFIC_TRACE
+ #define TRAFFIC_TRACE                           0
+ #endif
+ #if TRAFFIC_TRACE
+ #include "trace_recorder.h"
+ #else
+ #define traceTASK_SWITCHED_IN()                 cpu_stats_count_switch()
+ #define trace_isr_enter(isr)
+ #define trace_isr_exit(isr)
+ #endif
  
  #endif /* FREERTOS_CONFIG_H */
\ No newline at end of file
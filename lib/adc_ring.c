@@ -0,0 +1,36 @@
+#include "adc_ring.h"
+
+void adc_ring_init(adc_ring_t *ring, const volatile uint16_t *buffer, uint32_t size, uint8_t channels)
+{
+    ring->buffer = buffer;
+    ring->size = size;
+    ring->channels = channels;
+    ring->tail = 0;
+    ring->overruns = 0;
+}
+
+void adc_ring_restart(adc_ring_t *ring)
+{
+    ring->tail = 0;
+}
+
+uint32_t adc_ring_read(adc_ring_t *ring, uint32_t head, uint16_t *samples, uint32_t max)
+{
+    const uint32_t mask = ring->size - 1u;
+    uint32_t count = head - ring->tail;
+
+    if(count > ring->size - ring->channels)
+    {
+        // Atrasou mais que o buffer: pula para as amostras mais novas, mantendo o canal 0 no início
+        uint32_t tail = head - (ring->size - ring->channels);
+        tail += (ring->channels - tail % ring->channels) % ring->channels;
+        ring->overruns += tail - ring->tail;
+        ring->tail = tail;
+        count = head - tail;
+    }
+    if(count > max) count = max;
+    count -= count % ring->channels;
+    for(uint32_t i = 0; i < count; i++) samples[i] = ring->buffer[(ring->tail + i) & mask];
+    ring->tail += count;
+    return count;
+}
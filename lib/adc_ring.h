@@ -0,0 +1,62 @@
+#ifndef ADC_RING_H
+#define ADC_RING_H
+
+#include <stdint.h>
+
+/**
+ * @file adc_ring.h
+ * @brief Leitura de um buffer circular escrito por DMA, com amostras intercaladas.
+ *
+ * O DMA escreve as amostras em sequência, dando a volta no buffer, e o único
+ * sinal do produtor é o total de amostras escritas (o contador de
+ * transferências do canal). O leitor guarda quantas já entregou e copia as
+ * novas, sempre começando pelo canal 0 e em número múltiplo de canais. Se
+ * atrasar mais que o buffer, as amostras mais antigas já foram sobrescritas:
+ * o leitor pula para as mais novas, ainda começando pelo canal 0, e conta as
+ * descartadas.
+ *
+ * C puro, sem o Pico SDK (testável no Linux: tools/sim/detector_test.c); o
+ * DMA fica em lib/adc_sampler.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+/**
+ * @brief Leitor do buffer circular.
+ */
+typedef struct {
+    const volatile uint16_t *buffer;   /**< Buffer escrito pelo DMA */
+    uint32_t size;                     /**< Amostras no buffer (potência de 2) */
+    uint8_t channels;                  /**< Canais intercalados, a partir do 0 */
+    uint32_t tail;                     /**< Amostras já entregues desde o início do DMA */
+    uint32_t overruns;                 /**< Amostras descartadas porque o leitor atrasou */
+} adc_ring_t;
+
+/**
+ * @brief Inicia o leitor com o DMA no início do buffer.
+ *
+ * @param ring Leitor.
+ * @param buffer Buffer escrito pelo DMA.
+ * @param size Amostras no buffer (potência de 2, múltiplo de @p channels).
+ * @param channels Canais intercalados.
+ */
+void adc_ring_init(adc_ring_t *ring, const volatile uint16_t *buffer, uint32_t size, uint8_t channels);
+
+/**
+ * @brief Volta ao início do buffer quando o DMA é reiniciado (mantém as perdas).
+ */
+void adc_ring_restart(adc_ring_t *ring);
+
+/**
+ * @brief Copia as amostras novas.
+ *
+ * @param ring Leitor.
+ * @param head Amostras já escritas na RAM desde o início do DMA.
+ * @param samples Destino.
+ * @param max Capacidade de @p samples.
+ * @return Amostras copiadas, múltiplo do número de canais.
+ */
+uint32_t adc_ring_read(adc_ring_t *ring, uint32_t head, uint16_t *samples, uint32_t max);
+
+#endif // ADC_RING_H
@@ -0,0 +1,64 @@
+#include "adc_sampler.h"
+#include "adc_ring.h"
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+
+#define ADC_SAMPLER_CLOCK_HZ   48000000.0f   // clk_adc; cada conversão leva (1 + div) ciclos
+#define ADC_SAMPLER_TRANSFERS  0xFFFFFFFFu   // ~24 dias a 2 kHz; depois o canal é reiniciado
+
+static uint16_t sampler_ring[ADC_SAMPLER_RING_SAMPLES] __attribute__((aligned(1u << ADC_SAMPLER_RING_BITS)));
+static dma_channel_config sampler_config;
+static int sampler_dma = -1;
+static adc_ring_t sampler_reader;       // Amostras já entregues e descartadas
+
+/**
+ * @brief (Re)inicia a conversão a partir do canal 0, com o DMA no início do buffer.
+ */
+static void adc_sampler_start(void)
+{
+    adc_run(false);
+    adc_fifo_drain();
+    adc_select_input(0);
+    adc_ring_restart(&sampler_reader);
+    dma_channel_configure((uint) sampler_dma, &sampler_config, sampler_ring, &adc_hw->fifo,
+        ADC_SAMPLER_TRANSFERS, true);
+    adc_run(true);
+}
+
+void adc_sampler_init(void)
+{
+    adc_init();
+    for(uint i = 0; i < ADC_SAMPLER_CHANNELS; i++) adc_gpio_init(ADC_SAMPLER_FIRST_GPIO + i);
+    adc_set_round_robin((1u << ADC_SAMPLER_CHANNELS) - 1u);
+    adc_fifo_setup(true, true, 1, false, false);  // FIFO com DREQ a cada amostra, 12 bits
+    adc_set_clkdiv(ADC_SAMPLER_CLOCK_HZ / (ADC_SAMPLER_RATE_HZ * ADC_SAMPLER_CHANNELS) - 1.0f);
+
+    sampler_dma = dma_claim_unused_channel(true);
+    sampler_config = dma_channel_get_default_config((uint) sampler_dma);
+    channel_config_set_transfer_data_size(&sampler_config, DMA_SIZE_16);
+    channel_config_set_read_increment(&sampler_config, false);
+    channel_config_set_write_increment(&sampler_config, true);
+    channel_config_set_ring(&sampler_config, true, ADC_SAMPLER_RING_BITS);  // Escrita dá a volta no buffer
+    channel_config_set_dreq(&sampler_config, DREQ_ADC);
+    adc_ring_init(&sampler_reader, sampler_ring, ADC_SAMPLER_RING_SAMPLES, ADC_SAMPLER_CHANNELS);
+    adc_sampler_start();
+}
+
+uint32_t adc_sampler_read(uint16_t *samples, uint32_t max)
+{
+    uint32_t head = ADC_SAMPLER_TRANSFERS - dma_channel_hw_addr((uint) sampler_dma)->transfer_count;
+    uint32_t count;
+
+    // A última transferência contada pode ainda não ter sido escrita na RAM
+    if(head) head--;
+    count = adc_ring_read(&sampler_reader, head, samples, max);
+
+    if(!dma_channel_is_busy((uint) sampler_dma)) adc_sampler_start();
+    return count;
+}
+
+uint32_t adc_sampler_overruns(void)
+{
+    return sampler_reader.overruns;
+}
@@ -0,0 +1,51 @@
+#ifndef ADC_SAMPLER_H
+#define ADC_SAMPLER_H
+
+#include <stdint.h>
+
+/**
+ * @file adc_sampler.h
+ * @brief Amostragem contínua do ADC por DMA em buffer circular.
+ *
+ * O ADC roda livre em round-robin nos canais 0 e 1 (GPIO26 e GPIO27, o
+ * joystick da BitDogLab ou detectores de laço) e um canal de DMA copia cada
+ * resultado do FIFO para um buffer alinhado, usando o modo ring do DMA no
+ * endereço de escrita. Não há interrupção: o consumidor calcula quantas
+ * amostras chegaram pelo contador de transferências do canal e lê as novas
+ * com adc_sampler_read(). Se o consumidor atrasar mais que o buffer, as
+ * amostras mais antigas são descartadas e contadas em adc_sampler_overruns().
+ * A aritmética do buffer circular fica em lib/adc_ring, testável no Linux.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define ADC_SAMPLER_CHANNELS     2        /**< Canais em round-robin (ADC0 e ADC1) */
+#define ADC_SAMPLER_FIRST_GPIO   26       /**< GPIO do ADC0 */
+#define ADC_SAMPLER_RATE_HZ      1000     /**< Amostras por segundo, por canal */
+#define ADC_SAMPLER_RING_BITS    10       /**< Buffer de 2^10 bytes (512 amostras) */
+#define ADC_SAMPLER_RING_SAMPLES ((1u << ADC_SAMPLER_RING_BITS) / sizeof(uint16_t))
+
+/**
+ * @brief Configura o ADC e o DMA e inicia a amostragem.
+ */
+void adc_sampler_init(void);
+
+/**
+ * @brief Copia as amostras chegadas desde a última leitura.
+ *
+ * As amostras saem intercaladas, começando sempre pelo canal 0, e em número
+ * múltiplo de ADC_SAMPLER_CHANNELS. Só um consumidor pode chamar esta função.
+ *
+ * @param samples Destino.
+ * @param max Capacidade de @p samples.
+ * @return Número de amostras copiadas.
+ */
+uint32_t adc_sampler_read(uint16_t *samples, uint32_t max);
+
+/**
+ * @brief Amostras descartadas porque o consumidor atrasou.
+ */
+uint32_t adc_sampler_overruns(void);
+
+#endif // ADC_SAMPLER_H
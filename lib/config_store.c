@@ -0,0 +1,243 @@
+#include <string.h>
+#include "config_store.h"
+#include "crc.h"
+
+#define RECORDS_PER_SECTOR (FLASH_REGION_SECTOR_SIZE / CONFIG_STORE_RECORD_SIZE)
+#define RECORDS_PER_PAGE   (FLASH_REGION_PAGE_SIZE / CONFIG_STORE_RECORD_SIZE)
+#define NO_KEY             0xFFFFu   // Registro apagado
+
+/// Registro 0 de um setor
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;
+    uint8_t reserved[6];
+    uint16_t crc;
+} store_header_t;
+
+/// Registros 1 em diante
+typedef struct {
+    uint16_t key;
+    uint8_t len;
+    uint8_t reserved;
+    uint8_t value[CONFIG_STORE_VALUE_MAX];
+    uint16_t crc;
+} store_record_t;
+
+/// CRC dos bytes que antecedem o campo crc (os 2 últimos do registro)
+static uint16_t record_crc(const void *record)
+{
+    return crc16_ccitt_update(CRC16_CCITT_INIT, (const uint8_t *) record, CONFIG_STORE_RECORD_SIZE - 2u);
+}
+
+static uint32_t record_offset(uint8_t sector, uint16_t index)
+{
+    return (uint32_t) sector * FLASH_REGION_SECTOR_SIZE + (uint32_t) index * CONFIG_STORE_RECORD_SIZE;
+}
+
+static bool record_erased(const uint8_t *raw)
+{
+    for(uint8_t i = 0; i < CONFIG_STORE_RECORD_SIZE; i++)
+        if(raw[i] != 0xFF) return false;
+    return true;
+}
+
+static void encode_entry(store_record_t *record, const config_entry_t *entry)
+{
+    memset(record, 0, sizeof(*record));
+    record->key = entry->key;
+    record->len = entry->len;
+    memcpy(record->value, entry->value, entry->len);
+    record->crc = record_crc(record);
+}
+
+static config_entry_t *find_entry(config_store_t *store, uint16_t key)
+{
+    for(uint8_t i = 0; i < store->count; i++)
+        if(store->entries[i].key == key) return &store->entries[i];
+    return NULL;
+}
+
+/**
+ * @brief Grava um registro sozinho na sua página e confere a leitura.
+ *
+ * Os bytes da página fora do registro vão como 0xFF, que não altera a flash.
+ */
+static bool write_record(config_store_t *store, uint8_t sector, uint16_t index, const void *record)
+{
+    uint8_t *page = store->page;
+    uint32_t offset = record_offset(sector, index);
+    uint32_t in_page = offset % FLASH_REGION_PAGE_SIZE;
+
+    memset(page, 0xFF, FLASH_REGION_PAGE_SIZE);
+    memcpy(&page[in_page], record, CONFIG_STORE_RECORD_SIZE);
+    store->writes++;
+    if(!store->flash->program(store->flash, offset - in_page, page)) return false;
+    return memcmp(&store->flash->base[offset], record, CONFIG_STORE_RECORD_SIZE) == 0;
+}
+
+/**
+ * @brief Copia o cache para o próximo setor do rodízio e o torna ativo.
+ *
+ * O cabeçalho é gravado por último: se a cópia for interrompida, o setor
+ * ativo continua sendo o anterior.
+ */
+static bool compact(config_store_t *store)
+{
+    const flash_region_t *flash = store->flash;
+    uint8_t target = (store->sector == CONFIG_STORE_NO_SECTOR) ? 0 : (uint8_t) ((store->sector + 1u) % flash->sectors);
+    uint8_t *page = store->page;
+    store_header_t header;
+    uint8_t written = 0;
+
+    store->erases++;
+    if(!flash->erase(flash, record_offset(target, 0))) return false;
+    // Registros 1..count, uma página por gravação
+    for(uint16_t first = 0; written < store->count; first += RECORDS_PER_PAGE)
+    {
+        memset(page, 0xFF, FLASH_REGION_PAGE_SIZE);
+        for(uint16_t index = first; index < first + RECORDS_PER_PAGE && written < store->count; index++)
+        {
+            if(index == 0) continue;  // Cabeçalho
+            encode_entry((store_record_t *) &page[(index - first) * CONFIG_STORE_RECORD_SIZE], &store->entries[written++]);
+        }
+        store->writes++;
+        if(!flash->program(flash, record_offset(target, first), page)) return false;
+        if(memcmp(&flash->base[record_offset(target, first)], page, FLASH_REGION_PAGE_SIZE) != 0) return false;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic = CONFIG_STORE_MAGIC;
+    header.sequence = store->sequence + 1u;
+    header.crc = record_crc(&header);
+    if(!write_record(store, target, 0, &header)) return false;
+
+    store->sector = target;
+    store->sequence = header.sequence;
+    store->next = (uint16_t) (store->count + 1u);
+    return true;
+}
+
+void config_store_init(config_store_t *store, const flash_region_t *flash)
+{
+    store_header_t header;
+    store_record_t record;
+    uint16_t index;
+
+    store->flash = flash;
+    store->count = 0;
+    store->sector = CONFIG_STORE_NO_SECTOR;
+    store->sequence = 0;
+    store->next = 0;
+    store->bad_records = 0;
+    store->writes = 0;
+    store->erases = 0;
+
+    // Setor ativo: cabeçalho íntegro com o maior número de série (com volta)
+    for(uint8_t sector = 0; sector < flash->sectors; sector++)
+    {
+        memcpy(&header, &flash->base[record_offset(sector, 0)], sizeof(header));
+        if(header.magic != CONFIG_STORE_MAGIC || header.crc != record_crc(&header)) continue;
+        if(store->sector == CONFIG_STORE_NO_SECTOR || (int32_t) (header.sequence - store->sequence) > 0)
+        {
+            store->sector = sector;
+            store->sequence = header.sequence;
+        }
+    }
+    if(store->sector == CONFIG_STORE_NO_SECTOR) return;
+
+    for(index = 1; index < RECORDS_PER_SECTOR; index++)
+    {
+        const uint8_t *raw = &flash->base[record_offset(store->sector, index)];
+        if(record_erased(raw)) break;  // Fim do log
+        memcpy(&record, raw, sizeof(record));
+        if(record.crc != record_crc(&record) || record.key == NO_KEY
+            || record.len == 0 || record.len > CONFIG_STORE_VALUE_MAX)
+        {
+            store->bad_records++;
+            continue;
+        }
+        config_entry_t *entry = find_entry(store, record.key);
+        if(!entry)
+        {
+            if(store->count == CONFIG_STORE_MAX_KEYS)
+            {
+                store->bad_records++;
+                continue;
+            }
+            entry = &store->entries[store->count++];
+        }
+        entry->key = record.key;
+        entry->len = record.len;
+        memcpy(entry->value, record.value, sizeof(entry->value));
+    }
+    store->next = index;
+}
+
+bool config_store_get(const config_store_t *store, uint16_t key, void *value, uint8_t len)
+{
+    for(uint8_t i = 0; i < store->count; i++)
+    {
+        if(store->entries[i].key != key) continue;
+        if(store->entries[i].len != len) return false;
+        memcpy(value, store->entries[i].value, len);
+        return true;
+    }
+    return false;
+}
+
+bool config_store_set(config_store_t *store, uint16_t key, const void *value, uint8_t len)
+{
+    config_entry_t *entry;
+    config_entry_t saved;
+    store_record_t record;
+    bool added = false;
+    bool ok = false;
+
+    if(key == NO_KEY || len == 0 || len > CONFIG_STORE_VALUE_MAX) return false;
+    entry = find_entry(store, key);
+    if(entry && entry->len == len && memcmp(entry->value, value, len) == 0) return true;
+    if(!entry)
+    {
+        if(store->count == CONFIG_STORE_MAX_KEYS) return false;
+        entry = &store->entries[store->count++];
+        added = true;
+    }
+    saved = *entry;
+    memset(entry, 0, sizeof(*entry));
+    entry->key = key;
+    entry->len = len;
+    memcpy(entry->value, value, len);
+
+    // Acrescenta ao log; um registro que não confere é pulado
+    encode_entry(&record, entry);
+    while(!ok && store->sector != CONFIG_STORE_NO_SECTOR && store->next < RECORDS_PER_SECTOR)
+    {
+        ok = write_record(store, store->sector, store->next++, &record);
+        if(!ok) store->bad_records++;
+    }
+    // Setor cheio (ou região ainda não formatada): o cache já tem o novo valor
+    if(!ok) ok = compact(store);
+
+    if(!ok)
+    {
+        if(added) store->count--;
+        else *entry = saved;
+    }
+    return ok;
+}
+
+bool config_store_clear(config_store_t *store)
+{
+    uint8_t saved = store->count;
+
+    store->count = 0;
+    if(compact(store)) return true;
+    store->count = saved;
+    return false;
+}
+
+uint16_t config_store_free_records(const config_store_t *store)
+{
+    if(store->sector == CONFIG_STORE_NO_SECTOR) return 0;
+    return (uint16_t) (RECORDS_PER_SECTOR - store->next);
+}
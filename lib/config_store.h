@@ -0,0 +1,112 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_region.h"
+
+/**
+ * @file config_store.h
+ * @brief Armazenamento chave/valor em flash, em log com CRC e rodízio de setores.
+ *
+ * A região reservada tem CONFIG_STORE_MIN_SECTORS ou mais setores. Só um é o
+ * ativo: um cabeçalho (número mágico e número de série) seguido de registros
+ * de 16 bytes gravados em sequência, cada um com o seu CRC. Alterar um valor
+ * acrescenta um registro; o último registro íntegro de uma chave vence, e um
+ * registro cortado por falta de energia falha no CRC e é ignorado. Quando o
+ * setor enche, os valores vivos são copiados para o próximo setor do rodízio,
+ * cujo cabeçalho só é gravado no fim: até lá, o setor antigo continua valendo.
+ * Assim todos os setores são apagados igualmente (nivelamento de desgaste).
+ *
+ * Os valores ficam num cache em RAM, preenchido em config_store_init(), que só
+ * lê a flash; as leituras nunca tocam a flash. Cada operação de escrita chama
+ * o driver para apagar um setor ou gravar uma página, nunca mais de uma por
+ * vez, de modo que quem implementa o driver pode limitar o tempo em que a
+ * flash (e a execução a partir dela) fica parada.
+ *
+ * C puro, sem dependência do Pico SDK: testável no Linux com a flash simulada
+ * em RAM. Não é reentrante: um único escritor.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define CONFIG_STORE_RECORD_SIZE   16u     /**< Tamanho de um registro (e do cabeçalho) */
+#define CONFIG_STORE_VALUE_MAX     10u     /**< Maior valor, em bytes */
+#define CONFIG_STORE_MAX_KEYS      32u     /**< Máximo de chaves distintas */
+#define CONFIG_STORE_MIN_SECTORS   2u      /**< Setores mínimos da região (ativo e destino da cópia) */
+#define CONFIG_STORE_MAGIC         0x47464E43u  /**< "CNFG" */
+#define CONFIG_STORE_NO_SECTOR     0xFFu   /**< Nenhum setor formatado */
+
+/**
+ * @brief Valor de uma chave no cache.
+ */
+typedef struct {
+    uint16_t key;                            /**< Chave */
+    uint8_t len;                             /**< Tamanho do valor */
+    uint8_t value[CONFIG_STORE_VALUE_MAX];   /**< Valor */
+} config_entry_t;
+
+/**
+ * @brief Estado do armazenamento.
+ */
+typedef struct {
+    const flash_region_t *flash;                     /**< Região da flash */
+    config_entry_t entries[CONFIG_STORE_MAX_KEYS];   /**< Cache dos valores */
+    uint8_t count;                                   /**< Chaves no cache */
+    uint8_t sector;                                  /**< Setor ativo ou CONFIG_STORE_NO_SECTOR */
+    uint32_t sequence;                               /**< Número de série do setor ativo */
+    uint16_t next;                                   /**< Próximo registro livre no setor ativo */
+    uint32_t bad_records;                            /**< Registros com CRC inválido (leitura e verificação) */
+    uint32_t writes;                                 /**< Páginas gravadas desde o boot */
+    uint32_t erases;                                 /**< Setores apagados desde o boot */
+    uint8_t page[FLASH_REGION_PAGE_SIZE];             /**< Página em montagem (fora da pilha de quem grava) */
+} config_store_t;
+
+/**
+ * @brief Encontra o setor ativo e carrega os valores no cache. Só lê a flash.
+ *
+ * Uma região nunca formatada (ou corrompida) resulta num cache vazio; ela é
+ * formatada na primeira escrita.
+ *
+ * @param store Estado.
+ * @param flash Região da flash, com CONFIG_STORE_MIN_SECTORS ou mais setores (ponteiro mantido).
+ */
+void config_store_init(config_store_t *store, const flash_region_t *flash);
+
+/**
+ * @brief Lê um valor do cache.
+ *
+ * @param store Estado.
+ * @param key Chave.
+ * @param value Saída, com @p len bytes.
+ * @param len Tamanho esperado do valor.
+ * @return false se a chave não existe ou tem outro tamanho.
+ */
+bool config_store_get(const config_store_t *store, uint16_t key, void *value, uint8_t len);
+
+/**
+ * @brief Grava um valor. Não grava nada se o valor não mudou.
+ *
+ * @param store Estado.
+ * @param key Chave (0xFFFF é reservada).
+ * @param value Valor.
+ * @param len Tamanho, de 1 a CONFIG_STORE_VALUE_MAX.
+ * @return false se os argumentos são inválidos, o cache está cheio ou a
+ *         flash falhou; nesse caso o valor anterior continua valendo.
+ */
+bool config_store_set(config_store_t *store, uint16_t key, const void *value, uint8_t len);
+
+/**
+ * @brief Apaga todas as chaves (copia um conjunto vazio para o próximo setor).
+ *
+ * @return false se a flash falhou.
+ */
+bool config_store_clear(config_store_t *store);
+
+/**
+ * @brief Registros livres no setor ativo antes da próxima cópia.
+ */
+uint16_t config_store_free_records(const config_store_t *store);
+
+#endif // CONFIG_STORE_H
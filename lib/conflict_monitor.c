@@ -0,0 +1,155 @@
+#include "conflict_monitor.h"
+
+// Palavra do WS2812B: verde nos bits 31-24, vermelho em 23-16, azul em 15-8
+#define GRB_GREEN(word) (((word) >> 24) & 0xFFu)
+#define GRB_RED(word)   (((word) >> 16) & 0xFFu)
+#define GRB_BLUE(word)  (((word) >> 8) & 0xFFu)
+
+/**
+ * @brief Cor a partir das componentes acesas
+ */
+static uint8_t color_from_components(bool red, bool green, bool blue)
+{
+    if(!red && !green && !blue) return CONFLICT_COLOR_OFF;
+    if(red && green && blue) return CONFLICT_COLOR_WHITE;
+    if(blue) return CONFLICT_COLOR_INVALID;
+    if(red && green) return CONFLICT_COLOR_YELLOW;
+    return red ? CONFLICT_COLOR_RED : CONFLICT_COLOR_GREEN;
+}
+
+/**
+ * @brief Cor que um foco pode mostrar: apagado só na fase apagada do pisca, verde só fora dele
+ */
+static bool valid_head_color(uint8_t color, bool flash)
+{
+    if(color == CONFLICT_COLOR_OFF) return flash;
+    if(color == CONFLICT_COLOR_GREEN) return !flash;
+    return color == CONFLICT_COLOR_RED || color == CONFLICT_COLOR_YELLOW;
+}
+
+static bool permissive(uint8_t color)
+{
+    return color == CONFLICT_COLOR_GREEN || color == CONFLICT_COLOR_YELLOW;
+}
+
+void conflict_monitor_init(conflict_monitor_t *mon, const conflict_monitor_config_t *config)
+{
+    mon->config = config;
+    mon->streak = 0;
+    mon->fault = CONFLICT_FAULT_NONE;
+    mon->detail = 0;
+    mon->samples = 0;
+    mon->violations = 0;
+}
+
+uint8_t conflict_monitor_rgb_color(const uint16_t levels[3])
+{
+    return color_from_components(levels[0] != 0, levels[1] != 0, levels[2] != 0);
+}
+
+uint8_t conflict_monitor_pixel_color(uint32_t grb)
+{
+    return color_from_components(GRB_RED(grb) != 0, GRB_GREEN(grb) != 0, GRB_BLUE(grb) != 0);
+}
+
+uint8_t conflict_monitor_evaluate(const conflict_monitor_config_t *config,
+                                  const conflict_monitor_sample_t *sample, uint16_t *detail)
+{
+    uint8_t colors[CONFLICT_MONITOR_MAX_HEADS];
+    uint32_t head_pixels = 0;
+    bool ped_lit = false;
+
+    // Cor de cada foco: o seu LED da matriz e, se houver, o LED RGB
+    for(uint8_t h = 0; h < config->head_count; h++)
+    {
+        uint8_t pixel = config->pixel[h];
+        colors[h] = CONFLICT_COLOR_OFF;
+        if(pixel != CONFLICT_MONITOR_NO_PIXEL)
+        {
+            colors[h] = conflict_monitor_pixel_color(sample->frame[pixel]);
+            head_pixels |= 1u << pixel;
+        }
+        if(h == config->rgb_head)
+        {
+            uint8_t rgb = conflict_monitor_rgb_color(sample->rgb);
+            if(pixel != CONFLICT_MONITOR_NO_PIXEL && rgb != colors[h])
+            {
+                *detail = h;
+                return CONFLICT_FAULT_MISMATCH;
+            }
+            colors[h] = rgb;
+        }
+        if(!valid_head_color(colors[h], sample->flash))
+        {
+            *detail = h;
+            return CONFLICT_FAULT_INDICATION;
+        }
+    }
+
+    // Os outros LEDs: pedestre em branco, repetidores ou apagados
+    for(uint8_t pixel = 0; pixel < CONFLICT_MONITOR_PIXELS; pixel++)
+    {
+        if(head_pixels & (1u << pixel)) continue;
+        uint8_t color = conflict_monitor_pixel_color(sample->frame[pixel]);
+        if(color == CONFLICT_COLOR_OFF) continue;
+        if(color == CONFLICT_COLOR_WHITE && (config->ped_pixel == pixel || config->ped_pixel == CONFLICT_MONITOR_NO_PIXEL))
+        {
+            ped_lit = true;
+            continue;
+        }
+        if(pixel != config->ped_pixel && config->repeat_head != CONFLICT_MONITOR_NO_HEAD)
+        {
+            if(color == colors[config->repeat_head]) continue;
+            *detail = config->repeat_head;
+            return CONFLICT_FAULT_MISMATCH;
+        }
+        *detail = pixel;
+        return CONFLICT_FAULT_STRAY;
+    }
+
+    if(ped_lit && sample->flash)
+    {
+        *detail = CONFLICT_MONITOR_NO_HEAD;
+        return CONFLICT_FAULT_PEDESTRIAN;
+    }
+    for(uint8_t h = 0; h < config->head_count; h++)
+    {
+        if(!permissive(colors[h])) continue;
+        if(ped_lit && (config->ped_conflicts & (1u << h)))
+        {
+            *detail = h;
+            return CONFLICT_FAULT_PEDESTRIAN;
+        }
+        // O amarelo de todos os focos no modo piscante não é conflito
+        if(sample->flash) continue;
+        for(uint8_t other = (uint8_t) (h + 1u); other < config->head_count; other++)
+        {
+            if(permissive(colors[other]) && !(config->compatible[h] & (1u << other)))
+            {
+                *detail = (uint16_t) (h | (other << 8));
+                return CONFLICT_FAULT_CONFLICT;
+            }
+        }
+    }
+    return CONFLICT_FAULT_NONE;
+}
+
+bool conflict_monitor_check(conflict_monitor_t *mon, const conflict_monitor_sample_t *sample)
+{
+    uint16_t detail = 0;
+    uint8_t fault;
+
+    if(mon->fault != CONFLICT_FAULT_NONE) return false;
+    mon->samples++;
+    fault = conflict_monitor_evaluate(mon->config, sample, &detail);
+    if(fault == CONFLICT_FAULT_NONE)
+    {
+        mon->streak = 0;
+        return false;
+    }
+    mon->violations++;
+    if(++mon->streak < CONFLICT_MONITOR_DEBOUNCE) return false;
+    mon->fault = fault;
+    mon->detail = detail;
+    return true;
+}
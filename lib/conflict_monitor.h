@@ -0,0 +1,136 @@
+#ifndef CONFLICT_MONITOR_H
+#define CONFLICT_MONITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file conflict_monitor.h
+ * @brief Monitor de conflitos: confere as saídas lidas de volta contra uma
+ *        matriz de compatibilidade entre focos.
+ *
+ * O monitor não olha o estado do controlador, só o que foi comandado nas
+ * saídas: os níveis de PWM do LED RGB e o último quadro enviado à matriz de
+ * LEDs. Cada amostra é decodificada em uma cor por foco e verificada:
+ *
+ * - todo foco mostra exatamente uma cor válida (vermelho, amarelo ou verde);
+ *   apagado só é aceito no modo piscante;
+ * - o LED RGB e o LED da matriz de um mesmo foco mostram a mesma cor;
+ * - dois focos não compatíveis nunca estão em verde ou amarelo juntos;
+ * - o pedestre ("atravesse" ou limpeza, em branco) não acende com um foco
+ *   conflitante em verde ou amarelo;
+ * - no modo piscante (noturno) não há verde nem pedestre;
+ * - LEDs da matriz que não são de nenhum foco ficam apagados, ou repetem a cor
+ *   de um foco (contagem regressiva do semáforo simples).
+ *
+ * Uma violação só é confirmada depois de CONFLICT_MONITOR_DEBOUNCE amostras
+ * seguidas, e então fica travada até o reinício: quem chama deve levar as
+ * saídas para o vermelho piscante e não deixar mais ninguém escrevê-las.
+ *
+ * C puro, sem dependência do Pico SDK: testável no Linux.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define CONFLICT_MONITOR_MAX_HEADS  8      /**< Máximo de focos monitorados */
+#define CONFLICT_MONITOR_PIXELS     25     /**< LEDs da matriz */
+#define CONFLICT_MONITOR_NO_PIXEL   0xFF   /**< Foco sem LED na matriz, ou pedestre em qualquer LED */
+#define CONFLICT_MONITOR_NO_HEAD    0xFF   /**< Nenhum foco */
+#define CONFLICT_MONITOR_DEBOUNCE   3      /**< Amostras seguidas com violação para confirmar a falha */
+
+/**
+ * @brief Cor decodificada de uma saída.
+ */
+typedef enum {
+    CONFLICT_COLOR_OFF = 0,   /**< Apagada */
+    CONFLICT_COLOR_RED,       /**< Vermelho */
+    CONFLICT_COLOR_YELLOW,    /**< Amarelo (vermelho e verde) */
+    CONFLICT_COLOR_GREEN,     /**< Verde */
+    CONFLICT_COLOR_WHITE,     /**< Branco (pedestre) */
+    CONFLICT_COLOR_INVALID,   /**< Qualquer outra combinação */
+} conflict_color_t;
+
+/**
+ * @brief Falhas detectadas.
+ */
+typedef enum {
+    CONFLICT_FAULT_NONE = 0,     /**< Saídas seguras */
+    CONFLICT_FAULT_CONFLICT,     /**< Focos conflitantes liberados juntos (detalhe = foco | outro foco << 8) */
+    CONFLICT_FAULT_INDICATION,   /**< Foco apagado, com cor inválida ou verde no modo piscante (detalhe = foco) */
+    CONFLICT_FAULT_MISMATCH,     /**< LED RGB ou LED repetidor com outra cor que a do foco (detalhe = foco) */
+    CONFLICT_FAULT_PEDESTRIAN,   /**< Pedestre aceso com foco conflitante liberado ou no modo piscante (detalhe = foco) */
+    CONFLICT_FAULT_STRAY,        /**< LED da matriz fora dos focos aceso (detalhe = LED) */
+} conflict_fault_t;
+
+/**
+ * @brief Mapa das saídas e compatibilidade dos focos.
+ */
+typedef struct {
+    uint8_t head_count;                                  /**< Número de focos */
+    uint8_t pixel[CONFLICT_MONITOR_MAX_HEADS];           /**< LED da matriz de cada foco, ou CONFLICT_MONITOR_NO_PIXEL */
+    uint8_t compatible[CONFLICT_MONITOR_MAX_HEADS];      /**< Bit j: o foco pode estar liberado junto com o foco j */
+    uint8_t rgb_head;                                    /**< Foco repetido no LED RGB, ou CONFLICT_MONITOR_NO_HEAD */
+    uint8_t repeat_head;                                 /**< Foco repetido pelos outros LEDs acesos, ou CONFLICT_MONITOR_NO_HEAD */
+    uint8_t ped_pixel;                                   /**< LED do pedestre, ou CONFLICT_MONITOR_NO_PIXEL (qualquer LED branco) */
+    uint8_t ped_conflicts;                               /**< Focos que devem estar em vermelho com o pedestre aceso */
+} conflict_monitor_config_t;
+
+/**
+ * @brief Saídas lidas de volta.
+ */
+typedef struct {
+    uint16_t rgb[3];                                     /**< Níveis de PWM do LED RGB (vermelho, verde, azul) */
+    uint32_t frame[CONFLICT_MONITOR_PIXELS];             /**< Quadro da matriz (palavras GRB do WS2812B), na ordem de glyph */
+    bool flash;                                          /**< Saídas no modo piscante (noturno) */
+} conflict_monitor_sample_t;
+
+/**
+ * @brief Estado do monitor.
+ */
+typedef struct {
+    const conflict_monitor_config_t *config;   /**< Mapa das saídas */
+    uint8_t streak;                            /**< Amostras seguidas com violação */
+    uint8_t fault;                             /**< Falha travada (conflict_fault_t) */
+    uint16_t detail;                           /**< Detalhe da falha travada */
+    uint32_t samples;                          /**< Amostras verificadas */
+    uint32_t violations;                       /**< Amostras com violação (inclusive as não confirmadas) */
+} conflict_monitor_t;
+
+/**
+ * @brief Inicia o monitor sem falha.
+ *
+ * @param mon Estado.
+ * @param config Mapa das saídas (ponteiro mantido).
+ */
+void conflict_monitor_init(conflict_monitor_t *mon, const conflict_monitor_config_t *config);
+
+/**
+ * @brief Cor mostrada pelo LED RGB, a partir dos níveis de PWM.
+ */
+uint8_t conflict_monitor_rgb_color(const uint16_t levels[3]);
+
+/**
+ * @brief Cor de um LED da matriz, a partir da palavra GRB enviada ao WS2812B.
+ */
+uint8_t conflict_monitor_pixel_color(uint32_t grb);
+
+/**
+ * @brief Verifica uma amostra, sem filtro nem trava.
+ *
+ * @param config Mapa das saídas.
+ * @param sample Saídas lidas.
+ * @param detail Saída: detalhe da falha.
+ * @return conflict_fault_t da primeira violação encontrada.
+ */
+uint8_t conflict_monitor_evaluate(const conflict_monitor_config_t *config,
+                                  const conflict_monitor_sample_t *sample, uint16_t *detail);
+
+/**
+ * @brief Verifica uma amostra e trava a falha após CONFLICT_MONITOR_DEBOUNCE violações seguidas.
+ *
+ * @return true na amostra que trava a falha (só uma vez).
+ */
+bool conflict_monitor_check(conflict_monitor_t *mon, const conflict_monitor_sample_t *sample);
+
+#endif // CONFLICT_MONITOR_H
@@ -0,0 +1,65 @@
+#include "coordination.h"
+
+void coord_init(coord_t *coord, uint32_t cycle_ms, uint32_t offset_ms, uint32_t now_ms)
+{
+    coord->cycle_ms = cycle_ms;
+    coord->offset_ms = offset_ms;
+    coord->ref_ms = now_ms;
+    coord->synced = false;
+    coord->last_error_ms = 0;
+    coord->last_sync_ms = now_ms;
+    coord->correction_ms = 0;
+    coord->has_sync = false;
+}
+
+void coord_set_time(coord_t *coord, uint64_t time_ms, uint32_t now_ms)
+{
+    if(coord->cycle_ms == 0) return;
+    // Posição no ciclo agora: o ciclo começou há tanto tempo
+    uint32_t position = (uint32_t) ((time_ms + coord->cycle_ms - coord->offset_ms) % coord->cycle_ms);
+    coord->ref_ms = now_ms - position;
+    coord->synced = true;
+}
+
+void coord_resync(coord_t *coord)
+{
+    coord->correction_ms = 0;
+    coord->has_sync = false;
+}
+
+int32_t coord_sync_point(coord_t *coord, uint32_t start_ms, int32_t unapplied_ms)
+{
+    int32_t half = (int32_t) (coord->cycle_ms / 2u);
+    int32_t trim = 0;
+
+    if(coord->cycle_ms == 0) return 0;
+    // Diferença com sinal: o ponto pode estar antes da referência após um ajuste de relógio
+    int32_t position = (int32_t) (start_ms - coord->ref_ms) % (int32_t) coord->cycle_ms;
+    if(position < 0) position += (int32_t) coord->cycle_ms;
+    coord->ref_ms = start_ms - (uint32_t) position;  // Mantém a referência perto do presente
+
+    coord->last_error_ms = (position <= half) ? position : position - (int32_t) coord->cycle_ms;
+
+    // Sem correção, o próximo ciclo teria a duração natural do anterior
+    if(coord->has_sync)
+    {
+        int32_t natural = (int32_t) (start_ms - coord->last_sync_ms) - (coord->correction_ms - unapplied_ms);
+        trim = (int32_t) coord->cycle_ms - natural;
+        if(trim > half) trim = half;
+        if(trim < -half) trim = -half;
+    }
+    coord->last_sync_ms = start_ms;
+    coord->correction_ms = trim - coord->last_error_ms;
+    coord->has_sync = true;
+    return coord->correction_ms;
+}
+
+uint32_t coord_adjust(int32_t *pending_ms, uint32_t duration_ms, uint32_t min_ms, uint32_t max_ms)
+{
+    int32_t step = *pending_ms;
+
+    if(step > (int32_t) (max_ms - duration_ms)) step = (int32_t) (max_ms - duration_ms);
+    if(step < -(int32_t) (duration_ms - min_ms)) step = -(int32_t) (duration_ms - min_ms);
+    *pending_ms -= step;
+    return (uint32_t) ((int32_t) duration_ms + step);
+}
@@ -0,0 +1,102 @@
+#ifndef COORDINATION_H
+#define COORDINATION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file coordination.h
+ * @brief Coordenação por ciclo e defasagem (onda verde) sobre uma base de tempo absoluta.
+ *
+ * Cruzamentos vizinhos com o mesmo ciclo e defasagens escolhidas formam uma
+ * onda verde se todos contam o ciclo a partir do mesmo relógio. O ponto de
+ * sincronismo de um plano (início de uma fase ou cruzamento de uma barreira)
+ * deve cair nos instantes em que (tempo absoluto - defasagem) é múltiplo do
+ * ciclo. Em cada ponto de sincronismo o erro em relação a esse instante, mais
+ * a diferença entre o ciclo e a duração natural do ciclo anterior (fases
+ * puladas, gap-outs, travessias), vira uma correção gasta alongando ou
+ * encurtando as fases seguintes dentro dos seus limites mínimo e máximo: o
+ * controlador converge em um ciclo quando a correção cabe nos limites, e em
+ * alguns quando não cabe, sem saltos de fase.
+ *
+ * Sem sincronismo não há coordenação (coord_active()): um ciclo contado da
+ * partida não alinha nada com os vizinhos, e o plano roda livre, com as fases
+ * atuadas terminando por gap-out. O tempo local é o mesmo relógio em
+ * milissegundos do motor de fases; o tempo absoluto (por exemplo,
+ * milissegundos desde 1970) vem do host. C puro, testável no Linux.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+/**
+ * @brief Estado da coordenação.
+ */
+typedef struct {
+    uint32_t cycle_ms;        /**< Ciclo; 0 desliga a coordenação */
+    uint32_t offset_ms;       /**< Defasagem do ponto de sincronismo no ciclo */
+    uint32_t ref_ms;          /**< Início de ciclo (tempo local) mais recente conhecido */
+    bool synced;              /**< A referência veio de um tempo absoluto */
+    int32_t last_error_ms;    /**< Último erro medido (> 0: ponto de sincronismo atrasado) */
+    uint32_t last_sync_ms;    /**< Tempo local do último ponto de sincronismo */
+    int32_t correction_ms;    /**< Correção emitida no último ponto de sincronismo */
+    bool has_sync;            /**< last_sync_ms e correction_ms são válidos */
+} coord_t;
+
+/**
+ * @brief Liga a coordenação com o ciclo contado a partir de @p now_ms.
+ *
+ * @param coord Estado.
+ * @param cycle_ms Ciclo (0 desliga).
+ * @param offset_ms Defasagem, menor que o ciclo.
+ * @param now_ms Tempo local.
+ */
+void coord_init(coord_t *coord, uint32_t cycle_ms, uint32_t offset_ms, uint32_t now_ms);
+
+/**
+ * @brief Informa se o plano roda coordenado: tem ciclo e a referência veio de um tempo absoluto.
+ */
+static inline bool coord_active(const coord_t *coord)
+{
+    return coord->cycle_ms != 0 && coord->synced;
+}
+
+/**
+ * @brief Ancora o ciclo no tempo absoluto @p time_ms, lido no tempo local @p now_ms.
+ *
+ * Só move a referência; as fases em curso não mudam e o erro é corrigido aos
+ * poucos a partir do próximo ponto de sincronismo.
+ */
+void coord_set_time(coord_t *coord, uint64_t time_ms, uint32_t now_ms);
+
+/**
+ * @brief Esquece o último ponto de sincronismo depois de uma interrupção do
+ *        plano (preempção): o próximo ponto corrige só o erro de defasagem,
+ *        pelo menor caminho, sem compensar a duração do ciclo interrompido.
+ */
+void coord_resync(coord_t *coord);
+
+/**
+ * @brief Mede o erro de um ponto de sincronismo que ocorre em @p start_ms.
+ *
+ * @param coord Estado.
+ * @param start_ms Tempo local do ponto de sincronismo.
+ * @param unapplied_ms Parte da correção anterior que não coube nas fases.
+ * @return Correção a distribuir pelas fases seguintes, em milissegundos:
+ *         positiva para alongar (adiantado), negativa para encurtar (atrasado).
+ *         O menor dos dois caminhos é escolhido.
+ */
+int32_t coord_sync_point(coord_t *coord, uint32_t start_ms, int32_t unapplied_ms);
+
+/**
+ * @brief Aplica parte da correção pendente à duração de uma fase.
+ *
+ * @param pending_ms Correção pendente, descontada do que foi aplicado.
+ * @param duration_ms Duração planejada da fase.
+ * @param min_ms Duração mínima da fase.
+ * @param max_ms Duração máxima da fase.
+ * @return Duração corrigida, dentro de [min_ms, max_ms].
+ */
+uint32_t coord_adjust(int32_t *pending_ms, uint32_t duration_ms, uint32_t min_ms, uint32_t max_ms);
+
+#endif // COORDINATION_H
@@ -0,0 +1,162 @@
+#include "cpu_stats.h"
+#include "telemetry.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <string.h>
+
+volatile uint32_t cpu_stats_isr_time_us[CPU_STATS_ISR_COUNT];
+volatile uint32_t cpu_stats_context_switches[CPU_STATS_MAX_CORES];
+volatile uint32_t cpu_stats_isr_wcet_us[CPU_STATS_ISR_COUNT];
+volatile uint32_t cpu_stats_job_wcet_us[CPU_STATS_JOB_COUNT];
+
+static TaskStatus_t task_status[CPU_STATS_MAX_TASKS];                   // Evita ~600 bytes na pilha de quem chama
+static configRUN_TIME_COUNTER_TYPE last_task_time[CPU_STATS_MAX_TASKS + 1]; // Indexado pelo número da tarefa
+static uint32_t last_isr_time[CPU_STATS_ISR_COUNT];
+static uint32_t last_switches[CPU_STATS_MAX_CORES];
+static uint64_t last_report_us = 0;
+static uint32_t report_count = 0;
+
+/**
+ * @brief Verifica se a tarefa é a Idle de algum núcleo.
+ *
+ * @param task Handle da tarefa.
+ * @return Núcleo da Idle, ou -1 se não for uma tarefa Idle.
+ */
+static int cpu_stats_idle_core(TaskHandle_t task)
+{
+#if ( configNUMBER_OF_CORES > 1 )
+    for(BaseType_t core = 0; core < configNUMBER_OF_CORES; core++)
+        if(task == xTaskGetIdleTaskHandleForCore(core)) return (int) core;
+#else
+    if(task == xTaskGetIdleTaskHandle()) return 0;
+#endif
+    return -1;
+}
+
+/**
+ * @brief Converte um tempo em permilagem da janela, saturando em 1000.
+ */
+static uint16_t cpu_stats_permille(uint64_t time_us, uint64_t window_us)
+{
+    uint64_t permille = (time_us * 1000u + window_us / 2u) / window_us;
+    return (uint16_t) ((permille > 1000u) ? 1000u : permille);
+}
+
+/**
+ * @brief Envia a tabela número -> nome das tarefas já lidas em task_status.
+ */
+static void cpu_stats_send_names(UBaseType_t count)
+{
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+    size_t len = 0;
+
+    for(UBaseType_t i = 0; i < count; i++)
+    {
+        size_t name_len = strnlen(task_status[i].pcTaskName, configMAX_TASK_NAME_LEN);
+        if(len + 2 + name_len > sizeof(payload))
+        {
+            telemetry_send(TELEMETRY_TYPE_TASK_NAMES, payload, len);
+            len = 0;
+        }
+        payload[len++] = (uint8_t) task_status[i].xTaskNumber;
+        payload[len++] = (uint8_t) name_len;
+        memcpy(&payload[len], task_status[i].pcTaskName, name_len);
+        len += name_len;
+    }
+    if(len) telemetry_send(TELEMETRY_TYPE_TASK_NAMES, payload, len);
+}
+
+/**
+ * @brief Envia os maiores tempos observados de jobs e ISRs.
+ */
+static void cpu_stats_send_wcet(void)
+{
+    uint8_t payload[sizeof(cpu_stats_wcet_header_t) + (CPU_STATS_JOB_COUNT + CPU_STATS_ISR_COUNT) * sizeof(uint32_t)];
+    cpu_stats_wcet_header_t header = { .job_count = CPU_STATS_JOB_COUNT, .isr_count = CPU_STATS_ISR_COUNT };
+    size_t len = sizeof(header);
+
+    memcpy(payload, &header, sizeof(header));
+    for(uint8_t job = 0; job < CPU_STATS_JOB_COUNT; job++)
+    {
+        uint32_t wcet = cpu_stats_job_wcet_us[job];
+        memcpy(&payload[len], &wcet, sizeof(wcet));
+        len += sizeof(wcet);
+    }
+    for(uint8_t isr = 0; isr < CPU_STATS_ISR_COUNT; isr++)
+    {
+        uint32_t wcet = cpu_stats_isr_wcet_us[isr];
+        memcpy(&payload[len], &wcet, sizeof(wcet));
+        len += sizeof(wcet);
+    }
+    telemetry_send(TELEMETRY_TYPE_WCET, payload, len);
+}
+
+void cpu_stats_send_task_names(void)
+{
+    cpu_stats_send_names(uxTaskGetSystemState(task_status, CPU_STATS_MAX_TASKS, NULL));
+}
+
+void cpu_stats_report(void)
+{
+    uint8_t payload[sizeof(cpu_stats_header_t) + CPU_STATS_MAX_TASKS * sizeof(cpu_stats_task_entry_t)
+                    + CPU_STATS_ISR_COUNT * sizeof(cpu_stats_isr_entry_t)];
+    cpu_stats_header_t header = { 0 };
+    size_t len = sizeof(header);
+    uint64_t now_us = time_us_64();
+    uint64_t window_us = now_us - last_report_us;
+    UBaseType_t count = uxTaskGetSystemState(task_status, CPU_STATS_MAX_TASKS, NULL);
+
+    last_report_us = now_us;
+    if(report_count++ % CPU_STATS_NAMES_EVERY == 0) cpu_stats_send_names(count);
+    if(window_us == 0) return;
+
+    for(UBaseType_t i = 0; i < count; i++)
+    {
+        UBaseType_t number = task_status[i].xTaskNumber;
+        configRUN_TIME_COUNTER_TYPE delta = 0;
+        uint16_t permille;
+        int idle_core;
+
+        if(number <= CPU_STATS_MAX_TASKS)
+        {
+            delta = task_status[i].ulRunTimeCounter - last_task_time[number];
+            last_task_time[number] = task_status[i].ulRunTimeCounter;
+        }
+        permille = cpu_stats_permille(delta, window_us);
+
+        idle_core = cpu_stats_idle_core(task_status[i].xHandle);
+        if(idle_core >= 0 && idle_core < CPU_STATS_MAX_CORES)
+            header.idle_permille[idle_core] = permille;
+
+        cpu_stats_task_entry_t entry = { .task_number = (uint8_t) number, .permille = permille };
+        memcpy(&payload[len], &entry, sizeof(entry));
+        len += sizeof(entry);
+        header.task_count++;
+    }
+
+    for(uint8_t isr = 0; isr < CPU_STATS_ISR_COUNT; isr++)
+    {
+        uint32_t total = cpu_stats_isr_time_us[isr];
+        cpu_stats_isr_entry_t entry = {
+            .isr_id = isr,
+            .permille = cpu_stats_permille(total - last_isr_time[isr], window_us),
+        };
+        last_isr_time[isr] = total;
+        memcpy(&payload[len], &entry, sizeof(entry));
+        len += sizeof(entry);
+        header.isr_count++;
+    }
+
+    for(uint8_t core = 0; core < CPU_STATS_MAX_CORES; core++)
+    {
+        uint32_t total = cpu_stats_context_switches[core];
+        header.switches[core] = total - last_switches[core];
+        last_switches[core] = total;
+    }
+
+    header.window_us = (uint32_t) window_us;
+    header.cores = configNUMBER_OF_CORES;
+    memcpy(payload, &header, sizeof(header));
+    telemetry_send(TELEMETRY_TYPE_CPU_STATS, payload, len);
+    cpu_stats_send_wcet();
+}
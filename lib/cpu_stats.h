@@ -0,0 +1,169 @@
+#ifndef CPU_STATS_H
+#define CPU_STATS_H
+
+#include <stdint.h>
+#include "pico/stdlib.h"
+
+/**
+ * @file cpu_stats.h
+ * @brief Estatísticas de uso de CPU por tarefa, por ISR e da tarefa Idle.
+ *
+ * O contador de run-time do FreeRTOS é o timer de 64 bits em microssegundos do
+ * RP2040 (portGET_RUN_TIME_COUNTER_VALUE em FreeRTOSConfig.h). A cada chamada de
+ * cpu_stats_report() a diferença dos contadores desde a chamada anterior é
+ * convertida em permilagem de um núcleo e enviada como quadro
+ * TELEMETRY_TYPE_CPU_STATS.
+ *
+ * As ISRs da aplicação são medidas à parte com cpu_stats_isr_enter()/exit().
+ * O tempo de uma ISR também é contado para a tarefa que ela interrompeu, pois o
+ * kernel só contabiliza trocas de contexto.
+ *
+ * Cada job (callback de timer ou iteração de tarefa) marcado com
+ * cpu_stats_job_begin()/end() tem o maior tempo observado enviado no quadro
+ * TELEMETRY_TYPE_WCET, que alimenta tools/schedulability.py. O tempo medido é
+ * de relógio: inclui preempções e bloqueios dentro do job, portanto é um limite
+ * superior do tempo de execução.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define CPU_STATS_MAX_TASKS     16   /**< Máximo de tarefas relatadas por quadro */
+#define CPU_STATS_NAMES_EVERY   10   /**< Reenvia a tabela de nomes a cada N relatórios */
+#define CPU_STATS_MAX_CORES     2    /**< Núcleos do RP2040 */
+
+/**
+ * @brief Identificadores das ISRs instrumentadas.
+ */
+typedef enum {
+    CPU_STATS_ISR_GPIO = 0,   /**< Callback de GPIO (botões) */
+    CPU_STATS_ISR_MONITOR,    /**< Alarme do monitor de conflitos */
+    CPU_STATS_ISR_FLASH,      /**< Alarme do pisca (noturno e falha) */
+    CPU_STATS_ISR_COUNT
+} cpu_stats_isr_t;
+
+/**
+ * @brief Identificadores dos jobs medidos (nomes em tools/telemetry.py).
+ */
+typedef enum {
+    CPU_STATS_JOB_PHASE = 0,  /**< Callback do timer de fase */
+    CPU_STATS_JOB_BUZZER,     /**< Callback do timer do buzzer */
+    CPU_STATS_JOB_BUTTON,     /**< Callback do timer do botão */
+    CPU_STATS_JOB_DISPLAY,    /**< Atualização do OLED */
+    CPU_STATS_JOB_LOG,        /**< Iteração da tarefa de log */
+    CPU_STATS_JOB_DETECTOR,   /**< Callback do timer dos detectores */
+    CPU_STATS_JOB_SHELL,      /**< Linha de comando executada pelo shell */
+    CPU_STATS_JOB_COUNT
+} cpu_stats_job_t;
+
+/**
+ * @brief Cabeçalho do payload de TELEMETRY_TYPE_CPU_STATS.
+ *
+ * Seguido de task_count entradas cpu_stats_task_entry_t e isr_count entradas
+ * cpu_stats_isr_entry_t. Permilagens são relativas a um núcleo na janela.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t window_us;                            /**< Duração da janela */
+    uint8_t cores;                                 /**< Núcleos em uso */
+    uint8_t task_count;                            /**< Entradas de tarefa */
+    uint8_t isr_count;                             /**< Entradas de ISR */
+    uint16_t idle_permille[CPU_STATS_MAX_CORES];   /**< Ociosidade de cada núcleo */
+    uint32_t switches[CPU_STATS_MAX_CORES];        /**< Trocas de contexto de cada núcleo na janela */
+} cpu_stats_header_t;
+
+/**
+ * @brief Uso de CPU de uma tarefa na janela.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t task_number;   /**< Número da tarefa (ver TELEMETRY_TYPE_TASK_NAMES) */
+    uint16_t permille;     /**< Uso, em permilagem de um núcleo */
+} cpu_stats_task_entry_t;
+
+/**
+ * @brief Uso de CPU de uma ISR na janela.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t isr_id;        /**< cpu_stats_isr_t */
+    uint16_t permille;     /**< Uso, em permilagem de um núcleo */
+} cpu_stats_isr_entry_t;
+
+/** Trocas de contexto de cada núcleo desde o boot (com wrap), ver traceTASK_SWITCHED_IN. */
+extern volatile uint32_t cpu_stats_context_switches[CPU_STATS_MAX_CORES];
+
+/**
+ * @brief Cabeçalho do payload de TELEMETRY_TYPE_WCET.
+ *
+ * Seguido de job_count valores uint32_t (µs, na ordem de cpu_stats_job_t) e de
+ * isr_count valores uint32_t (µs, na ordem de cpu_stats_isr_t).
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t job_count;   /**< Entradas de job */
+    uint8_t isr_count;   /**< Entradas de ISR */
+} cpu_stats_wcet_header_t;
+
+/** Tempo acumulado de cada ISR, em microssegundos (com wrap). */
+extern volatile uint32_t cpu_stats_isr_time_us[CPU_STATS_ISR_COUNT];
+
+/** Maior duração observada de cada ISR, em microssegundos. */
+extern volatile uint32_t cpu_stats_isr_wcet_us[CPU_STATS_ISR_COUNT];
+
+/** Maior duração observada de cada job, em microssegundos. */
+extern volatile uint32_t cpu_stats_job_wcet_us[CPU_STATS_JOB_COUNT];
+
+/**
+ * @brief Marca a entrada em uma ISR instrumentada.
+ *
+ * @return Instante de entrada, a ser passado para cpu_stats_isr_exit().
+ */
+static inline uint32_t cpu_stats_isr_enter(void) { return time_us_32(); }
+
+/**
+ * @brief Acumula o tempo gasto em uma ISR instrumentada.
+ *
+ * @param isr Identificador da ISR.
+ * @param enter_us Valor retornado por cpu_stats_isr_enter().
+ */
+static inline void cpu_stats_isr_exit(cpu_stats_isr_t isr, uint32_t enter_us)
+{
+    uint32_t elapsed = time_us_32() - enter_us;
+    cpu_stats_isr_time_us[isr] += elapsed;
+    if(elapsed > cpu_stats_isr_wcet_us[isr]) cpu_stats_isr_wcet_us[isr] = elapsed;
+}
+
+/**
+ * @brief Marca o início de um job medido.
+ *
+ * @return Instante de início, a ser passado para cpu_stats_job_end().
+ */
+static inline uint32_t cpu_stats_job_begin(void) { return time_us_32(); }
+
+/**
+ * @brief Atualiza o maior tempo observado de um job.
+ *
+ * Cada job deve ser medido sempre pela mesma tarefa.
+ *
+ * @param job Identificador do job.
+ * @param begin_us Valor retornado por cpu_stats_job_begin().
+ */
+static inline void cpu_stats_job_end(cpu_stats_job_t job, uint32_t begin_us)
+{
+    uint32_t elapsed = time_us_32() - begin_us;
+    if(elapsed > cpu_stats_job_wcet_us[job]) cpu_stats_job_wcet_us[job] = elapsed;
+}
+
+/**
+ * @brief Envia a tabela número -> nome das tarefas (TELEMETRY_TYPE_TASK_NAMES).
+ *
+ * Deve ser chamada pela mesma tarefa que chama cpu_stats_report().
+ */
+void cpu_stats_send_task_names(void);
+
+/**
+ * @brief Calcula o uso de CPU desde a chamada anterior e envia por telemetria.
+ *
+ * Envia também o quadro TELEMETRY_TYPE_WCET. Deve ser chamada periodicamente
+ * por uma única tarefa.
+ */
+void cpu_stats_report(void);
+
+#endif // CPU_STATS_H
@@ -0,0 +1,27 @@
+#ifndef CRC_H
+#define CRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file crc.h
+ * @brief Cálculo de CRC usado nos quadros de telemetria.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define CRC16_CCITT_INIT 0xFFFFu  /**< Valor inicial do CRC-16/CCITT-FALSE */
+
+/**
+ * @brief Atualiza um CRC-16/CCITT-FALSE (polinômio 0x1021) com novos bytes.
+ *
+ * @param crc Valor atual (CRC16_CCITT_INIT no início).
+ * @param data Bytes a acumular.
+ * @param len Quantidade de bytes.
+ * @return CRC atualizado.
+ */
+uint16_t crc16_ccitt_update(uint16_t crc, const uint8_t *data, size_t len);
+
+#endif // CRC_H
@@ -0,0 +1,46 @@
+#include "detector.h"
+
+void detector_init(detector_t *det, const detector_config_t *config)
+{
+    det->config = config;
+    det->baseline_acc = 0;
+    det->baseline_count = 0;
+    det->baseline = 0;
+    det->level = 0;
+    det->present = false;
+    det->activations = 0;
+}
+
+bool detector_feed(detector_t *det, uint16_t sample)
+{
+    const detector_config_t *config = det->config;
+
+    if(det->baseline_count < config->baseline_samples)
+    {
+        det->baseline_acc += sample;
+        if(++det->baseline_count == config->baseline_samples)
+            det->baseline = (uint16_t) (det->baseline_acc / config->baseline_samples);
+        return false;
+    }
+
+    uint32_t deviation = (sample > det->baseline) ? sample - det->baseline : det->baseline - sample;
+    // IIR em ponto fixo (4 bits de fração): sobe e desce sem divisão
+    det->level = det->level - (det->level >> DETECTOR_FILTER_SHIFT) + ((deviation << 4) >> DETECTOR_FILTER_SHIFT);
+    if(!det->present && det->level >= ((uint32_t) config->on_level << 4))
+    {
+        det->present = true;
+        det->activations++;
+    }
+    else if(det->present && det->level < ((uint32_t) config->off_level << 4)) det->present = false;
+    return det->present;
+}
+
+uint32_t detector_feed_interleaved(detector_t *dets, uint8_t channels, const uint16_t *samples, uint32_t count)
+{
+    uint32_t mask = 0;
+
+    for(uint32_t i = 0; i < count; i++) detector_feed(&dets[i % channels], samples[i]);
+    for(uint8_t c = 0; c < channels; c++)
+        if(dets[c].present) mask |= 1u << c;
+    return mask;
+}
@@ -0,0 +1,70 @@
+#ifndef DETECTOR_H
+#define DETECTOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file detector.h
+ * @brief Filtro de presença de veículo a partir de amostras do ADC.
+ *
+ * Cada detector calibra uma linha de base com as primeiras amostras e passa o
+ * desvio absoluto em relação a ela por um filtro IIR de primeira ordem. A
+ * presença liga quando o nível filtrado passa de on_level e só desliga abaixo
+ * de off_level (histerese), o que serve tanto para o joystick da BitDogLab
+ * (desvio do centro) quanto para um laço indutivo com saída analógica.
+ *
+ * C puro, sem dependência do Pico SDK: testável no Linux.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define DETECTOR_FILTER_SHIFT 3   /**< Constante do IIR: nível += (desvio - nível) / 2^3 */
+
+/**
+ * @brief Parâmetros de um detector (contagens do ADC de 12 bits).
+ */
+typedef struct {
+    uint16_t on_level;           /**< Desvio filtrado que liga a presença */
+    uint16_t off_level;          /**< Desvio filtrado que desliga a presença */
+    uint16_t baseline_samples;   /**< Amostras usadas na calibração da linha de base */
+} detector_config_t;
+
+/**
+ * @brief Estado de um detector.
+ */
+typedef struct {
+    const detector_config_t *config;   /**< Parâmetros */
+    uint32_t baseline_acc;             /**< Soma das amostras de calibração */
+    uint16_t baseline_count;           /**< Amostras de calibração recebidas */
+    uint16_t baseline;                 /**< Linha de base (válida ao fim da calibração) */
+    uint32_t level;                    /**< Desvio filtrado, em 1/16 de contagem */
+    bool present;                      /**< Presença de veículo */
+    uint32_t activations;              /**< Vezes que a presença ligou */
+} detector_t;
+
+/**
+ * @brief Inicia um detector (recomeça a calibração).
+ */
+void detector_init(detector_t *det, const detector_config_t *config);
+
+/**
+ * @brief Processa uma amostra.
+ *
+ * @return Presença após a amostra.
+ */
+bool detector_feed(detector_t *det, uint16_t sample);
+
+/**
+ * @brief Processa amostras intercaladas de vários detectores.
+ *
+ * @param dets Detectores, um por canal.
+ * @param channels Número de canais (amostra i pertence ao canal i % channels).
+ * @param samples Amostras, começando pelo canal 0.
+ * @param count Número de amostras.
+ * @return Máscara de presença (bit n = detector n).
+ */
+uint32_t detector_feed_interleaved(detector_t *dets, uint8_t channels, const uint16_t *samples, uint32_t count);
+
+#endif // DETECTOR_H
@@ -0,0 +1,204 @@
+#include <string.h>
+#include "event_log.h"
+#include "crc.h"
+#include "telemetry.h"
+#include "pico/stdlib.h"
+
+#define HEADER_CRC_BYTES (sizeof(event_log_page_header_t) - sizeof(uint16_t))
+
+static uint16_t total_pages(const event_log_t *log)
+{
+    return (uint16_t) (log->flash->sectors * EVENT_LOG_PAGES_PER_SECTOR);
+}
+
+static const uint8_t *page_address(const event_log_t *log, uint16_t page)
+{
+    return &log->flash->base[(uint32_t) page * FLASH_REGION_PAGE_SIZE];
+}
+
+/**
+ * @brief Lê o cabeçalho de uma página; false se ela não tem um cabeçalho íntegro.
+ */
+static bool read_header(const event_log_t *log, uint16_t page, event_log_page_header_t *header)
+{
+    memcpy(header, page_address(log, page), sizeof(*header));
+    return header->magic == EVENT_LOG_MAGIC
+        && header->crc == crc16_ccitt_update(CRC16_CCITT_INIT, (const uint8_t *) header, HEADER_CRC_BYTES);
+}
+
+static bool page_erased(const event_log_t *log, uint16_t page)
+{
+    const uint8_t *data = page_address(log, page);
+
+    for(uint16_t i = 0; i < FLASH_REGION_PAGE_SIZE; i++)
+        if(data[i] != 0xFF) return false;
+    return true;
+}
+
+void event_log_init(event_log_t *log, const flash_region_t *flash)
+{
+    event_log_page_header_t header;
+    bool found = false;
+
+    log->lock = spin_lock_instance((uint) spin_lock_claim_unused(true));
+    log->head = 0;
+    log->tail = 0;
+    log->lost = 0;
+    log->flash = flash;
+    log->clock_us = time_us_64();
+    log->last_us = timer_hw->timerawl;
+    log->last_ms = 0;
+    log->sequence = 0;
+    log->page = 0;
+    log->boot = 0;
+    log->used = 0;
+    log->programmed = 0;
+    log->pages_written = 0;
+    log->flash_errors = 0;
+
+    // Página mais recente: maior número de série (com volta)
+    for(uint16_t page = 0; page < total_pages(log); page++)
+    {
+        if(!read_header(log, page, &header)) continue;
+        if(!found || (int32_t) (header.sequence - log->sequence) >= 0)
+        {
+            found = true;
+            log->page = page;
+            log->sequence = header.sequence;
+            log->boot = header.boot;
+        }
+    }
+    if(!found) return;
+    log->sequence++;
+    log->boot++;
+    // Continua na página seguinte; uma página parcialmente gravada (queda de
+    // energia) é pulada até o início do próximo setor, que será apagado
+    do log->page = (uint16_t) ((log->page + 1u) % total_pages(log));
+    while(log->page % EVENT_LOG_PAGES_PER_SECTOR != 0 && !page_erased(log, log->page));
+}
+
+/**
+ * @brief Grava os registros da página em montagem (os já gravados vão iguais)
+ */
+static void program_page(event_log_t *log)
+{
+    const flash_region_t *flash = log->flash;
+    uint32_t offset = (uint32_t) log->page * FLASH_REGION_PAGE_SIZE;
+
+    if(log->programmed == log->used) return;
+    if(log->programmed == 0 && log->page % EVENT_LOG_PAGES_PER_SECTOR == 0
+        && !flash->erase(flash, offset))
+        log->flash_errors++;
+    if(!flash->program(flash, offset, log->buffer)
+        || memcmp(page_address(log, log->page), log->buffer, FLASH_REGION_PAGE_SIZE) != 0)
+        log->flash_errors++;
+    log->programmed = log->used;
+}
+
+/**
+ * @brief Grava a página em montagem e passa para a próxima página do anel
+ */
+static void close_page(event_log_t *log)
+{
+    program_page(log);
+    log->pages_written++;
+    log->page = (uint16_t) ((log->page + 1u) % total_pages(log));
+    log->sequence++;
+    log->used = 0;
+    log->programmed = 0;
+}
+
+static void put_record(event_log_t *log, uint32_t time_ms, uint8_t code, uint8_t arg, uint32_t value)
+{
+    event_log_record_t record;
+
+    // Um intervalo que não cabe no delta vira uma marca de tempo (ou uma página nova)
+    if(log->used && time_ms - log->last_ms > UINT16_MAX)
+    {
+        if(log->used < EVENT_LOG_RECORDS_PER_PAGE - 1u)
+        {
+            put_record(log, log->last_ms, EVENT_LOG_TIME, 0, time_ms);
+            log->last_ms = time_ms;
+        }
+        else close_page(log);
+    }
+    if(log->used == 0)
+    {
+        event_log_page_header_t header = {
+            .magic = EVENT_LOG_MAGIC,
+            .sequence = log->sequence,
+            .base_ms = time_ms,
+            .boot = log->boot,
+        };
+        header.crc = crc16_ccitt_update(CRC16_CCITT_INIT, (const uint8_t *) &header, HEADER_CRC_BYTES);
+        memset(log->buffer, 0xFF, sizeof(log->buffer));
+        memcpy(log->buffer, &header, sizeof(header));
+        log->last_ms = time_ms;
+    }
+    record.delta_ms = (uint16_t) (time_ms - log->last_ms);
+    record.code = code;
+    record.arg = arg;
+    record.value = value;
+    memcpy(&log->buffer[sizeof(event_log_page_header_t) + log->used * sizeof(record)], &record, sizeof(record));
+    log->used++;
+    log->last_ms = time_ms;
+    if(log->used == EVENT_LOG_RECORDS_PER_PAGE) close_page(log);
+}
+
+void event_log_flush(event_log_t *log, bool partial)
+{
+    event_log_entry_t entry;
+
+    while(1)
+    {
+        uint32_t irq_state = spin_lock_blocking(log->lock);
+        if(log->head == log->tail)
+        {
+            // Sem eventos pendentes: acompanha o timer para não perder a volta
+            // dos 32 bits. Os descartes aconteceram depois dos eventos copiados.
+            uint32_t now_us = timer_hw->timerawl;
+            uint32_t lost = log->lost;
+            log->lost = 0;
+            spin_unlock(log->lock, irq_state);
+            log->clock_us += now_us - log->last_us;
+            log->last_us = now_us;
+            if(lost) put_record(log, (uint32_t) (log->clock_us / 1000u), EVENT_LOG_LOST, 0, lost);
+            break;
+        }
+        entry = log->ram[log->tail++ & (EVENT_LOG_RAM_SIZE - 1u)];
+        spin_unlock(log->lock, irq_state);
+
+        log->clock_us += entry.time_us - log->last_us;
+        log->last_us = entry.time_us;
+        put_record(log, (uint32_t) (log->clock_us / 1000u), entry.code, entry.arg, entry.value);
+    }
+    if(partial) program_page(log);
+}
+
+bool event_log_unsaved(const event_log_t *log)
+{
+    return log->programmed != log->used;
+}
+
+void event_log_dump(const event_log_t *log)
+{
+    event_log_page_header_t header;
+    event_log_frame_t frame;
+
+    // A página em montagem é a mais nova; as seguintes no anel são as mais antigas
+    for(uint16_t i = 1; i <= total_pages(log); i++)
+    {
+        uint16_t page = (uint16_t) ((log->page + i) % total_pages(log));
+        if(!read_header(log, page, &header)) continue;
+        frame.page = page;
+        for(frame.part = 0; frame.part < FLASH_REGION_PAGE_SIZE / EVENT_LOG_DUMP_PART; frame.part++)
+        {
+            memcpy(frame.data, page_address(log, page) + frame.part * EVENT_LOG_DUMP_PART, EVENT_LOG_DUMP_PART);
+            telemetry_send(TELEMETRY_TYPE_EVENT_LOG, &frame, sizeof(frame));
+        }
+    }
+    frame.page = EVENT_LOG_DUMP_END;
+    frame.part = 0;
+    memset(frame.data, 0xFF, sizeof(frame.data));
+    telemetry_send(TELEMETRY_TYPE_EVENT_LOG, &frame, sizeof(frame));
+}
@@ -0,0 +1,198 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/structs/timer.h"
+#include "hardware/sync.h"
+#include "flash_region.h"
+
+/**
+ * @file event_log.h
+ * @brief Log binário de eventos (transições, modos, falhas) em anel na flash.
+ *
+ * event_log_add() grava o evento, com o timestamp de 32 bits do timer de 1 µs,
+ * num anel em RAM: um spinlock de hardware com as interrupções desligadas, a
+ * leitura do TIMERAWL e um store de 12 bytes, então pode ser chamada de
+ * qualquer núcleo, tarefa ou ISR, inclusive dentro de seções críticas.
+ *
+ * event_log_flush(), chamada por uma única tarefa, esvazia o anel de RAM numa
+ * página de 256 bytes: um cabeçalho de 16 bytes (número de série, boot e
+ * instante do primeiro registro) e até EVENT_LOG_RECORDS_PER_PAGE registros
+ * de 8 bytes (delta em ms desde o registro anterior, código, argumentos). A
+ * página cheia é gravada de uma vez na região da flash, usada como anel: ao
+ * entrar num setor, ele é apagado, perdendo as páginas mais antigas. Uma
+ * página incompleta pode ser gravada antes (gravações seguintes da mesma
+ * página só acrescentam registros), e o fim dos registros de uma página é o
+ * primeiro código 0xFF.
+ *
+ * event_log_dump() envia as páginas em quadros TELEMETRY_TYPE_EVENT_LOG, do
+ * mais antigo ao mais novo; tools/event_log.py baixa e decodifica o log (ou
+ * uma imagem da região lida com o picotool).
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define EVENT_LOG_RAM_SIZE          64u          /**< Eventos no anel de RAM (potência de 2) */
+#define EVENT_LOG_RECORDS_PER_PAGE  30u          /**< Registros por página da flash */
+#define EVENT_LOG_PAGES_PER_SECTOR  (FLASH_REGION_SECTOR_SIZE / FLASH_REGION_PAGE_SIZE)
+#define EVENT_LOG_MAGIC             0x474C5645u  /**< "EVLG" */
+#define EVENT_LOG_DUMP_PART         128u         /**< Bytes de página por quadro do dump */
+#define EVENT_LOG_DUMP_END          0xFFFFu      /**< Página do quadro que encerra o dump */
+
+/**
+ * @brief Códigos de evento.
+ */
+typedef enum {
+    EVENT_LOG_TIME = 0,     /**< Marca de tempo após mais de 65 s sem eventos (value = ms desde o boot) */
+    EVENT_LOG_LOST,         /**< Eventos descartados com o anel de RAM cheio (value = quantidade) */
+    EVENT_LOG_BOOT,         /**< Partida (arg = 1 após reset do watchdog, value = culpado | resets << 8) */
+    EVENT_LOG_PHASE,        /**< Transição (arg = fase ou grupo do cruzamento, value = sinal | pedestre << 8 | focos << 16) */
+    EVENT_LOG_MODE,         /**< Troca de modo (arg = modo, value = 1 se pelo calendário) */
+    EVENT_LOG_PED_CALL,     /**< Botão de pedestre */
+    EVENT_LOG_PED_WALK,     /**< Travessia iniciada (value = espera em ms) */
+    EVENT_LOG_TIME_SYNC,    /**< Hora recebida do host (value = segundos desde 1970) */
+    EVENT_LOG_CONFIG,       /**< Configuração salva na flash (value = chave) */
+    EVENT_LOG_FAULT,        /**< Falha (arg = event_log_fault_t, value = detalhe) */
+    EVENT_LOG_DETECTOR,     /**< Veículo detectado, início da presença (arg = detector) */
+    EVENT_LOG_PREEMPT,      /**< Preempção pedida (arg = fase alvo, value = limite em ms até o verde) */
+    EVENT_LOG_PREEMPT_GREEN, /**< Verde da fase alvo (arg = fase, value = ms desde o pedido) */
+    EVENT_LOG_PREEMPT_END,  /**< Fim da preempção (arg = fase alvo, value = duração em ms) */
+    EVENT_LOG_PLAN,         /**< Troca de plano no início do ciclo (arg = plan_id_t, value = 1 se pelo calendário) */
+} event_log_code_t;
+
+/**
+ * @brief Falhas registradas com EVENT_LOG_FAULT.
+ */
+typedef enum {
+    EVENT_FAULT_LOG_DROPPED = 0,   /**< Mensagem do log de texto perdida (value = 0 pool cheio, 1 fila cheia) */
+    EVENT_FAULT_CONFIG_DISCARDED,  /**< Durações salvas inválidas para o plano */
+    EVENT_FAULT_FLASH,             /**< Gravação da flash falhou (value = chave da configuração) */
+    EVENT_FAULT_CONFLICT,          /**< Monitor de conflitos em falha (value = conflict_fault_t | detalhe << 8) */
+} event_log_fault_t;
+
+/**
+ * @brief Cabeçalho de uma página na flash (16 bytes).
+ */
+typedef struct {
+    uint32_t magic;        /**< EVENT_LOG_MAGIC */
+    uint32_t sequence;     /**< Número de série da página, crescente entre boots */
+    uint32_t base_ms;      /**< Instante do primeiro registro, em ms desde o boot */
+    uint16_t boot;         /**< Número do boot que gravou a página */
+    uint16_t crc;          /**< CRC-16/CCITT-FALSE dos 14 bytes anteriores */
+} event_log_page_header_t;
+
+/**
+ * @brief Registro na flash (8 bytes).
+ */
+typedef struct {
+    uint16_t delta_ms;     /**< Tempo desde o registro anterior (ou base_ms) */
+    uint8_t code;          /**< event_log_code_t; 0xFF marca o fim da página */
+    uint8_t arg;           /**< Argumento curto */
+    uint32_t value;        /**< Argumento longo */
+} event_log_record_t;
+
+/**
+ * @brief Evento no anel de RAM (12 bytes).
+ */
+typedef struct {
+    uint32_t time_us;      /**< 32 bits baixos do timer de 1 µs */
+    uint8_t code;
+    uint8_t arg;
+    uint16_t reserved;
+    uint32_t value;
+} event_log_entry_t;
+
+/**
+ * @brief Payload de TELEMETRY_TYPE_EVENT_LOG: metade de uma página da flash.
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t page;                        /**< Página na região, ou EVENT_LOG_DUMP_END */
+    uint8_t part;                         /**< Metade da página (0 ou 1) */
+    uint8_t data[EVENT_LOG_DUMP_PART];    /**< Bytes da página */
+} event_log_frame_t;
+
+/**
+ * @brief Estado do log.
+ */
+typedef struct {
+    // Anel de RAM, protegido por lock
+    spin_lock_t *lock;                             /**< Spinlock de hardware do anel */
+    event_log_entry_t ram[EVENT_LOG_RAM_SIZE];     /**< Eventos ainda não copiados para a página */
+    uint32_t head;                                 /**< Próximo evento a gravar */
+    uint32_t tail;                                 /**< Próximo evento a copiar */
+    uint32_t lost;                                 /**< Eventos descartados ainda não registrados */
+    // Página e anel na flash, só da tarefa que chama event_log_flush()
+    const flash_region_t *flash;                   /**< Região da flash */
+    uint64_t clock_us;                             /**< Tempo desde o boot do último evento copiado */
+    uint32_t last_us;                              /**< TIMERAWL correspondente a clock_us */
+    uint32_t last_ms;                              /**< Instante do último registro da página */
+    uint32_t sequence;                             /**< Número de série da página em montagem */
+    uint16_t page;                                 /**< Página da região em montagem */
+    uint16_t boot;                                 /**< Número deste boot */
+    uint8_t used;                                  /**< Registros na página em montagem */
+    uint8_t programmed;                            /**< Registros da página já gravados */
+    uint32_t pages_written;                        /**< Páginas completas gravadas desde o boot */
+    uint32_t flash_errors;                         /**< Gravações ou apagamentos que falharam */
+    uint8_t buffer[FLASH_REGION_PAGE_SIZE];        /**< Página em montagem */
+} event_log_t;
+
+/**
+ * @brief Localiza a página mais recente na flash e prepara o log deste boot. Só lê a flash.
+ *
+ * @param log Estado.
+ * @param flash Região da flash (ponteiro mantido).
+ */
+void event_log_init(event_log_t *log, const flash_region_t *flash);
+
+/**
+ * @brief Grava um evento no anel de RAM. Nunca bloqueia; se o anel está cheio
+ *        o evento é contado e registrado depois como EVENT_LOG_LOST.
+ *
+ * @param log Estado.
+ * @param code Código (event_log_code_t).
+ * @param arg Argumento curto.
+ * @param value Argumento longo.
+ */
+static inline void event_log_add(event_log_t *log, uint8_t code, uint8_t arg, uint32_t value)
+{
+    uint32_t irq_state = spin_lock_blocking(log->lock);
+    if(log->head - log->tail < EVENT_LOG_RAM_SIZE)
+    {
+        event_log_entry_t *entry = &log->ram[log->head++ & (EVENT_LOG_RAM_SIZE - 1u)];
+        entry->time_us = timer_hw->timerawl;
+        entry->code = code;
+        entry->arg = arg;
+        entry->value = value;
+    }
+    else log->lost++;
+    spin_unlock(log->lock, irq_state);
+}
+
+/**
+ * @brief Copia o anel de RAM para a página e grava as páginas completas.
+ *
+ * Deve ser chamada por uma única tarefa, com frequência suficiente para o anel
+ * de RAM não encher e pelo menos a cada hora (o timestamp de 32 bits dá a volta
+ * em 71 minutos).
+ *
+ * @param log Estado.
+ * @param partial Grava também a página incompleta.
+ */
+void event_log_flush(event_log_t *log, bool partial);
+
+/**
+ * @brief Informa se há registros da página ainda não gravados.
+ */
+bool event_log_unsaved(const event_log_t *log);
+
+/**
+ * @brief Envia todas as páginas da flash por telemetria, da mais antiga à mais nova.
+ *
+ * Chame event_log_flush() com partial = true antes para incluir os eventos
+ * recentes. Termina com um quadro de página EVENT_LOG_DUMP_END.
+ */
+void event_log_dump(const event_log_t *log);
+
+#endif // EVENT_LOG_H
@@ -0,0 +1,39 @@
+#ifndef FLASH_REGION_H
+#define FLASH_REGION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file flash_region.h
+ * @brief Região reservada da flash, com o driver de apagamento e gravação.
+ *
+ * Os módulos que gravam na flash (config_store, event_log) recebem a região
+ * e só apagam um setor ou gravam uma página por chamada do driver; no
+ * firmware o driver para o outro núcleo durante cada operação. A leitura é
+ * direta pelo endereço mapeado (XIP). Sem dependência do Pico SDK: no Linux a
+ * região pode ser um vetor em RAM.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define FLASH_REGION_SECTOR_SIZE 4096u   /**< Menor unidade apagável */
+#define FLASH_REGION_PAGE_SIZE   256u    /**< Unidade de gravação */
+
+typedef struct flash_region flash_region_t;
+
+/**
+ * @brief Região da flash. Os deslocamentos dos callbacks são relativos ao início da região.
+ */
+struct flash_region {
+    const uint8_t *base;     /**< Região mapeada em memória, para leitura */
+    uint32_t offset;         /**< Início da região na flash (uso do driver) */
+    uint8_t sectors;         /**< Setores da região */
+    /** Apaga o setor que começa em @p offset; false em caso de falha */
+    bool (*erase)(const flash_region_t *region, uint32_t offset);
+    /** Grava uma página de FLASH_REGION_PAGE_SIZE bytes em @p offset; false em caso de falha */
+    bool (*program)(const flash_region_t *region, uint32_t offset, const uint8_t *page);
+};
+
+#endif // FLASH_REGION_H
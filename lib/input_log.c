@@ -0,0 +1,462 @@
+#include <string.h>
+#include "input_log.h"
+
+#define HEADER_BYTES    23u     // magic, série, controlador, fases, base_ms, base de µs, ponto de verificação, plano
+#define CHECKPOINT_MAX  512u    // Maior ponto de verificação (16 fases: durações e rotas)
+
+/**
+ * @brief Cursor do ponto de verificação: o mesmo código grava e restaura o estado.
+ */
+typedef struct {
+    uint8_t *p;
+    bool load;
+} cursor_t;
+
+/**
+ * @brief Grava ou lê um campo de 1, 2 ou 4 bytes, em little-endian.
+ */
+static void field(cursor_t *c, void *value, uint8_t size)
+{
+    uint32_t v = 0;
+
+    if(c->load)
+    {
+        for(uint8_t i = 0; i < size; i++) v |= (uint32_t) c->p[i] << (8u * i);
+        if(size == 1) *(uint8_t *) value = (uint8_t) v;
+        else if(size == 2) *(uint16_t *) value = (uint16_t) v;
+        else *(uint32_t *) value = v;
+    }
+    else
+    {
+        if(size == 1) v = *(const uint8_t *) value;
+        else if(size == 2) v = *(const uint16_t *) value;
+        else v = *(const uint32_t *) value;
+        for(uint8_t i = 0; i < size; i++) c->p[i] = (uint8_t) (v >> (8u * i));
+    }
+    c->p += size;
+}
+
+#define FIELD(c, x) field((c), &(x), sizeof(x))
+
+static void coord_fields(cursor_t *c, coord_t *coord)
+{
+    FIELD(c, coord->cycle_ms);
+    FIELD(c, coord->offset_ms);
+    FIELD(c, coord->ref_ms);
+    FIELD(c, coord->synced);
+    FIELD(c, coord->last_error_ms);
+    FIELD(c, coord->last_sync_ms);
+    FIELD(c, coord->correction_ms);
+    FIELD(c, coord->has_sync);
+}
+
+/**
+ * @brief Ponto de verificação do motor: durações do plano e todo o estado.
+ *
+ * Gravando, nada é alterado (os ponteiros só perdem o const para o cursor).
+ * @return Bytes.
+ */
+static uint16_t engine_fields(uint8_t *data, bool load, const phase_plan_t *plan, phase_def_t *phases,
+    phase_engine_t *engine)
+{
+    cursor_t c = { data, load };
+    bool started = engine->plan != NULL;
+
+    for(uint8_t i = 0; i < plan->count; i++)
+    {
+        FIELD(&c, phases[i].min_s);
+        FIELD(&c, phases[i].max_s);
+        FIELD(&c, phases[i].default_s);
+    }
+    FIELD(&c, started);
+    if(load) engine->plan = started ? plan : NULL;
+    FIELD(&c, engine->phase);
+    FIELD(&c, engine->start_ms);
+    FIELD(&c, engine->duration_ms);
+    FIELD(&c, engine->transitions);
+    FIELD(&c, engine->gap_outs);
+    FIELD(&c, engine->max_outs);
+    FIELD(&c, engine->calls);
+    coord_fields(&c, &engine->coord);
+    FIELD(&c, engine->correction_ms);
+    FIELD(&c, engine->preempt);
+    FIELD(&c, engine->preemptions);
+    // As rotas da preempção são calculadas na partida, com o plano de então
+    for(uint8_t i = 0; i < plan->count; i++)
+        for(uint8_t j = 0; j < plan->count; j++) FIELD(&c, engine->route[i][j]);
+    return (uint16_t) (c.p - data);
+}
+
+/**
+ * @brief Ponto de verificação do cruzamento, como engine_fields().
+ */
+static uint16_t rb_fields(uint8_t *data, bool load, const rb_plan_t *plan, rb_phase_def_t *phases,
+    rb_controller_t *ctrl)
+{
+    cursor_t c = { data, load };
+    bool started = ctrl->plan != NULL;
+
+    for(uint8_t i = 0; i < plan->phase_count; i++)
+    {
+        FIELD(&c, phases[i].min_green_ds);
+        FIELD(&c, phases[i].max_green_ds);
+        FIELD(&c, phases[i].green_ds);
+    }
+    FIELD(&c, started);
+    if(load) ctrl->plan = started ? plan : NULL;
+    FIELD(&c, ctrl->group);
+    FIELD(&c, ctrl->calls);
+    for(uint8_t i = 0; i < plan->phase_count; i++) FIELD(&c, ctrl->signals[i]);
+    for(uint8_t r = 0; r < RB_RINGS; r++)
+    {
+        FIELD(&c, ctrl->rings[r].slot);
+        FIELD(&c, ctrl->rings[r].interval);
+        FIELD(&c, ctrl->rings[r].start_ms);
+        FIELD(&c, ctrl->rings[r].duration_ms);
+        FIELD(&c, ctrl->rings[r].correction_ms);
+    }
+    FIELD(&c, ctrl->transitions);
+    FIELD(&c, ctrl->gap_outs);
+    FIELD(&c, ctrl->max_outs);
+    coord_fields(&c, &ctrl->coord);
+    FIELD(&c, ctrl->preempt);
+    FIELD(&c, ctrl->preemptions);
+    return (uint16_t) (c.p - data);
+}
+
+/**
+ * @brief Ponto de verificação do estado atual do log.
+ */
+static uint16_t checkpoint(const input_log_t *log, uint8_t *data)
+{
+    if(log->controller == INPUT_LOG_RING_BARRIER)
+    {
+        const rb_plan_t *plan = log->plan;
+        return rb_fields(data, false, plan, (rb_phase_def_t *) plan->phases, (rb_controller_t *) log->state);
+    }
+    const phase_plan_t *plan = log->plan;
+    return engine_fields(data, false, plan, (phase_def_t *) plan->phases, (phase_engine_t *) log->state);
+}
+
+static uint8_t plan_phase_count(const input_log_t *log)
+{
+    if(log->controller == INPUT_LOG_RING_BARRIER) return ((const rb_plan_t *) log->plan)->phase_count;
+    return ((const phase_plan_t *) log->plan)->count;
+}
+
+static void put_le(uint8_t *data, uint64_t value, uint8_t size)
+{
+    for(uint8_t i = 0; i < size; i++) data[i] = (uint8_t) (value >> (8u * i));
+}
+
+static uint64_t get_le(const uint8_t *data, uint8_t size)
+{
+    uint64_t value = 0;
+
+    for(uint8_t i = 0; i < size; i++) value |= (uint64_t) data[i] << (8u * i);
+    return value;
+}
+
+static uint8_t put_varint(uint8_t *data, uint64_t value)
+{
+    uint8_t len = 0;
+
+    while(value >= 0x80u)
+    {
+        data[len++] = (uint8_t) (value | 0x80u);
+        value >>= 7;
+    }
+    data[len++] = (uint8_t) value;
+    return len;
+}
+
+static bool get_varint(input_log_reader_t *reader, uint64_t *value)
+{
+    *value = 0;
+    for(uint8_t shift = 0; shift < 64; shift += 7)
+    {
+        if(reader->pos >= INPUT_LOG_BLOCK_SIZE) return false;
+        uint8_t byte = reader->block[reader->pos++];
+        *value |= (uint64_t) (byte & 0x7Fu) << shift;
+        if(!(byte & 0x80u)) return true;
+    }
+    return false;
+}
+
+static inline uint64_t zigzag(int64_t value)
+{
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t value)
+{
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1u);
+}
+
+static inline bool is_external(uint8_t kind)
+{
+    return kind != INPUT_LOG_UPDATE && kind != INPUT_LOG_EXPIRE && kind != INPUT_LOG_OUTPUT;
+}
+
+/**
+ * @brief Diferença entre o timer de µs e o relógio do controlador (com volta em 64 bits)
+ */
+static inline uint64_t skew_us(uint64_t time_us, uint32_t time_ms)
+{
+    return time_us - (uint64_t) time_ms * 1000u;
+}
+
+/**
+ * @brief Passa para o próximo bloco do anel e grava o cabeçalho e o ponto de verificação.
+ */
+static void begin_block(input_log_t *log)
+{
+    if(log->count)
+    {
+        log->block = (uint8_t) ((log->block + 1u) % INPUT_LOG_BLOCKS);
+        log->sequence++;
+    }
+    if(log->count == INPUT_LOG_BLOCKS) log->blocks_lost++;
+    else log->count++;
+
+    uint8_t *data = log->blocks[log->block];
+    memset(data, 0, INPUT_LOG_BLOCK_SIZE);
+    put_le(&data[0], INPUT_LOG_MAGIC, 2);
+    put_le(&data[2], log->sequence, 4);
+    data[6] = log->controller;
+    data[7] = plan_phase_count(log);
+    put_le(&data[8], log->last_ms, 4);
+    put_le(&data[12], log->last_skew_us, 8);
+    uint16_t size = checkpoint(log, &data[HEADER_BYTES]);
+    put_le(&data[20], size, 2);
+    data[22] = log->plan_id;
+    log->used = (uint16_t) (HEADER_BYTES + size);
+    log->update_count_pos = 0;
+}
+
+static void init_log(input_log_t *log, uint8_t controller, const void *plan, const void *state)
+{
+    memset(log, 0, sizeof(*log));
+    log->controller = controller;
+    log->plan = plan;
+    log->state = state;
+}
+
+void input_log_init_engine(input_log_t *log, const phase_plan_t *plan, const phase_engine_t *engine)
+{
+    init_log(log, INPUT_LOG_ENGINE, plan, engine);
+}
+
+void input_log_init_rb(input_log_t *log, const rb_plan_t *plan, const rb_controller_t *ctrl)
+{
+    init_log(log, INPUT_LOG_RING_BARRIER, plan, ctrl);
+}
+
+void input_log_set_plan(input_log_t *log, uint8_t plan_id, const void *plan)
+{
+    log->plan_id = plan_id;
+    log->plan = plan;
+}
+
+void input_log_add(input_log_t *log, const input_log_record_t *record)
+{
+    uint8_t buffer[INPUT_LOG_RECORD_MAX];
+    uint8_t len = 0;
+    uint32_t delta_ms = record->time_ms - log->last_ms;
+    uint64_t skew = log->last_skew_us;
+
+    if(log->plan == NULL) return;
+    log->records++;
+    // Avanço com o mesmo intervalo do anterior: só o contador
+    if(record->kind == INPUT_LOG_UPDATE && log->update_count_pos && delta_ms == log->update_delta_ms
+        && log->blocks[log->block][log->update_count_pos] < UINT8_MAX)
+    {
+        log->blocks[log->block][log->update_count_pos]++;
+        log->last_ms = record->time_ms;
+        return;
+    }
+
+    buffer[len++] = record->kind;
+    if(record->kind == INPUT_LOG_UPDATE) buffer[len++] = 1;
+    if(record->kind != INPUT_LOG_OUTPUT) len += put_varint(&buffer[len], zigzag((int32_t) delta_ms));
+    if(is_external(record->kind))
+    {
+        skew = skew_us(record->time_us, record->time_ms);
+        len += put_varint(&buffer[len], zigzag((int64_t) (skew - log->last_skew_us)));
+    }
+    switch(record->kind)
+    {
+        case INPUT_LOG_CALL:
+        case INPUT_LOG_PREEMPT:
+        case INPUT_LOG_PLAN:
+            buffer[len++] = record->arg;
+            break;
+        case INPUT_LOG_RESUME:
+        case INPUT_LOG_OUTPUT:
+            buffer[len++] = record->arg;
+            len += put_varint(&buffer[len], record->value);
+            break;
+        case INPUT_LOG_PRESENCE:
+        case INPUT_LOG_SET_TIME:
+            len += put_varint(&buffer[len], record->value);
+            break;
+        case INPUT_LOG_DURATIONS:
+            buffer[len++] = record->arg;
+            for(uint8_t i = 0; i < 3; i++) len += put_varint(&buffer[len], record->durations[i]);
+            break;
+        default:
+            break;
+    }
+
+    // Os deltas continuam valendo no bloco novo: a base dele é o registro anterior
+    if(log->count == 0 || log->used + len > INPUT_LOG_BLOCK_SIZE) begin_block(log);
+    memcpy(&log->blocks[log->block][log->used], buffer, len);
+    log->update_count_pos = (record->kind == INPUT_LOG_UPDATE) ? (uint16_t) (log->used + 1u) : 0;
+    log->update_delta_ms = delta_ms;
+    log->used = (uint16_t) (log->used + len);
+    log->last_ms = record->time_ms;
+    log->last_skew_us = skew;
+}
+
+uint8_t input_log_block_count(const input_log_t *log)
+{
+    return log->count;
+}
+
+const uint8_t *input_log_block(const input_log_t *log, uint8_t index)
+{
+    uint8_t block = (uint8_t) ((log->block + INPUT_LOG_BLOCKS - log->count + 1u + index) % INPUT_LOG_BLOCKS);
+    return log->blocks[block];
+}
+
+uint32_t input_log_engine_output(const phase_engine_t *engine, uint8_t *arg)
+{
+    const phase_def_t *phase = phase_engine_current(engine);
+
+    *arg = engine->phase;
+    return phase->signal | ((uint32_t) phase->ped << 8);
+}
+
+uint32_t input_log_rb_output(const rb_controller_t *ctrl, uint8_t *arg)
+{
+    uint8_t heads[RB_MAX_HEADS];
+    uint32_t packed = 0;
+
+    rb_controller_heads(ctrl, heads);
+    for(uint8_t i = 0; i < ctrl->plan->head_count; i++) packed |= (uint32_t) heads[i] << (2u * i);
+    *arg = ctrl->group;
+    return heads[0] | ((uint32_t) rb_controller_ped(ctrl) << 8) | (packed << 16);
+}
+
+bool input_log_reader_init(input_log_reader_t *reader, const uint8_t *block)
+{
+    if(get_le(&block[0], 2) != INPUT_LOG_MAGIC) return false;
+    reader->block = block;
+    reader->sequence = (uint32_t) get_le(&block[2], 4);
+    reader->controller = block[6];
+    reader->plan_id = block[22];
+    reader->time_ms = (uint32_t) get_le(&block[8], 4);
+    reader->skew_us = get_le(&block[12], 8);
+    reader->state_pos = HEADER_BYTES;
+    reader->pos = (uint16_t) (HEADER_BYTES + get_le(&block[20], 2));
+    return (reader->controller == INPUT_LOG_ENGINE || reader->controller == INPUT_LOG_RING_BARRIER)
+        && reader->pos <= INPUT_LOG_BLOCK_SIZE;
+}
+
+bool input_log_restore_engine(const input_log_reader_t *reader, const phase_plan_t *plan, phase_def_t *phases,
+    phase_engine_t *engine)
+{
+    if(reader->controller != INPUT_LOG_ENGINE || reader->block[7] != plan->count) return false;
+    memset(engine, 0, sizeof(*engine));
+    engine_fields((uint8_t *) &reader->block[reader->state_pos], true, plan, phases, engine);
+    return true;
+}
+
+bool input_log_restore_rb(const input_log_reader_t *reader, const rb_plan_t *plan, rb_phase_def_t *phases,
+    rb_controller_t *ctrl)
+{
+    if(reader->controller != INPUT_LOG_RING_BARRIER || reader->block[7] != plan->phase_count) return false;
+    memset(ctrl, 0, sizeof(*ctrl));
+    rb_fields((uint8_t *) &reader->block[reader->state_pos], true, plan, phases, ctrl);
+    return true;
+}
+
+bool input_log_check_engine(const input_log_reader_t *reader, const phase_plan_t *plan, const phase_engine_t *engine)
+{
+    uint8_t data[CHECKPOINT_MAX];
+    uint16_t size;
+
+    if(reader->controller != INPUT_LOG_ENGINE || reader->block[7] != plan->count) return false;
+    size = engine_fields(data, false, plan, (phase_def_t *) plan->phases, (phase_engine_t *) engine);
+    return memcmp(data, &reader->block[reader->state_pos], size) == 0;
+}
+
+bool input_log_check_rb(const input_log_reader_t *reader, const rb_plan_t *plan, const rb_controller_t *ctrl)
+{
+    uint8_t data[CHECKPOINT_MAX];
+    uint16_t size;
+
+    if(reader->controller != INPUT_LOG_RING_BARRIER || reader->block[7] != plan->phase_count) return false;
+    size = rb_fields(data, false, plan, (rb_phase_def_t *) plan->phases, (rb_controller_t *) ctrl);
+    return memcmp(data, &reader->block[reader->state_pos], size) == 0;
+}
+
+bool input_log_next(input_log_reader_t *reader, input_log_record_t *record)
+{
+    uint64_t value;
+
+    if(reader->pos >= INPUT_LOG_BLOCK_SIZE) return false;
+    memset(record, 0, sizeof(*record));
+    record->kind = reader->block[reader->pos++];
+    if(record->kind == INPUT_LOG_END || record->kind >= INPUT_LOG_KIND_COUNT) return false;
+
+    if(record->kind == INPUT_LOG_UPDATE)
+    {
+        if(reader->pos >= INPUT_LOG_BLOCK_SIZE) return false;
+        record->count = reader->block[reader->pos++];
+    }
+    if(record->kind != INPUT_LOG_OUTPUT)
+    {
+        if(!get_varint(reader, &value)) return false;
+        record->delta_ms = (uint32_t) unzigzag(value);
+        reader->time_ms += (record->kind == INPUT_LOG_UPDATE) ? record->delta_ms * record->count : record->delta_ms;
+    }
+    record->time_ms = reader->time_ms;
+    if(is_external(record->kind))
+    {
+        if(!get_varint(reader, &value)) return false;
+        reader->skew_us += (uint64_t) unzigzag(value);
+        record->time_us = reader->skew_us + (uint64_t) record->time_ms * 1000u;
+    }
+    switch(record->kind)
+    {
+        case INPUT_LOG_CALL:
+        case INPUT_LOG_PREEMPT:
+        case INPUT_LOG_RESUME:
+        case INPUT_LOG_OUTPUT:
+        case INPUT_LOG_DURATIONS:
+        case INPUT_LOG_PLAN:
+            if(reader->pos >= INPUT_LOG_BLOCK_SIZE) return false;
+            record->arg = reader->block[reader->pos++];
+            break;
+        default:
+            break;
+    }
+    switch(record->kind)
+    {
+        case INPUT_LOG_RESUME:
+        case INPUT_LOG_OUTPUT:
+        case INPUT_LOG_PRESENCE:
+        case INPUT_LOG_SET_TIME:
+            return get_varint(reader, &record->value);
+        case INPUT_LOG_DURATIONS:
+            for(uint8_t i = 0; i < 3; i++)
+            {
+                if(!get_varint(reader, &value)) return false;
+                record->durations[i] = (uint16_t) value;
+            }
+            return true;
+        default:
+            return true;
+    }
+}
@@ -0,0 +1,236 @@
+#ifndef INPUT_LOG_H
+#define INPUT_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "phase_engine.h"
+#include "ring_barrier.h"
+
+/**
+ * @file input_log.h
+ * @brief Gravação das entradas do controlador para reprodução determinística no Linux.
+ *
+ * O motor de fases e o controlador de anéis e barreiras são funções puras das
+ * chamadas que recebem: partida, avanço até um instante, presença, chamadas,
+ * preempção, hora do host, troca de plano e durações alteradas. O firmware grava cada chamada,
+ * na ordem em que é feita e com o relógio em ms do controlador, antes de
+ * fazê-la; as entradas externas (botão, detectores, preempção, shell) levam
+ * também o instante em µs do timer do RP2040. Depois de cada avanço com
+ * transição, um registro de saída guarda o sinal publicado, para conferência.
+ * tools/sim/replay_inputs.c refaz as mesmas chamadas no mesmo código e
+ * compara as saídas, bit a bit.
+ *
+ * Os registros são variáveis: 1 byte de tipo e os tempos em deltas LEB128
+ * (zigzag). O µs é guardado como a diferença para 1000 × ms, quase
+ * constante, então custa 1 ou 2 bytes. Avanços seguidos com o mesmo
+ * intervalo viram um só registro com contador: sem veículos, o foco único
+ * gasta 4 bytes a cada 255 s. Os blocos de
+ * INPUT_LOG_BLOCK_SIZE bytes formam um anel em RAM; cada bloco começa com um
+ * ponto de verificação (durações do plano e estado completo do controlador),
+ * então a reprodução pode começar no bloco mais antigo que sobrou e confere
+ * o estado no início de cada bloco seguinte.
+ *
+ * C puro, como os controladores: quem chama passa os instantes e garante a
+ * exclusão mútua (o firmware grava dentro das mesmas seções críticas que
+ * chamam o controlador).
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define INPUT_LOG_BLOCK_SIZE  2048u       /**< Bytes por bloco */
+#define INPUT_LOG_BLOCKS      8u          /**< Blocos no anel de RAM */
+#define INPUT_LOG_MAGIC       0x4C49u     /**< "IL" no início de cada bloco */
+#define INPUT_LOG_DUMP_PART   128u        /**< Bytes de bloco por quadro do dump */
+#define INPUT_LOG_DUMP_END    0xFFFFu     /**< Bloco do quadro que encerra o dump */
+#define INPUT_LOG_RECORD_MAX  32u         /**< Maior registro codificado */
+
+/**
+ * @brief Controlador gravado.
+ */
+typedef enum {
+    INPUT_LOG_ENGINE = 0,   /**< Motor de fases (foco único) */
+    INPUT_LOG_RING_BARRIER, /**< Anéis e barreiras (cruzamento) */
+} input_log_controller_t;
+
+/**
+ * @brief Tipos de registro; os marcados com µs são entradas externas.
+ */
+typedef enum {
+    INPUT_LOG_END = 0,      /**< Fim dos registros do bloco */
+    INPUT_LOG_UPDATE,       /**< Avanço até o instante (count avanços, cada um delta ms depois do anterior) */
+    INPUT_LOG_PRESENCE,     /**< Presença nos detectores (value = máscara), µs */
+    INPUT_LOG_CALL,         /**< Chamada (arg = chamada do motor ou fase do cruzamento), µs */
+    INPUT_LOG_START,        /**< Partida do plano, µs */
+    INPUT_LOG_RESUME,       /**< Retomada após reset (arg = fase, value = segundos restantes), µs */
+    INPUT_LOG_SET_TIME,     /**< Hora do host (value = ms desde 1970), µs */
+    INPUT_LOG_DURATIONS,    /**< Durações da fase arg (mínimo, máximo, padrão), µs */
+    INPUT_LOG_PREEMPT,      /**< Preempção para a fase arg (PHASE_NO_PHASE: fim), µs */
+    INPUT_LOG_EXPIRE,       /**< Fim antecipado da fase atual (build de perfil de pilha) */
+    INPUT_LOG_OUTPUT,       /**< Saída publicada (arg = fase ou grupo, value = input_log_output()) */
+    INPUT_LOG_PLAN,         /**< Troca para o plano arg de lib/phase_plans.c; as durações alteradas vêm em seguida, µs */
+    INPUT_LOG_KIND_COUNT
+} input_log_kind_t;
+
+/**
+ * @brief Um registro, já decodificado.
+ */
+typedef struct {
+    uint8_t kind;            /**< input_log_kind_t */
+    uint8_t arg;             /**< Argumento curto */
+    uint8_t count;           /**< Avanços de INPUT_LOG_UPDATE */
+    uint32_t time_ms;        /**< Relógio do controlador (do último avanço, em INPUT_LOG_UPDATE) */
+    uint32_t delta_ms;       /**< Intervalo entre os avanços de INPUT_LOG_UPDATE */
+    uint64_t time_us;        /**< Timer de 1 µs (entradas externas) */
+    uint64_t value;          /**< Argumento longo */
+    uint16_t durations[3];   /**< INPUT_LOG_DURATIONS */
+} input_log_record_t;
+
+/**
+ * @brief Payload de TELEMETRY_TYPE_INPUT_LOG: 1/16 de um bloco.
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t block;                       /**< Bloco, do mais antigo (0), ou INPUT_LOG_DUMP_END */
+    uint8_t part;                         /**< Parte do bloco (0 a 15) */
+    uint8_t data[INPUT_LOG_DUMP_PART];    /**< Bytes do bloco */
+} input_log_frame_t;
+
+/**
+ * @brief Log de entradas.
+ */
+typedef struct {
+    uint8_t blocks[INPUT_LOG_BLOCKS][INPUT_LOG_BLOCK_SIZE]; /**< Anel de blocos */
+    uint32_t sequence;              /**< Número de série do bloco em uso */
+    uint8_t block;                  /**< Bloco em uso */
+    uint8_t count;                  /**< Blocos com registros */
+    uint16_t used;                  /**< Bytes usados no bloco em uso (0: nenhum bloco ainda) */
+    uint32_t last_ms;               /**< Relógio do controlador do último registro */
+    uint64_t last_skew_us;          /**< µs − 1000 × ms da última entrada externa */
+    uint16_t update_count_pos;      /**< Contador do último INPUT_LOG_UPDATE do bloco, ou 0 */
+    uint32_t update_delta_ms;       /**< Intervalo do último INPUT_LOG_UPDATE */
+    uint8_t controller;             /**< input_log_controller_t */
+    uint8_t plan_id;                /**< Número do plano em uso (PLAN_DAY no início) */
+    const void *plan;               /**< phase_plan_t ou rb_plan_t gravado */
+    const void *state;              /**< phase_engine_t ou rb_controller_t gravado */
+    uint32_t records;               /**< Registros gravados desde o boot */
+    uint32_t blocks_lost;           /**< Blocos sobrescritos pelo anel */
+} input_log_t;
+
+/**
+ * @brief Leitura dos registros de um bloco.
+ */
+typedef struct {
+    const uint8_t *block;    /**< Bloco */
+    uint16_t pos;            /**< Próximo byte */
+    uint32_t sequence;       /**< Número de série do bloco */
+    uint8_t controller;      /**< input_log_controller_t */
+    uint8_t plan_id;         /**< Plano em uso no início do bloco */
+    uint32_t time_ms;        /**< Relógio do último registro lido */
+    uint64_t skew_us;        /**< µs − 1000 × ms da última entrada externa lida */
+    uint16_t state_pos;      /**< Início do ponto de verificação */
+} input_log_reader_t;
+
+/**
+ * @brief Prepara a gravação das chamadas a um motor de fases.
+ *
+ * @param log Log (zerado por esta função).
+ * @param plan Plano em uso, com as fases em RAM (as durações entram no ponto de verificação).
+ * @param engine Motor de fases.
+ */
+void input_log_init_engine(input_log_t *log, const phase_plan_t *plan, const phase_engine_t *engine);
+
+/**
+ * @brief Prepara a gravação das chamadas a um controlador de cruzamento.
+ */
+void input_log_init_rb(input_log_t *log, const rb_plan_t *plan, const rb_controller_t *ctrl);
+
+/**
+ * @brief Grava um registro (antes da chamada que ele descreve).
+ *
+ * Campos usados: kind, arg, time_ms, time_us (entradas externas), value e
+ * durations. Um INPUT_LOG_UPDATE com o mesmo intervalo do anterior só
+ * incrementa o contador dele. Sem espaço no bloco, o próximo bloco do anel
+ * é sobrescrito e começa com um ponto de verificação do estado atual.
+ * Não faz nada antes de input_log_init_engine() ou input_log_init_rb().
+ */
+void input_log_add(input_log_t *log, const input_log_record_t *record);
+
+/**
+ * @brief Troca o plano gravado, logo depois do registro INPUT_LOG_PLAN.
+ *
+ * Os pontos de verificação seguintes levam o número @p plan_id e as
+ * durações de @p plan.
+ */
+void input_log_set_plan(input_log_t *log, uint8_t plan_id, const void *plan);
+
+/**
+ * @brief Número de blocos com registros.
+ */
+uint8_t input_log_block_count(const input_log_t *log);
+
+/**
+ * @brief Bloco @p index, do mais antigo (0) ao em uso.
+ */
+const uint8_t *input_log_block(const input_log_t *log, uint8_t index);
+
+/**
+ * @brief Saída publicada pelo motor: sinal | pedestre << 8, e a fase em @p arg.
+ *
+ * Mesmo valor de EVENT_LOG_PHASE.
+ */
+uint32_t input_log_engine_output(const phase_engine_t *engine, uint8_t *arg);
+
+/**
+ * @brief Saída publicada pelo cruzamento: sinal do primeiro foco | pedestre << 8
+ *        | focos << 16 (2 bits por foco), e o grupo em @p arg.
+ */
+uint32_t input_log_rb_output(const rb_controller_t *ctrl, uint8_t *arg);
+
+/**
+ * @brief Lê o cabeçalho de um bloco.
+ *
+ * @return false se o bloco não começa com INPUT_LOG_MAGIC.
+ */
+bool input_log_reader_init(input_log_reader_t *reader, const uint8_t *block);
+
+/**
+ * @brief Restaura o plano e o motor do ponto de verificação do bloco.
+ *
+ * Sem partida gravada no ponto de verificação (bloco do boot), o motor fica
+ * zerado e o primeiro registro é INPUT_LOG_START ou INPUT_LOG_RESUME.
+ *
+ * @param reader Leitor recém-iniciado.
+ * @param plan Cópia do mesmo plano do firmware (o plano reader->plan_id).
+ * @param phases Fases de @p plan, em RAM (recebem as durações gravadas).
+ * @param engine Motor (fica em @p plan).
+ * @return false se o bloco não é do motor ou não cabe no plano.
+ */
+bool input_log_restore_engine(const input_log_reader_t *reader, const phase_plan_t *plan, phase_def_t *phases,
+    phase_engine_t *engine);
+
+/**
+ * @brief Restaura o plano e o controlador do ponto de verificação do bloco.
+ */
+bool input_log_restore_rb(const input_log_reader_t *reader, const rb_plan_t *plan, rb_phase_def_t *phases,
+    rb_controller_t *ctrl);
+
+/**
+ * @brief Compara o plano e o motor com o ponto de verificação do bloco.
+ *
+ * @return true se são idênticos.
+ */
+bool input_log_check_engine(const input_log_reader_t *reader, const phase_plan_t *plan, const phase_engine_t *engine);
+
+/**
+ * @brief Compara o plano e o controlador com o ponto de verificação do bloco.
+ */
+bool input_log_check_rb(const input_log_reader_t *reader, const rb_plan_t *plan, const rb_controller_t *ctrl);
+
+/**
+ * @brief Lê o próximo registro do bloco.
+ *
+ * @return false no fim dos registros (ou num registro inválido).
+ */
+bool input_log_next(input_log_reader_t *reader, input_log_record_t *record);
+
+#endif // INPUT_LOG_H
@@ -30,8 +30,16 @@ void buzzer_init(uint8_t buzzer_pin){
 }
 
 void buzzer_beep(uint8_t buzzer_pin, uint16_t duration, uint16_t frequency){
-    buzzer_set_frequency(buzzer_pin, frequency);
+    buzzer_tone_on(buzzer_pin, frequency);
     // sleep_ms(duration);
     vTaskDelay(pdMS_TO_TICKS(duration));
-    pwm_set_gpio_level(buzzer_pin, 0);
+    buzzer_tone_off(buzzer_pin);
  }
+
+void buzzer_tone_on(uint8_t buzzer_pin, uint16_t frequency){
+    buzzer_set_frequency(buzzer_pin, frequency);
+}
+
+void buzzer_tone_off(uint8_t buzzer_pin){
+    pwm_set_gpio_level(buzzer_pin, 0);
+}
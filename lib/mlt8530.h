@@ -20,4 +20,14 @@
 void buzzer_init(uint8_t buzzer_pin);
 void buzzer_beep(uint8_t buzzer_pin, uint16_t duration, uint16_t frequency);
 
+/**
+ * @brief Liga o tom sem bloquear (para uso em callbacks de software timer).
+ */
+void buzzer_tone_on(uint8_t buzzer_pin, uint16_t frequency);
+
+/**
+ * @brief Desliga o tom iniciado por buzzer_tone_on().
+ */
+void buzzer_tone_off(uint8_t buzzer_pin);
+
 #endif // MLT8530_H
@@ -0,0 +1,67 @@
+#include "msg_pool.h"
+#include "pico/stdlib.h"
+
+void msg_pool_init(msg_pool_t *pool, void *storage, size_t payload_size, uint16_t count)
+{
+    uint8_t *block = (uint8_t *) storage;
+    size_t block_size = MSG_POOL_BLOCK_SIZE(payload_size);
+
+    pool->lock = spin_lock_instance((uint) spin_lock_claim_unused(true));
+    pool->block_size = (uint16_t) block_size;
+    pool->block_count = count;
+    pool->free_count = count;
+    pool->min_free = count;
+    pool->alloc_failures = 0;
+    pool->free_list = NULL;
+    // Encadeia de trás para frente para que a primeira alocação pegue o bloco 0
+    for(uint16_t i = count; i > 0; i--)
+    {
+        msg_block_header_t *header = (msg_block_header_t *) &block[(size_t) (i - 1u) * block_size];
+        header->next = pool->free_list;
+        pool->free_list = header;
+    }
+}
+
+void *msg_pool_alloc(msg_pool_t *pool)
+{
+    msg_block_header_t *header;
+    uint32_t irq = spin_lock_blocking(pool->lock);
+
+    header = pool->free_list;
+    if(header)
+    {
+        pool->free_list = header->next;
+        pool->free_count--;
+        if(pool->free_count < pool->min_free) pool->min_free = pool->free_count;
+        header->owner = pool;
+    }
+    else pool->alloc_failures++;
+    spin_unlock(pool->lock, irq);
+    return header ? (void *) (header + 1) : NULL;
+}
+
+void msg_pool_free(void *msg)
+{
+    msg_block_header_t *header;
+    msg_pool_t *pool;
+    uint32_t irq;
+
+    if(!msg) return;
+    header = (msg_block_header_t *) msg - 1;
+    pool = header->owner;
+    irq = spin_lock_blocking(pool->lock);
+    header->next = pool->free_list;
+    pool->free_list = header;
+    pool->free_count++;
+    spin_unlock(pool->lock, irq);
+}
+
+void msg_queue_init(msg_queue_t *queue, void **storage, UBaseType_t length, const char *name)
+{
+    queue->handle = xQueueCreateStatic(length, sizeof(void *), (uint8_t *) storage, &queue->buffer);
+#if ( configQUEUE_REGISTRY_SIZE > 0 )
+    if(name) vQueueAddToRegistry(queue->handle, name);
+#else
+    (void) name;
+#endif
+}
@@ -0,0 +1,146 @@
+#ifndef MSG_POOL_H
+#define MSG_POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "hardware/sync.h"
+#include "FreeRTOS.h"
+#include "queue.h"
+
+/**
+ * @file msg_pool.h
+ * @brief Pools de blocos de tamanho fixo e filas de ponteiros para passagem de
+ *        mensagens sem cópia entre tarefas, callbacks e ISRs.
+ *
+ * Um pool é um vetor estático de blocos iguais encadeados em uma lista livre:
+ * msg_pool_alloc() e msg_pool_free() são O(1) e protegidas por um spinlock de
+ * hardware com as interrupções desligadas, então podem ser chamadas de
+ * qualquer núcleo, tarefa ou ISR. Cada bloco guarda, antes do payload, o pool
+ * de origem, de modo que quem consome a mensagem a devolve só com o ponteiro.
+ *
+ * A fila (msg_queue_t) transporta apenas o ponteiro do bloco: o produtor
+ * preenche o payload no próprio bloco e o consumidor lê e libera o mesmo bloco,
+ * sem memcpy do conteúdo.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+/**
+ * @brief Cabeçalho oculto de cada bloco (8 bytes, mantém o payload alinhado).
+ */
+typedef union msg_block_header {
+    struct msg_pool *owner;          /**< Pool de origem (bloco em uso) */
+    union msg_block_header *next;    /**< Próximo bloco livre (bloco livre) */
+    uint64_t align;                  /**< Força alinhamento de 8 bytes */
+} msg_block_header_t;
+
+/**
+ * @brief Pool de blocos de tamanho fixo.
+ */
+typedef struct msg_pool {
+    msg_block_header_t *free_list;   /**< Primeiro bloco livre */
+    spin_lock_t *lock;               /**< Spinlock de hardware do pool */
+    uint16_t block_size;             /**< Bytes por bloco, incluindo o cabeçalho */
+    uint16_t block_count;            /**< Total de blocos */
+    volatile uint16_t free_count;    /**< Blocos livres agora */
+    uint16_t min_free;               /**< Menor número de blocos livres já observado */
+    uint32_t alloc_failures;         /**< Alocações negadas por falta de bloco */
+} msg_pool_t;
+
+/** Tamanho de um bloco para um payload de @p payload bytes. */
+#define MSG_POOL_BLOCK_SIZE(payload) (sizeof(msg_block_header_t) + ((((size_t) (payload)) + 7u) & ~(size_t) 7u))
+
+/** Declara a memória estática de um pool de @p count blocos de @p payload bytes. */
+#define MSG_POOL_STORAGE(name, payload, count) \
+    static uint64_t name[(MSG_POOL_BLOCK_SIZE(payload) * (count)) / sizeof(uint64_t)]
+
+/**
+ * @brief Fila de ponteiros para blocos de pool (FreeRTOS, alocação estática).
+ */
+typedef struct {
+    QueueHandle_t handle;     /**< Fila do FreeRTOS */
+    StaticQueue_t buffer;     /**< Estrutura estática da fila */
+} msg_queue_t;
+
+/** Declara a memória estática de uma fila de @p length mensagens. */
+#define MSG_QUEUE_STORAGE(name, length) static void *name[length]
+
+/**
+ * @brief Inicializa um pool sobre a memória declarada com MSG_POOL_STORAGE.
+ *
+ * Deve ser chamada uma vez, antes de qualquer alocação.
+ *
+ * @param pool Pool a inicializar.
+ * @param storage Memória do pool.
+ * @param payload_size Tamanho do payload de cada bloco, em bytes.
+ * @param count Número de blocos.
+ */
+void msg_pool_init(msg_pool_t *pool, void *storage, size_t payload_size, uint16_t count);
+
+/**
+ * @brief Retira um bloco do pool. Não bloqueia; pode ser chamada de ISR.
+ *
+ * @param pool Pool de origem.
+ * @return Ponteiro para o payload, ou NULL se o pool estiver vazio.
+ */
+void *msg_pool_alloc(msg_pool_t *pool);
+
+/**
+ * @brief Devolve um bloco ao seu pool. Pode ser chamada de ISR.
+ *
+ * @param msg Ponteiro retornado por msg_pool_alloc() (NULL é ignorado).
+ */
+void msg_pool_free(void *msg);
+
+/**
+ * @brief Inicializa uma fila de ponteiros.
+ *
+ * @param queue Fila a inicializar.
+ * @param storage Memória declarada com MSG_QUEUE_STORAGE.
+ * @param length Capacidade da fila.
+ * @param name Nome no registro de filas (aparece no trace), ou NULL.
+ */
+void msg_queue_init(msg_queue_t *queue, void **storage, UBaseType_t length, const char *name);
+
+/**
+ * @brief Envia uma mensagem (o bloco passa a pertencer ao consumidor).
+ *
+ * @param queue Fila de destino.
+ * @param msg Bloco alocado de um pool.
+ * @param ticks Tempo máximo de espera por espaço na fila.
+ * @return true se enviada; em caso de falha o bloco continua com quem chamou.
+ */
+static inline bool msg_queue_send(msg_queue_t *queue, void *msg, TickType_t ticks)
+{
+    return xQueueSend(queue->handle, &msg, ticks) == pdTRUE;
+}
+
+/**
+ * @brief Envia uma mensagem a partir de uma ISR.
+ *
+ * @param queue Fila de destino.
+ * @param msg Bloco alocado de um pool.
+ * @param woken Recebe pdTRUE se uma tarefa de maior prioridade foi acordada.
+ * @return true se enviada; em caso de falha o bloco continua com quem chamou.
+ */
+static inline bool msg_queue_send_from_isr(msg_queue_t *queue, void *msg, BaseType_t *woken)
+{
+    return xQueueSendFromISR(queue->handle, &msg, woken) == pdTRUE;
+}
+
+/**
+ * @brief Recebe uma mensagem; o consumidor deve liberá-la com msg_pool_free().
+ *
+ * @param queue Fila de origem.
+ * @param ticks Tempo máximo de espera.
+ * @return Bloco recebido, ou NULL no timeout.
+ */
+static inline void *msg_queue_receive(msg_queue_t *queue, TickType_t ticks)
+{
+    void *msg = NULL;
+    return (xQueueReceive(queue->handle, &msg, ticks) == pdTRUE) ? msg : NULL;
+}
+
+#endif // MSG_POOL_H
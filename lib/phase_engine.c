@@ -0,0 +1,274 @@
+#include "phase_engine.h"
+
+bool phase_plan_is_valid(const phase_plan_t *plan)
+{
+    if(!plan || !plan->phases || plan->count == 0 || plan->count > PHASE_ENGINE_MAX_PHASES) return false;
+    if(plan->initial >= plan->count) return false;
+    for(uint8_t i = 0; i < plan->count; i++)
+    {
+        const phase_def_t *phase = &plan->phases[i];
+        if(phase->next >= plan->count) return false;
+        if(phase->min_s == 0 || phase->min_s > phase->default_s || phase->default_s > phase->max_s) return false;
+        if(phase->detector != PHASE_NO_DETECTOR && (phase->detector >= 32 || phase->passage_s == 0)) return false;
+        if(phase->call != PHASE_NO_CALL && (phase->call >= 32 || phase->call_next >= plan->count)) return false;
+    }
+    if(plan->cycle_s && (plan->offset_s >= plan->cycle_s || plan->sync_phase >= plan->count)) return false;
+    if(plan->preempt_phase != PHASE_NO_PHASE && plan->preempt_phase >= plan->count) return false;
+    return true;
+}
+
+/**
+ * @brief Verifica se a fase é estendida por um detector.
+ */
+static inline bool phase_is_actuated(const phase_def_t *phase)
+{
+    return phase->detector != PHASE_NO_DETECTOR;
+}
+
+/**
+ * @brief Entra na fase @p phase, começando em @p start_ms.
+ *
+ * Fases atuadas começam com a duração mínima; as demais, com a padrão. Em
+ * planos coordenados, depois do sincronismo, todas começam com a padrão (a
+ * parte da fase no ciclo) e recebem a correção pendente.
+ */
+static void phase_engine_enter(phase_engine_t *engine, uint8_t phase, uint32_t start_ms)
+{
+    const phase_def_t *def = &engine->plan->phases[phase];
+
+    engine->phase = phase;
+    engine->start_ms = start_ms;
+    engine->duration_ms = (uint32_t) (phase_is_actuated(def) ? def->min_s : def->default_s) * 1000u;
+    if(engine->preempt != PHASE_NO_PHASE)
+        engine->duration_ms = (uint32_t) def->min_s * 1000u;  // Caminho da preempção: só o mínimo
+    else if(coord_active(&engine->coord))
+    {
+        if(phase == engine->plan->sync_phase)
+            engine->correction_ms = coord_sync_point(&engine->coord, start_ms, engine->correction_ms);
+        engine->duration_ms = coord_adjust(&engine->correction_ms, (uint32_t) def->default_s * 1000u,
+            (uint32_t) def->min_s * 1000u, (uint32_t) def->max_s * 1000u);
+    }
+}
+
+/**
+ * @brief Fases seguintes possíveis de @p phase: next e, se houver chamada, call_next.
+ *
+ * @return Quantidade (1 ou 2).
+ */
+static uint8_t phase_successors(const phase_def_t *def, uint8_t *next)
+{
+    next[0] = def->next;
+    if(def->call == PHASE_NO_CALL) return 1;
+    next[1] = def->call_next;
+    return 2;
+}
+
+/**
+ * @brief Calcula os caminhos da preempção: para cada alvo, a próxima fase que
+ *        minimiza a soma dos mínimos das fases entre a atual e o alvo.
+ *
+ * Bellman-Ford sobre as transições do plano (no máximo 16 fases e duas saídas
+ * por fase). Só roda na partida do plano; a preempção só consulta a tabela.
+ */
+static void phase_engine_route(phase_engine_t *engine)
+{
+    const phase_plan_t *plan = engine->plan;
+    uint32_t cost[PHASE_ENGINE_MAX_PHASES];
+
+    for(uint8_t target = 0; target < plan->count; target++)
+    {
+        for(uint8_t i = 0; i < plan->count; i++)
+        {
+            cost[i] = UINT32_MAX;
+            engine->route[i][target] = PHASE_NO_PHASE;
+        }
+        for(uint8_t pass = 0; pass < plan->count; pass++)
+        {
+            bool changed = false;
+            for(uint8_t i = 0; i < plan->count; i++)
+            {
+                uint8_t next[2];
+                uint8_t count = phase_successors(&plan->phases[i], next);
+                for(uint8_t n = 0; n < count; n++)
+                {
+                    uint32_t via;
+                    if(next[n] == target) via = 0;
+                    else if(cost[next[n]] == UINT32_MAX) continue;
+                    else via = plan->phases[next[n]].min_s + cost[next[n]];
+                    if(via >= cost[i]) continue;
+                    cost[i] = via;
+                    engine->route[i][target] = next[n];
+                    changed = true;
+                }
+            }
+            if(!changed) break;
+        }
+    }
+}
+
+void phase_engine_start(phase_engine_t *engine, const phase_plan_t *plan, uint32_t now_ms)
+{
+    engine->plan = plan;
+    engine->transitions = 0;
+    engine->gap_outs = 0;
+    engine->max_outs = 0;
+    engine->calls = 0;
+    engine->correction_ms = 0;
+    engine->preempt = PHASE_NO_PHASE;
+    engine->preemptions = 0;
+    phase_engine_route(engine);
+    coord_init(&engine->coord, (uint32_t) plan->cycle_s * 1000u, (uint32_t) plan->offset_s * 1000u, now_ms);
+    phase_engine_enter(engine, plan->initial, now_ms);
+}
+
+bool phase_engine_resume(phase_engine_t *engine, const phase_plan_t *plan, uint8_t phase,
+    uint16_t remaining_s, uint32_t now_ms)
+{
+    uint32_t remaining_ms = (uint32_t) remaining_s * 1000u;
+
+    if(phase >= plan->count || remaining_s == 0 || remaining_s > plan->phases[phase].max_s) return false;
+    phase_engine_start(engine, plan, now_ms);
+    phase_engine_enter(engine, phase, now_ms);
+    if(remaining_ms <= engine->duration_ms) engine->start_ms = now_ms - (engine->duration_ms - remaining_ms);
+    else engine->duration_ms = remaining_ms;
+    return true;
+}
+
+uint32_t phase_engine_update(phase_engine_t *engine, uint32_t now_ms)
+{
+    uint32_t count = 0;
+    // Diferença sem sinal: funciona com o relógio dando a volta
+    while(now_ms - engine->start_ms >= engine->duration_ms)
+    {
+        uint32_t end_ms = engine->start_ms + engine->duration_ms;
+        const phase_def_t *ended = phase_engine_current(engine);
+        if(engine->preempt != PHASE_NO_PHASE)
+        {
+            // A fase alvo fica até o fim da preempção
+            if(engine->phase == engine->preempt)
+            {
+                engine->duration_ms = now_ms - engine->start_ms;
+                break;
+            }
+            phase_engine_enter(engine, engine->route[engine->phase][engine->preempt], end_ms);
+            engine->transitions++;
+            count++;
+            continue;
+        }
+        if(phase_is_actuated(ended))
+        {
+            if(engine->duration_ms >= (uint32_t) ended->max_s * 1000u) engine->max_outs++;
+            else engine->gap_outs++;
+        }
+        uint8_t next = ended->next;
+        if(ended->call != PHASE_NO_CALL && (engine->calls & (1u << ended->call)))
+        {
+            engine->calls &= ~(1u << ended->call);
+            next = ended->call_next;
+        }
+        phase_engine_enter(engine, next, end_ms);
+        engine->transitions++;
+        count++;
+    }
+    return count;
+}
+
+void phase_engine_set_duration(phase_engine_t *engine, uint16_t duration_s)
+{
+    const phase_def_t *phase = phase_engine_current(engine);
+    if(duration_s < phase->min_s) duration_s = phase->min_s;
+    if(duration_s > phase->max_s) duration_s = phase->max_s;
+    engine->duration_ms = (uint32_t) duration_s * 1000u;
+}
+
+void phase_engine_set_time(phase_engine_t *engine, uint64_t time_ms, uint32_t now_ms)
+{
+    coord_set_time(&engine->coord, time_ms, now_ms);
+}
+
+bool phase_engine_change_plan(phase_engine_t *engine, const phase_plan_t *plan, uint32_t now_ms)
+{
+    if(plan->count != engine->plan->count) return false;
+    engine->plan = plan;
+    engine->correction_ms = 0;
+    phase_engine_route(engine);
+    coord_init(&engine->coord, (uint32_t) plan->cycle_s * 1000u, (uint32_t) plan->offset_s * 1000u, now_ms);
+    return true;
+}
+
+void phase_engine_call(phase_engine_t *engine, uint8_t call)
+{
+    if(call < 32) engine->calls |= 1u << call;
+}
+
+void phase_engine_presence(phase_engine_t *engine, uint32_t detectors, uint32_t now_ms)
+{
+    const phase_def_t *phase = phase_engine_current(engine);
+    uint32_t elapsed = now_ms - engine->start_ms;
+    uint32_t end_ms;
+
+    if(!phase_is_actuated(phase) || !(detectors & (1u << phase->detector))) return;
+    if(engine->preempt != PHASE_NO_PHASE) return;  // O caminho da preempção não é estendido
+    if(elapsed >= engine->duration_ms) return;  // Já terminou; a transição vem no próximo update
+    end_ms = elapsed + (uint32_t) phase->passage_s * 1000u;
+    if(end_ms > (uint32_t) phase->max_s * 1000u) end_ms = (uint32_t) phase->max_s * 1000u;
+    if(end_ms > engine->duration_ms) engine->duration_ms = end_ms;
+}
+
+void phase_engine_expire(phase_engine_t *engine, uint32_t now_ms)
+{
+    uint32_t elapsed = now_ms - engine->start_ms;
+    if(elapsed < engine->duration_ms) engine->duration_ms = elapsed;
+}
+
+bool phase_engine_preempt(phase_engine_t *engine, uint8_t target, uint32_t now_ms)
+{
+    uint32_t elapsed = now_ms - engine->start_ms;
+    uint32_t min_ms = (uint32_t) phase_engine_current(engine)->min_s * 1000u;
+
+    if(target >= engine->plan->count) return false;
+    if(target != engine->phase && engine->route[engine->phase][target] == PHASE_NO_PHASE) return false;
+    if(engine->preempt != target) engine->preemptions++;
+    engine->preempt = target;
+    engine->correction_ms = 0;
+    // A fase atual (ou o alvo, se já está nele) vai até o mínimo
+    if(elapsed < engine->duration_ms) engine->duration_ms = (elapsed > min_ms) ? elapsed : min_ms;
+    return true;
+}
+
+void phase_engine_preempt_release(phase_engine_t *engine, uint32_t now_ms)
+{
+    (void) now_ms;
+    if(engine->preempt == PHASE_NO_PHASE) return;
+    engine->preempt = PHASE_NO_PHASE;
+    engine->correction_ms = 0;
+    coord_resync(&engine->coord);
+}
+
+uint32_t phase_engine_preempt_bound_ms(const phase_engine_t *engine, uint8_t target)
+{
+    const phase_plan_t *plan = engine->plan;
+    uint32_t worst_ms = 0;
+
+    if(target >= plan->count) return UINT32_MAX;
+    for(uint8_t from = 0; from < plan->count; from++)
+    {
+        if(from == target) continue;
+        uint32_t total_ms = (uint32_t) plan->phases[from].min_s * 1000u;
+        uint8_t phase = engine->route[from][target];
+        for(uint8_t hops = 0; phase != target; hops++, phase = engine->route[phase][target])
+        {
+            if(phase == PHASE_NO_PHASE || hops == plan->count) return UINT32_MAX;
+            total_ms += (uint32_t) plan->phases[phase].min_s * 1000u;
+        }
+        if(total_ms > worst_ms) worst_ms = total_ms;
+    }
+    return worst_ms;
+}
+
+uint16_t phase_engine_remaining_s(const phase_engine_t *engine, uint32_t now_ms)
+{
+    uint32_t elapsed = now_ms - engine->start_ms;
+    if(elapsed >= engine->duration_ms) return 0;
+    return (uint16_t) ((engine->duration_ms - elapsed + 999u) / 1000u);
+}
@@ -0,0 +1,244 @@
+#ifndef PHASE_ENGINE_H
+#define PHASE_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "coordination.h"
+
+/**
+ * @file phase_engine.h
+ * @brief Motor de fases do semáforo dirigido por tabela.
+ *
+ * Um plano (phase_plan_t) é só dado: uma tabela de fases com o sinal mostrado,
+ * as durações mínima, máxima e padrão e a fase seguinte. O motor guarda a fase
+ * atual e o instante em que ela começou; cada transição é um acesso à tabela,
+ * O(1). Fases com detector são atuadas: começam com o verde mínimo, cada
+ * presença de veículo estende a fase por passage_s (sem passar de max_s) e a
+ * fase termina quando a demanda some (gap-out) ou no máximo (max-out).
+ * Chamadas (por exemplo, o botão de pedestre) desviam a sequência: se a
+ * chamada de uma fase está pendente quando ela termina, o motor segue para
+ * call_next em vez de next e a chamada é atendida.
+ * Planos com cycle_s são coordenados (coordination.h) depois que o ciclo é
+ * ancorado numa hora absoluta (phase_engine_set_time()): o início de
+ * sync_phase é mantido na defasagem offset_s do ciclo, corrigindo as durações
+ * das fases dentro de [min_s, max_s]. Até lá o plano roda livre e atuado.
+ * A preempção (veículo de emergência) leva o motor à fase pedida pelo caminho
+ * mais curto do plano, calculado na partida: cada fase do caminho, a atual
+ * inclusive, dura só o seu mínimo, então amarelos e limpezas (de duração
+ * fixa) são cumpridos inteiros. A fase pedida fica até a preempção acabar e
+ * o plano segue pela sequência normal, com a coordenação voltando à
+ * defasagem pelo menor caminho.
+ * O tempo é sempre passado por quem chama, em milissegundos, então o
+ * mesmo código roda no firmware (tick do FreeRTOS) e em testes no Linux com
+ * relógio virtual. Este módulo não depende do Pico SDK nem do FreeRTOS.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define PHASE_ENGINE_MAX_PHASES 16   /**< Máximo de fases em um plano */
+#define PHASE_NO_DETECTOR       0xFF /**< Fase de tempo fixo */
+#define PHASE_NO_CALL           0xFF /**< Fase sem desvio por chamada */
+#define PHASE_NO_PHASE          0xFF /**< Nenhuma fase (sem preempção) */
+
+/**
+ * @brief Sinal mostrado por uma fase (mesma codificação do estado do semáforo).
+ */
+typedef enum {
+    PHASE_SIGNAL_YELLOW = 0,   /**< Amarelo */
+    PHASE_SIGNAL_GREEN  = 1,   /**< Verde */
+    PHASE_SIGNAL_RED    = 2,   /**< Vermelho */
+} phase_signal_t;
+
+/**
+ * @brief Indicação de pedestre durante uma fase.
+ */
+typedef enum {
+    PHASE_PED_DONT_WALK = 0,   /**< Não atravesse */
+    PHASE_PED_WALK,            /**< Atravesse */
+    PHASE_PED_CLEARANCE,       /**< Limpeza: termine a travessia, não comece */
+} phase_ped_t;
+
+/**
+ * @brief Uma linha do plano de fases.
+ */
+typedef struct {
+    const char *name;       /**< Nome da fase (log e ferramentas) */
+    uint8_t signal;         /**< phase_signal_t mostrado durante a fase */
+    uint8_t ped;            /**< phase_ped_t mostrado durante a fase */
+    uint8_t next;           /**< Índice da fase seguinte no plano */
+    uint8_t call;           /**< Chamada que desvia o fim da fase, ou PHASE_NO_CALL */
+    uint8_t call_next;      /**< Fase seguinte quando a chamada está pendente */
+    uint8_t detector;       /**< Detector que estende a fase, ou PHASE_NO_DETECTOR */
+    uint16_t min_s;         /**< Duração mínima, em segundos */
+    uint16_t max_s;         /**< Duração máxima, em segundos */
+    uint16_t default_s;     /**< Duração das fases de tempo fixo, em segundos */
+    uint16_t passage_s;     /**< Extensão por presença (fases atuadas), em segundos */
+} phase_def_t;
+
+/**
+ * @brief Plano de fases.
+ */
+typedef struct {
+    const char *name;             /**< Nome do plano */
+    const phase_def_t *phases;    /**< Tabela de fases */
+    uint8_t count;                /**< Número de fases */
+    uint8_t initial;              /**< Fase inicial */
+    uint8_t pedestrian_call;      /**< Chamada do botão de pedestre, ou PHASE_NO_CALL */
+    uint16_t cycle_s;             /**< Ciclo coordenado, em segundos (0: livre) */
+    uint16_t offset_s;            /**< Defasagem do início de sync_phase no ciclo */
+    uint8_t sync_phase;           /**< Fase cujo início é o ponto de sincronismo */
+    uint8_t preempt_phase;        /**< Fase pedida pela entrada de preempção, ou PHASE_NO_PHASE */
+} phase_plan_t;
+
+/**
+ * @brief Estado do motor.
+ */
+typedef struct {
+    const phase_plan_t *plan;     /**< Plano em execução */
+    uint8_t phase;                /**< Fase atual */
+    uint32_t start_ms;            /**< Início da fase atual */
+    uint32_t duration_ms;         /**< Duração da fase atual */
+    uint32_t transitions;         /**< Transições desde o início do plano */
+    uint32_t gap_outs;            /**< Fases atuadas encerradas por falta de demanda */
+    uint32_t max_outs;            /**< Fases atuadas encerradas no máximo */
+    uint32_t calls;               /**< Chamadas pendentes (bit n = chamada n) */
+    coord_t coord;                /**< Ciclo e defasagem (planos coordenados) */
+    int32_t correction_ms;        /**< Correção de coordenação ainda não aplicada */
+    uint8_t preempt;              /**< Fase alvo da preempção em curso, ou PHASE_NO_PHASE */
+    uint32_t preemptions;         /**< Preempções desde o início do plano */
+    uint8_t route[PHASE_ENGINE_MAX_PHASES][PHASE_ENGINE_MAX_PHASES];   /**< route[de][alvo]: próxima fase do caminho mais curto */
+} phase_engine_t;
+
+/**
+ * @brief Verifica a consistência de um plano (índices, durações).
+ *
+ * @return true se o plano pode ser executado.
+ */
+bool phase_plan_is_valid(const phase_plan_t *plan);
+
+/**
+ * @brief Inicia um plano na fase inicial.
+ *
+ * @param engine Motor.
+ * @param plan Plano (deve continuar válido enquanto estiver em uso).
+ * @param now_ms Instante atual.
+ */
+void phase_engine_start(phase_engine_t *engine, const phase_plan_t *plan, uint32_t now_ms);
+
+/**
+ * @brief Retoma uma fase com @p remaining_s segundos restantes (por exemplo, após um reset).
+ *
+ * @p remaining_s pode ir até max_s da fase.
+ * @return false se a fase ou o tempo restante forem inválidos para o plano.
+ */
+bool phase_engine_resume(phase_engine_t *engine, const phase_plan_t *plan, uint8_t phase,
+    uint16_t remaining_s, uint32_t now_ms);
+
+/**
+ * @brief Avança o motor até o instante @p now_ms.
+ *
+ * Cada fase seguinte começa exatamente no fim da anterior, sem acumular o
+ * atraso de quem chama. Se várias fases expiraram, todas são percorridas.
+ *
+ * @return Número de transições feitas.
+ */
+uint32_t phase_engine_update(phase_engine_t *engine, uint32_t now_ms);
+
+/**
+ * @brief Altera a duração da fase atual, limitada a [min_s, max_s].
+ *
+ * @param engine Motor.
+ * @param duration_s Nova duração total da fase, em segundos.
+ */
+void phase_engine_set_duration(phase_engine_t *engine, uint16_t duration_s);
+
+/**
+ * @brief Ancora o ciclo de um plano coordenado no tempo absoluto @p time_ms.
+ *
+ * @param engine Motor.
+ * @param time_ms Tempo absoluto (por exemplo, ms desde 1970) no instante @p now_ms.
+ * @param now_ms Instante atual.
+ */
+void phase_engine_set_time(phase_engine_t *engine, uint64_t time_ms, uint32_t now_ms);
+
+/**
+ * @brief Troca o plano sem reiniciar, no início de um ciclo.
+ *
+ * A fase em curso termina como estava; as seguintes usam as durações de
+ * @p plan, e a coordenação passa ao ciclo e à defasagem dele (livre até o
+ * próximo phase_engine_set_time()).
+ *
+ * @param engine Motor já iniciado.
+ * @param plan Plano com as mesmas fases (deve continuar válido enquanto estiver em uso).
+ * @param now_ms Instante atual.
+ * @return false, sem trocar, se o número de fases é outro.
+ */
+bool phase_engine_change_plan(phase_engine_t *engine, const phase_plan_t *plan, uint32_t now_ms);
+
+/**
+ * @brief Registra a chamada @p call (atendida no fim da próxima fase que a aceita).
+ */
+void phase_engine_call(phase_engine_t *engine, uint8_t call);
+
+/**
+ * @brief Informa os detectores com presença de veículo.
+ *
+ * Se a fase atual é atuada e o seu detector está em @p detectors, ela passa a
+ * terminar em @p now_ms + passage_s, limitada a max_s desde o início.
+ *
+ * @param engine Motor.
+ * @param detectors Máscara de detectores com presença (bit n = detector n).
+ * @param now_ms Instante atual.
+ */
+void phase_engine_presence(phase_engine_t *engine, uint32_t detectors, uint32_t now_ms);
+
+/**
+ * @brief Encerra a fase atual em @p now_ms (a transição ocorre no próximo update).
+ */
+void phase_engine_expire(phase_engine_t *engine, uint32_t now_ms);
+
+/**
+ * @brief Inicia a preempção para a fase @p target.
+ *
+ * A fase atual termina ao completar o seu mínimo (na hora, se já passou dele)
+ * e as fases seguintes são as do caminho mais curto até @p target, cada uma
+ * no mínimo, sem extensão por detector nem correção de coordenação. Chamadas
+ * pendentes continuam pendentes. @p target fica até phase_engine_preempt_release().
+ * Pode ser chamada com outra preempção em curso (troca o alvo).
+ *
+ * @return false se @p target não existe ou não é alcançável da fase atual.
+ */
+bool phase_engine_preempt(phase_engine_t *engine, uint8_t target, uint32_t now_ms);
+
+/**
+ * @brief Encerra a preempção: a fase alvo termina ao completar o mínimo e o
+ *        plano segue pela sequência normal.
+ *
+ * Em planos coordenados, o próximo ponto de sincronismo mede só o erro de
+ * defasagem (coord_resync), corrigido aos poucos dentro de [min_s, max_s].
+ */
+void phase_engine_preempt_release(phase_engine_t *engine, uint32_t now_ms);
+
+/**
+ * @brief Pior tempo entre o pedido de preempção e o início de @p target,
+ *        de qualquer fase do plano.
+ *
+ * @return Milissegundos, ou UINT32_MAX se alguma fase não alcança @p target.
+ */
+uint32_t phase_engine_preempt_bound_ms(const phase_engine_t *engine, uint8_t target);
+
+/**
+ * @brief Segundos restantes da fase atual, arredondados para cima.
+ */
+uint16_t phase_engine_remaining_s(const phase_engine_t *engine, uint32_t now_ms);
+
+/**
+ * @brief Definição da fase atual.
+ */
+static inline const phase_def_t *phase_engine_current(const phase_engine_t *engine)
+{
+    return &engine->plan->phases[engine->phase];
+}
+
+#endif // PHASE_ENGINE_H
@@ -0,0 +1,168 @@
+#include "phase_plans.h"
+
+/// Índices das fases do plano padrão
+enum {
+    DEFAULT_PHASE_GREEN,
+    DEFAULT_PHASE_YELLOW,
+    DEFAULT_PHASE_RED,
+    DEFAULT_PHASE_WALK,
+    DEFAULT_PHASE_PED_CLEAR,
+    DEFAULT_PHASE_COUNT
+};
+
+/// Detectores (lib/detector.h): 0 na via do semáforo, 1 na via transversal
+enum {
+    DEFAULT_DETECTOR_MAIN,
+    DEFAULT_DETECTOR_CROSS,
+};
+
+/// Chamadas do plano padrão
+enum {
+    DEFAULT_CALL_PEDESTRIAN,
+};
+
+/// Com chamada de pedestre, o amarelo leva à travessia (veículos em vermelho) em vez do vermelho comum
+static const phase_def_t DEFAULT_PHASES[DEFAULT_PHASE_COUNT] = {
+    //                          name         signal               ped                  next                     call                     call_next           detector                min max default passage
+    [DEFAULT_PHASE_GREEN]     = { "verde",     PHASE_SIGNAL_GREEN,  PHASE_PED_DONT_WALK, DEFAULT_PHASE_YELLOW,    PHASE_NO_CALL,           0,                  DEFAULT_DETECTOR_MAIN,  4,  9,  9,      2 },
+    [DEFAULT_PHASE_YELLOW]    = { "amarelo",   PHASE_SIGNAL_YELLOW, PHASE_PED_DONT_WALK, DEFAULT_PHASE_RED,       DEFAULT_CALL_PEDESTRIAN, DEFAULT_PHASE_WALK, PHASE_NO_DETECTOR,      3,  3,  3,      0 },
+    [DEFAULT_PHASE_RED]       = { "vermelho",  PHASE_SIGNAL_RED,    PHASE_PED_DONT_WALK, DEFAULT_PHASE_GREEN,     PHASE_NO_CALL,           0,                  DEFAULT_DETECTOR_CROSS, 3,  9,  6,      2 },
+    [DEFAULT_PHASE_WALK]      = { "travessia", PHASE_SIGNAL_RED,    PHASE_PED_WALK,      DEFAULT_PHASE_PED_CLEAR, PHASE_NO_CALL,           0,                  PHASE_NO_DETECTOR,      5,  5,  5,      0 },
+    [DEFAULT_PHASE_PED_CLEAR] = { "limpeza",   PHASE_SIGNAL_RED,    PHASE_PED_CLEARANCE, DEFAULT_PHASE_GREEN,     PHASE_NO_CALL,           0,                  PHASE_NO_DETECTOR,      7,  7,  7,      0 },
+};
+
+const phase_plan_t PHASE_PLAN_DEFAULT = {
+    .name = "padrao",
+    .phases = DEFAULT_PHASES,
+    .count = DEFAULT_PHASE_COUNT,
+    .initial = DEFAULT_PHASE_GREEN,
+    .pedestrian_call = DEFAULT_CALL_PEDESTRIAN,
+    .cycle_s = 18,   // Soma das durações padrão (9/3/6)
+    .offset_s = 0,
+    .sync_phase = DEFAULT_PHASE_GREEN,
+    .preempt_phase = DEFAULT_PHASE_GREEN,  // Emergência chega pela via do semáforo
+};
+
+/// Índices das fases do cruzamento (NEMA F1 a F8)
+enum {
+    RB_F1, RB_F2, RB_F3, RB_F4, RB_F5, RB_F6, RB_F7, RB_F8, RB_PHASE_COUNT
+};
+
+/// Detectores do cruzamento: 0 na via principal, 1 na via secundária
+enum {
+    RB_DETECTOR_MAIN,
+    RB_DETECTOR_SIDE,
+};
+
+static const rb_phase_def_t RB_DEFAULT_PHASES[RB_PHASE_COUNT] = {
+    //          name                min   max  green yellow red  passage detector          recall
+    [RB_F1] = { "F1 conv. leste",   30,   60,   50,   30,   10,    0,  RB_NO_DETECTOR,    true  },
+    [RB_F2] = { "F2 oeste",        100,  300,  200,   40,   20,   30,  RB_DETECTOR_MAIN,  true  },
+    [RB_F3] = { "F3 conv. norte",   30,   60,   50,   30,   10,    0,  RB_NO_DETECTOR,    true  },
+    [RB_F4] = { "F4 norte",         50,  200,  100,   30,   20,   30,  RB_DETECTOR_SIDE,  false },
+    [RB_F5] = { "F5 conv. oeste",   30,   60,   50,   30,   10,    0,  RB_NO_DETECTOR,    true  },
+    [RB_F6] = { "F6 leste",        100,  300,  200,   40,   20,   30,  RB_DETECTOR_MAIN,  true  },
+    [RB_F7] = { "F7 conv. sul",     30,   60,   50,   30,   10,    0,  RB_NO_DETECTOR,    true  },
+    [RB_F8] = { "F8 sul",           50,  200,  100,   30,   20,   30,  RB_DETECTOR_SIDE,  false },
+};
+
+/// Focos do cruzamento; pixel na ordem de glyph de ws2812b_draw (linha * 5 + coluna)
+static const rb_head_def_t RB_DEFAULT_HEADS[] = {
+    { "oeste frente",   RB_F2, RB_HEAD_THROUGH,  9 },
+    { "oeste conversao", RB_F5, RB_HEAD_LEFT,    14 },
+    { "leste frente",   RB_F6, RB_HEAD_THROUGH, 15 },
+    { "leste conversao", RB_F1, RB_HEAD_LEFT,    10 },
+    { "norte frente",   RB_F4, RB_HEAD_THROUGH, 23 },
+    { "norte conversao", RB_F3, RB_HEAD_LEFT,    22 },
+    { "sul frente",     RB_F8, RB_HEAD_THROUGH,  1 },
+    { "sul conversao",  RB_F7, RB_HEAD_LEFT,     2 },
+};
+
+const rb_plan_t RB_PLAN_DEFAULT = {
+    .name = "cruzamento",
+    .phases = RB_DEFAULT_PHASES,
+    .phase_count = RB_PHASE_COUNT,
+    .sequence = {
+        // Grupo 0 (via principal) | Grupo 1 (via secundária)
+        { { RB_F1, RB_F2 }, { RB_F3, RB_F4 } },   // Anel 1
+        { { RB_F5, RB_F6 }, { RB_F7, RB_F8 } },   // Anel 2
+    },
+    .heads = RB_DEFAULT_HEADS,
+    .head_count = sizeof(RB_DEFAULT_HEADS) / sizeof(RB_DEFAULT_HEADS[0]),
+    .startup_red_ds = 30,
+    .ped_phase = RB_F4,  // Pedestres cruzam a via principal junto com a via norte
+    .cycle_ds = 500,  // Cabe com F4/F8 e sem elas (verdes entre o mínimo e o máximo)
+    .offset_ds = 0,
+    .preempt_phase = RB_F2,  // Emergência chega pelo oeste da via principal
+};
+
+/// Pico: mesmas fases, mais verde para a via do semáforo (a matriz ainda limita a 9 s)
+static const phase_def_t PEAK_PHASES[DEFAULT_PHASE_COUNT] = {
+    //                          name         signal               ped                  next                     call                     call_next           detector                min max default passage
+    [DEFAULT_PHASE_GREEN]     = { "verde",     PHASE_SIGNAL_GREEN,  PHASE_PED_DONT_WALK, DEFAULT_PHASE_YELLOW,    PHASE_NO_CALL,           0,                  DEFAULT_DETECTOR_MAIN,  6,  9,  9,      2 },
+    [DEFAULT_PHASE_YELLOW]    = { "amarelo",   PHASE_SIGNAL_YELLOW, PHASE_PED_DONT_WALK, DEFAULT_PHASE_RED,       DEFAULT_CALL_PEDESTRIAN, DEFAULT_PHASE_WALK, PHASE_NO_DETECTOR,      3,  3,  3,      0 },
+    [DEFAULT_PHASE_RED]       = { "vermelho",  PHASE_SIGNAL_RED,    PHASE_PED_DONT_WALK, DEFAULT_PHASE_GREEN,     PHASE_NO_CALL,           0,                  DEFAULT_DETECTOR_CROSS, 3,  6,  4,      2 },
+    [DEFAULT_PHASE_WALK]      = { "travessia", PHASE_SIGNAL_RED,    PHASE_PED_WALK,      DEFAULT_PHASE_PED_CLEAR, PHASE_NO_CALL,           0,                  PHASE_NO_DETECTOR,      5,  5,  5,      0 },
+    [DEFAULT_PHASE_PED_CLEAR] = { "limpeza",   PHASE_SIGNAL_RED,    PHASE_PED_CLEARANCE, DEFAULT_PHASE_GREEN,     PHASE_NO_CALL,           0,                  PHASE_NO_DETECTOR,      7,  7,  7,      0 },
+};
+
+const phase_plan_t PHASE_PLAN_PEAK = {
+    .name = "pico",
+    .phases = PEAK_PHASES,
+    .count = DEFAULT_PHASE_COUNT,
+    .initial = DEFAULT_PHASE_GREEN,
+    .pedestrian_call = DEFAULT_CALL_PEDESTRIAN,
+    .cycle_s = 16,   // Soma das durações padrão (9/3/4)
+    .offset_s = 0,
+    .sync_phase = DEFAULT_PHASE_GREEN,
+    .preempt_phase = DEFAULT_PHASE_GREEN,
+};
+
+static const rb_phase_def_t RB_PEAK_PHASES[RB_PHASE_COUNT] = {
+    //          name                min   max  green yellow red  passage detector          recall
+    [RB_F1] = { "F1 conv. leste",   30,   60,   50,   30,   10,    0,  RB_NO_DETECTOR,    true  },
+    [RB_F2] = { "F2 oeste",        150,  450,  300,   40,   20,   30,  RB_DETECTOR_MAIN,  true  },
+    [RB_F3] = { "F3 conv. norte",   30,   60,   50,   30,   10,    0,  RB_NO_DETECTOR,    true  },
+    [RB_F4] = { "F4 norte",         50,  200,  100,   30,   20,   30,  RB_DETECTOR_SIDE,  false },
+    [RB_F5] = { "F5 conv. oeste",   30,   60,   50,   30,   10,    0,  RB_NO_DETECTOR,    true  },
+    [RB_F6] = { "F6 leste",        150,  450,  300,   40,   20,   30,  RB_DETECTOR_MAIN,  true  },
+    [RB_F7] = { "F7 conv. sul",     30,   60,   50,   30,   10,    0,  RB_NO_DETECTOR,    true  },
+    [RB_F8] = { "F8 sul",           50,  200,  100,   30,   20,   30,  RB_DETECTOR_SIDE,  false },
+};
+
+const rb_plan_t RB_PLAN_PEAK = {
+    .name = "cruzamento pico",
+    .phases = RB_PEAK_PHASES,
+    .phase_count = RB_PHASE_COUNT,
+    .sequence = {
+        { { RB_F1, RB_F2 }, { RB_F3, RB_F4 } },
+        { { RB_F5, RB_F6 }, { RB_F7, RB_F8 } },
+    },
+    .heads = RB_DEFAULT_HEADS,
+    .head_count = sizeof(RB_DEFAULT_HEADS) / sizeof(RB_DEFAULT_HEADS[0]),
+    .startup_red_ds = 30,
+    .ped_phase = RB_F4,
+    .cycle_ds = 700,  // Soma dos verdes padrão e entreverdes, com F4/F8
+    .offset_ds = 0,
+    .preempt_phase = RB_F2,
+};
+
+const phase_plan_t *const PHASE_PLANS[PLAN_COUNT] = { &PHASE_PLAN_DEFAULT, &PHASE_PLAN_PEAK };
+const rb_plan_t *const RB_PLANS[PLAN_COUNT] = { &RB_PLAN_DEFAULT, &RB_PLAN_PEAK };
+
+static const schedule_entry_t DEFAULT_SCHEDULE_ENTRIES[] = {
+    //  days                 minute    program
+    { SCHEDULE_WEEKDAYS,      6 * 60,  SCHEDULE_DAY   },
+    { SCHEDULE_WEEKDAYS,      7 * 60,  SCHEDULE_PEAK  },
+    { SCHEDULE_WEEKDAYS,      9 * 60,  SCHEDULE_DAY   },
+    { SCHEDULE_WEEKDAYS,     17 * 60,  SCHEDULE_PEAK  },
+    { SCHEDULE_WEEKDAYS,     19 * 60,  SCHEDULE_DAY   },
+    { SCHEDULE_WEEKEND,       7 * 60,  SCHEDULE_DAY   },
+    { SCHEDULE_EVERY_DAY,    23 * 60,  SCHEDULE_NIGHT },
+};
+
+const schedule_t SCHEDULE_DEFAULT = {
+    .name = "semanal",
+    .entries = DEFAULT_SCHEDULE_ENTRIES,
+    .count = sizeof(DEFAULT_SCHEDULE_ENTRIES) / sizeof(DEFAULT_SCHEDULE_ENTRIES[0]),
+};
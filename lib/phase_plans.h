@@ -0,0 +1,69 @@
+#ifndef PHASE_PLANS_H
+#define PHASE_PLANS_H
+
+#include "phase_engine.h"
+#include "ring_barrier.h"
+#include "schedule.h"
+
+/**
+ * @file phase_plans.h
+ * @brief Planos de fases do semáforo (somente dados).
+ *
+ * Um plano novo é uma tabela phase_def_t e um phase_plan_t em phase_plans.c;
+ * não há código a alterar no motor. A matriz de LEDs mostra um só dígito,
+ * então nenhuma fase pode passar de 9 s. Os planos de cruzamento
+ * (rb_plan_t) seguem a mesma ideia para o controlador de anéis e barreiras.
+ * O plano de pico de cada controlador tem as mesmas fases do de dia, com
+ * outras durações e outro ciclo, para o calendário poder trocar um pelo
+ * outro no início de um ciclo.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+/**
+ * @brief Plano padrão atuado: verde de 4 a 9 s (detector 0), amarelo 3 s,
+ *        vermelho de 3 a 9 s (detector 1, via transversal). Com chamada de
+ *        pedestre, o amarelo leva à travessia (5 s) e à limpeza (7 s).
+ */
+extern const phase_plan_t PHASE_PLAN_DEFAULT;
+
+/**
+ * @brief Cruzamento de 8 fases NEMA: via principal leste-oeste (F2/F6, com
+ *        conversões protegidas F1/F5) e via secundária norte-sul (F4/F8, com
+ *        conversões F3/F7), 2 anéis e 2 grupos de concorrência.
+ */
+extern const rb_plan_t RB_PLAN_DEFAULT;
+
+/**
+ * @brief Plano de pico: o padrão com mais verde para a via do semáforo
+ *        (verde de 6 a 9 s, vermelho de 3 a 6 s, ciclo de 16 s).
+ */
+extern const phase_plan_t PHASE_PLAN_PEAK;
+
+/**
+ * @brief Cruzamento no pico: verde da via principal (F2/F6) de 15 a 45 s e
+ *        ciclo de 70 s.
+ */
+extern const rb_plan_t RB_PLAN_PEAK;
+
+/**
+ * @brief Planos por número (o do calendário, do shell e do log de entradas).
+ */
+typedef enum {
+    PLAN_DAY = 0,   /**< Plano de dia (PHASE_PLAN_DEFAULT ou RB_PLAN_DEFAULT) */
+    PLAN_PEAK,      /**< Plano de pico */
+    PLAN_COUNT
+} plan_id_t;
+
+extern const phase_plan_t *const PHASE_PLANS[PLAN_COUNT];   /**< Planos de foco único por plan_id_t */
+extern const rb_plan_t *const RB_PLANS[PLAN_COUNT];         /**< Planos de cruzamento por plan_id_t */
+
+/**
+ * @brief Calendário semanal padrão (hora local): pico de 7 h às 9 h e de
+ *        17 h às 19 h nos dias úteis, noite (amarelo piscante) das 23 h às
+ *        6 h (7 h no fim de semana) e dia no resto.
+ */
+extern const schedule_t SCHEDULE_DEFAULT;
+
+#endif // PHASE_PLANS_H
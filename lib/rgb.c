@@ -207,4 +207,23 @@ void rgb_turn_on_by_color(const rgb_t *pins, uint8_t color)
             rgb_turn_on_green(pins, 255);
             break;
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Lê o nível de comparação do canal PWM de um pino.
+ * 
+ * @param pin Pino GPIO.
+ * @return Nível gravado no registrador CC da fatia (canal A nos 16 bits baixos, B nos altos).
+ */
+static uint16_t read_gpio_level(uint8_t pin)
+{
+    uint32_t cc = pwm_hw->slice[pwm_gpio_to_slice_num(pin)].cc;
+    return (uint16_t) ((pwm_gpio_to_channel(pin) == PWM_CHAN_B) ? (cc >> 16) : (cc & 0xFFFFu));
+}
+
+void rgb_read_levels(const rgb_t *pins, uint16_t levels[3])
+{
+    levels[0] = read_gpio_level(pins->red_pin);
+    levels[1] = read_gpio_level(pins->green_pin);
+    levels[2] = read_gpio_level(pins->blue_pin);
+}
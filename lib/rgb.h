@@ -117,4 +117,12 @@ void rgb_turn_on_by_gpio(uint8_t pin, uint8_t intensity);
 
 void rgb_turn_on_by_color(const rgb_t *pins, uint8_t color);
 
+/**
+ * @brief Lê de volta os níveis de PWM comandados (registradores de comparação).
+ * 
+ * @param pins Estrutura contendo os pinos dos LEDs RGB.
+ * @param levels Saída: níveis do vermelho, do verde e do azul.
+ */
+void rgb_read_levels(const rgb_t *pins, uint16_t levels[3]);
+
 #endif // RGB_H
@@ -0,0 +1,378 @@
+#include <string.h>
+#include "ring_barrier.h"
+
+bool rb_plan_is_valid(const rb_plan_t *plan)
+{
+    uint8_t seen = 0;
+
+    if(!plan || !plan->phases || plan->phase_count == 0 || plan->phase_count > RB_MAX_PHASES) return false;
+    if(plan->head_count > RB_MAX_HEADS || (plan->head_count && !plan->heads)) return false;
+    if(plan->ped_phase != RB_NO_PHASE && plan->ped_phase >= plan->phase_count) return false;
+    if(plan->cycle_ds && plan->offset_ds >= plan->cycle_ds) return false;
+    if(plan->preempt_phase != RB_NO_PHASE && plan->preempt_phase >= plan->phase_count) return false;
+    for(uint8_t r = 0; r < RB_RINGS; r++)
+        for(uint8_t g = 0; g < RB_GROUPS; g++)
+            for(uint8_t s = 0; s < RB_GROUP_SLOTS; s++)
+            {
+                uint8_t phase = plan->sequence[r][g][s];
+                if(phase == RB_NO_PHASE) continue;
+                if(phase >= plan->phase_count || (seen & (1u << phase))) return false;
+                seen |= (uint8_t) (1u << phase);
+            }
+    if(seen != (uint8_t) ((1u << plan->phase_count) - 1u)) return false;
+    for(uint8_t i = 0; i < plan->phase_count; i++)
+    {
+        const rb_phase_def_t *phase = &plan->phases[i];
+        if(phase->min_green_ds == 0 || phase->yellow_ds == 0) return false;
+        if(phase->min_green_ds > phase->green_ds || phase->green_ds > phase->max_green_ds) return false;
+        if(phase->detector != RB_NO_DETECTOR && (phase->detector >= 32 || phase->passage_ds == 0)) return false;
+    }
+    for(uint8_t i = 0; i < plan->head_count; i++)
+        if(plan->heads[i].phase >= plan->phase_count || plan->heads[i].pixel >= 25) return false;
+    return true;
+}
+
+bool rb_plan_phases_compatible(const rb_plan_t *plan, uint8_t a, uint8_t b)
+{
+    uint8_t ring[2] = { RB_RINGS, RB_RINGS };
+    uint8_t group[2] = { 0, 0 };
+
+    if(a == b) return true;
+    for(uint8_t r = 0; r < RB_RINGS; r++)
+        for(uint8_t g = 0; g < RB_GROUPS; g++)
+            for(uint8_t s = 0; s < RB_GROUP_SLOTS; s++)
+            {
+                uint8_t phase = plan->sequence[r][g][s];
+                uint8_t which = (phase == a) ? 0 : (phase == b) ? 1 : 2;
+                if(which == 2) continue;
+                ring[which] = r;
+                group[which] = g;
+            }
+    return ring[0] < RB_RINGS && ring[1] < RB_RINGS && ring[0] != ring[1] && group[0] == group[1];
+}
+
+/**
+ * @brief Coloca o anel @p ring no intervalo @p interval, de @p start_ms a start_ms + duration_ds.
+ */
+static void rb_ring_enter(rb_controller_t *ctrl, uint8_t ring, uint8_t interval, uint32_t start_ms, uint16_t duration_ds)
+{
+    rb_ring_t *state = &ctrl->rings[ring];
+    state->interval = interval;
+    state->start_ms = start_ms;
+    state->duration_ms = (uint32_t) duration_ds * 100u;
+}
+
+/**
+ * @brief Fase do anel @p ring na posição @p slot do grupo atual.
+ */
+static inline uint8_t rb_ring_phase(const rb_controller_t *ctrl, uint8_t ring, uint8_t slot)
+{
+    return ctrl->plan->sequence[ring][ctrl->group][slot];
+}
+
+/**
+ * @brief Próxima posição, a partir de @p from, com fase a atender no grupo @p group.
+ *
+ * Durante a preempção, só a fase alvo é atendida.
+ *
+ * @return RB_GROUP_SLOTS se não houver.
+ */
+static uint8_t rb_next_slot(const rb_controller_t *ctrl, uint8_t ring, uint8_t group, uint8_t from)
+{
+    for(uint8_t s = from; s < RB_GROUP_SLOTS; s++)
+    {
+        uint8_t phase = ctrl->plan->sequence[ring][group][s];
+        if(phase == RB_NO_PHASE) continue;
+        if(ctrl->preempt != RB_NO_PHASE)
+        {
+            if(phase == ctrl->preempt) return s;
+            continue;
+        }
+        if(ctrl->plan->phases[phase].recall || (ctrl->calls & (1u << phase))) return s;
+    }
+    return RB_GROUP_SLOTS;
+}
+
+/**
+ * @brief Inicia o verde da posição @p slot ou, se não houver fase, espera na barreira.
+ *
+ * @return Número de mudanças de sinal (0 ou 1).
+ */
+static uint32_t rb_ring_begin_slot(rb_controller_t *ctrl, uint8_t ring, uint8_t slot, uint32_t start_ms)
+{
+    ctrl->rings[ring].slot = slot;
+    if(slot >= RB_GROUP_SLOTS)
+    {
+        rb_ring_enter(ctrl, ring, RB_INTERVAL_BARRIER, start_ms, 0);
+        return 0;
+    }
+    uint8_t phase = rb_ring_phase(ctrl, ring, slot);
+    const rb_phase_def_t *def = &ctrl->plan->phases[phase];
+    ctrl->signals[phase] = PHASE_SIGNAL_GREEN;
+    ctrl->calls &= (uint8_t) ~(1u << phase);
+    // Verde atuado começa no mínimo e cresce com a presença
+    rb_ring_enter(ctrl, ring, RB_INTERVAL_GREEN, start_ms,
+        (def->detector != RB_NO_DETECTOR) ? def->min_green_ds : def->green_ds);
+    // Coordenado: o verde começa no padrão (a parte da fase no ciclo) mais a correção
+    if(ctrl->preempt != RB_NO_PHASE)
+        ctrl->rings[ring].duration_ms = (uint32_t) def->min_green_ds * 100u;
+    else if(coord_active(&ctrl->coord))
+        ctrl->rings[ring].duration_ms = coord_adjust(&ctrl->rings[ring].correction_ms, (uint32_t) def->green_ds * 100u,
+            (uint32_t) def->min_green_ds * 100u, (uint32_t) def->max_green_ds * 100u);
+    return 1;
+}
+
+/**
+ * @brief Avança um anel até @p now_ms, parando na barreira.
+ *
+ * @return Número de mudanças de sinal.
+ */
+static uint32_t rb_ring_advance(rb_controller_t *ctrl, uint8_t ring, uint32_t now_ms)
+{
+    rb_ring_t *state = &ctrl->rings[ring];
+    uint32_t count = 0;
+
+    while(state->interval != RB_INTERVAL_BARRIER && now_ms - state->start_ms >= state->duration_ms)
+    {
+        uint32_t end_ms = state->start_ms + state->duration_ms;
+        uint8_t phase = (state->slot < RB_GROUP_SLOTS) ? rb_ring_phase(ctrl, ring, state->slot) : RB_NO_PHASE;
+
+        switch(state->interval)
+        {
+            case RB_INTERVAL_GREEN:
+                if(phase == ctrl->preempt)
+                {
+                    // O alvo da preempção fica verde até o fim da preempção
+                    state->duration_ms = now_ms - state->start_ms;
+                    return count;
+                }
+                if(ctrl->plan->phases[phase].detector != RB_NO_DETECTOR)
+                {
+                    if(state->duration_ms >= (uint32_t) ctrl->plan->phases[phase].max_green_ds * 100u) ctrl->max_outs++;
+                    else ctrl->gap_outs++;
+                }
+                ctrl->signals[phase] = PHASE_SIGNAL_YELLOW;
+                rb_ring_enter(ctrl, ring, RB_INTERVAL_YELLOW, end_ms, ctrl->plan->phases[phase].yellow_ds);
+                count++;
+                break;
+            case RB_INTERVAL_YELLOW:
+                ctrl->signals[phase] = PHASE_SIGNAL_RED;
+                rb_ring_enter(ctrl, ring, RB_INTERVAL_RED_CLEAR, end_ms, ctrl->plan->phases[phase].red_clear_ds);
+                count++;
+                break;
+            default:  // Fim do vermelho de limpeza: próxima fase do grupo ou barreira
+                count += rb_ring_begin_slot(ctrl, ring,
+                    rb_next_slot(ctrl, ring, ctrl->group, (uint8_t) (state->slot + 1u)), end_ms);
+                break;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Cruza a barreira para o próximo grupo com demanda.
+ *
+ * @param cross_ms Instante do cruzamento (fim do último anel a chegar).
+ * @return Número de mudanças de sinal; 0 se nenhuma fase tem demanda.
+ */
+static uint32_t rb_cross_barrier(rb_controller_t *ctrl, uint32_t cross_ms)
+{
+    for(uint8_t g = 1; g <= RB_GROUPS; g++)
+    {
+        uint8_t group = (uint8_t) ((ctrl->group + g) % RB_GROUPS);
+        uint8_t slots[RB_RINGS];
+        bool demand = false;
+
+        for(uint8_t r = 0; r < RB_RINGS; r++)
+        {
+            slots[r] = rb_next_slot(ctrl, r, group, 0);
+            if(slots[r] < RB_GROUP_SLOTS) demand = true;
+        }
+        if(!demand) continue;
+        ctrl->group = group;
+        if(group == 0 && coord_active(&ctrl->coord) && ctrl->preempt == RB_NO_PHASE)
+        {
+            // Ponto de sincronismo: os dois anéis recebem a mesma correção
+            int32_t correction = coord_sync_point(&ctrl->coord, cross_ms, ctrl->rings[0].correction_ms);
+            for(uint8_t r = 0; r < RB_RINGS; r++) ctrl->rings[r].correction_ms = correction;
+        }
+        uint32_t count = 0;
+        for(uint8_t r = 0; r < RB_RINGS; r++) count += rb_ring_begin_slot(ctrl, r, slots[r], cross_ms);
+        return count;
+    }
+    return 0;
+}
+
+void rb_controller_start(rb_controller_t *ctrl, const rb_plan_t *plan, uint32_t now_ms)
+{
+    ctrl->plan = plan;
+    ctrl->group = RB_GROUPS - 1u;  // O primeiro cruzamento leva ao grupo 0
+    ctrl->calls = 0;
+    ctrl->transitions = 0;
+    ctrl->gap_outs = 0;
+    ctrl->max_outs = 0;
+    ctrl->preempt = RB_NO_PHASE;
+    ctrl->preemptions = 0;
+    for(uint8_t i = 0; i < RB_MAX_PHASES; i++) ctrl->signals[i] = PHASE_SIGNAL_RED;
+    for(uint8_t r = 0; r < RB_RINGS; r++)
+    {
+        ctrl->rings[r].slot = RB_GROUP_SLOTS;
+        ctrl->rings[r].correction_ms = 0;
+        rb_ring_enter(ctrl, r, RB_INTERVAL_RED_CLEAR, now_ms, plan->startup_red_ds);
+    }
+    // O primeiro ciclo começa no fim do vermelho de partida
+    coord_init(&ctrl->coord, (uint32_t) plan->cycle_ds * 100u, (uint32_t) plan->offset_ds * 100u,
+        now_ms + (uint32_t) plan->startup_red_ds * 100u);
+}
+
+void rb_controller_set_time(rb_controller_t *ctrl, uint64_t time_ms, uint32_t now_ms)
+{
+    coord_set_time(&ctrl->coord, time_ms, now_ms);
+}
+
+bool rb_controller_change_plan(rb_controller_t *ctrl, const rb_plan_t *plan, uint32_t now_ms)
+{
+    const rb_plan_t *old = ctrl->plan;
+
+    if(plan->phase_count != old->phase_count || plan->head_count != old->head_count
+        || memcmp(plan->sequence, old->sequence, sizeof(plan->sequence)) != 0
+        || memcmp(plan->heads, old->heads, plan->head_count * sizeof(plan->heads[0])) != 0)
+        return false;
+    ctrl->plan = plan;
+    for(uint8_t r = 0; r < RB_RINGS; r++) ctrl->rings[r].correction_ms = 0;
+    coord_init(&ctrl->coord, (uint32_t) plan->cycle_ds * 100u, (uint32_t) plan->offset_ds * 100u, now_ms);
+    return true;
+}
+
+void rb_controller_call(rb_controller_t *ctrl, uint8_t phase)
+{
+    if(phase < ctrl->plan->phase_count) ctrl->calls |= (uint8_t) (1u << phase);
+}
+
+void rb_controller_presence(rb_controller_t *ctrl, uint32_t detectors, uint32_t now_ms)
+{
+    for(uint8_t r = 0; r < RB_RINGS && ctrl->preempt == RB_NO_PHASE; r++)
+    {
+        rb_ring_t *state = &ctrl->rings[r];
+        uint32_t elapsed = now_ms - state->start_ms;
+        if(state->interval != RB_INTERVAL_GREEN || elapsed >= state->duration_ms) continue;
+
+        const rb_phase_def_t *def = &ctrl->plan->phases[rb_ring_phase(ctrl, r, state->slot)];
+        if(def->detector == RB_NO_DETECTOR || !(detectors & (1u << def->detector))) continue;
+        uint32_t end_ms = elapsed + (uint32_t) def->passage_ds * 100u;
+        if(end_ms > (uint32_t) def->max_green_ds * 100u) end_ms = (uint32_t) def->max_green_ds * 100u;
+        if(end_ms > state->duration_ms) state->duration_ms = end_ms;
+    }
+    for(uint8_t p = 0; p < ctrl->plan->phase_count; p++)
+    {
+        uint8_t detector = ctrl->plan->phases[p].detector;
+        if(detector != RB_NO_DETECTOR && (detectors & (1u << detector)) && ctrl->signals[p] != PHASE_SIGNAL_GREEN)
+            ctrl->calls |= (uint8_t) (1u << p);
+    }
+}
+
+uint32_t rb_controller_update(rb_controller_t *ctrl, uint32_t now_ms)
+{
+    uint32_t count = 0;
+
+    while(1)
+    {
+        uint32_t cross_ms = 0;
+        uint32_t latest_elapsed = UINT32_MAX;
+        bool at_barrier = true;
+
+        for(uint8_t r = 0; r < RB_RINGS; r++)
+        {
+            count += rb_ring_advance(ctrl, r, now_ms);
+            if(ctrl->rings[r].interval != RB_INTERVAL_BARRIER) at_barrier = false;
+            else if(now_ms - ctrl->rings[r].start_ms < latest_elapsed)
+            {
+                latest_elapsed = now_ms - ctrl->rings[r].start_ms;
+                cross_ms = ctrl->rings[r].start_ms;
+            }
+        }
+        if(!at_barrier) break;
+
+        uint32_t crossed = rb_cross_barrier(ctrl, cross_ms);
+        if(!crossed)
+        {
+            // Sem demanda: repousa em vermelho geral e cruza quando chegar uma chamada
+            for(uint8_t r = 0; r < RB_RINGS; r++) ctrl->rings[r].start_ms = now_ms;
+            break;
+        }
+        count += crossed;
+    }
+    ctrl->transitions += count;
+    return count;
+}
+
+bool rb_controller_preempt(rb_controller_t *ctrl, uint8_t phase, uint32_t now_ms)
+{
+    if(phase >= ctrl->plan->phase_count) return false;
+    if(ctrl->preempt != phase) ctrl->preemptions++;
+    ctrl->preempt = phase;
+    for(uint8_t r = 0; r < RB_RINGS; r++)
+    {
+        rb_ring_t *state = &ctrl->rings[r];
+        uint32_t elapsed = now_ms - state->start_ms;
+        state->correction_ms = 0;
+        if(state->interval != RB_INTERVAL_GREEN || elapsed >= state->duration_ms) continue;
+        uint32_t min_ms = (uint32_t) ctrl->plan->phases[rb_ring_phase(ctrl, r, state->slot)].min_green_ds * 100u;
+        state->duration_ms = (elapsed > min_ms) ? elapsed : min_ms;
+    }
+    return true;
+}
+
+void rb_controller_preempt_release(rb_controller_t *ctrl, uint32_t now_ms)
+{
+    (void) now_ms;
+    if(ctrl->preempt == RB_NO_PHASE) return;
+    ctrl->preempt = RB_NO_PHASE;
+    for(uint8_t r = 0; r < RB_RINGS; r++) ctrl->rings[r].correction_ms = 0;
+    coord_resync(&ctrl->coord);
+}
+
+uint32_t rb_controller_preempt_bound_ms(const rb_controller_t *ctrl)
+{
+    uint32_t worst_ds = ctrl->plan->startup_red_ds;
+
+    for(uint8_t i = 0; i < ctrl->plan->phase_count; i++)
+    {
+        const rb_phase_def_t *def = &ctrl->plan->phases[i];
+        uint32_t clear_ds = (uint32_t) def->min_green_ds + def->yellow_ds + def->red_clear_ds;
+        if(clear_ds > worst_ds) worst_ds = clear_ds;
+    }
+    return worst_ds * 100u;
+}
+
+uint16_t rb_controller_remaining_ds(const rb_controller_t *ctrl, uint8_t ring, uint32_t now_ms)
+{
+    const rb_ring_t *state = &ctrl->rings[ring];
+    uint32_t elapsed = now_ms - state->start_ms;
+
+    if(state->interval == RB_INTERVAL_BARRIER || elapsed >= state->duration_ms) return 0;
+    return (uint16_t) ((state->duration_ms - elapsed + 99u) / 100u);
+}
+
+uint8_t rb_controller_ped(const rb_controller_t *ctrl)
+{
+    uint8_t phase = ctrl->plan->ped_phase;
+
+    if(phase == RB_NO_PHASE) return PHASE_PED_DONT_WALK;
+    if(ctrl->signals[phase] == PHASE_SIGNAL_GREEN) return PHASE_PED_WALK;
+    // Amarelo ou vermelho de limpeza da própria fase: quem já está na faixa termina a travessia
+    for(uint8_t r = 0; r < RB_RINGS; r++)
+    {
+        const rb_ring_t *state = &ctrl->rings[r];
+        if(state->slot < RB_GROUP_SLOTS && rb_ring_phase(ctrl, r, state->slot) == phase
+            && state->interval != RB_INTERVAL_BARRIER)
+            return PHASE_PED_CLEARANCE;
+    }
+    return PHASE_PED_DONT_WALK;
+}
+
+void rb_controller_heads(const rb_controller_t *ctrl, uint8_t *signals)
+{
+    for(uint8_t i = 0; i < ctrl->plan->head_count; i++)
+        signals[i] = ctrl->signals[ctrl->plan->heads[i].phase];
+}
@@ -0,0 +1,258 @@
+#ifndef RING_BARRIER_H
+#define RING_BARRIER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "phase_engine.h"
+#include "coordination.h"
+
+/**
+ * @file ring_barrier.h
+ * @brief Controlador de cruzamento em anéis e barreiras (estilo NEMA).
+ *
+ * O plano tem até 8 fases distribuídas em 2 anéis. Cada anel percorre suas
+ * fases em sequência (verde, amarelo, vermelho de limpeza) e os anéis rodam
+ * em paralelo. As barreiras dividem o ciclo em grupos de concorrência: as
+ * fases de um grupo, em anéis diferentes, podem estar verdes ao mesmo tempo,
+ * e nenhum anel cruza a barreira antes que todos terminem o grupo. Fases sem
+ * chamada e sem recall são puladas. Fases com detector são atuadas: o verde
+ * começa no mínimo, cada presença o estende por passage_ds até o máximo, e a
+ * presença com a fase fora do verde registra uma chamada.
+ *
+ * Cada fase aciona um ou mais focos (rb_head_def_t), por exemplo o foco de
+ * seguir em frente e o de conversão protegida de uma aproximação. A travessia
+ * de pedestres acompanha a fase ped_phase: "atravesse" no verde e limpeza no
+ * amarelo e no vermelho de limpeza; o botão de pedestre chama essa fase.
+ * Planos com cycle_ds são coordenados (coordination.h) depois de
+ * rb_controller_set_time(): o cruzamento da barreira para o grupo 0 é o ponto
+ * de sincronismo, e a correção é gasta nos verdes de cada anel, entre o verde
+ * mínimo e o máximo. Até lá o plano roda livre e atuado.
+ *
+ * A preempção (veículo de emergência) encerra os verdes no mínimo, serve só
+ * a fase alvo, que fica verde até o fim da preempção, e deixa o outro anel
+ * esperando na barreira; o atraso até o verde do alvo é limitado por
+ * rb_controller_preempt_bound_ms().
+ *
+ * Como o motor de fases, o controlador é só C: o tempo é passado por quem
+ * chama, em milissegundos, e as durações do plano são em décimos de segundo.
+ * A avaliação por tick é O(anéis); cada transição é uma consulta à tabela.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define RB_RINGS        2      /**< Anéis */
+#define RB_GROUPS       2      /**< Grupos de concorrência (barreiras por ciclo) */
+#define RB_GROUP_SLOTS  2      /**< Fases por anel em cada grupo */
+#define RB_MAX_PHASES   8      /**< Máximo de fases em um plano */
+#define RB_MAX_HEADS    8      /**< Máximo de focos em um plano */
+#define RB_NO_PHASE     0xFF   /**< Posição vazia na sequência de um anel */
+#define RB_NO_DETECTOR  0xFF   /**< Fase sem detector (verde fixo) */
+
+/**
+ * @brief Intervalo em que um anel está.
+ */
+typedef enum {
+    RB_INTERVAL_GREEN,       /**< Verde da fase atual */
+    RB_INTERVAL_YELLOW,      /**< Amarelo da fase atual */
+    RB_INTERVAL_RED_CLEAR,   /**< Vermelho de limpeza (todos vermelhos no anel) */
+    RB_INTERVAL_BARRIER,     /**< Esperando os outros anéis na barreira */
+} rb_interval_t;
+
+/**
+ * @brief Tipo de foco.
+ */
+typedef enum {
+    RB_HEAD_THROUGH,         /**< Seguir em frente */
+    RB_HEAD_LEFT,            /**< Conversão protegida */
+} rb_head_kind_t;
+
+/**
+ * @brief Uma fase do plano (durações em décimos de segundo).
+ */
+typedef struct {
+    const char *name;        /**< Nome da fase (log e ferramentas) */
+    uint16_t min_green_ds;   /**< Verde mínimo */
+    uint16_t max_green_ds;   /**< Verde máximo */
+    uint16_t green_ds;       /**< Verde padrão */
+    uint16_t yellow_ds;      /**< Amarelo */
+    uint16_t red_clear_ds;   /**< Vermelho de limpeza */
+    uint16_t passage_ds;     /**< Extensão do verde por presença (fases atuadas) */
+    uint8_t detector;        /**< Detector da fase, ou RB_NO_DETECTOR */
+    bool recall;             /**< Atendida em todo ciclo, mesmo sem chamada */
+} rb_phase_def_t;
+
+/**
+ * @brief Um foco acionado por uma fase.
+ */
+typedef struct {
+    const char *name;        /**< Nome do foco */
+    uint8_t phase;           /**< Índice da fase que o aciona */
+    uint8_t kind;            /**< rb_head_kind_t */
+    uint8_t pixel;           /**< LED da matriz 5x5 que o representa (0 a 24) */
+} rb_head_def_t;
+
+/**
+ * @brief Plano de cruzamento.
+ */
+typedef struct {
+    const char *name;                                         /**< Nome do plano */
+    const rb_phase_def_t *phases;                             /**< Tabela de fases */
+    uint8_t phase_count;                                      /**< Número de fases */
+    uint8_t sequence[RB_RINGS][RB_GROUPS][RB_GROUP_SLOTS];    /**< Fases de cada anel por grupo */
+    const rb_head_def_t *heads;                               /**< Tabela de focos */
+    uint8_t head_count;                                       /**< Número de focos */
+    uint16_t startup_red_ds;                                  /**< Vermelho geral na partida */
+    uint8_t ped_phase;                                        /**< Fase da travessia de pedestres, ou RB_NO_PHASE */
+    uint16_t cycle_ds;                                        /**< Ciclo coordenado (0: livre) */
+    uint16_t offset_ds;                                       /**< Defasagem da entrada no grupo 0 no ciclo */
+    uint8_t preempt_phase;                                    /**< Fase pedida pela entrada de preempção, ou RB_NO_PHASE */
+} rb_plan_t;
+
+/**
+ * @brief Estado de um anel.
+ */
+typedef struct {
+    uint8_t slot;            /**< Posição no grupo atual */
+    uint8_t interval;        /**< rb_interval_t */
+    uint32_t start_ms;       /**< Início do intervalo */
+    uint32_t duration_ms;    /**< Duração do intervalo */
+    int32_t correction_ms;   /**< Correção de coordenação ainda não aplicada */
+} rb_ring_t;
+
+/**
+ * @brief Estado do controlador.
+ */
+typedef struct {
+    const rb_plan_t *plan;                /**< Plano em execução */
+    uint8_t group;                        /**< Grupo de concorrência atual */
+    uint8_t calls;                        /**< Chamadas pendentes, um bit por fase */
+    uint8_t signals[RB_MAX_PHASES];       /**< phase_signal_t de cada fase */
+    rb_ring_t rings[RB_RINGS];            /**< Anéis */
+    uint32_t transitions;                 /**< Mudanças de sinal desde a partida */
+    uint32_t gap_outs;                    /**< Verdes atuados encerrados por falta de demanda */
+    uint32_t max_outs;                    /**< Verdes atuados encerrados no máximo */
+    coord_t coord;                        /**< Ciclo e defasagem (planos coordenados) */
+    uint8_t preempt;                      /**< Fase alvo da preempção em curso, ou RB_NO_PHASE */
+    uint32_t preemptions;                 /**< Preempções desde a partida */
+} rb_controller_t;
+
+/**
+ * @brief Verifica a consistência de um plano (cada fase em exatamente uma
+ *        posição dos anéis, focos e durações válidos).
+ *
+ * @return true se o plano pode ser executado.
+ */
+bool rb_plan_is_valid(const rb_plan_t *plan);
+
+/**
+ * @brief Informa se duas fases podem estar verdes ao mesmo tempo: a mesma
+ *        fase, ou fases de anéis diferentes no mesmo grupo de concorrência.
+ *
+ * Derivada só da sequência do plano, não do estado do controlador (matriz
+ * de compatibilidade do monitor de conflitos).
+ */
+bool rb_plan_phases_compatible(const rb_plan_t *plan, uint8_t a, uint8_t b);
+
+/**
+ * @brief Parte o plano com todos os focos vermelhos por startup_red_ds.
+ *
+ * @param ctrl Controlador.
+ * @param plan Plano (deve continuar válido enquanto estiver em uso).
+ * @param now_ms Instante atual.
+ */
+void rb_controller_start(rb_controller_t *ctrl, const rb_plan_t *plan, uint32_t now_ms);
+
+/**
+ * @brief Ancora o ciclo de um plano coordenado no tempo absoluto @p time_ms, lido em @p now_ms.
+ */
+void rb_controller_set_time(rb_controller_t *ctrl, uint64_t time_ms, uint32_t now_ms);
+
+/**
+ * @brief Troca o plano sem reiniciar, no início de um ciclo (ao cruzar para o grupo 0).
+ *
+ * Os intervalos em curso terminam como estavam; os seguintes usam as
+ * durações de @p plan, e a coordenação passa ao ciclo e à defasagem dele
+ * (livre até o próximo rb_controller_set_time()).
+ *
+ * @return false, sem trocar, se as fases, a sequência ou os focos são outros.
+ */
+bool rb_controller_change_plan(rb_controller_t *ctrl, const rb_plan_t *plan, uint32_t now_ms);
+
+/**
+ * @brief Registra uma chamada (demanda) para a fase @p phase.
+ */
+void rb_controller_call(rb_controller_t *ctrl, uint8_t phase);
+
+/**
+ * @brief Informa os detectores com presença de veículo.
+ *
+ * Fase atuada em verde: o verde passa a terminar em @p now_ms + passage_ds,
+ * limitado ao verde máximo. Fase fora do verde: registra uma chamada.
+ *
+ * @param ctrl Controlador.
+ * @param detectors Máscara de detectores com presença (bit n = detector n).
+ * @param now_ms Instante atual.
+ */
+void rb_controller_presence(rb_controller_t *ctrl, uint32_t detectors, uint32_t now_ms);
+
+/**
+ * @brief Avança os anéis até o instante @p now_ms.
+ *
+ * Cada intervalo começa exatamente no fim do anterior, e os anéis cruzam a
+ * barreira juntos, no fim do último a chegar.
+ *
+ * @return Número de mudanças de sinal feitas.
+ */
+uint32_t rb_controller_update(rb_controller_t *ctrl, uint32_t now_ms);
+
+/**
+ * @brief Inicia a preempção para a fase @p phase.
+ *
+ * Os verdes das outras fases terminam ao completar o mínimo (na hora, se já
+ * passaram dele) e seguem para amarelo e vermelho de limpeza; nenhuma outra
+ * fase é iniciada, sem extensão por detector nem correção de coordenação.
+ * @p phase fica verde até rb_controller_preempt_release(). Pode ser chamada
+ * com outra preempção em curso (troca o alvo).
+ *
+ * @return false se @p phase não existe.
+ */
+bool rb_controller_preempt(rb_controller_t *ctrl, uint8_t phase, uint32_t now_ms);
+
+/**
+ * @brief Encerra a preempção: o verde do alvo termina ao completar o mínimo e
+ *        os anéis seguem a sequência normal.
+ *
+ * Em planos coordenados, o próximo ponto de sincronismo mede só o erro de
+ * defasagem (coord_resync).
+ */
+void rb_controller_preempt_release(rb_controller_t *ctrl, uint32_t now_ms);
+
+/**
+ * @brief Pior tempo entre o pedido de preempção e o verde da fase alvo:
+ *        o maior verde mínimo mais amarelo e vermelho de limpeza do plano,
+ *        ou o vermelho de partida, se maior.
+ */
+uint32_t rb_controller_preempt_bound_ms(const rb_controller_t *ctrl);
+
+/**
+ * @brief Tempo restante do intervalo atual do anel @p ring, em décimos de segundo.
+ *
+ * @return 0 se o anel está esperando na barreira.
+ */
+uint16_t rb_controller_remaining_ds(const rb_controller_t *ctrl, uint8_t ring, uint32_t now_ms);
+
+/**
+ * @brief Indicação de pedestre (phase_ped_t) da travessia do plano.
+ */
+uint8_t rb_controller_ped(const rb_controller_t *ctrl);
+
+/**
+ * @brief Sinal de cada foco do plano.
+ *
+ * @param ctrl Controlador.
+ * @param signals Saída, head_count posições com o phase_signal_t do foco.
+ */
+void rb_controller_heads(const rb_controller_t *ctrl, uint8_t *signals);
+
+#endif // RING_BARRIER_H
@@ -0,0 +1,87 @@
+#include "ring_bench.h"
+#include "spsc_ring.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include <stdio.h>
+
+static uint32_t bench_queue_storage[RING_BENCH_CAPACITY];
+static StaticQueue_t bench_queue_buffer;
+SPSC_RING_STORAGE(bench_ring_storage, uint32_t, RING_BENCH_CAPACITY);
+
+/**
+ * @brief Converte a duração de uma medição em ciclos por elemento.
+ */
+static uint32_t ring_bench_cycles(uint64_t start_us, uint64_t end_us)
+{
+    uint64_t cycles = (end_us - start_us) * (uint64_t) clock_get_hz(clk_sys) / 1000000u;
+    return (uint32_t) (cycles / RING_BENCH_ITEMS);
+}
+
+/**
+ * @brief Envio e recebimento alternados pela API de tarefa da fila.
+ */
+static uint32_t ring_bench_queue(QueueHandle_t queue)
+{
+    uint32_t value = 0;
+    uint64_t start = time_us_64();
+    for(uint32_t i = 0; i < RING_BENCH_ITEMS; i++)
+    {
+        xQueueSend(queue, &i, 0);
+        xQueueReceive(queue, &value, 0);
+    }
+    return ring_bench_cycles(start, time_us_64());
+}
+
+/**
+ * @brief Envio e recebimento alternados pela API FromISR da fila.
+ */
+static uint32_t ring_bench_queue_from_isr(QueueHandle_t queue)
+{
+    uint32_t value = 0;
+    BaseType_t woken = pdFALSE;
+    uint64_t start = time_us_64();
+    for(uint32_t i = 0; i < RING_BENCH_ITEMS; i++)
+    {
+        xQueueSendFromISR(queue, &i, &woken);
+        xQueueReceiveFromISR(queue, &value, &woken);
+    }
+    return ring_bench_cycles(start, time_us_64());
+}
+
+/**
+ * @brief Escrita e leitura no buffer SPSC, @p batch elementos por chamada.
+ */
+static uint32_t ring_bench_spsc(spsc_ring_t *ring, uint32_t batch)
+{
+    uint32_t values[RING_BENCH_BATCH];
+    uint64_t start = time_us_64();
+    for(uint32_t i = 0; i < RING_BENCH_ITEMS; i += batch)
+    {
+        for(uint32_t j = 0; j < batch; j++) values[j] = i + j;
+        spsc_ring_push(ring, values, batch);
+        spsc_ring_pop(ring, values, batch);
+    }
+    return ring_bench_cycles(start, time_us_64());
+}
+
+void vRingBenchTask(void *pvParameters)
+{
+    QueueHandle_t queue = xQueueCreateStatic(RING_BENCH_CAPACITY, sizeof(uint32_t),
+        (uint8_t *) bench_queue_storage, &bench_queue_buffer);
+    spsc_ring_t ring;
+
+    spsc_ring_init(&ring, bench_ring_storage, sizeof(uint32_t), RING_BENCH_CAPACITY);
+    while(1)
+    {
+        vTaskDelay(pdMS_TO_TICKS(RING_BENCH_PERIOD_MS));
+        printf("ring bench: ciclos por elemento (push + pop, %u elementos)\n", RING_BENCH_ITEMS);
+        printf("  xQueueSend/Receive         %lu\n", (unsigned long) ring_bench_queue(queue));
+        printf("  xQueueSend/ReceiveFromISR  %lu\n", (unsigned long) ring_bench_queue_from_isr(queue));
+        printf("  spsc_ring 1 por chamada    %lu\n", (unsigned long) ring_bench_spsc(&ring, 1));
+        printf("  spsc_ring lote de %-2u       %lu\n", RING_BENCH_BATCH,
+            (unsigned long) ring_bench_spsc(&ring, RING_BENCH_BATCH));
+    }
+}
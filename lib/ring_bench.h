@@ -0,0 +1,30 @@
+#ifndef RING_BENCH_H
+#define RING_BENCH_H
+
+/**
+ * @file ring_bench.h
+ * @brief Benchmark de ciclos: spsc_ring_t contra fila do FreeRTOS.
+ *
+ * Usado apenas no build TRAFFIC_BENCH. A tarefa mede o custo médio, em ciclos
+ * de clk_sys, de enviar e receber um elemento de 4 bytes por xQueueSend /
+ * xQueueReceive, pelas variantes FromISR e por spsc_ring_push / spsc_ring_pop
+ * (um elemento por chamada e em lotes de RING_BENCH_BATCH), e imprime a tabela
+ * no stdio a cada RING_BENCH_PERIOD_MS.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define RING_BENCH_ITEMS      4096    /**< Elementos por medição */
+#define RING_BENCH_CAPACITY   64      /**< Capacidade da fila e do buffer */
+#define RING_BENCH_BATCH      16      /**< Tamanho do lote nas medições em lote */
+#define RING_BENCH_PERIOD_MS  10000   /**< Intervalo entre execuções */
+
+/**
+ * @brief Tarefa do benchmark.
+ *
+ * @param pvParameters Não utilizado.
+ */
+void vRingBenchTask(void *pvParameters);
+
+#endif // RING_BENCH_H
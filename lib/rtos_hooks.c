@@ -0,0 +1,81 @@
+#include "FreeRTOS.h"
+#include "task.h"
+#include "pico/stdlib.h"
+
+/**
+ * @file rtos_hooks.c
+ * @brief Funções de gancho (hooks) exigidas pelo kernel do FreeRTOS.
+ *
+ * Com configSUPPORT_STATIC_ALLOCATION = 1 e sem heap, o kernel pede à aplicação
+ * a memória das tarefas que ele mesmo cria: a Idle de cada núcleo e a tarefa
+ * de serviço dos timers. Todos os buffers abaixo ficam em .bss e aparecem no
+ * mapa de link. No build de perfil de pilha também fica aqui o gancho de
+ * estouro de pilha.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+static StaticTask_t idle_task_tcb;                             /**< TCB da Idle do núcleo 0 */
+static StackType_t idle_task_stack[configMINIMAL_STACK_SIZE];  /**< Pilha da Idle do núcleo 0 */
+
+#if ( configNUMBER_OF_CORES > 1 )
+static StaticTask_t passive_idle_task_tcb[configNUMBER_OF_CORES - 1];                             /**< TCBs das Idle passivas */
+static StackType_t passive_idle_task_stack[configNUMBER_OF_CORES - 1][configMINIMAL_STACK_SIZE];  /**< Pilhas das Idle passivas */
+#endif
+
+#if ( configUSE_TIMERS == 1 )
+static StaticTask_t timer_task_tcb;                                /**< TCB da tarefa de serviço dos timers */
+static StackType_t timer_task_stack[configTIMER_TASK_STACK_DEPTH]; /**< Pilha da tarefa de serviço dos timers */
+#endif
+
+/**
+ * @brief Fornece a memória da tarefa Idle principal.
+ */
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+                                   configSTACK_DEPTH_TYPE *puxIdleTaskStackSize)
+{
+    *ppxIdleTaskTCBBuffer = &idle_task_tcb;
+    *ppxIdleTaskStackBuffer = idle_task_stack;
+    *puxIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+#if ( configNUMBER_OF_CORES > 1 )
+/**
+ * @brief Fornece a memória das tarefas Idle dos demais núcleos (SMP).
+ */
+void vApplicationGetPassiveIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+                                          configSTACK_DEPTH_TYPE *puxIdleTaskStackSize, BaseType_t xPassiveIdleTaskIndex)
+{
+    *ppxIdleTaskTCBBuffer = &passive_idle_task_tcb[xPassiveIdleTaskIndex];
+    *ppxIdleTaskStackBuffer = passive_idle_task_stack[xPassiveIdleTaskIndex];
+    *puxIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+#endif
+
+#if ( configCHECK_FOR_STACK_OVERFLOW > 0 )
+/**
+ * @brief Chamado pelo kernel ao detectar estouro de pilha na troca de contexto.
+ *
+ * @param xTask Tarefa que estourou a pilha.
+ * @param pcTaskName Nome da tarefa.
+ */
+void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName)
+{
+    (void) xTask;
+    panic("stack overflow: %s", pcTaskName);
+}
+#endif
+
+#if ( configUSE_TIMERS == 1 )
+/**
+ * @brief Fornece a memória da tarefa de serviço dos timers.
+ */
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer,
+                                    configSTACK_DEPTH_TYPE *puxTimerTaskStackSize)
+{
+    *ppxTimerTaskTCBBuffer = &timer_task_tcb;
+    *ppxTimerTaskStackBuffer = timer_task_stack;
+    *puxTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+#endif
@@ -0,0 +1,89 @@
+#include "schedule.h"
+
+#define MINUTES_WEEK    (7u * SCHEDULE_MINUTES_DAY)
+#define MS_MINUTE       60000u
+#define EPOCH_WEEKDAY   4u      // 01/01/1970 foi uma quinta-feira
+
+bool schedule_is_valid(const schedule_t *schedule)
+{
+    if(!schedule || !schedule->entries || schedule->count == 0 || schedule->count > SCHEDULE_MAX_ENTRIES) return false;
+    for(uint8_t i = 0; i < schedule->count; i++)
+    {
+        const schedule_entry_t *entry = &schedule->entries[i];
+        if(entry->days == 0 || entry->days > SCHEDULE_EVERY_DAY) return false;
+        if(entry->minute >= SCHEDULE_MINUTES_DAY || entry->program >= SCHEDULE_PROGRAM_COUNT) return false;
+        // Duas entradas no mesmo minuto do mesmo dia seriam ambíguas
+        for(uint8_t j = 0; j < i; j++)
+            if(schedule->entries[j].minute == entry->minute && (schedule->entries[j].days & entry->days)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Hora local em ms, com o fuso aplicado.
+ */
+static inline uint64_t local_ms(uint64_t time_ms, int16_t utc_offset_min)
+{
+    return (uint64_t) ((int64_t) time_ms + (int64_t) utc_offset_min * (int64_t) MS_MINUTE);
+}
+
+/**
+ * @brief Minuto da semana (0 = domingo, 00:00) da hora local.
+ */
+static inline uint32_t week_minute(uint64_t local)
+{
+    return (uint32_t) ((local / MS_MINUTE + EPOCH_WEEKDAY * SCHEDULE_MINUTES_DAY) % MINUTES_WEEK);
+}
+
+uint8_t schedule_program_at(const schedule_t *schedule, uint64_t time_ms, int16_t utc_offset_min)
+{
+    uint32_t now = week_minute(local_ms(time_ms, utc_offset_min));
+    uint32_t best = MINUTES_WEEK;
+    uint8_t program = SCHEDULE_NO_PROGRAM;
+
+    // A entrada em vigor é a que começou há menos tempo (dando a volta na semana)
+    for(uint8_t i = 0; i < schedule->count; i++)
+        for(uint8_t day = 0; day < 7; day++)
+        {
+            if(!(schedule->entries[i].days & (1u << day))) continue;
+            uint32_t start = day * SCHEDULE_MINUTES_DAY + schedule->entries[i].minute;
+            uint32_t ago = (now + MINUTES_WEEK - start) % MINUTES_WEEK;
+            if(ago < best)
+            {
+                best = ago;
+                program = schedule->entries[i].program;
+            }
+        }
+    return program;
+}
+
+uint64_t schedule_next_switch(const schedule_t *schedule, uint64_t time_ms, int16_t utc_offset_min,
+    uint8_t *program)
+{
+    uint64_t local = local_ms(time_ms, utc_offset_min);
+    uint32_t now = week_minute(local);
+    uint8_t current = schedule_program_at(schedule, time_ms, utc_offset_min);
+    uint32_t best = MINUTES_WEEK + 1u;
+    uint8_t next = SCHEDULE_NO_PROGRAM;
+
+    // A próxima troca é o início mais próximo de uma entrada com outro programa
+    for(uint8_t i = 0; i < schedule->count; i++)
+    {
+        if(schedule->entries[i].program == current) continue;
+        for(uint8_t day = 0; day < 7; day++)
+        {
+            if(!(schedule->entries[i].days & (1u << day))) continue;
+            uint32_t start = day * SCHEDULE_MINUTES_DAY + schedule->entries[i].minute;
+            uint32_t ahead = (start + MINUTES_WEEK - now) % MINUTES_WEEK;
+            if(ahead < best)
+            {
+                best = ahead;
+                next = schedule->entries[i].program;
+            }
+        }
+    }
+    if(program) *program = next;
+    if(next == SCHEDULE_NO_PROGRAM) return SCHEDULE_NEVER;
+    // ahead > 0: o início no minuto atual é o da entrada em vigor
+    return time_ms - local % MS_MINUTE + (uint64_t) best * MS_MINUTE;
+}
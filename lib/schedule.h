@@ -0,0 +1,94 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file schedule.h
+ * @brief Calendário semanal dos programas do semáforo (dia, pico e noite).
+ *
+ * Cada entrada diz a partir de que minuto do dia, e em que dias da semana,
+ * vale um programa; ele vale até a próxima entrada da semana. A hora é a do
+ * host (ms desde 1970, UTC) mais o fuso em minutos. O firmware não avalia o
+ * calendário a cada tick: schedule_next_switch() dá o instante da próxima
+ * troca de programa, e basta comparar a hora com ele.
+ *
+ * C puro: quem chama passa a hora.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define SCHEDULE_MAX_ENTRIES  16u                  /**< Entradas por calendário */
+#define SCHEDULE_NEVER        UINT64_MAX            /**< Sem troca de programa */
+#define SCHEDULE_NO_PROGRAM   0xFFu                 /**< Nenhum programa */
+#define SCHEDULE_MINUTES_DAY  1440u                 /**< Minutos por dia */
+
+/// Dias da semana (bit 0 = domingo)
+#define SCHEDULE_SUNDAY    0x01u
+#define SCHEDULE_MONDAY    0x02u
+#define SCHEDULE_TUESDAY   0x04u
+#define SCHEDULE_WEDNESDAY 0x08u
+#define SCHEDULE_THURSDAY  0x10u
+#define SCHEDULE_FRIDAY    0x20u
+#define SCHEDULE_SATURDAY  0x40u
+#define SCHEDULE_WEEKDAYS  0x3Eu                   /**< Segunda a sexta */
+#define SCHEDULE_WEEKEND   0x41u                   /**< Sábado e domingo */
+#define SCHEDULE_EVERY_DAY 0x7Fu                   /**< Todos os dias */
+
+/**
+ * @brief Programa de uma entrada do calendário.
+ */
+typedef enum {
+    SCHEDULE_DAY = 0,       /**< Plano de dia (PLAN_DAY) */
+    SCHEDULE_PEAK,          /**< Plano de pico (PLAN_PEAK) */
+    SCHEDULE_NIGHT,         /**< Modo noturno (amarelo piscante) */
+    SCHEDULE_PROGRAM_COUNT
+} schedule_program_t;
+
+/**
+ * @brief Uma entrada: o programa vale a partir de minute nos dias de days.
+ */
+typedef struct {
+    uint8_t days;           /**< Dias da semana (SCHEDULE_SUNDAY...) */
+    uint16_t minute;        /**< Início, em minutos desde a meia-noite local */
+    uint8_t program;        /**< schedule_program_t */
+} schedule_entry_t;
+
+/**
+ * @brief Calendário semanal.
+ */
+typedef struct {
+    const char *name;                  /**< Nome mostrado pelo shell */
+    const schedule_entry_t *entries;   /**< Entradas, em qualquer ordem */
+    uint8_t count;                     /**< Número de entradas */
+} schedule_t;
+
+/**
+ * @brief Verifica o calendário: entradas válidas e nenhum início repetido.
+ */
+bool schedule_is_valid(const schedule_t *schedule);
+
+/**
+ * @brief Programa em vigor.
+ *
+ * @param schedule Calendário válido.
+ * @param time_ms Hora do host (ms desde 1970, UTC).
+ * @param utc_offset_min Fuso local em minutos (-180 em Brasília).
+ * @return schedule_program_t.
+ */
+uint8_t schedule_program_at(const schedule_t *schedule, uint64_t time_ms, int16_t utc_offset_min);
+
+/**
+ * @brief Instante da próxima troca de programa.
+ *
+ * Entradas seguidas com o mesmo programa não são trocas.
+ *
+ * @param program Recebe o programa seguinte (pode ser NULL).
+ * @return Hora do host da troca, ou SCHEDULE_NEVER se o calendário tem um só programa.
+ */
+uint64_t schedule_next_switch(const schedule_t *schedule, uint64_t time_ms, int16_t utc_offset_min,
+    uint8_t *program);
+
+#endif // SCHEDULE_H
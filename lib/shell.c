@@ -0,0 +1,77 @@
+#include <string.h>
+#include "shell.h"
+
+void shell_init(shell_t *shell, const shell_command_t *commands, uint8_t count)
+{
+    shell->commands = commands;
+    shell->count = count;
+    shell->len = 0;
+    shell->overflow = false;
+    shell->last = NULL;
+}
+
+/**
+ * @brief Separa a linha em palavras e executa o comando.
+ */
+static shell_result_t shell_execute(shell_t *shell)
+{
+    char *argv[SHELL_MAX_ARGS];
+    int argc = 0;
+    char *p = shell->line;
+
+    while(*p)
+    {
+        while(*p == ' ' || *p == '\t') *p++ = '\0';
+        if(!*p) break;
+        if(argc == SHELL_MAX_ARGS) return SHELL_TOO_LONG;
+        argv[argc++] = p;
+        while(*p && *p != ' ' && *p != '\t') p++;
+    }
+    if(argc == 0) return SHELL_EMPTY;
+    for(uint8_t i = 0; i < shell->count; i++)
+    {
+        if(strcmp(argv[0], shell->commands[i].name) != 0) continue;
+        shell->last = &shell->commands[i];
+        return shell->commands[i].handler(argc, argv) ? SHELL_OK : SHELL_BAD_ARGS;
+    }
+    return SHELL_UNKNOWN;
+}
+
+shell_result_t shell_feed(shell_t *shell, char c)
+{
+    shell_result_t result;
+
+    if(c == '\b' || c == 0x7F)
+    {
+        if(shell->len) shell->len--;
+        return SHELL_PENDING;
+    }
+    if(c != '\n' && c != '\r')
+    {
+        if(shell->len < SHELL_LINE_MAX - 1) shell->line[shell->len++] = c;
+        else shell->overflow = true;
+        return SHELL_PENDING;
+    }
+    // "\r\n" termina a linha no "\r"; o "\n" vira uma linha vazia
+    shell->line[shell->len] = '\0';
+    result = shell->overflow ? SHELL_TOO_LONG : shell_execute(shell);
+    shell->len = 0;
+    shell->overflow = false;
+    return result;
+}
+
+bool shell_parse_uint(const char *text, uint64_t max, uint64_t *value)
+{
+    uint64_t result = 0;
+
+    if(!*text) return false;
+    for(; *text; text++)
+    {
+        if(*text < '0' || *text > '9') return false;
+        uint8_t digit = (uint8_t) (*text - '0');
+        if(digit > max || result > (max - digit) / 10u) return false;
+        result = result * 10u + digit;
+    }
+    *value = result;
+    return true;
+}
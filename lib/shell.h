@@ -0,0 +1,91 @@
+#ifndef SHELL_H
+#define SHELL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file shell.h
+ * @brief Interpretador de comandos por linha, sem heap e sem bloqueio.
+ *
+ * Os caracteres são entregues um a um por shell_feed(), na medida em que
+ * chegam; a linha fica num buffer fixo dentro de shell_t. No fim da linha
+ * ("\n" ou "\r") ela é separada em palavras (no próprio buffer) e o comando
+ * com o nome da primeira palavra é executado. Backspace apaga o último
+ * caractere, para uso direto num terminal.
+ *
+ * C puro, sem dependência do Pico SDK: testável no Linux. A saída fica a
+ * cargo dos comandos.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define SHELL_LINE_MAX 64   /**< Maior linha aceita, com o terminador */
+#define SHELL_MAX_ARGS 6    /**< Maior número de palavras por linha */
+
+/**
+ * @brief Função de um comando.
+ *
+ * @param argc Número de palavras, contando o nome do comando.
+ * @param argv Palavras (argv[0] é o nome).
+ * @return false se os argumentos são inválidos (o uso do comando é mostrado).
+ */
+typedef bool (*shell_handler_t)(int argc, char **argv);
+
+/**
+ * @brief Um comando.
+ */
+typedef struct {
+    const char *name;          /**< Nome digitado */
+    const char *usage;         /**< Argumentos e descrição (comando de ajuda) */
+    shell_handler_t handler;   /**< Função executada */
+} shell_command_t;
+
+/**
+ * @brief Resultado de um caractere entregue ao interpretador.
+ */
+typedef enum {
+    SHELL_PENDING,     /**< Linha ainda incompleta */
+    SHELL_EMPTY,       /**< Linha vazia */
+    SHELL_OK,          /**< Comando executado */
+    SHELL_BAD_ARGS,    /**< O comando recusou os argumentos */
+    SHELL_UNKNOWN,     /**< Nenhum comando com esse nome */
+    SHELL_TOO_LONG,    /**< Linha ou número de palavras acima do limite (descartada) */
+} shell_result_t;
+
+/**
+ * @brief Estado do interpretador.
+ */
+typedef struct {
+    const shell_command_t *commands;   /**< Tabela de comandos */
+    uint8_t count;                     /**< Número de comandos */
+    char line[SHELL_LINE_MAX];         /**< Linha em edição */
+    uint8_t len;                       /**< Caracteres na linha */
+    bool overflow;                     /**< A linha passou do limite */
+    const shell_command_t *last;       /**< Último comando encontrado (SHELL_OK/SHELL_BAD_ARGS) */
+} shell_t;
+
+/**
+ * @brief Inicializa o interpretador com a tabela @p commands.
+ */
+void shell_init(shell_t *shell, const shell_command_t *commands, uint8_t count);
+
+/**
+ * @brief Entrega um caractere; no fim da linha, executa o comando.
+ *
+ * @return Resultado da linha, ou SHELL_PENDING se ela não terminou.
+ */
+shell_result_t shell_feed(shell_t *shell, char c);
+
+/**
+ * @brief Converte um número decimal sem sinal.
+ *
+ * @param text Texto (só dígitos).
+ * @param max Maior valor aceito.
+ * @param value Saída.
+ * @return false se o texto não é um número ou passa de @p max.
+ */
+bool shell_parse_uint(const char *text, uint64_t max, uint64_t *value);
+
+#endif // SHELL_H
@@ -0,0 +1,80 @@
+#include "spsc_ring.h"
+#include <stdatomic.h>
+#include <string.h>
+#include <assert.h>
+
+// Barreira completa: dmb no Cortex-M0+, mfence (ou nada) no PC
+#define spsc_ring_barrier() atomic_thread_fence(memory_order_seq_cst)
+
+void spsc_ring_init(spsc_ring_t *ring, void *storage, uint32_t elem_size, uint32_t capacity)
+{
+    assert(capacity && (capacity & (capacity - 1u)) == 0);
+    ring->storage = (uint8_t *) storage;
+    ring->elem_size = elem_size;
+    ring->mask = capacity - 1u;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+    ring->consumer = NULL;
+    ring->notify_threshold = 1;
+}
+
+void spsc_ring_set_consumer(spsc_ring_t *ring, void *consumer, uint32_t threshold)
+{
+    ring->notify_threshold = threshold ? threshold : 1u;
+    ring->consumer = consumer;
+}
+
+/**
+ * @brief Copia @p count elementos entre o buffer e @p items a partir do índice
+ *        livre @p index, em no máximo dois trechos.
+ */
+static void spsc_ring_copy(spsc_ring_t *ring, uint32_t index, void *items, uint32_t count, bool to_ring)
+{
+    uint32_t start = index & ring->mask;
+    uint32_t first = ring->mask + 1u - start;
+    uint8_t *data = (uint8_t *) items;
+
+    if(first > count) first = count;
+    if(to_ring)
+    {
+        memcpy(&ring->storage[start * ring->elem_size], data, first * ring->elem_size);
+        memcpy(ring->storage, &data[first * ring->elem_size], (count - first) * ring->elem_size);
+    }
+    else
+    {
+        memcpy(data, &ring->storage[start * ring->elem_size], first * ring->elem_size);
+        memcpy(&data[first * ring->elem_size], ring->storage, (count - first) * ring->elem_size);
+    }
+}
+
+uint32_t spsc_ring_push(spsc_ring_t *ring, const void *items, uint32_t count)
+{
+    uint32_t head = ring->head;
+    uint32_t space = ring->mask + 1u - (head - ring->tail);
+
+    if(count > space)
+    {
+        ring->dropped += count - space;
+        count = space;
+    }
+    if(!count) return 0;
+    spsc_ring_copy(ring, head, (void *) items, count, true);
+    spsc_ring_barrier();  // Elementos visíveis antes do novo head
+    ring->head = head + count;
+    return count;
+}
+
+uint32_t spsc_ring_pop(spsc_ring_t *ring, void *items, uint32_t max)
+{
+    uint32_t tail = ring->tail;
+    uint32_t count = ring->head - tail;
+
+    if(count > max) count = max;
+    if(!count) return 0;
+    spsc_ring_barrier();  // Lê os elementos só depois de ver o head
+    spsc_ring_copy(ring, tail, items, count, false);
+    spsc_ring_barrier();  // Termina a leitura antes de liberar o espaço
+    ring->tail = tail + count;
+    return count;
+}
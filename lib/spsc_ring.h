@@ -0,0 +1,123 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file spsc_ring.h
+ * @brief Buffer circular lock-free de um produtor e um consumidor (SPSC).
+ *
+ * Feito para caminhos ISR -> tarefa (bordas de botão, amostras de ADC, bytes de
+ * UART): o produtor só escreve head e o consumidor só escreve tail, então nenhum
+ * dos lados desliga interrupções ou toma o spinlock do kernel. Uma barreira de
+ * memória (atomic_thread_fence, um dmb no RP2040) separa a cópia dos elementos
+ * da publicação do índice, o que também vale com produtor e consumidor em
+ * núcleos diferentes.
+ *
+ * push e pop movem lotes de elementos com no máximo dois memcpy. O consumidor
+ * pode ser acordado quando a ocupação atinge um limiar, em vez de uma vez por
+ * elemento: spsc_ring_push_wakes() diz se um push cruzou o limiar, e
+ * spsc_ring_rtos.h transforma isso em notificação de tarefa do FreeRTOS.
+ *
+ * C puro (testável no Linux: tools/sim/spsc_ring_test.c). Apenas um contexto
+ * pode produzir e apenas um pode consumir em cada buffer.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+/**
+ * @brief Buffer circular SPSC.
+ */
+typedef struct {
+    uint8_t *storage;              /**< Memória dos elementos */
+    uint32_t elem_size;            /**< Tamanho de um elemento, em bytes */
+    uint32_t mask;                 /**< Capacidade - 1 (capacidade potência de 2) */
+    volatile uint32_t head;        /**< Total de elementos escritos (só o produtor altera) */
+    volatile uint32_t tail;        /**< Total de elementos lidos (só o consumidor altera) */
+    uint32_t dropped;              /**< Elementos recusados por falta de espaço (produtor) */
+    void *consumer;                /**< Consumidor acordado no limiar (TaskHandle_t no firmware), ou NULL */
+    uint32_t notify_threshold;     /**< Ocupação que dispara a notificação */
+} spsc_ring_t;
+
+/** Declara a memória estática de um buffer de @p capacity elementos de @p type. */
+#define SPSC_RING_STORAGE(name, type, capacity) static type name[capacity]
+
+/**
+ * @brief Inicializa o buffer.
+ *
+ * @param ring Buffer a inicializar.
+ * @param storage Memória declarada com SPSC_RING_STORAGE.
+ * @param elem_size Tamanho de um elemento, em bytes.
+ * @param capacity Número de elementos (potência de 2).
+ */
+void spsc_ring_init(spsc_ring_t *ring, void *storage, uint32_t elem_size, uint32_t capacity);
+
+/**
+ * @brief Define o consumidor e o limiar de notificação.
+ *
+ * O consumidor é acordado quando um push leva a ocupação de abaixo do limiar
+ * para o limiar ou acima. Ele deve esvaziar o buffer a cada despertar e usar
+ * um timeout para recolher sobras abaixo do limiar.
+ *
+ * @param ring Buffer.
+ * @param consumer Consumidor (TaskHandle_t no firmware; NULL desliga a notificação).
+ * @param threshold Ocupação que acorda o consumidor (mínimo 1).
+ */
+void spsc_ring_set_consumer(spsc_ring_t *ring, void *consumer, uint32_t threshold);
+
+/**
+ * @brief Elementos disponíveis para leitura.
+ */
+static inline uint32_t spsc_ring_count(const spsc_ring_t *ring)
+{
+    return ring->head - ring->tail;
+}
+
+/**
+ * @brief Espaço livre, em elementos.
+ */
+static inline uint32_t spsc_ring_space(const spsc_ring_t *ring)
+{
+    return ring->mask + 1u - (ring->head - ring->tail);
+}
+
+/**
+ * @brief Escreve até @p count elementos (lado do produtor, sem notificação).
+ *
+ * @param ring Buffer.
+ * @param items Elementos a escrever.
+ * @param count Quantidade de elementos.
+ * @return Elementos escritos; o restante é contado em dropped.
+ */
+uint32_t spsc_ring_push(spsc_ring_t *ring, const void *items, uint32_t count);
+
+/**
+ * @brief Verifica se o último push fez a ocupação cruzar o limiar.
+ *
+ * Lado do produtor, logo depois de spsc_ring_push().
+ *
+ * @param ring Buffer.
+ * @param pushed Retorno do push.
+ * @return true se o consumidor registrado deve ser acordado.
+ */
+static inline bool spsc_ring_push_wakes(const spsc_ring_t *ring, uint32_t pushed)
+{
+    uint32_t used = ring->head - ring->tail;
+    return ring->consumer && pushed && used >= ring->notify_threshold
+        && used - pushed < ring->notify_threshold;
+}
+
+/**
+ * @brief Lê até @p max elementos (lado do consumidor).
+ *
+ * @param ring Buffer.
+ * @param items Destino dos elementos.
+ * @param max Capacidade do destino, em elementos.
+ * @return Elementos lidos.
+ */
+uint32_t spsc_ring_pop(spsc_ring_t *ring, void *items, uint32_t max);
+
+#endif // SPSC_RING_H
@@ -0,0 +1,23 @@
+#include "spsc_ring_rtos.h"
+
+uint32_t spsc_ring_push_from_isr(spsc_ring_t *ring, const void *items, uint32_t count, BaseType_t *woken)
+{
+    uint32_t pushed = spsc_ring_push(ring, items, count);
+    if(spsc_ring_push_wakes(ring, pushed)) vTaskNotifyGiveFromISR((TaskHandle_t) ring->consumer, woken);
+    return pushed;
+}
+
+uint32_t spsc_ring_push_from_task(spsc_ring_t *ring, const void *items, uint32_t count)
+{
+    uint32_t pushed = spsc_ring_push(ring, items, count);
+    if(spsc_ring_push_wakes(ring, pushed)) xTaskNotifyGive((TaskHandle_t) ring->consumer);
+    return pushed;
+}
+
+uint32_t spsc_ring_wait(spsc_ring_t *ring, void *items, uint32_t max, TickType_t timeout)
+{
+    uint32_t count = spsc_ring_pop(ring, items, max);
+    if(count) return count;
+    ulTaskNotifyTake(pdTRUE, timeout);
+    return spsc_ring_pop(ring, items, max);
+}
@@ -0,0 +1,45 @@
+#ifndef SPSC_RING_RTOS_H
+#define SPSC_RING_RTOS_H
+
+#include "spsc_ring.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/**
+ * @file spsc_ring_rtos.h
+ * @brief Notificação de tarefa do FreeRTOS para o spsc_ring_t.
+ *
+ * O consumidor registrado com spsc_ring_set_consumer() é uma TaskHandle_t e é
+ * acordado por xTaskNotifyGive quando um push cruza o limiar. Só no firmware:
+ * o buffer em si (spsc_ring.h) não depende do FreeRTOS.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+/**
+ * @brief spsc_ring_push() chamada de ISR, acordando o consumidor no limiar.
+ *
+ * @param woken Recebe pdTRUE se for preciso portYIELD_FROM_ISR.
+ */
+uint32_t spsc_ring_push_from_isr(spsc_ring_t *ring, const void *items, uint32_t count, BaseType_t *woken);
+
+/**
+ * @brief spsc_ring_push() chamada de tarefa, acordando o consumidor no limiar.
+ */
+uint32_t spsc_ring_push_from_task(spsc_ring_t *ring, const void *items, uint32_t count);
+
+/**
+ * @brief Lê até @p max elementos, esperando a notificação se estiver vazio.
+ *
+ * Só pode ser chamada pela tarefa registrada em spsc_ring_set_consumer().
+ *
+ * @param ring Buffer.
+ * @param items Destino dos elementos.
+ * @param max Capacidade do destino, em elementos.
+ * @param timeout Espera máxima pelo limiar.
+ * @return Elementos lidos (0 no timeout com o buffer vazio).
+ */
+uint32_t spsc_ring_wait(spsc_ring_t *ring, void *items, uint32_t max, TickType_t timeout);
+
+#endif // SPSC_RING_RTOS_H
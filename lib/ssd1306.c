@@ -1,5 +1,7 @@
 #include "ssd1306.h"
 #include "font.h"
+#include <assert.h>
+#include <string.h>
 
 void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
   ssd->width = width;
@@ -8,7 +10,8 @@ void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_v
   ssd->address = address;
   ssd->i2c_port = i2c;
   ssd->bufsize = ssd->pages * ssd->width + 1;
-  ssd->ram_buffer = calloc(ssd->bufsize, sizeof(uint8_t));
+  assert(ssd->bufsize <= SSD1306_BUFSIZE);
+  memset(ssd->ram_buffer, 0, sizeof(ssd->ram_buffer));
   ssd->ram_buffer[0] = 0x40;
   ssd->port_buffer[0] = 0x80;
 }
@@ -4,6 +4,7 @@
 
 #define WIDTH 128
 #define HEIGHT 64
+#define SSD1306_BUFSIZE (WIDTH * HEIGHT / 8 + 1) // Buffer estatico: 1 byte de controle + paginas
 
 typedef enum {
   SET_CONTRAST = 0x81,
@@ -29,7 +30,7 @@ typedef struct {
   uint8_t width, height, pages, address;
   i2c_inst_t *i2c_port;
   bool external_vcc;
-  uint8_t *ram_buffer;
+  uint8_t ram_buffer[SSD1306_BUFSIZE];
   size_t bufsize;
   uint8_t port_buffer[2];
 } ssd1306_t;
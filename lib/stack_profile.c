@@ -0,0 +1,91 @@
+#include "stack_profile.h"
+#include "timers.h"
+#include <stdio.h>
+
+/**
+ * @brief Estado de medição de uma tarefa registrada.
+ */
+typedef struct {
+    TaskHandle_t task;          /**< Handle da tarefa */
+    const char *depth_macro;    /**< Nome da macro de profundidade */
+    uint32_t depth;             /**< Profundidade alocada (palavras) */
+    uint32_t min_free;          /**< Menor folga observada (palavras) */
+} stack_profile_entry_t;
+
+static stack_profile_entry_t profile_entries[STACK_PROFILE_MAX_TASKS];
+static uint8_t profile_count = 0;
+
+/**
+ * @brief Converte o pico medido em uma profundidade com margem, múltipla de 8.
+ *
+ * @param used Pico de uso medido, em palavras.
+ * @return Profundidade sugerida, em palavras.
+ */
+static uint32_t stack_profile_sized_depth(uint32_t used)
+{
+    uint32_t depth = used + (used * STACK_PROFILE_MARGIN_PCT) / 100u + STACK_PROFILE_MARGIN_WORDS;
+    depth = (depth + 7u) & ~7u;
+    return (depth < STACK_PROFILE_MIN_DEPTH) ? STACK_PROFILE_MIN_DEPTH : depth;
+}
+
+void stack_profile_register(TaskHandle_t task, const char *depth_macro, uint32_t depth)
+{
+    if(profile_count >= STACK_PROFILE_MAX_TASKS) return;
+    profile_entries[profile_count].task = task;
+    profile_entries[profile_count].depth_macro = depth_macro;
+    profile_entries[profile_count].depth = depth;
+    profile_entries[profile_count].min_free = depth;
+    profile_count++;
+}
+
+void stack_profile_sample(void)
+{
+    for(uint8_t i = 0; i < profile_count; i++)
+    {
+        uint32_t free_words = (uint32_t) uxTaskGetStackHighWaterMark(profile_entries[i].task);
+        if(free_words < profile_entries[i].min_free) profile_entries[i].min_free = free_words;
+    }
+}
+
+void stack_profile_emit_header(void)
+{
+    printf("%s\n", STACK_PROFILE_HEADER_BEGIN);
+    printf("/* Gerado por tools/stack_header.py a partir do build TRAFFIC_STACK_PROFILE. */\n");
+    printf("#ifndef TASK_STACKS_H\n#define TASK_STACKS_H\n\n");
+    for(uint8_t i = 0; i < profile_count; i++)
+    {
+        const stack_profile_entry_t *entry = &profile_entries[i];
+        uint32_t used = entry->depth - entry->min_free;
+        printf("#define %-26s %4lu  /* %s: pico %lu de %lu palavras */\n", entry->depth_macro,
+            (unsigned long) stack_profile_sized_depth(used), pcTaskGetName(entry->task),
+            (unsigned long) used, (unsigned long) entry->depth);
+    }
+    printf("\n#endif // TASK_STACKS_H\n");
+    printf("%s\n", STACK_PROFILE_HEADER_END);
+}
+
+void vStackProfileTask(void *pvParameters)
+{
+    stack_profile_stress_fn stress = (stack_profile_stress_fn) pvParameters;
+    TickType_t last_wake = xTaskGetTickCount();
+    uint32_t steps = STACK_PROFILE_DURATION_MS / STACK_PROFILE_STEP_MS;
+
+#if configUSE_TIMERS
+    // A tarefa de serviço dos timers só existe depois de o escalonador iniciar
+    stack_profile_register(xTimerGetTimerDaemonTaskHandle(), "TIMER_TASK_STACK_DEPTH",
+        configTIMER_TASK_STACK_DEPTH);
+#endif
+    for(uint32_t step = 0; step < steps; step++)
+    {
+        if(stress) stress(step);
+        xTaskDelayUntil(&last_wake, pdMS_TO_TICKS(STACK_PROFILE_STEP_MS));
+        stack_profile_sample();
+    }
+    while(1)
+    {
+        // Reemite periodicamente para quem conectar ao USB depois do fim do perfil
+        stack_profile_sample();
+        stack_profile_emit_header();
+        vTaskDelay(pdMS_TO_TICKS(10000));
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef STACK_PROFILE_H
+#define STACK_PROFILE_H
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+/**
+ * @file stack_profile.h
+ * @brief Medição do uso de pilha das tarefas e geração do cabeçalho
+ *        generated/task_stacks.h com as profundidades dimensionadas.
+ *
+ * Usado apenas no build de perfil (opção CMake TRAFFIC_STACK_PROFILE): todas as
+ * tarefas recebem STACK_PROFILE_TASK_DEPTH palavras, um cenário de estresse é
+ * executado por STACK_PROFILE_DURATION_MS e, ao final, o menor
+ * uxTaskGetStackHighWaterMark de cada tarefa é convertido em uma profundidade
+ * com margem e impresso no stdio entre marcadores. O script
+ * tools/stack_header.py extrai o cabeçalho da saída serial.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define STACK_PROFILE_TASK_DEPTH   1024   /**< Pilha (palavras) dada a cada tarefa durante o perfil */
+#define STACK_PROFILE_MAX_TASKS    12     /**< Número máximo de tarefas monitoradas */
+#define STACK_PROFILE_STEP_MS      250    /**< Intervalo entre passos do cenário de estresse */
+#define STACK_PROFILE_DURATION_MS  60000  /**< Duração total do cenário de estresse */
+#define STACK_PROFILE_MARGIN_PCT   25     /**< Margem proporcional sobre o pico medido */
+#define STACK_PROFILE_MARGIN_WORDS 32     /**< Margem fixa (palavras) somada ao pico medido */
+#define STACK_PROFILE_MIN_DEPTH    128    /**< Profundidade mínima gerada */
+
+#define STACK_PROFILE_HEADER_BEGIN "---8<--- task_stacks.h begin"
+#define STACK_PROFILE_HEADER_END   "---8<--- task_stacks.h end"
+
+/**
+ * @brief Passo do cenário de estresse, chamado a cada STACK_PROFILE_STEP_MS.
+ *
+ * @param step Número do passo, a partir de 0.
+ */
+typedef void (*stack_profile_stress_fn)(uint32_t step);
+
+/**
+ * @brief Registra uma tarefa para medição.
+ *
+ * @param task Handle da tarefa.
+ * @param depth_macro Nome da macro de profundidade gerada (ex.: "BLINK_TASK_STACK_DEPTH").
+ * @param depth Profundidade (palavras) com que a tarefa foi criada.
+ */
+void stack_profile_register(TaskHandle_t task, const char *depth_macro, uint32_t depth);
+
+/**
+ * @brief Amostra o high-water mark de todas as tarefas registradas.
+ */
+void stack_profile_sample(void);
+
+/**
+ * @brief Imprime o cabeçalho gerado entre os marcadores de início e fim.
+ */
+void stack_profile_emit_header(void);
+
+/**
+ * @brief Tarefa que executa o cenário de estresse e emite o cabeçalho.
+ *
+ * @param pvParameters Ponteiro para a função stack_profile_stress_fn do cenário.
+ */
+void vStackProfileTask(void *pvParameters);
+
+#endif // STACK_PROFILE_H
@@ -0,0 +1,125 @@
+#include "supervisor.h"
+#include "pico/stdlib.h"
+#include "hardware/watchdog.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/**
+ * @brief Heartbeat registrado.
+ */
+typedef struct {
+    const char *name;            /**< Nome do heartbeat */
+    uint32_t deadline_us;        /**< Intervalo máximo entre check-ins */
+    volatile uint32_t last_us;   /**< Instante do último check-in (time_us_32) */
+} supervisor_heartbeat_t;
+
+static supervisor_heartbeat_t heartbeats[SUPERVISOR_MAX_TASKS];
+static uint8_t heartbeat_count = 0;
+static uint8_t boot_resets = 0;
+
+/**
+ * @brief Grava culpado e contador de resets no scratch 1.
+ */
+static void supervisor_write_status(uint8_t culprit, uint8_t resets)
+{
+    watchdog_hw->scratch[1] = (uint32_t) culprit | ((uint32_t) resets << 8);
+}
+
+void supervisor_init(supervisor_record_t *record)
+{
+    bool magic_ok = watchdog_hw->scratch[0] == SUPERVISOR_MAGIC;
+    uint32_t status = watchdog_hw->scratch[1];
+    uint32_t state = watchdog_hw->scratch[2];
+
+    record->watchdog_reset = watchdog_enable_caused_reboot() && magic_ok;
+    record->culprit = (uint8_t) (status & 0xFFu);
+    record->resets = 0;
+    record->state = state;
+    record->state_valid = false;
+    if(record->watchdog_reset)
+    {
+        uint8_t previous = (uint8_t) ((status >> 8) & 0xFFu);
+        record->resets = (previous < UINT8_MAX) ? previous + 1 : UINT8_MAX;
+        record->state_valid = (watchdog_hw->scratch[3] == ~state) && record->resets <= SUPERVISOR_MAX_RESTORES;
+    }
+    else
+    {
+        // Power-on ou reset externo: o conteúdo anterior não vale
+        watchdog_hw->scratch[2] = 0;
+        watchdog_hw->scratch[3] = 0;
+    }
+
+    boot_resets = record->resets;
+    watchdog_hw->scratch[0] = SUPERVISOR_MAGIC;
+    supervisor_write_status(SUPERVISOR_CULPRIT_BOOT, boot_resets);
+    watchdog_enable(SUPERVISOR_WATCHDOG_MS, true);
+}
+
+int supervisor_register(const char *name, uint32_t deadline_ms)
+{
+    if(heartbeat_count >= SUPERVISOR_MAX_TASKS) return -1;
+    heartbeats[heartbeat_count].name = name;
+    heartbeats[heartbeat_count].deadline_us = deadline_ms * 1000u;
+    heartbeats[heartbeat_count].last_us = time_us_32();
+    return heartbeat_count++;
+}
+
+void supervisor_checkin(int id)
+{
+    if(id >= 0 && id < heartbeat_count) heartbeats[id].last_us = time_us_32();
+}
+
+void supervisor_save_state(uint32_t state)
+{
+    watchdog_hw->scratch[2] = state;
+    watchdog_hw->scratch[3] = ~state;
+}
+
+const char *supervisor_culprit_name(uint8_t culprit)
+{
+    if(culprit < heartbeat_count) return heartbeats[culprit].name;
+    if(culprit == SUPERVISOR_CULPRIT_BOOT) return "boot";
+    return "desconhecido";
+}
+
+/**
+ * @brief Procura um heartbeat atrasado.
+ *
+ * @return Índice do primeiro heartbeat atrasado, ou -1 se todos estão em dia.
+ */
+static int supervisor_find_late(uint32_t now_us)
+{
+    for(uint8_t i = 0; i < heartbeat_count; i++)
+        if(now_us - heartbeats[i].last_us > heartbeats[i].deadline_us) return i;
+    return -1;
+}
+
+void vSupervisorTask(void *pvParameters)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    uint32_t start_us = time_us_32();
+    int late;
+
+    // Os prazos contam a partir do início do escalonador
+    for(uint8_t i = 0; i < heartbeat_count; i++) heartbeats[i].last_us = start_us;
+    supervisor_write_status(SUPERVISOR_CULPRIT_NONE, boot_resets);
+    watchdog_update();
+
+    while(1)
+    {
+        xTaskDelayUntil(&last_wake, pdMS_TO_TICKS(SUPERVISOR_PERIOD_MS));
+        late = supervisor_find_late(time_us_32());
+        if(late >= 0)
+        {
+            // Para de alimentar o watchdog: o reset acontece em até SUPERVISOR_WATCHDOG_MS
+            supervisor_write_status((uint8_t) late, boot_resets);
+            vTaskSuspend(NULL);
+        }
+        if(boot_resets && time_us_32() - start_us >= SUPERVISOR_STABLE_MS * 1000u)
+        {
+            boot_resets = 0;
+            supervisor_write_status(SUPERVISOR_CULPRIT_NONE, boot_resets);
+        }
+        watchdog_update();
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file supervisor.h
+ * @brief Supervisor do watchdog do RP2040 com heartbeat por tarefa.
+ *
+ * Cada tarefa (ou callback de timer) registrada chama supervisor_checkin()
+ * dentro do seu prazo. A tarefa vSupervisorTask alimenta o watchdog a cada
+ * SUPERVISOR_PERIOD_MS somente se todos os heartbeats estiverem em dia; se
+ * algum atrasar, grava o culpado nos registradores scratch e deixa o watchdog
+ * reiniciar a placa.
+ *
+ * Os registradores scratch 0 a 3 sobrevivem ao reset do watchdog e guardam:
+ *
+ *     [0] SUPERVISOR_MAGIC
+ *     [1] culpado (bits 0-7) | resets consecutivos (bits 8-15)
+ *     [2] último estado salvo pela aplicação (supervisor_save_state)
+ *     [3] ~estado, para validar [2]
+ *
+ * Os scratch 4 a 7 são usados pelo SDK (watchdog_reboot) e não são tocados.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define SUPERVISOR_MAX_TASKS     8      /**< Máximo de heartbeats registrados */
+#define SUPERVISOR_PERIOD_MS     100    /**< Período de verificação dos heartbeats */
+#define SUPERVISOR_WATCHDOG_MS   1000   /**< Timeout do watchdog (cobre também o boot) */
+#define SUPERVISOR_STABLE_MS     10000  /**< Tempo saudável que zera os resets consecutivos */
+#define SUPERVISOR_MAX_RESTORES  3      /**< Resets consecutivos até desistir de restaurar o estado */
+
+#define SUPERVISOR_MAGIC         0x57445354u  /**< "WDST" */
+#define SUPERVISOR_CULPRIT_NONE  0xFFu  /**< Nenhum heartbeat atrasou (supervisor não rodou a tempo) */
+#define SUPERVISOR_CULPRIT_BOOT  0xFEu  /**< Travou antes do escalonador iniciar */
+
+/**
+ * @brief Informações do reset anterior, lidas em supervisor_init().
+ */
+typedef struct {
+    bool watchdog_reset;   /**< O boot atual foi causado pelo watchdog */
+    bool state_valid;      /**< state contém um estado salvo íntegro e pode ser restaurado */
+    uint8_t culprit;       /**< Índice do heartbeat culpado ou SUPERVISOR_CULPRIT_* */
+    uint8_t resets;        /**< Resets consecutivos por watchdog */
+    uint32_t state;        /**< Último estado salvo pela aplicação */
+} supervisor_record_t;
+
+/**
+ * @brief Lê o registro do reset anterior e liga o watchdog.
+ *
+ * Deve ser a primeira chamada de main(), antes de inicializar periféricos que
+ * possam travar. O estado só é marcado como válido se o boot veio do watchdog
+ * e houve no máximo SUPERVISOR_MAX_RESTORES resets seguidos.
+ *
+ * @param record Registro do reset anterior (saída).
+ */
+void supervisor_init(supervisor_record_t *record);
+
+/**
+ * @brief Registra um heartbeat.
+ *
+ * Deve ser chamada antes de o escalonador iniciar e sempre na mesma ordem, para
+ * que o índice gravado como culpado identifique o mesmo heartbeat após o reset.
+ *
+ * @param name Nome do heartbeat (ponteiro mantido).
+ * @param deadline_ms Intervalo máximo entre dois check-ins.
+ * @return Índice do heartbeat, ou -1 se a tabela estiver cheia.
+ */
+int supervisor_register(const char *name, uint32_t deadline_ms);
+
+/**
+ * @brief Informa que o heartbeat está vivo. Pode ser chamada de qualquer núcleo.
+ *
+ * @param id Índice retornado por supervisor_register().
+ */
+void supervisor_checkin(int id);
+
+/**
+ * @brief Salva o estado da aplicação nos registradores scratch.
+ *
+ * @param state Estado codificado pela aplicação.
+ */
+void supervisor_save_state(uint32_t state);
+
+/**
+ * @brief Nome de um culpado registrado em supervisor_record_t.
+ *
+ * @param culprit Índice do heartbeat ou SUPERVISOR_CULPRIT_*.
+ * @return Nome do heartbeat ou descrição do código especial.
+ */
+const char *supervisor_culprit_name(uint8_t culprit);
+
+/**
+ * @brief Tarefa do supervisor: verifica os heartbeats e alimenta o watchdog.
+ *
+ * @param pvParameters Não utilizado.
+ */
+void vSupervisorTask(void *pvParameters);
+
+#endif // SUPERVISOR_H
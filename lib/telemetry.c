@@ -0,0 +1,25 @@
+#include "telemetry.h"
+#include "crc.h"
+#include "pico/stdlib.h"
+#include <string.h>
+
+bool telemetry_send(uint8_t type, const void *payload, size_t len)
+{
+    uint8_t frame[4 + TELEMETRY_MAX_PAYLOAD + 2];
+    uint16_t crc;
+
+    if(len > TELEMETRY_MAX_PAYLOAD) return false;
+
+    frame[0] = TELEMETRY_SYNC0;
+    frame[1] = TELEMETRY_SYNC1;
+    frame[2] = type;
+    frame[3] = (uint8_t) len;
+    memcpy(&frame[4], payload, len);
+    crc = crc16_ccitt_update(CRC16_CCITT_INIT, &frame[2], len + 2);
+    frame[4 + len] = (uint8_t) (crc & 0xFFu);
+    frame[5 + len] = (uint8_t) (crc >> 8);
+
+    // Sem tradução CR/LF: o quadro é binário
+    stdio_put_string((const char *) frame, (int) (len + 6), false, false);
+    return true;
+}
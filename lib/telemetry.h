@@ -0,0 +1,101 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file telemetry.h
+ * @brief Canal binário de telemetria sobre o stdio USB (CDC).
+ *
+ * Cada quadro tem o formato:
+ *
+ *     0xA5 0x5A | tipo (1) | tamanho (1) | payload (tamanho) | CRC-16 (2, little-endian)
+ *
+ * O CRC-16/CCITT-FALSE cobre tipo, tamanho e payload. Os quadros são enviados
+ * sem tradução de CR/LF e podem se intercalar com as mensagens de texto do
+ * printf; o receptor (tools/telemetry.py) ressincroniza pelo marcador e pelo CRC.
+ * Todos os campos multibyte do payload são little-endian.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define TELEMETRY_SYNC0        0xA5u  /**< Primeiro byte do marcador de quadro */
+#define TELEMETRY_SYNC1        0x5Au  /**< Segundo byte do marcador de quadro */
+#define TELEMETRY_MAX_PAYLOAD  240u   /**< Tamanho máximo do payload de um quadro */
+
+/**
+ * @brief Tipos de quadro de telemetria.
+ */
+typedef enum {
+    TELEMETRY_TYPE_CPU_STATS  = 0x01, /**< Uso de CPU por tarefa/ISR na janela (cpu_stats.h) */
+    TELEMETRY_TYPE_TASK_NAMES = 0x02, /**< Tabela número da tarefa -> nome */
+    TELEMETRY_TYPE_LATENCY    = 0x03, /**< Pior latência de transição de fase */
+    TELEMETRY_TYPE_TRACE      = 0x04, /**< Registros do trace do kernel (trace_recorder.h) */
+    TELEMETRY_TYPE_WCET       = 0x05, /**< Pior tempo de execução de cada job e ISR (cpu_stats.h) */
+    TELEMETRY_TYPE_ACTUATION  = 0x06, /**< Detectores e encerramentos de fase atuada */
+    TELEMETRY_TYPE_PEDESTRIAN = 0x07, /**< Chamadas de pedestre e tempo até a travessia */
+    TELEMETRY_TYPE_COORDINATION = 0x08, /**< Ciclo, defasagem e erro da coordenação */
+    TELEMETRY_TYPE_EVENT_LOG  = 0x09, /**< Páginas do log de eventos na flash (event_log.h) */
+    TELEMETRY_TYPE_INPUT_LOG  = 0x0A, /**< Blocos do log de entradas do controlador (input_log.h) */
+} telemetry_type_t;
+
+/**
+ * @brief Payload de TELEMETRY_TYPE_LATENCY.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t cores;              /**< Núcleos em uso pelo FreeRTOS */
+    uint32_t transitions;       /**< Transições de fase desde o boot */
+    uint32_t latency_max_us;    /**< Pior latência observada, em microssegundos */
+} telemetry_latency_t;
+
+#define TELEMETRY_DETECTORS 2   /**< Detectores reportados em TELEMETRY_TYPE_ACTUATION */
+
+/**
+ * @brief Payload de TELEMETRY_TYPE_ACTUATION.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t presence;                           /**< Detectores com presença (bit n = detector n) */
+    uint32_t gap_outs;                          /**< Fases encerradas por falta de demanda */
+    uint32_t max_outs;                          /**< Fases encerradas no máximo */
+    uint32_t activations[TELEMETRY_DETECTORS];  /**< Vezes que cada detector ligou */
+    uint32_t overruns;                          /**< Amostras do ADC descartadas */
+} telemetry_actuation_t;
+
+/**
+ * @brief Payload de TELEMETRY_TYPE_PEDESTRIAN.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t waiting;            /**< 1 se há chamada aguardando a travessia */
+    uint32_t requests;          /**< Chamadas registradas desde o boot */
+    uint32_t served;            /**< Chamadas atendidas (travessia iniciada) */
+    uint32_t latency_last_ms;   /**< Tempo entre o botão e a travessia, última chamada */
+    uint32_t latency_max_ms;    /**< Pior tempo entre o botão e a travessia */
+} telemetry_pedestrian_t;
+
+/**
+ * @brief Payload de TELEMETRY_TYPE_COORDINATION.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t synced;             /**< 1 se o ciclo está ancorado no tempo do host */
+    uint32_t cycle_ms;          /**< Ciclo do plano (0: livre) */
+    uint32_t offset_ms;         /**< Defasagem do plano */
+    int32_t last_error_ms;      /**< Erro no último ponto de sincronismo (> 0: atrasado) */
+    uint32_t time_syncs;        /**< Ajustes de tempo recebidos desde o boot */
+} telemetry_coordination_t;
+
+/**
+ * @brief Envia um quadro de telemetria.
+ *
+ * Pode ser chamado de qualquer tarefa; o stdio serializa o acesso à porta.
+ *
+ * @param type Tipo do quadro (telemetry_type_t).
+ * @param payload Dados do quadro.
+ * @param len Tamanho do payload (até TELEMETRY_MAX_PAYLOAD).
+ * @return true se o quadro foi enviado.
+ */
+bool telemetry_send(uint8_t type, const void *payload, size_t len);
+
+#endif // TELEMETRY_H
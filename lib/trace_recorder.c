@@ -0,0 +1,51 @@
+#include "FreeRTOS.h"
+
+#if TRAFFIC_TRACE
+
+#include "trace_recorder.h"
+#include "telemetry.h"
+#include "cpu_stats.h"
+#include "pico/stdlib.h"
+#include <string.h>
+
+trace_record_t trace_ring[TRACE_CORES][TRACE_RING_SIZE];
+volatile uint32_t trace_head[TRACE_CORES];
+volatile bool trace_enabled = true;
+
+void trace_dump(void)
+{
+    uint8_t payload[sizeof(trace_frame_header_t) + TRACE_RECORDS_PER_FRAME * sizeof(trace_record_t)];
+    trace_frame_header_t header;
+
+    trace_enabled = false;
+    __dmb();  // O outro núcleo pode estar no meio de um registro
+    busy_wait_us(2);
+
+    header.dump_time_us = time_us_64();
+    cpu_stats_send_task_names();
+    for(uint8_t core = 0; core < TRACE_CORES; core++)
+    {
+        uint32_t head = trace_head[core];
+        uint32_t count = (head < TRACE_RING_SIZE) ? head : TRACE_RING_SIZE;
+        uint32_t next = head - count;
+
+        header.core = core;
+        while(count)
+        {
+            uint32_t chunk = (count < TRACE_RECORDS_PER_FRAME) ? count : TRACE_RECORDS_PER_FRAME;
+            header.count = (uint8_t) chunk;
+            memcpy(payload, &header, sizeof(header));
+            for(uint32_t i = 0; i < chunk; i++, next++)
+                memcpy(&payload[sizeof(header) + i * sizeof(trace_record_t)],
+                    &trace_ring[core][next & (TRACE_RING_SIZE - 1u)], sizeof(trace_record_t));
+            telemetry_send(TELEMETRY_TYPE_TRACE, payload, sizeof(header) + chunk * sizeof(trace_record_t));
+            count -= chunk;
+        }
+        trace_head[core] = 0;
+    }
+
+    __dmb();
+    trace_enabled = true;
+}
+
+#endif // TRAFFIC_TRACE
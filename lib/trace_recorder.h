@@ -0,0 +1,128 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+/**
+ * @file trace_recorder.h
+ * @brief Gravador de trace do kernel em anel de RAM, um anel por núcleo.
+ *
+ * Incluído ao final de FreeRTOSConfig.h quando TRAFFIC_TRACE = 1 (opção CMake
+ * TRAFFIC_TRACE). Define as macros de trace do FreeRTOS (troca de contexto,
+ * operações de fila e entrada/saída de ISR) para gravar registros de 8 bytes
+ * com o timestamp de 32 bits do timer de 1 µs. Cada registro custa a leitura
+ * do CPUID e do TIMERAWL, um incremento de índice e um store de 8 bytes, com as
+ * interrupções mascaradas apenas durante a escrita.
+ *
+ * O conteúdo dos anéis é enviado com trace_dump() em quadros
+ * TELEMETRY_TYPE_TRACE; tools/trace2perfetto.py converte a captura para o
+ * formato JSON do Chrome/Perfetto.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/structs/sio.h"
+#include "hardware/structs/timer.h"
+#include "hardware/sync.h"
+
+#define TRACE_RING_SIZE       2048u  /**< Registros por núcleo (potência de 2) */
+#define TRACE_CORES           2u     /**< Núcleos do RP2040 */
+#define TRACE_RECORDS_PER_FRAME 28u  /**< Registros por quadro de telemetria */
+
+/**
+ * @brief Tipos de evento gravados.
+ */
+typedef enum {
+    TRACE_EVT_TASK_IN = 1,        /**< Tarefa entrou em execução (arg = número da tarefa) */
+    TRACE_EVT_TASK_OUT,           /**< Tarefa saiu de execução (arg = número da tarefa) */
+    TRACE_EVT_QUEUE_SEND,         /**< Envio para fila (arg = número da fila) */
+    TRACE_EVT_QUEUE_SEND_ISR,     /**< Envio para fila a partir de ISR */
+    TRACE_EVT_QUEUE_RECEIVE,      /**< Recepção de fila */
+    TRACE_EVT_QUEUE_RECEIVE_ISR,  /**< Recepção de fila a partir de ISR */
+    TRACE_EVT_ISR_ENTER,          /**< Entrada em ISR (arg = trace_isr_t) */
+    TRACE_EVT_ISR_EXIT,           /**< Saída de ISR (arg = trace_isr_t) */
+} trace_event_type_t;
+
+/**
+ * @brief Identificadores das ISRs gravadas.
+ */
+typedef enum {
+    TRACE_ISR_KERNEL = 0,  /**< traceISR_ENTER/EXIT chamados pelo port */
+    TRACE_ISR_GPIO,        /**< Callback de GPIO (botões) */
+    TRACE_ISR_MONITOR,     /**< Alarme do monitor de conflitos */
+    TRACE_ISR_FLASH,       /**< Alarme do pisca (noturno e falha) */
+} trace_isr_t;
+
+/**
+ * @brief Registro de trace (8 bytes).
+ */
+typedef struct {
+    uint32_t timestamp_us;  /**< 32 bits baixos do timer de 1 µs */
+    uint8_t event;          /**< trace_event_type_t */
+    uint8_t reserved;
+    uint16_t arg;           /**< Argumento do evento */
+} trace_record_t;
+
+/**
+ * @brief Cabeçalho do payload de TELEMETRY_TYPE_TRACE.
+ *
+ * Seguido de count registros trace_record_t, do mais antigo ao mais novo.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t core;            /**< Núcleo do anel */
+    uint8_t count;           /**< Registros neste quadro */
+    uint64_t dump_time_us;   /**< time_us_64() no início do dump, para desfazer o wrap */
+} trace_frame_header_t;
+
+extern trace_record_t trace_ring[TRACE_CORES][TRACE_RING_SIZE];
+extern volatile uint32_t trace_head[TRACE_CORES];
+extern volatile bool trace_enabled;
+
+/**
+ * @brief Grava um evento no anel do núcleo atual.
+ *
+ * @param event Tipo do evento (trace_event_type_t).
+ * @param arg Argumento do evento.
+ */
+static inline void trace_record(uint8_t event, uint16_t arg)
+{
+    uint32_t irq_state = save_and_disable_interrupts();
+    if(trace_enabled)
+    {
+        uint32_t core = sio_hw->cpuid;
+        uint32_t index = trace_head[core]++ & (TRACE_RING_SIZE - 1u);
+        trace_record_t *record = &trace_ring[core][index];
+        record->timestamp_us = timer_hw->timerawl;
+        record->event = event;
+        record->arg = arg;
+    }
+    restore_interrupts(irq_state);
+}
+
+/**
+ * @brief Envia o conteúdo dos anéis por telemetria.
+ *
+ * A gravação é pausada durante o envio e os anéis são esvaziados ao final.
+ */
+void trace_dump(void);
+
+#define trace_isr_enter(isr) trace_record(TRACE_EVT_ISR_ENTER, (uint16_t) (isr))
+#define trace_isr_exit(isr)  trace_record(TRACE_EVT_ISR_EXIT, (uint16_t) (isr))
+
+/* Macros do kernel. Expandidas dentro de tasks.c/queue.c, onde TCB_t e Queue_t são completos. */
+#define traceTASK_SWITCHED_IN()             do { cpu_stats_count_switch(); trace_record(TRACE_EVT_TASK_IN, (uint16_t) pxCurrentTCB->uxTCBNumber); } while(0)
+#define traceTASK_SWITCHED_OUT()            trace_record(TRACE_EVT_TASK_OUT, (uint16_t) pxCurrentTCB->uxTCBNumber)
+#define traceQUEUE_SEND(pxQueue)            trace_record(TRACE_EVT_QUEUE_SEND, (uint16_t) (pxQueue)->uxQueueNumber)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)   trace_record(TRACE_EVT_QUEUE_SEND_ISR, (uint16_t) (pxQueue)->uxQueueNumber)
+#define traceQUEUE_RECEIVE(pxQueue)         trace_record(TRACE_EVT_QUEUE_RECEIVE, (uint16_t) (pxQueue)->uxQueueNumber)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue) trace_record(TRACE_EVT_QUEUE_RECEIVE_ISR, (uint16_t) (pxQueue)->uxQueueNumber)
+#define traceISR_ENTER()                    trace_isr_enter(TRACE_ISR_KERNEL)
+#define traceISR_EXIT()                     trace_isr_exit(TRACE_ISR_KERNEL)
+#define traceISR_EXIT_TO_SCHEDULER()        trace_isr_exit(TRACE_ISR_KERNEL)
+
+#endif // __ASSEMBLER__
+
+#endif // TRACE_RECORDER_H
@@ -34,6 +34,18 @@ static void fliplr(uint8_t *matrix) {
     matrix[18] = temp;
 }
 
+/**
+ * @brief Divide a intensidade entre os canais de uma cor misturada.
+ * 
+ * @note Com intensidade baixa a divisão inteira zeraria o canal (branco na
+ *       intensidade 1: 2/3 = 0) e o LED ficaria apagado; cada canal fica com
+ *       pelo menos 1 enquanto a intensidade não for 0.
+ */
+static uint8_t ws2812b_mix_channel(uint8_t intensity_value, uint8_t channels)
+{
+    uint8_t channel_value = intensity_value / channels;
+    return (intensity_value != 0 && channel_value == 0) ? 1 : channel_value;
+}
 
 /**
  * @brief Compoe o valor do LED com base na cor e intensidade fornecida.
@@ -63,19 +75,19 @@ static uint32_t ws2812b_compose_led_value(uint8_t color, uint8_t intensity)
         composite_value = intensity_value << 8;  // Coloca o valor da intensidade na posição do azul
         break;
     case WS2812B_COLOR_YELLOW:
-        intensity_value /= 2u; 
+        intensity_value = ws2812b_mix_channel(intensity_value, 2u);
         composite_value = ((intensity_value << 16) | (intensity_value << 24)); // Mistura vermelho e verde
         break;
     case WS2812B_COLOR_PURPLE:
-        intensity_value /= 2u;
+        intensity_value = ws2812b_mix_channel(intensity_value, 2u);
         composite_value = ((intensity_value << 8) | (intensity_value << 16)); // Mistura vermelho e azul
         break;
     case WS2812B_COLOR_WHITE:
-        intensity_value /= 3u;
+        intensity_value = ws2812b_mix_channel(intensity_value, 3u);
         composite_value = ((intensity_value << 24) | (intensity_value << 16) | (intensity_value << 8)); // Mistura as três cores
         break;
     case WS2812B_COLOR_BLUE_MARINE:
-        intensity_value /= 2u;
+        intensity_value = ws2812b_mix_channel(intensity_value, 2u);
         composite_value = ((intensity_value << 24) | (intensity_value << 8)); // Mistura verde e azul
         break;
     default:
@@ -96,7 +108,7 @@ static uint32_t ws2812b_compose_led_value(uint8_t color, uint8_t intensity)
  * @param color Cor do LED (vermelho, verde, azul, etc.).
  * @param intensity Intensidade do LED (0-100%).
  */
-void ws2812b_draw(const ws2812b_t *ws, const uint8_t *glyph, const uint8_t color, const uint8_t intensity)
+void ws2812b_draw(ws2812b_t *ws, const uint8_t *glyph, const uint8_t color, const uint8_t intensity)
 {
     uint8_t i;
     uint32_t composite_value;
@@ -104,11 +116,31 @@ void ws2812b_draw(const ws2812b_t *ws, const uint8_t *glyph, const uint8_t color
     // Percorre cada posição do "glyph" (matriz 5x5) e acende o LED correspondente
     for(i = 0; i < 25; i++) {
         // Se o valor da posição for 1, acende o LED com o valor calculado
-        if(glyph[24-i] == 1) {
-            composite_value = ws2812b_compose_led_value(color, intensity); // Calcula o valor para a cor e intensidade
-            send_ws2812b_data(ws->pio, ws->state_machine_id, composite_value); // Envia o valor do LED via PIO
-        }
-        else send_ws2812b_data(ws->pio, ws->state_machine_id, 0); // Se o LED estiver apagado, envia 0
+        if(glyph[24-i] == 1) composite_value = ws2812b_compose_led_value(color, intensity); // Calcula o valor para a cor e intensidade
+        else composite_value = 0; // Se o LED estiver apagado, envia 0
+        ws->frame[24-i] = composite_value;
+        send_ws2812b_data(ws->pio, ws->state_machine_id, composite_value); // Envia o valor do LED via PIO
+    }
+}
+
+/**
+ * @brief Desenha a matriz com uma cor por LED.
+ * 
+ * Percorre a matriz na mesma ordem de ws2812b_draw(); posições com
+ * WS2812B_COLOR_OFF são apagadas.
+ * 
+ * @param ws Ponteiro para o controlador WS2812B.
+ * @param colors Matriz de 25 elementos com a cor de cada LED.
+ * @param intensity Intensidade do LED (0-100%).
+ */
+void ws2812b_draw_colors(ws2812b_t *ws, const uint8_t *colors, const uint8_t intensity)
+{
+    uint8_t i;
+
+    for(i = 0; i < 25; i++) {
+        uint8_t color = colors[24-i];
+        ws->frame[24-i] = (color == WS2812B_COLOR_OFF) ? 0 : ws2812b_compose_led_value(color, intensity);
+        send_ws2812b_data(ws->pio, ws->state_machine_id, ws->frame[24-i]);
     }
 }
 
@@ -119,11 +151,14 @@ void ws2812b_draw(const ws2812b_t *ws, const uint8_t *glyph, const uint8_t color
  * 
  * @param ws Ponteiro para o controlador WS2812B.
  */
-void ws2812b_turn_off_all(const ws2812b_t *ws)
+void ws2812b_turn_off_all(ws2812b_t *ws)
 {
     uint8_t i;
     // Envia o valor 0 para todos os LEDs, apagando-os
-    for(i = 0; i < 25; i++) send_ws2812b_data(ws->pio, ws->state_machine_id, 0);
+    for(i = 0; i < 25; i++) {
+        ws->frame[i] = 0;
+        send_ws2812b_data(ws->pio, ws->state_machine_id, 0);
+    }
 }
 
 /**
@@ -183,6 +218,7 @@ void ws2812b_init(ws2812b_t *ws, PIO pio, uint8_t pin)
     ws->out_pin = pin;
     ws->state_machine_id = sm;
     ws->pio = pio;
+    for(uint8_t i = 0; i < 25; i++) ws->frame[i] = 0; // Nenhum quadro enviado ainda
 
     // return ws; // Retorna o controlador WS2812B configurado
 }
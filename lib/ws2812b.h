@@ -13,6 +13,7 @@
 #define WS2812B_COLOR_PURPLE      4             /**< Define a cor roxa para os LEDs */
 #define WS2812B_COLOR_WHITE       5             /**< Define a cor branca para os LEDs */
 #define WS2812B_COLOR_BLUE_MARINE 6             /**< Define a cor azul-marinho para os LEDs */
+#define WS2812B_COLOR_OFF         0xFF          /**< LED apagado (ws2812b_draw_colors) */
 
 #define ws2812b_init_default(pio) ws2812b_init(pio, WS2812B_PIN)
 
@@ -42,6 +43,7 @@ typedef struct {
     PIO pio;                 /**< Ponteiro para o controlador PIO utilizado para comunicação com os LEDs */
     uint state_machine_id;   /**< ID da máquina de estado (state machine) que controla o envio dos dados para os LEDs */
     uint8_t out_pin;         /**< Pino GPIO ao qual o WS2812B está conectado */
+    uint32_t frame[25];      /**< Último quadro enviado (palavras GRB na ordem de glyph), lido pelo monitor de conflitos */
 } ws2812b_t;
 
 /**
@@ -70,9 +72,21 @@ void ws2812b_init(ws2812b_t *ws, PIO pio, uint8_t pin);
  * @param color A cor dos LEDs, definida pelas constantes `WS2812B_COLOR_RED`, `GREEN`, `BLUE`, etc.
  * @param intensity A intensidade dos LEDs, em valor de 0 a 100.
  */
-void ws2812b_draw(const ws2812b_t *ws, const uint8_t *glyph, const uint8_t color, const uint8_t intensity);
+void ws2812b_draw(ws2812b_t *ws, const uint8_t *glyph, const uint8_t color, const uint8_t intensity);
 
 
+/**
+ * @brief Desenha a matriz com uma cor por LED.
+ * 
+ * Mesma ordem de LEDs de ws2812b_draw(), mas cada posição traz a sua cor
+ * (`WS2812B_COLOR_*`, ou `WS2812B_COLOR_OFF` para apagado).
+ * 
+ * @param ws Ponteiro para a estrutura `ws2812b_t` contendo as configurações do WS2812B.
+ * @param colors Matriz de 25 elementos com a cor de cada LED.
+ * @param intensity A intensidade dos LEDs, em valor de 0 a 100.
+ */
+void ws2812b_draw_colors(ws2812b_t *ws, const uint8_t *colors, const uint8_t intensity);
+
 /**
  * @brief Desliga todos os LEDs da matriz WS2812B.
  * 
@@ -81,7 +95,7 @@ void ws2812b_draw(const ws2812b_t *ws, const uint8_t *glyph, const uint8_t color
  * 
  * @param ws Ponteiro para a estrutura `ws2812b_t` contendo as configurações do WS2812B.
  */
-void ws2812b_turn_off_all(const ws2812b_t *ws);
+void ws2812b_turn_off_all(ws2812b_t *ws);
 
 /**
  * @brief Envia dados para o WS2812B via PIO.
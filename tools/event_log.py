@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""Baixa e decodifica o log de eventos gravado na flash (lib/event_log.h).
+
+Uso:
+    python3 tools/event_log.py /dev/ttyACM0              # pede o log pelo shell
+    python3 tools/event_log.py regiao.bin --raw          # imagem da região da flash
+    python3 tools/event_log.py /dev/ttyACM0 --save log.bin
+    python3 tools/event_log.py log.bin --raw --arrivals chegadas.csv
+
+Pela porta USB, o comando "eventos" do shell faz a placa gravar os eventos
+pendentes e enviar as páginas em quadros de telemetria. A imagem bruta pode ser
+lida com a placa em BOOTSEL:
+
+    picotool save -r 0x101EC000 0x101FC000 regiao.bin
+
+Os eventos saem em ordem, agrupados por boot, com o tempo desde o boot (e a
+hora do host depois do primeiro ajuste de hora do boot).
+
+Com --arrivals, as chegadas (início de presença nos detectores e botão de
+pedestre) também vão para um CSV "boot,tempo_ms,entrada", a entrada do
+otimizador de planos (tools/sim/optimize_plan.c).
+"""
+import argparse
+import csv
+import datetime
+import struct
+import sys
+
+from telemetry import Decoder, crc16_ccitt
+
+PAGE_SIZE = 256
+MAGIC = 0x474C5645
+HEADER = struct.Struct("<IIIHH")
+RECORD = struct.Struct("<HBBI")
+RECORDS_PER_PAGE = 30
+
+CODE_TIME, CODE_LOST, CODE_BOOT, CODE_PHASE, CODE_MODE, CODE_PED_CALL, CODE_PED_WALK, \
+    CODE_TIME_SYNC, CODE_CONFIG, CODE_FAULT, CODE_DETECTOR, CODE_PREEMPT, CODE_PREEMPT_GREEN, \
+    CODE_PREEMPT_END, CODE_PLAN = range(15)
+
+SIGNALS = {0: "amarelo", 1: "verde", 2: "vermelho"}
+PED = {0: "", 1: " travessia", 2: " limpeza"}
+PLANS = {0: "dia", 1: "pico"}
+FAULTS = {0: "log de texto perdido", 1: "duracoes salvas descartadas", 2: "falha ao gravar a flash",
+          3: "monitor de conflitos"}
+FAULT_CONFLICT = 3
+CONFLICTS = {1: "focos conflitantes", 2: "indicacao invalida", 3: "saidas divergentes", 4: "pedestre em conflito",
+             5: "LED fora dos focos"}
+
+
+def parse_page(data):
+    """Cabeçalho e registros de uma página, ou None se o cabeçalho não confere."""
+    magic, sequence, base_ms, boot, crc = HEADER.unpack_from(data)
+    if magic != MAGIC or crc16_ccitt(data[:HEADER.size - 2]) != crc:
+        return None
+    records = []
+    for i in range(RECORDS_PER_PAGE):
+        record = RECORD.unpack_from(data, HEADER.size + i * RECORD.size)
+        if record[1] == 0xFF:
+            break
+        records.append(record)
+    return sequence, boot, base_ms, records
+
+
+def events(pages):
+    """(boot, ms desde o boot, código, arg, value) em ordem de gravação."""
+    parsed = [p for p in (parse_page(data) for data in pages) if p]
+    parsed.sort(key=lambda p: p[0])
+    for _, boot, base_ms, records in parsed:
+        time_ms = base_ms
+        for delta_ms, code, arg, value in records:
+            time_ms += delta_ms
+            if code == CODE_TIME:
+                time_ms = value
+                continue
+            yield boot, time_ms, code, arg, value
+
+
+def describe(code, arg, value):
+    if code == CODE_LOST:
+        return "%d eventos perdidos (anel de RAM cheio)" % value
+    if code == CODE_BOOT:
+        if arg:
+            return "partida apos watchdog (culpado #%d, resets %d)" % (value & 0xFF, (value >> 8) & 0xFF)
+        return "partida"
+    if code == CODE_PHASE:
+        heads = value >> 16
+        text = "fase %d %s%s" % (arg, SIGNALS.get(value & 0xFF, "?"), PED.get((value >> 8) & 0xFF, ""))
+        return text + (" focos=%04x" % heads if heads else "")
+    if code == CODE_MODE:
+        return "modo %s%s" % ("noite" if arg else "dia", " (agenda)" if value else "")
+    if code == CODE_PED_CALL:
+        return "chamada de pedestre"
+    if code == CODE_PED_WALK:
+        return "travessia apos %d ms de espera" % value
+    if code == CODE_TIME_SYNC:
+        return "hora do host %s" % datetime.datetime.fromtimestamp(value).isoformat(" ")
+    if code == CODE_CONFIG:
+        return "configuracao salva (chave 0x%04x)" % value
+    if code == CODE_FAULT and arg == FAULT_CONFLICT:
+        return "FALHA: %s: %s (%04x), vermelho piscante" % (FAULTS[arg], CONFLICTS.get(value & 0xFF, "?"), value >> 8)
+    if code == CODE_FAULT:
+        return "FALHA: %s (%d)" % (FAULTS.get(arg, "#%d" % arg), value)
+    if code == CODE_DETECTOR:
+        return "veiculo no detector %d" % arg
+    if code == CODE_PREEMPT:
+        return "preempcao para a fase %d (verde em ate %d ms)" % (arg, value)
+    if code == CODE_PREEMPT_GREEN:
+        return "preempcao: fase %d verde apos %d ms" % (arg, value)
+    if code == CODE_PREEMPT_END:
+        return "fim da preempcao da fase %d (%d ms)" % (arg, value)
+    if code == CODE_PLAN:
+        return "plano %s%s" % (PLANS.get(arg, "#%d" % arg), " (agenda)" if value else "")
+    return "codigo %d arg=%d value=%d" % (code, arg, value)
+
+
+def print_events(pages, out=sys.stdout):
+    items = list(events(pages))
+    # Hora do host: o primeiro ajuste de cada boot vale para o boot inteiro
+    offsets = {}
+    for boot, time_ms, code, _, value in items:
+        if code == CODE_TIME_SYNC and boot not in offsets:
+            offsets[boot] = value * 1000 - time_ms
+    for boot, time_ms, code, arg, value in items:
+        uptime = "%d:%02d:%02d.%03d" % (time_ms // 3600000, time_ms // 60000 % 60, time_ms // 1000 % 60, time_ms % 1000)
+        wall = ""
+        if boot in offsets:
+            wall = " " + datetime.datetime.fromtimestamp((offsets[boot] + time_ms) / 1000).isoformat(" ", "milliseconds")
+        print("boot %d +%s%s  %s" % (boot, uptime, wall, describe(code, arg, value)), file=out)
+
+
+def save_arrivals(pages, path):
+    """Grava as chegadas: entrada é o número do detector ou "pedestre"."""
+    with open(path, "w", newline="") as stream:
+        writer = csv.writer(stream)
+        writer.writerow(["boot", "tempo_ms", "entrada"])
+        for boot, time_ms, code, arg, _ in events(pages):
+            if code == CODE_DETECTOR:
+                writer.writerow([boot, time_ms, arg])
+            elif code == CODE_PED_CALL:
+                writer.writerow([boot, time_ms, "pedestre"])
+
+
+def download(port):
+    """Pede o log pelo shell e junta as páginas recebidas até o quadro final."""
+    with open(port, "wb", buffering=0) as stream:
+        stream.write(b"eventos\n")
+    decoder = Decoder(out=open("/dev/null", "w"))
+    with open(port, "rb", buffering=0) as stream:
+        while not decoder.event_dump_done:
+            data = stream.read(256)
+            if not data:
+                break
+            decoder.feed(data)
+    return [bytes(decoder.event_pages[page]) for page in sorted(decoder.event_pages)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="porta serial da placa ou imagem da região (--raw)")
+    parser.add_argument("--raw", action="store_true", help="source é uma imagem bruta da região da flash")
+    parser.add_argument("--save", help="salva as páginas recebidas como imagem bruta")
+    parser.add_argument("--arrivals", help="grava as chegadas em CSV (tools/sim/optimize_plan.c)")
+    args = parser.parse_args()
+
+    if args.raw:
+        with open(args.source, "rb") as stream:
+            image = stream.read()
+        pages = [image[i:i + PAGE_SIZE] for i in range(0, len(image) - PAGE_SIZE + 1, PAGE_SIZE)]
+    else:
+        pages = download(args.source)
+    if args.save:
+        with open(args.save, "wb") as stream:
+            stream.write(b"".join(pages))
+    if args.arrivals:
+        save_arrivals(pages, args.arrivals)
+    print_events(pages)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""Baixa o log de entradas do controlador (lib/input_log.h) para reprodução no Linux.
+
+Uso:
+    python3 tools/input_log.py /dev/ttyACM0 --save entradas.bin
+    ./replay_inputs entradas.bin                 # tools/sim/replay_inputs.c
+
+Pela porta USB, o comando "entradas" do shell faz a placa enviar os blocos do
+anel de RAM, do mais antigo ao em uso, em quadros de telemetria. Os blocos são
+gravados em sequência no arquivo, como o replay_inputs os lê, e o resumo de
+cada um (número de série, controlador e trecho do relógio que ele cobre) sai
+na tela.
+"""
+import argparse
+import struct
+
+from telemetry import Decoder
+
+BLOCK_SIZE = 2048
+MAGIC = 0x4C49
+HEADER = struct.Struct("<HIBBIQHB")
+CONTROLLERS = {0: "motor de fases", 1: "aneis e barreiras"}
+PLANS = {0: "dia", 1: "pico"}
+
+
+def download(port):
+    """Pede o log pelo shell e junta os blocos recebidos até o quadro final."""
+    with open(port, "wb", buffering=0) as stream:
+        stream.write(b"entradas\n")
+    decoder = Decoder(out=open("/dev/null", "w"))
+    with open(port, "rb", buffering=0) as stream:
+        while not decoder.input_dump_done:
+            data = stream.read(256)
+            if not data:
+                break
+            decoder.feed(data)
+    return [bytes(decoder.input_blocks[block]) for block in sorted(decoder.input_blocks)]
+
+
+def print_summary(blocks):
+    previous = None
+    for data in blocks:
+        magic, sequence, controller, phases, base_ms, _, _, plan = HEADER.unpack_from(data)
+        if magic != MAGIC:
+            print("bloco invalido")
+            continue
+        gap = " (blocos perdidos antes deste)" if previous is not None and sequence != previous + 1 else ""
+        print("bloco %d: %s, plano %s, %d fases, a partir de %.3f s%s"
+              % (sequence, CONTROLLERS.get(controller, "?"), PLANS.get(plan, "?"), phases, base_ms / 1000.0, gap))
+        previous = sequence
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port", help="porta serial da placa")
+    parser.add_argument("--save", required=True, help="arquivo dos blocos (entrada do replay_inputs)")
+    args = parser.parse_args()
+
+    blocks = download(args.port)
+    with open(args.save, "wb") as stream:
+        stream.write(b"".join(blocks))
+    print_summary(blocks)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+"""Análise de escalonabilidade (tempo de resposta) do conjunto de tarefas do firmware.
+
+Uso:
+    python3 tools/schedulability.py tools/task_set.json
+    python3 tools/schedulability.py tools/task_set.json --capture captura.bin
+    python3 tools/schedulability.py tools/task_set.json --single-core   # build TRAFFIC_SMP=OFF
+
+O escalonamento é particionado: cada job roda no núcleo indicado e só sofre
+interferência dos jobs de prioridade maior ou igual no mesmo núcleo. ISRs têm
+prioridade acima de qualquer tarefa. Os callbacks de software timer rodam na
+tarefa de serviço dos timers e são tratados como jobs dessa prioridade (que se
+interferem entre si, pois a fila de comandos é FIFO).
+
+O tempo de resposta segue a análise clássica de prioridade fixa:
+
+    R = C + B + soma(ceil(R / T_j) * C_j)   para j em hp(i)
+
+com o bloqueio B vindo das seções críticas de jobs de menor prioridade no mesmo
+núcleo e do uso do mesmo recurso em outro núcleo. Com --capture, os WCETs
+medidos na placa (quadro TELEMETRY_TYPE_WCET, ver lib/cpu_stats.h) substituem
+os valores da tabela.
+"""
+import argparse
+import json
+import math
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from telemetry import Decoder  # noqa: E402
+
+ISR_PRIORITY = float("inf")
+
+
+class Job:
+    def __init__(self, spec, timer_task):
+        self.name = spec["name"]
+        self.kind = spec["kind"]
+        self.period_us = spec["period_ms"] * 1000
+        self.deadline_us = spec.get("deadline_ms", spec["period_ms"]) * 1000
+        self.wcet_us = spec["wcet_us"]
+        self.measure = spec.get("measure")
+        self.measured = False
+        self.resources = spec.get("resources", {})
+        if self.kind == "timer":
+            self.core = timer_task["core"]
+            self.priority = timer_task["priority"]
+            self.task = timer_task["name"]
+        else:
+            self.core = spec["core"]
+            self.priority = ISR_PRIORITY if self.kind == "isr" else spec["priority"]
+            self.task = self.name
+
+    def priority_text(self, priority=None):
+        priority = self.priority if priority is None else priority
+        return "ISR" if priority == ISR_PRIORITY else str(priority)
+
+
+def load_capture(path):
+    """Lê uma captura bruta do USB e devolve o último WCET de cada job/ISR."""
+    with open(os.devnull, "w") as devnull, open(path, "rb") as stream:
+        decoder = Decoder(out=devnull)
+        decoder.feed(stream.read())
+    return decoder.wcet
+
+
+def blocking(job, jobs, resources, priorities):
+    """Maior bloqueio sofrido pelo job por seções críticas de outros jobs."""
+    same_core_lower = [j for j in jobs if j is not job and j.core == job.core
+                       and priorities[j.name] < priorities[job.name]]
+    remote = [j for j in jobs if j.core != job.core]
+    total = 0
+    for name in job.resources:
+        holders = [j.resources[name] for j in same_core_lower + remote if name in j.resources]
+        total += max(holders, default=0)
+    # taskENTER_CRITICAL mascara as interrupções do núcleo: qualquer seção crítica
+    # de menor prioridade atrasa o job mesmo sem compartilhar o recurso
+    masked = [cs for j in same_core_lower for name, cs in j.resources.items()
+              if resources[name]["protocol"] == "critical" and name not in job.resources]
+    return total + max(masked, default=0)
+
+
+def response_time(job, jobs, resources, priorities):
+    """Tempo de resposta no pior caso, ou None se passar do deadline."""
+    hp = [j for j in jobs if j is not job and j.core == job.core
+          and priorities[j.name] >= priorities[job.name]]
+    base = job.wcet_us + blocking(job, jobs, resources, priorities)
+    r = base
+    while True:
+        nxt = base + sum(math.ceil(r / j.period_us) * j.wcet_us for j in hp)
+        if nxt == r:
+            return r
+        if nxt > job.deadline_us:
+            return None
+        r = nxt
+
+
+def analyse(jobs, resources, priorities):
+    return {job.name: response_time(job, jobs, resources, priorities) for job in jobs}
+
+
+def priority_inversions(jobs, resources, priorities):
+    """Lista os pares que compartilham um recurso sem protocolo contra inversão."""
+    warnings = []
+    for name, info in resources.items():
+        users = [j for j in jobs if name in j.resources]
+        for hi in users:
+            for lo in users:
+                if priorities[hi.name] <= priorities[lo.name] or hi.task == lo.task:
+                    continue
+                middle = [m.name for m in jobs if m.core == lo.core and m.task not in (hi.task, lo.task)
+                          and priorities[lo.name] < priorities[m.name] < priorities[hi.name]]
+                if info["protocol"] == "critical":
+                    continue  # limitado pela seção crítica, já contado em B
+                if info["protocol"] == "none" and middle:
+                    warnings.append("%s: %s (prio %s) pode esperar %s (prio %s) preemptado por %s"
+                                    " -> inversão sem limite"
+                                    % (name, hi.name, hi.priority_text(priorities[hi.name]),
+                                       lo.name, lo.priority_text(priorities[lo.name]), ", ".join(middle)))
+                else:
+                    warnings.append("%s: %s espera %s por até %d us (%s)"
+                                    % (name, hi.name, lo.name, lo.resources[name], info["protocol"]))
+    return warnings
+
+
+def suggest_priorities(jobs, max_priorities):
+    """Prioridades deadline/rate monotonic (callbacks de timer contam como uma unidade).
+
+    A ordem é global para que o resultado valha também no build de um núcleo.
+    As prioridades são atribuídas de baixo para cima a partir de
+    tskIDLE_PRIORITY + 1, uma por unidade, até configMAX_PRIORITIES - 1.
+    """
+    units = {}
+    for job in jobs:
+        if job.kind != "isr":
+            units.setdefault(job.task, []).append(job)
+    ordered = sorted(units.values(), key=lambda members: (min(j.deadline_us for j in members),
+                                                          min(j.period_us for j in members)))
+    suggested = {job.name: job.priority for job in jobs if job.kind == "isr"}
+    for rank, members in enumerate(reversed(ordered)):
+        for job in members:
+            suggested[job.name] = min(1 + rank, max_priorities - 1)
+    return suggested
+
+
+def same_order(jobs, a, b):
+    """Verifica se duas atribuições de prioridade ordenam as tarefas do mesmo jeito."""
+    tasks = [j for j in jobs if j.kind != "isr"]
+    return all((a[x.name] > a[y.name]) == (b[x.name] > b[y.name]) for x in tasks for y in tasks
+               if x.task != y.task)
+
+
+def fmt_us(value):
+    return "  >deadline" if value is None else "%9.3f ms" % (value / 1000)
+
+
+def report(title, jobs, resources, priorities, outputs):
+    results = analyse(jobs, resources, priorities)
+    print(title)
+    print("  %-8s %-8s %4s %4s %10s %10s %12s %12s %6s" % (
+        "job", "tarefa", "core", "prio", "T (ms)", "C (us)", "R", "D", "U"))
+    for core in sorted({j.core for j in jobs}):
+        for job in sorted((j for j in jobs if j.core == core), key=lambda j: -priorities[j.name]):
+            print("  %-8s %-8s %4d %4s %10.1f %9d%s %12s %9.3f ms %5.1f%%" % (
+                job.name, job.task, job.core, job.priority_text(priorities[job.name]),
+                job.period_us / 1000, job.wcet_us, "*" if job.measured else " ",
+                fmt_us(results[job.name]), job.deadline_us / 1000, 100 * job.wcet_us / job.period_us))
+        usage = sum(j.wcet_us / j.period_us for j in jobs if j.core == core)
+        print("  núcleo %d: utilização %.1f%%" % (core, usage * 100))
+    print("  latência no pior caso por saída:")
+    for output in outputs:
+        parts = [results[name] for name in output["chain"]]
+        sampling = output.get("sampling_ms", 0) * 1000
+        total = None if None in parts else sum(parts) + sampling
+        print("    %-16s %s  (%s)" % (output["name"], fmt_us(total), " -> ".join(output["chain"])))
+    missed = [name for name, r in results.items() if r is None]
+    print("  escalonável" if not missed else "  NÃO escalonável: " + ", ".join(missed))
+    return not missed
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("task_set", help="tabela de tarefas (JSON, ver tools/task_set.json)")
+    parser.add_argument("--capture", help="captura bruta da telemetria com quadros de WCET")
+    parser.add_argument("--single-core", action="store_true", help="analisa tudo no núcleo 0 (TRAFFIC_SMP=OFF)")
+    args = parser.parse_args()
+
+    with open(args.task_set) as f:
+        spec = json.load(f)
+    jobs = [Job(j, spec["timer_task"]) for j in spec["jobs"]]
+    resources = spec["resources"]
+    if args.single_core:
+        for job in jobs:
+            job.core = 0
+    if args.capture:
+        measured = load_capture(args.capture)
+        for job in jobs:
+            if job.measure in measured and measured[job.measure] > 0:
+                job.wcet_us = measured[job.measure]
+                job.measured = True
+
+    current = {job.name: job.priority for job in jobs}
+    ok = report("Prioridades atuais (* = WCET medido na placa):", jobs, resources, current, spec["outputs"])
+
+    warnings = priority_inversions(jobs, resources, current)
+    print("\nRecursos compartilhados:")
+    for line in warnings or ["  nenhuma inversão de prioridade possível"]:
+        print("  " + line)
+
+    suggested = suggest_priorities(jobs, spec["max_priorities"])
+    print()
+    if same_order(jobs, current, suggested):
+        print("As prioridades atuais já seguem a ordem deadline/rate monotonic.")
+    else:
+        print("Sugestão (deadline/rate monotonic):")
+        tasks = {}
+        for job in jobs:
+            if job.kind != "isr":
+                tasks[job.task] = (job.priority, suggested[job.name])
+        for task, (old, new) in tasks.items():
+            print("  %-8s %d -> %d" % (task, old, new))
+        report("\nCom as prioridades sugeridas:", jobs, resources, suggested, spec["outputs"])
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,219 @@
+/**
+ * @file config_store_test.c
+ * @brief Teste de queda de energia do lib/config_store com a flash NOR simulada, no Linux.
+ *
+ * A flash simulada se comporta como a NOR do RP2040: apagar põe o setor em
+ * 0xFF e gravar só leva bits de 1 para 0. Uma sequência de escritas (valores
+ * de vários tamanhos, chaves novas, uma limpeza e cópias suficientes para dar
+ * a volta no rodízio de setores) é refeita uma vez para cada operação do
+ * driver: na operação k a energia cai no meio dela (a gravação fica com só um
+ * trecho da página, e o último byte pela metade; o apagamento, com só o
+ * começo do setor em 0xFF) e nada mais chega à flash. Depois, um novo
+ * config_store_init() sobre a flash tem de ler exatamente os valores
+ * confirmados antes da queda, exceto a escrita interrompida, que pode ter o
+ * valor antigo ou o novo, nunca outro. Em seguida a escrita tem de voltar a
+ * funcionar e o valor gravado tem de sobreviver a outro boot.
+ *
+ * Compilação e uso (da raiz do repositório):
+ *
+ *     gcc -std=c11 -O2 -Ilib -o config_store_test tools/sim/config_store_test.c lib/config_store.c lib/crc.c
+ *     ./config_store_test
+ *
+ * Sai com 0 se todas as quedas conferem.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+#include "config_store.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SECTORS        3u
+#define KEYS           12u          // Chaves usadas pela sequência (cabem no cache)
+#define STEPS          1100u        // Escritas da sequência: mais de três setores cheios
+#define CLEAR_STEP     400u         // Passo em que a sequência apaga tudo
+#define TEARS_PER_OP   3u           // Quedas diferentes (ponto do corte) por operação
+
+static uint8_t flash_mem[SECTORS * FLASH_REGION_SECTOR_SIZE];
+static uint32_t ops;                // Operações do driver desde o início da sequência
+static uint32_t cut_at;             // Operação em que a energia cai (UINT32_MAX: nunca)
+static uint32_t erases;             // Apagamentos completos (voltas do rodízio)
+static bool powered;
+static uint32_t tear_seed;
+
+/// Ponto do corte: gerador congruencial, o mesmo em qualquer plataforma
+static uint32_t tear_random(void)
+{
+    tear_seed = tear_seed * 1103515245u + 12345u;
+    return tear_seed >> 8;
+}
+
+static bool sim_erase(const flash_region_t *region, uint32_t offset)
+{
+    (void) region;
+    if(!powered) return false;
+    if(ops++ == cut_at)
+    {
+        // Apagamento interrompido: só o começo do setor chegou a 0xFF
+        uint32_t done = tear_random() % FLASH_REGION_SECTOR_SIZE;
+        memset(&flash_mem[offset], 0xFF, done);
+        powered = false;
+        return false;
+    }
+    memset(&flash_mem[offset], 0xFF, FLASH_REGION_SECTOR_SIZE);
+    erases++;
+    return true;
+}
+
+static bool sim_program(const flash_region_t *region, uint32_t offset, const uint8_t *page)
+{
+    uint32_t count = FLASH_REGION_PAGE_SIZE;
+
+    (void) region;
+    if(!powered) return false;
+    if(ops++ == cut_at)
+    {
+        // Gravação interrompida: um trecho da página, e o último byte pela metade
+        count = tear_random() % FLASH_REGION_PAGE_SIZE;
+        flash_mem[offset + count] &= (uint8_t) (page[count] | (uint8_t) tear_random());
+        powered = false;
+    }
+    for(uint32_t i = 0; i < count; i++) flash_mem[offset + i] &= page[i];  // NOR: só 1 -> 0
+    return powered;
+}
+
+static const flash_region_t region = {
+    .base = flash_mem,
+    .offset = 0,
+    .sectors = SECTORS,
+    .erase = sim_erase,
+    .program = sim_program,
+};
+
+/// Valores conhecidos de cada chave (len 0: não existe)
+typedef struct {
+    uint8_t len;
+    uint8_t value[CONFIG_STORE_VALUE_MAX];
+} model_t;
+
+static config_store_t store;
+static unsigned failures;
+
+/**
+ * @brief Escrita do passo @p step da sequência.
+ */
+static void step_value(uint32_t step, uint16_t *key, uint8_t *value, uint8_t *len)
+{
+    *key = (uint16_t) (0x0100u + (step * 7u) % KEYS);
+    *len = (uint8_t) (1u + (step * 3u) % CONFIG_STORE_VALUE_MAX);
+    for(uint8_t i = 0; i < *len; i++) value[i] = (uint8_t) (step * 31u + i * 17u + 1u);
+}
+
+static bool matches(uint16_t key, const model_t *model)
+{
+    uint8_t value[CONFIG_STORE_VALUE_MAX];
+    uint8_t probe;
+
+    if(!model->len) return !config_store_get(&store, key, &probe, 1) && !config_store_get(&store, key, value, 2);
+    return config_store_get(&store, key, value, model->len) && memcmp(value, model->value, model->len) == 0;
+}
+
+/**
+ * @brief Roda a sequência até a energia cair; confere o boot seguinte.
+ * @return Operações do driver feitas (sem queda: a sequência toda).
+ */
+static uint32_t run(uint32_t cut, uint32_t seed)
+{
+    model_t model[KEYS], before[KEYS];
+    uint32_t step;
+
+    memset(flash_mem, 0xFF, sizeof(flash_mem));
+    memset(model, 0, sizeof(model));
+    ops = 0;
+    erases = 0;
+    cut_at = cut;
+    powered = true;
+    tear_seed = seed;
+    config_store_init(&store, &region);
+
+    for(step = 0; step < STEPS && powered; step++)
+    {
+        memcpy(before, model, sizeof(model));
+        bool ok;
+        if(step == CLEAR_STEP)
+        {
+            ok = config_store_clear(&store);
+            memset(model, 0, sizeof(model));
+        }
+        else
+        {
+            uint16_t key;
+            uint8_t len;
+            uint8_t value[CONFIG_STORE_VALUE_MAX];
+            step_value(step, &key, value, &len);
+            ok = config_store_set(&store, key, value, len);
+            model[key - 0x0100u].len = len;
+            memcpy(model[key - 0x0100u].value, value, len);
+        }
+        if(!ok && powered)
+        {
+            printf("  escrita %u falhou sem queda de energia\n", step);
+            failures++;
+            return ops;
+        }
+    }
+
+    // Boot depois da queda (ou do fim da sequência)
+    powered = true;
+    cut_at = UINT32_MAX;
+    config_store_init(&store, &region);
+    bool torn = (cut != UINT32_MAX && step > 0);
+    bool all_old = true, all_new = true;
+    for(uint16_t k = 0; k < KEYS; k++)
+    {
+        bool is_new = matches((uint16_t) (0x0100u + k), &model[k]);
+        bool is_old = torn && matches((uint16_t) (0x0100u + k), &before[k]);
+        if(!is_new && !is_old)
+        {
+            printf("  queda na operacao %u (passo %u): chave %u com valor desconhecido\n", cut, step - 1u, k);
+            failures++;
+        }
+        if(!is_new) all_new = false;
+        if(!is_old) all_old = false;
+    }
+    // A limpeza interrompida vale inteira ou não vale
+    if(torn && step - 1u == CLEAR_STEP && !all_old && !all_new)
+    {
+        printf("  queda na operacao %u: limpeza pela metade\n", cut);
+        failures++;
+    }
+
+    // A escrita volta a funcionar e sobrevive a outro boot
+    static const uint8_t probe[4] = { 0xDE, 0xAD, 0xBE, 0xEF };
+    uint8_t back[4];
+    if(!config_store_set(&store, 0x0200u, probe, sizeof(probe)))
+    {
+        printf("  queda na operacao %u: escrita depois do boot falhou\n", cut);
+        failures++;
+    }
+    config_store_init(&store, &region);
+    if(!config_store_get(&store, 0x0200u, back, sizeof(back)) || memcmp(back, probe, sizeof(probe)) != 0)
+    {
+        printf("  queda na operacao %u: escrita depois do boot perdida\n", cut);
+        failures++;
+    }
+    return ops;
+}
+
+int main(void)
+{
+    uint32_t total = run(UINT32_MAX, 1);
+
+    printf("sequencia sem queda: %u operacoes do driver, %u apagamentos em %u setores\n", total, erases, SECTORS);
+    for(uint32_t cut = 0; cut < total; cut++)
+        for(unsigned tear = 0; tear < TEARS_PER_OP; tear++)
+            run(cut, cut * TEARS_PER_OP + tear + 1u);
+    printf("%u quedas simuladas, %u falhas\n", total * TEARS_PER_OP, failures);
+    return failures ? 1 : 0;
+}
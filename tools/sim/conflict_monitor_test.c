@@ -0,0 +1,605 @@
+/**
+ * @file conflict_monitor_test.c
+ * @brief Testes do monitor de conflitos (lib/conflict_monitor) no Linux.
+ *
+ * O mapa das saídas é montado como em setup_conflict_monitor() do firmware,
+ * para o cruzamento (um LED da matriz por foco, pedestre no LED central) e
+ * para o semáforo simples (LED RGB, contagem regressiva na matriz).
+ *
+ * Primeiro, falhas injetadas em quadros válidos: focos conflitantes liberados
+ * juntos, LED RGB ou repetidor com outra cor, foco apagado ou com cor
+ * inválida, verde no modo piscante, LED fora dos focos aceso e pedestre com
+ * foco conflitante liberado; cada uma tem de dar a falha e o detalhe certos,
+ * e só travar depois de CONFLICT_MONITOR_DEBOUNCE amostras seguidas. Na
+ * intensidade mínima (1) as cores misturadas não podem zerar nenhum canal:
+ * o LED da travessia continua branco e o conflito com ele continua visto.
+ *
+ * Depois, 10 minutos simulados de cada plano, com detectores e botão de
+ * pedestre aleatórios, preempção e um trecho de modo noturno: as saídas são
+ * desenhadas como o firmware as desenha (mesmas palavras GRB, em várias
+ * intensidades) e amostradas a cada 1 ms, como o alarme do monitor. Nenhuma
+ * amostra pode dar violação.
+ *
+ * Compilação e uso (da raiz do repositório):
+ *
+ *     gcc -std=c11 -O2 -Ilib -o conflict_monitor_test tools/sim/conflict_monitor_test.c lib/conflict_monitor.c \
+ *         lib/ring_barrier.c lib/phase_engine.c lib/phase_plans.c lib/coordination.c
+ *     ./conflict_monitor_test
+ *
+ * Sai com 0 se todos os casos passam.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+#include "conflict_monitor.h"
+#include "phase_engine.h"
+#include "phase_plans.h"
+#include "ring_barrier.h"
+#include "ws2812b_definitions.h"
+#include <stdio.h>
+#include <string.h>
+
+// Cores do WS2812B (lib/ws2812b.h) e do LED RGB (lib/rgb.h), sem o Pico SDK
+enum { LED_RED = 0, LED_GREEN = 1, LED_YELLOW = 3, LED_WHITE = 5, LED_OFF = 0xFF };
+
+#define PED_PIXEL        12          // LED da travessia no cruzamento (PicoFreeRTOS.c)
+#define SIM_MS           600000u     // 10 minutos simulados
+#define NIGHT_FROM_MS    420000u     // Trecho em modo noturno (piscante)
+#define NIGHT_TO_MS      480000u
+#define FLASH_PERIOD_MS  1100u       // Grade do pisca (FLASH_PERIOD_US, FLASH_ON_US)
+#define FLASH_ON_MS      550u
+#define PED_BLINK_MS     250u        // Pisca da limpeza de pedestre (timer do buzzer)
+
+static const uint8_t SIGNAL_LED_COLOR[] = { LED_YELLOW, LED_GREEN, LED_RED };  // Por phase_signal_t
+static const uint8_t INTENSITIES[] = { 1, 50, 100 };
+
+static unsigned checks, failures;
+static uint32_t sim_seed = 1;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+
+static void check(bool ok, const char *what, int line)
+{
+    checks++;
+    if(ok) return;
+    failures++;
+    printf("  falhou (linha %d): %s\n", line, what);
+}
+
+/// Gerador congruencial, o mesmo em qualquer plataforma
+static uint32_t sim_random(void)
+{
+    sim_seed = sim_seed * 1103515245u + 12345u;
+    return sim_seed >> 8;
+}
+
+/**
+ * @brief Palavra GRB de uma cor, como ws2812b_compose_led_value()
+ */
+static uint32_t compose(uint8_t color, uint8_t intensity)
+{
+    uint32_t value = (uint32_t) (uint8_t) ((intensity * 255) / 100);
+    uint32_t half = (value && value < 2u) ? 1u : value / 2u;    // ws2812b_mix_channel()
+    uint32_t third = (value && value < 3u) ? 1u : value / 3u;
+
+    switch(color)
+    {
+    case LED_RED:    return value << 16;
+    case LED_GREEN:  return value << 24;
+    case LED_YELLOW: return (half << 16) | (half << 24);
+    case LED_WHITE:  return (third << 24) | (third << 16) | (third << 8);
+    default:         return 0;
+    }
+}
+
+/**
+ * @brief Níveis de PWM do LED RGB para uma cor, como rgb_turn_on_by_color() (LED_OFF: apagado)
+ */
+static void draw_rgb(conflict_monitor_sample_t *sample, uint8_t color)
+{
+    sample->rgb[0] = (color == LED_RED || color == LED_YELLOW) ? 5u : 0u;
+    sample->rgb[1] = (color == LED_GREEN) ? 170u : (color == LED_YELLOW) ? 255u : 0u;
+    sample->rgb[2] = 0;
+}
+
+/**
+ * @brief Quadro com uma cor por LED, como ws2812b_draw_colors()
+ */
+static void draw_colors(conflict_monitor_sample_t *sample, const uint8_t *colors, uint8_t intensity)
+{
+    for(uint8_t i = 0; i < CONFLICT_MONITOR_PIXELS; i++)
+        sample->frame[i] = (colors[i] == LED_OFF) ? 0 : compose(colors[i], intensity);
+}
+
+/**
+ * @brief Quadro com um glyph numa cor, como ws2812b_draw()
+ */
+static void draw_glyph(conflict_monitor_sample_t *sample, const uint8_t *glyph, uint8_t color, uint8_t intensity)
+{
+    for(uint8_t i = 0; i < CONFLICT_MONITOR_PIXELS; i++)
+        sample->frame[i] = glyph[i] ? compose(color, intensity) : 0;
+}
+
+/**
+ * @brief Mapa do cruzamento, como setup_conflict_monitor()
+ */
+static void setup_intersection(conflict_monitor_config_t *config, const rb_plan_t *plan)
+{
+    memset(config, 0, sizeof(*config));
+    config->head_count = plan->head_count;
+    config->rgb_head = 0;
+    config->repeat_head = CONFLICT_MONITOR_NO_HEAD;
+    config->ped_pixel = PED_PIXEL;
+    for(uint8_t i = 0; i < plan->head_count; i++)
+    {
+        config->pixel[i] = plan->heads[i].pixel;
+        for(uint8_t j = 0; j < plan->head_count; j++)
+            if(rb_plan_phases_compatible(plan, plan->heads[i].phase, plan->heads[j].phase))
+                config->compatible[i] |= (uint8_t) (1u << j);
+        if(plan->ped_phase != RB_NO_PHASE && !rb_plan_phases_compatible(plan, plan->ped_phase, plan->heads[i].phase))
+            config->ped_conflicts |= (uint8_t) (1u << i);
+    }
+}
+
+/**
+ * @brief Mapa do semáforo simples, como setup_conflict_monitor()
+ */
+static void setup_single(conflict_monitor_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+    config->head_count = 1;
+    config->pixel[0] = CONFLICT_MONITOR_NO_PIXEL;
+    config->compatible[0] = 1u;
+    config->rgb_head = 0;
+    config->repeat_head = 0;
+    config->ped_pixel = CONFLICT_MONITOR_NO_PIXEL;
+    config->ped_conflicts = 1u;
+}
+
+/**
+ * @brief Quadro do cruzamento com uma cor por foco (o foco 0 também no LED RGB)
+ */
+static void draw_heads(conflict_monitor_sample_t *sample, const rb_plan_t *plan, const uint8_t *head_colors,
+    bool ped_lit, bool flash)
+{
+    uint8_t colors[CONFLICT_MONITOR_PIXELS];
+
+    memset(colors, LED_OFF, sizeof(colors));
+    for(uint8_t i = 0; i < plan->head_count; i++) colors[plan->heads[i].pixel] = head_colors[i];
+    if(ped_lit) colors[PED_PIXEL] = LED_WHITE;
+    draw_colors(sample, colors, 100);
+    draw_rgb(sample, head_colors[0]);
+    sample->flash = flash;
+}
+
+/**
+ * @brief Avalia uma amostra e confere a falha e o detalhe esperados
+ */
+static void expect(const conflict_monitor_config_t *config, const conflict_monitor_sample_t *sample,
+    uint8_t fault, uint16_t detail, int line)
+{
+    uint16_t got_detail = 0;
+    uint8_t got = conflict_monitor_evaluate(config, sample, &got_detail);
+
+    check(got == fault, "falha esperada", line);
+    if(fault != CONFLICT_FAULT_NONE) check(got_detail == detail, "detalhe esperado", line);
+    if(got != fault || (fault != CONFLICT_FAULT_NONE && got_detail != detail))
+        printf("    esperado %u/%u, obtido %u/%u\n", fault, detail, got, got_detail);
+}
+
+#define EXPECT(config, sample, fault, detail) expect((config), (sample), (fault), (detail), __LINE__)
+
+static void test_intersection_faults(void)
+{
+    const rb_plan_t *plan = &RB_PLAN_DEFAULT;
+    conflict_monitor_config_t config;
+    conflict_monitor_sample_t sample;
+    uint8_t heads[CONFLICT_MONITOR_MAX_HEADS];
+    uint8_t a = 0, b = 0, ped = 0xFF, ok_ped = 0xFF;
+    bool found_conflict = false, found_pair = false;
+    uint8_t pa = 0, pb = 0;
+
+    printf("falhas injetadas (cruzamento)\n");
+    setup_intersection(&config, plan);
+    CHECK(plan->head_count >= 2);
+    for(uint8_t i = 0; i < plan->head_count; i++)
+    {
+        for(uint8_t j = (uint8_t) (i + 1u); j < plan->head_count; j++)
+        {
+            bool compatible = config.compatible[i] & (1u << j);
+            CHECK(compatible == ((config.compatible[j] >> i) & 1u));  // Matriz simétrica
+            if(!compatible && !found_conflict) { a = i; b = j; found_conflict = true; }
+            if(compatible && !found_pair) { pa = i; pb = j; found_pair = true; }
+        }
+        if((config.ped_conflicts & (1u << i)) && ped == 0xFF) ped = i;
+        if(!(config.ped_conflicts & (1u << i)) && ok_ped == 0xFF) ok_ped = i;
+    }
+    CHECK(found_conflict && ped != 0xFF);
+
+    // Todos em vermelho, com e sem pedestre: seguro
+    memset(heads, LED_RED, sizeof(heads));
+    draw_heads(&sample, plan, heads, false, false);
+    EXPECT(&config, &sample, CONFLICT_FAULT_NONE, 0);
+    draw_heads(&sample, plan, heads, true, false);
+    EXPECT(&config, &sample, CONFLICT_FAULT_NONE, 0);
+
+    // Focos conflitantes liberados juntos, em verde ou amarelo
+    heads[a] = LED_GREEN;
+    heads[b] = LED_GREEN;
+    draw_heads(&sample, plan, heads, false, false);
+    EXPECT(&config, &sample, CONFLICT_FAULT_CONFLICT, (uint16_t) (a | (b << 8)));
+    heads[a] = LED_YELLOW;
+    draw_heads(&sample, plan, heads, false, false);
+    EXPECT(&config, &sample, CONFLICT_FAULT_CONFLICT, (uint16_t) (a | (b << 8)));
+    heads[b] = LED_RED;
+    draw_heads(&sample, plan, heads, false, false);
+    EXPECT(&config, &sample, CONFLICT_FAULT_NONE, 0);
+
+    // Focos compatíveis liberados juntos: seguro
+    if(found_pair)
+    {
+        memset(heads, LED_RED, sizeof(heads));
+        heads[pa] = LED_GREEN;
+        heads[pb] = LED_GREEN;
+        draw_heads(&sample, plan, heads, false, false);
+        EXPECT(&config, &sample, CONFLICT_FAULT_NONE, 0);
+    }
+
+    // LED RGB com outra cor que a do foco 0
+    memset(heads, LED_RED, sizeof(heads));
+    draw_heads(&sample, plan, heads, false, false);
+    draw_rgb(&sample, LED_GREEN);
+    EXPECT(&config, &sample, CONFLICT_FAULT_MISMATCH, 0);
+
+    // Foco apagado fora do modo piscante, ou com cor inválida
+    draw_heads(&sample, plan, heads, false, false);
+    sample.frame[plan->heads[1].pixel] = 0;
+    EXPECT(&config, &sample, CONFLICT_FAULT_INDICATION, 1);
+    sample.frame[plan->heads[1].pixel] = compose(LED_RED, 100) | 0x4000u;  // Com azul
+    EXPECT(&config, &sample, CONFLICT_FAULT_INDICATION, 1);
+    draw_heads(&sample, plan, heads, false, false);
+    draw_rgb(&sample, LED_OFF);
+    sample.frame[plan->heads[0].pixel] = 0;
+    EXPECT(&config, &sample, CONFLICT_FAULT_INDICATION, 0);
+
+    // Modo piscante: todos em amarelo ou todos apagados é seguro; verde e pedestre não
+    memset(heads, LED_YELLOW, sizeof(heads));
+    draw_heads(&sample, plan, heads, false, true);
+    EXPECT(&config, &sample, CONFLICT_FAULT_NONE, 0);
+    memset(heads, LED_OFF, sizeof(heads));
+    draw_heads(&sample, plan, heads, false, true);
+    EXPECT(&config, &sample, CONFLICT_FAULT_NONE, 0);
+    memset(heads, LED_YELLOW, sizeof(heads));
+    heads[1] = LED_GREEN;
+    draw_heads(&sample, plan, heads, false, true);
+    EXPECT(&config, &sample, CONFLICT_FAULT_INDICATION, 1);
+    memset(heads, LED_RED, sizeof(heads));
+    draw_heads(&sample, plan, heads, true, true);
+    EXPECT(&config, &sample, CONFLICT_FAULT_PEDESTRIAN, CONFLICT_MONITOR_NO_HEAD);
+
+    // LED fora dos focos aceso; LED do pedestre em outra cor que o branco
+    memset(heads, LED_RED, sizeof(heads));
+    draw_heads(&sample, plan, heads, false, false);
+    for(uint8_t pixel = 0; pixel < CONFLICT_MONITOR_PIXELS; pixel++)
+    {
+        bool used = (pixel == PED_PIXEL);
+        for(uint8_t i = 0; i < plan->head_count; i++) used |= (plan->heads[i].pixel == pixel);
+        if(used) continue;
+        sample.frame[pixel] = compose(LED_RED, 100);
+        EXPECT(&config, &sample, CONFLICT_FAULT_STRAY, pixel);
+        sample.frame[pixel] = compose(LED_WHITE, 100);
+        EXPECT(&config, &sample, CONFLICT_FAULT_STRAY, pixel);
+        sample.frame[pixel] = 0;
+    }
+    sample.frame[PED_PIXEL] = compose(LED_GREEN, 100);
+    EXPECT(&config, &sample, CONFLICT_FAULT_STRAY, PED_PIXEL);
+
+    // Pedestre com foco conflitante liberado; com foco compatível, seguro
+    heads[ped] = LED_GREEN;
+    draw_heads(&sample, plan, heads, true, false);
+    EXPECT(&config, &sample, CONFLICT_FAULT_PEDESTRIAN, ped);
+    heads[ped] = LED_YELLOW;
+    draw_heads(&sample, plan, heads, true, false);
+    EXPECT(&config, &sample, CONFLICT_FAULT_PEDESTRIAN, ped);
+    if(ok_ped != 0xFF)
+    {
+        memset(heads, LED_RED, sizeof(heads));
+        heads[ok_ped] = LED_GREEN;
+        draw_heads(&sample, plan, heads, true, false);
+        EXPECT(&config, &sample, CONFLICT_FAULT_NONE, 0);
+    }
+}
+
+static void test_single_faults(void)
+{
+    conflict_monitor_config_t config;
+    conflict_monitor_sample_t sample;
+
+    printf("falhas injetadas (semaforo simples)\n");
+    setup_single(&config);
+
+    // Contagem na cor do foco, ou em branco com o foco em vermelho: seguro
+    draw_glyph(&sample, NUMERIC_GLYPHS[5], LED_GREEN, 100);
+    draw_rgb(&sample, LED_GREEN);
+    sample.flash = false;
+    EXPECT(&config, &sample, CONFLICT_FAULT_NONE, 0);
+    draw_glyph(&sample, NUMERIC_GLYPHS[5], LED_WHITE, 100);
+    draw_rgb(&sample, LED_RED);
+    EXPECT(&config, &sample, CONFLICT_FAULT_NONE, 0);
+
+    // Contagem em outra cor que a do LED RGB
+    draw_glyph(&sample, NUMERIC_GLYPHS[3], LED_RED, 100);
+    draw_rgb(&sample, LED_GREEN);
+    EXPECT(&config, &sample, CONFLICT_FAULT_MISMATCH, 0);
+    draw_glyph(&sample, NUMERIC_GLYPHS[3], LED_RED, 100);
+    draw_rgb(&sample, LED_RED);
+    sample.frame[0] = compose(LED_YELLOW, 100);  // Um LED só
+    EXPECT(&config, &sample, CONFLICT_FAULT_MISMATCH, 0);
+
+    // LED RGB apagado ou com cor inválida fora do modo piscante
+    draw_glyph(&sample, NUMERIC_GLYPHS[3], LED_RED, 100);
+    draw_rgb(&sample, LED_OFF);
+    EXPECT(&config, &sample, CONFLICT_FAULT_INDICATION, 0);
+    draw_rgb(&sample, LED_RED);
+    sample.rgb[2] = 40;
+    EXPECT(&config, &sample, CONFLICT_FAULT_INDICATION, 0);
+
+    // Pedestre com o foco liberado, ou no modo piscante
+    draw_glyph(&sample, NUMERIC_GLYPHS[7], LED_WHITE, 100);
+    draw_rgb(&sample, LED_GREEN);
+    EXPECT(&config, &sample, CONFLICT_FAULT_PEDESTRIAN, 0);
+    draw_rgb(&sample, LED_YELLOW);
+    EXPECT(&config, &sample, CONFLICT_FAULT_PEDESTRIAN, 0);
+    draw_rgb(&sample, LED_RED);
+    sample.flash = true;
+    EXPECT(&config, &sample, CONFLICT_FAULT_PEDESTRIAN, CONFLICT_MONITOR_NO_HEAD);
+
+    // Modo piscante: amarelo aceso ou tudo apagado é seguro; verde não
+    draw_glyph(&sample, NUMERIC_GLYPHS[0], LED_YELLOW, 100);
+    draw_rgb(&sample, LED_YELLOW);
+    EXPECT(&config, &sample, CONFLICT_FAULT_NONE, 0);
+    memset(sample.frame, 0, sizeof(sample.frame));
+    draw_rgb(&sample, LED_OFF);
+    EXPECT(&config, &sample, CONFLICT_FAULT_NONE, 0);
+    draw_glyph(&sample, NUMERIC_GLYPHS[0], LED_GREEN, 100);
+    draw_rgb(&sample, LED_GREEN);
+    EXPECT(&config, &sample, CONFLICT_FAULT_INDICATION, 0);
+}
+
+static void test_low_intensity(void)
+{
+    const rb_plan_t *plan = &RB_PLAN_DEFAULT;
+    conflict_monitor_config_t config;
+    conflict_monitor_sample_t sample;
+    uint8_t colors[CONFLICT_MONITOR_PIXELS];
+    uint8_t ped = CONFLICT_MONITOR_NO_HEAD;
+
+    printf("intensidade minima\n");
+    // Nenhum canal de uma cor misturada pode zerar, senão o LED apaga
+    for(uint8_t intensity = 1; intensity <= 100; intensity++)
+    {
+        uint32_t white = compose(LED_WHITE, intensity), yellow = compose(LED_YELLOW, intensity);
+        CHECK((white >> 24) & 0xFFu);
+        CHECK((white >> 16) & 0xFFu);
+        CHECK((white >> 8) & 0xFFu);
+        CHECK(((yellow >> 24) & 0xFFu) && ((yellow >> 16) & 0xFFu));
+    }
+
+    // Na intensidade 1 a travessia ainda é vista, e o conflito com ela também
+    setup_intersection(&config, plan);
+    for(uint8_t i = 0; i < plan->head_count && ped == CONFLICT_MONITOR_NO_HEAD; i++)
+        if(config.ped_conflicts & (1u << i)) ped = i;
+    CHECK(ped != CONFLICT_MONITOR_NO_HEAD);
+    memset(colors, LED_OFF, sizeof(colors));
+    for(uint8_t i = 0; i < plan->head_count; i++) colors[plan->heads[i].pixel] = LED_RED;
+    colors[PED_PIXEL] = LED_WHITE;
+    draw_colors(&sample, colors, 1);
+    draw_rgb(&sample, LED_RED);
+    sample.flash = false;
+    CHECK(sample.frame[PED_PIXEL] != 0);
+    EXPECT(&config, &sample, CONFLICT_FAULT_NONE, 0);
+    colors[plan->heads[ped].pixel] = LED_GREEN;
+    if(ped == 0) draw_rgb(&sample, LED_GREEN);
+    draw_colors(&sample, colors, 1);
+    EXPECT(&config, &sample, CONFLICT_FAULT_PEDESTRIAN, ped);
+}
+
+static void test_debounce(void)
+{
+    const rb_plan_t *plan = &RB_PLAN_DEFAULT;
+    conflict_monitor_config_t config;
+    conflict_monitor_sample_t good, bad;
+    conflict_monitor_t mon;
+    uint8_t heads[CONFLICT_MONITOR_MAX_HEADS];
+
+    printf("filtro e trava\n");
+    setup_intersection(&config, plan);
+    memset(heads, LED_RED, sizeof(heads));
+    draw_heads(&good, plan, heads, false, false);
+    bad = good;
+    bad.frame[plan->heads[1].pixel] = 0;  // Foco 1 apagado
+
+    // Violações isoladas, abaixo do filtro, não travam
+    conflict_monitor_init(&mon, &config);
+    for(unsigned round = 0; round < 100; round++)
+    {
+        for(unsigned i = 0; i + 1u < CONFLICT_MONITOR_DEBOUNCE; i++) CHECK(!conflict_monitor_check(&mon, &bad));
+        CHECK(!conflict_monitor_check(&mon, &good));
+    }
+    CHECK(mon.fault == CONFLICT_FAULT_NONE);
+    CHECK(mon.violations == 100u * (CONFLICT_MONITOR_DEBOUNCE - 1u));
+
+    // CONFLICT_MONITOR_DEBOUNCE seguidas travam, uma vez só, com a primeira falha encontrada
+    for(unsigned i = 0; i + 1u < CONFLICT_MONITOR_DEBOUNCE; i++) CHECK(!conflict_monitor_check(&mon, &bad));
+    CHECK(conflict_monitor_check(&mon, &bad));
+    CHECK(mon.fault == CONFLICT_FAULT_INDICATION && mon.detail == 1);
+    uint32_t samples = mon.samples;
+    CHECK(!conflict_monitor_check(&mon, &bad));
+    CHECK(!conflict_monitor_check(&mon, &good));
+    CHECK(mon.fault == CONFLICT_FAULT_INDICATION);  // Travada até o reinício
+    CHECK(mon.samples == samples);
+}
+
+/**
+ * @brief Quadro do modo noturno, como draw_flash_outputs(false, lit)
+ */
+static void draw_night(conflict_monitor_sample_t *sample, const conflict_monitor_config_t *config,
+    const rb_plan_t *plan, uint32_t now_ms, uint8_t intensity)
+{
+    bool lit = now_ms % FLASH_PERIOD_MS < FLASH_ON_MS;
+    uint8_t color = lit ? LED_YELLOW : LED_OFF;
+
+    if(plan)
+    {
+        uint8_t colors[CONFLICT_MONITOR_PIXELS];
+        memset(colors, LED_OFF, sizeof(colors));
+        for(uint8_t i = 0; i < config->head_count; i++) colors[plan->heads[i].pixel] = color;
+        draw_colors(sample, colors, intensity);
+    }
+    else if(lit)
+        draw_glyph(sample, NUMERIC_GLYPHS[0], color, intensity);
+    else
+        memset(sample->frame, 0, sizeof(sample->frame));
+    draw_rgb(sample, color);
+    sample->flash = true;
+}
+
+/**
+ * @brief Amostra a cada 1 ms; o monitor não pode ver violação nenhuma
+ */
+static void sample_period(conflict_monitor_t *mon, const conflict_monitor_sample_t *sample, unsigned ms)
+{
+    for(unsigned i = 0; i < ms; i++) conflict_monitor_check(mon, sample);
+}
+
+static void run_intersection(const rb_plan_t *plan, uint8_t intensity)
+{
+    conflict_monitor_config_t config;
+    conflict_monitor_sample_t sample;
+    conflict_monitor_t mon;
+    rb_controller_t ctrl;
+    uint32_t preempt_until = 0;
+    bool preempting = false;
+
+    setup_intersection(&config, plan);
+    conflict_monitor_init(&mon, &config);
+    rb_controller_start(&ctrl, plan, 0);
+    for(uint32_t now = 0; now < SIM_MS && mon.fault == CONFLICT_FAULT_NONE; now += 100u)  // Tick do cruzamento
+    {
+        uint32_t r = sim_random();
+        rb_controller_presence(&ctrl, r & 0xFu, now);
+        if(r % 97u == 0 && plan->ped_phase != RB_NO_PHASE) rb_controller_call(&ctrl, plan->ped_phase);
+        if(!preempting && r % 1499u == 0 && rb_controller_preempt(&ctrl, plan->preempt_phase, now))
+        {
+            preempting = true;
+            preempt_until = now + 20000u + sim_random() % 20000u;
+        }
+        else if(preempting && now >= preempt_until)
+        {
+            rb_controller_preempt_release(&ctrl, now);
+            preempting = false;
+        }
+        rb_controller_update(&ctrl, now);
+
+        if(now >= NIGHT_FROM_MS && now < NIGHT_TO_MS)
+        {
+            for(uint32_t t = now; t < now + 100u; t++)
+            {
+                draw_night(&sample, &config, plan, t, intensity);
+                sample_period(&mon, &sample, 1);
+            }
+            continue;
+        }
+
+        uint8_t signals[RB_MAX_HEADS], heads[CONFLICT_MONITOR_MAX_HEADS];
+        uint8_t ped = rb_controller_ped(&ctrl);
+        rb_controller_heads(&ctrl, signals);
+        for(uint8_t i = 0; i < plan->head_count; i++) heads[i] = SIGNAL_LED_COLOR[signals[i]];
+        for(uint32_t t = now; t < now + 100u; t += PED_BLINK_MS / 5u)
+        {
+            bool blink_on = (t / PED_BLINK_MS) % 2u == 0;
+            uint8_t colors[CONFLICT_MONITOR_PIXELS];
+            memset(colors, LED_OFF, sizeof(colors));
+            for(uint8_t i = 0; i < plan->head_count; i++) colors[plan->heads[i].pixel] = heads[i];
+            if(ped == PHASE_PED_WALK || (ped == PHASE_PED_CLEARANCE && blink_on)) colors[PED_PIXEL] = LED_WHITE;
+            draw_colors(&sample, colors, intensity);
+            draw_rgb(&sample, heads[0]);
+            sample.flash = false;
+            sample_period(&mon, &sample, PED_BLINK_MS / 5u);
+        }
+    }
+    printf("  %-12s intensidade %3u: %u amostras, %u violacoes, falha %u\n",
+        plan == &RB_PLAN_DEFAULT ? "cruzamento" : "cruz. pico", intensity, mon.samples, mon.violations, mon.fault);
+    CHECK(mon.samples == SIM_MS);
+    CHECK(mon.violations == 0);
+    CHECK(mon.fault == CONFLICT_FAULT_NONE);
+}
+
+static void run_single(const phase_plan_t *plan, uint8_t intensity)
+{
+    conflict_monitor_config_t config;
+    conflict_monitor_sample_t sample;
+    conflict_monitor_t mon;
+    phase_engine_t engine;
+
+    setup_single(&config);
+    conflict_monitor_init(&mon, &config);
+    phase_engine_start(&engine, plan, 0);
+    for(uint32_t now = 0; now < SIM_MS && mon.fault == CONFLICT_FAULT_NONE; now += 50u)
+    {
+        uint32_t r = sim_random();
+        if(now % 1000u == 0)  // Tick do semáforo simples
+        {
+            phase_engine_presence(&engine, r & 0x3u, now);
+            if(r % 23u == 0) phase_engine_call(&engine, plan->pedestrian_call);
+            phase_engine_update(&engine, now);
+        }
+
+        if(now >= NIGHT_FROM_MS && now < NIGHT_TO_MS)
+        {
+            for(uint32_t t = now; t < now + 50u; t++)
+            {
+                draw_night(&sample, &config, NULL, t, intensity);
+                sample_period(&mon, &sample, 1);
+            }
+            continue;
+        }
+
+        const phase_def_t *phase = phase_engine_current(&engine);
+        uint32_t counter = phase_engine_remaining_s(&engine, now);
+        bool blink_on = (now / PED_BLINK_MS) % 2u == 0;
+        if(counter > 9u) counter = 9u;
+        if(phase->ped == PHASE_PED_DONT_WALK)
+            draw_glyph(&sample, NUMERIC_GLYPHS[counter], SIGNAL_LED_COLOR[phase->signal], intensity);
+        else if(phase->ped == PHASE_PED_WALK || blink_on)
+            draw_glyph(&sample, NUMERIC_GLYPHS[counter], LED_WHITE, intensity);
+        else
+            memset(sample.frame, 0, sizeof(sample.frame));
+        draw_rgb(&sample, SIGNAL_LED_COLOR[phase->signal]);
+        sample.flash = false;
+        sample_period(&mon, &sample, 50u);
+    }
+    printf("  %-12s intensidade %3u: %u amostras, %u violacoes, falha %u\n",
+        plan == &PHASE_PLAN_DEFAULT ? "simples" : "simples pico", intensity, mon.samples, mon.violations, mon.fault);
+    CHECK(mon.samples == SIM_MS);
+    CHECK(mon.violations == 0);
+    CHECK(mon.fault == CONFLICT_FAULT_NONE);
+}
+
+int main(void)
+{
+    test_intersection_faults();
+    test_single_faults();
+    test_low_intensity();
+    test_debounce();
+    printf("10 minutos simulados por plano\n");
+    for(unsigned i = 0; i < sizeof(INTENSITIES); i++)
+    {
+        run_intersection(&RB_PLAN_DEFAULT, INTENSITIES[i]);
+        run_intersection(&RB_PLAN_PEAK, INTENSITIES[i]);
+        run_single(&PHASE_PLAN_DEFAULT, INTENSITIES[i]);
+        run_single(&PHASE_PLAN_PEAK, INTENSITIES[i]);
+    }
+    printf("%u verificacoes, %u falhas\n", checks, failures);
+    return failures ? 1 : 0;
+}
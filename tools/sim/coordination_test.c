@@ -0,0 +1,288 @@
+/**
+ * @file coordination_test.c
+ * @brief Testes da coordenação (lib/coordination) no motor de fases e no controlador de cruzamento, no Linux.
+ *
+ * Para cada plano coordenado (PHASE_PLAN_DEFAULT e RB_PLAN_DEFAULT), a hora
+ * chega com erros de defasagem espalhados por um ciclo inteiro. Em cada caso
+ * conferem-se a duração de toda fase encerrada (entre o mínimo e o máximo do
+ * plano: a correção é espalhada pelas fases, sem saltos) e o ponto de
+ * sincronismo, que tem de chegar à grade do ciclo absoluto em poucos ciclos e
+ * não sair mais dela. Depois uma preempção tira o plano da grade, e ao fim
+ * dela o plano tem de voltar à grade do mesmo jeito. Sem tráfego: só as
+ * durações padrão e a correção decidem as fases.
+ *
+ * Compilação e uso (da raiz do repositório):
+ *
+ *     gcc -std=c11 -O2 -Ilib -o coordination_test tools/sim/coordination_test.c lib/coordination.c \
+ *         lib/phase_engine.c lib/ring_barrier.c lib/phase_plans.c
+ *     ./coordination_test
+ *
+ * Sai com 0 se todos os casos passam.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+#include "coordination.h"
+#include "phase_engine.h"
+#include "phase_plans.h"
+#include "ring_barrier.h"
+#include <stdio.h>
+
+#define PE_TICK_MS      50u                 // Passo do relógio virtual do motor de fases
+#define RB_TICK_MS      100u                // Período do timer de fase no cruzamento
+#define EPOCH_MS        1760000000000ull    // Hora absoluta de base (ms desde 1970)
+#define ERROR_STEPS     24u                 // Erros de defasagem testados por plano, espalhados no ciclo
+#define RUN_CYCLES      12u                 // Ciclos rodados depois da hora e depois da preempção
+#define PREEMPT_HOLD_MS 15000u              // Duração da preempção
+
+// Pontos de sincronismo até a grade, no máximo: o primeiro, mais um por
+// ciclo de correção, mais o primeiro na grade. O plano de foco único alonga
+// até 3 s por ciclo (o vermelho; o verde padrão já é o máximo) contra um erro
+// de até meio ciclo (9 s). O cruzamento tem verdes que crescem 12 s por ciclo,
+// 6 s dos quais cobrem o ciclo natural de 44 s, contra um erro de até 25 s.
+#define PE_SETTLE_POINTS 5u
+#define RB_SETTLE_POINTS 7u
+
+static unsigned checks, failures;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+
+static void check(bool ok, const char *what, int line)
+{
+    checks++;
+    if(ok) return;
+    failures++;
+    printf("  falhou (linha %d): %s\n", line, what);
+}
+
+/**
+ * @brief Pontos de sincronismo vistos desde a hora (ou o fim da preempção).
+ */
+typedef struct {
+    uint64_t time_ms;       // Hora absoluta no tempo local 0
+    uint32_t cycle_ms;      // Ciclo do plano
+    uint32_t offset_ms;     // Defasagem do plano
+    unsigned points;        // Pontos vistos
+    unsigned settled;       // Primeiro ponto na grade (a partir de 1), ou 0
+    unsigned lost;          // Pontos fora da grade depois do primeiro na grade
+    int32_t first_error_ms;         // Erro medido no primeiro ponto
+    int32_t first_correction_ms;    // Correção emitida no primeiro ponto
+} sync_track_t;
+
+static void sync_track_init(sync_track_t *track, uint64_t time_ms, uint32_t cycle_ms, uint32_t offset_ms)
+{
+    track->time_ms = time_ms;
+    track->cycle_ms = cycle_ms;
+    track->offset_ms = offset_ms;
+    track->points = 0;
+    track->settled = 0;
+    track->lost = 0;
+    track->first_error_ms = 0;
+    track->first_correction_ms = 0;
+}
+
+/**
+ * @brief Registra um ponto de sincronismo no tempo local @p local_ms, já medido em @p coord.
+ */
+static void sync_track_point(sync_track_t *track, uint32_t local_ms, const coord_t *coord)
+{
+    uint64_t position = (track->time_ms + local_ms + track->cycle_ms - track->offset_ms) % track->cycle_ms;
+
+    if(track->points == 0)
+    {
+        track->first_error_ms = coord->last_error_ms;
+        track->first_correction_ms = coord->correction_ms;
+    }
+    track->points++;
+    if(position != 0)
+    {
+        if(track->settled) track->lost++;
+    }
+    else if(!track->settled) track->settled = track->points;
+}
+
+/**
+ * @brief Confere a volta à grade: no máximo em @p settle_points pontos, e sem sair depois.
+ *
+ * O primeiro ponto (depois da hora ou da preempção) não tem ciclo anterior
+ * para comparar: corrige só o erro, pelo menor caminho.
+ */
+static void sync_track_check(const sync_track_t *track, unsigned settle_points, unsigned *worst)
+{
+    int32_t half = (int32_t) (track->cycle_ms / 2u);
+
+    CHECK(track->first_error_ms >= -half && track->first_error_ms <= half);
+    CHECK(track->first_correction_ms == -track->first_error_ms);
+    CHECK(track->settled != 0 && track->settled <= settle_points);
+    CHECK(track->lost == 0);
+    CHECK(track->points >= RUN_CYCLES - 1u);
+    if(track->settled > *worst) *worst = track->settled;
+}
+
+/**
+ * @brief Roda o motor de fases de @p from_ms até @p to_ms.
+ *
+ * Cada fase encerrada tem de durar entre min_s e max_s, salvo as tocadas pela
+ * preempção; cada início da fase de sincronismo fora da preempção vai para
+ * @p track.
+ *
+ * @param disturbed A fase em curso foi tocada pela preempção.
+ * @return Tempo local em que parou.
+ */
+static uint32_t pe_run(phase_engine_t *engine, uint32_t from_ms, uint32_t to_ms, bool *disturbed,
+    sync_track_t *track)
+{
+    const phase_plan_t *plan = engine->plan;
+    uint32_t now;
+
+    for(now = from_ms; now < to_ms; now += PE_TICK_MS)
+    {
+        uint8_t phase = engine->phase;
+        uint32_t start_ms = engine->start_ms;
+
+        if(engine->preempt != PHASE_NO_PHASE) *disturbed = true;
+        uint32_t n = phase_engine_update(engine, now);
+        if(!n) continue;
+        CHECK(n == 1);
+
+        const phase_def_t *def = &plan->phases[phase];
+        uint32_t length = engine->start_ms - start_ms;
+        if(!*disturbed) CHECK(length >= def->min_s * 1000u && length <= def->max_s * 1000u);
+        *disturbed = (engine->preempt != PHASE_NO_PHASE);
+        if(engine->phase == plan->sync_phase && engine->preempt == PHASE_NO_PHASE)
+            sync_track_point(track, engine->start_ms, &engine->coord);
+    }
+    return now;
+}
+
+static void test_phase_engine(void)
+{
+    const phase_plan_t *plan = &PHASE_PLAN_DEFAULT;
+    const uint32_t cycle_ms = plan->cycle_s * 1000u;
+    unsigned worst_sync = 0, worst_resync = 0, moved = 0;
+
+    printf("motor de fases: defasagem e preempcao\n");
+    for(uint32_t k = 0; k < ERROR_STEPS; k++)
+    {
+        uint64_t time_ms = EPOCH_MS + (uint64_t) k * (cycle_ms / ERROR_STEPS);
+        phase_engine_t engine;
+        sync_track_t track;
+        bool disturbed = false;
+        uint32_t now;
+
+        phase_engine_start(&engine, plan, 0);
+        phase_engine_set_time(&engine, time_ms, 0);
+        sync_track_init(&track, time_ms, cycle_ms, plan->offset_s * 1000u);
+        now = pe_run(&engine, 0, RUN_CYCLES * cycle_ms, &disturbed, &track);
+        sync_track_check(&track, PE_SETTLE_POINTS, &worst_sync);
+        CHECK(engine.coord.last_error_ms == 0);
+
+        // Preempção no meio do ciclo: o plano sai da grade e volta ao fim dela
+        CHECK(phase_engine_preempt(&engine, plan->preempt_phase, now));
+        now = pe_run(&engine, now, now + PREEMPT_HOLD_MS, &disturbed, &track);
+        CHECK(engine.phase == plan->preempt_phase);
+        phase_engine_preempt_release(&engine, now);
+        sync_track_init(&track, time_ms, cycle_ms, plan->offset_s * 1000u);
+        pe_run(&engine, now, now + RUN_CYCLES * cycle_ms, &disturbed, &track);
+        sync_track_check(&track, PE_SETTLE_POINTS, &worst_resync);
+        if(track.settled > 1) moved++;
+        CHECK(engine.coord.last_error_ms == 0);
+        CHECK(engine.preemptions == 1);
+    }
+    CHECK(moved > 0);  // A preempção tirou o plano da grade em algum caso
+    printf("  grade em ate %u pontos apos a hora, %u apos a preempcao\n", worst_sync, worst_resync);
+}
+
+/**
+ * @brief Roda o controlador de cruzamento de @p from_ms até @p to_ms.
+ *
+ * Cada verde encerrado tem de durar entre o mínimo e o máximo da fase, salvo
+ * os tocados pela preempção; cada cruzamento para o grupo 0 fora da
+ * preempção vai para @p track.
+ *
+ * @param disturbed O intervalo em curso de cada anel foi tocado pela preempção.
+ * @return Tempo local em que parou.
+ */
+static uint32_t rb_run(rb_controller_t *ctrl, uint32_t from_ms, uint32_t to_ms, bool *disturbed,
+    sync_track_t *track)
+{
+    const rb_plan_t *plan = ctrl->plan;
+    uint32_t now;
+
+    for(now = from_ms; now < to_ms; now += RB_TICK_MS)
+    {
+        uint8_t group = ctrl->group;
+        rb_ring_t before[RB_RINGS];
+
+        for(uint8_t r = 0; r < RB_RINGS; r++)
+        {
+            before[r] = ctrl->rings[r];
+            if(ctrl->preempt != RB_NO_PHASE) disturbed[r] = true;
+        }
+        if(!rb_controller_update(ctrl, now)) continue;
+
+        for(uint8_t r = 0; r < RB_RINGS; r++)
+        {
+            const rb_ring_t *state = &ctrl->rings[r];
+            if(state->interval == before[r].interval && state->start_ms == before[r].start_ms) continue;
+            if(before[r].interval == RB_INTERVAL_GREEN && !disturbed[r])
+            {
+                const rb_phase_def_t *def = &plan->phases[plan->sequence[r][group][before[r].slot]];
+                uint32_t length = state->start_ms - before[r].start_ms;
+                CHECK(length >= def->min_green_ds * 100u && length <= def->max_green_ds * 100u);
+            }
+            disturbed[r] = (ctrl->preempt != RB_NO_PHASE);
+        }
+        if(group != 0 && ctrl->group == 0 && ctrl->preempt == RB_NO_PHASE)
+            sync_track_point(track, ctrl->rings[0].start_ms, &ctrl->coord);
+    }
+    return now;
+}
+
+static void test_ring_barrier(void)
+{
+    const rb_plan_t *plan = &RB_PLAN_DEFAULT;
+    const uint32_t cycle_ms = plan->cycle_ds * 100u;
+    unsigned worst_sync = 0, worst_resync = 0, moved = 0;
+
+    printf("cruzamento: defasagem e preempcao\n");
+    for(uint32_t k = 0; k < ERROR_STEPS; k++)
+    {
+        uint64_t time_ms = EPOCH_MS + (uint64_t) k * (cycle_ms / ERROR_STEPS);
+        rb_controller_t ctrl;
+        sync_track_t track;
+        bool disturbed[RB_RINGS] = { false, false };
+        uint32_t now;
+
+        rb_controller_start(&ctrl, plan, 0);
+        rb_controller_set_time(&ctrl, time_ms, 0);
+        sync_track_init(&track, time_ms, cycle_ms, plan->offset_ds * 100u);
+        now = rb_run(&ctrl, 0, RUN_CYCLES * cycle_ms, disturbed, &track);
+        sync_track_check(&track, RB_SETTLE_POINTS, &worst_sync);
+        CHECK(ctrl.coord.last_error_ms == 0);
+
+        // Preempção no meio do ciclo: o plano sai da grade e volta ao fim dela
+        CHECK(rb_controller_preempt(&ctrl, plan->preempt_phase, now));
+        now = rb_run(&ctrl, now, now + PREEMPT_HOLD_MS, disturbed, &track);
+        CHECK(ctrl.signals[plan->preempt_phase] == PHASE_SIGNAL_GREEN);
+        rb_controller_preempt_release(&ctrl, now);
+        sync_track_init(&track, time_ms, cycle_ms, plan->offset_ds * 100u);
+        rb_run(&ctrl, now, now + RUN_CYCLES * cycle_ms, disturbed, &track);
+        sync_track_check(&track, RB_SETTLE_POINTS, &worst_resync);
+        if(track.settled > 1) moved++;
+        CHECK(ctrl.coord.last_error_ms == 0);
+        CHECK(ctrl.preemptions == 1);
+    }
+    CHECK(moved > 0);
+    printf("  grade em ate %u pontos apos a hora, %u apos a preempcao\n", worst_sync, worst_resync);
+}
+
+int main(void)
+{
+    CHECK(phase_plan_is_valid(&PHASE_PLAN_DEFAULT) && PHASE_PLAN_DEFAULT.cycle_s != 0);
+    CHECK(rb_plan_is_valid(&RB_PLAN_DEFAULT) && RB_PLAN_DEFAULT.cycle_ds != 0);
+    test_phase_engine();
+    test_ring_barrier();
+    printf("%u verificacoes, %u falhas\n", checks, failures);
+    return failures ? 1 : 0;
+}
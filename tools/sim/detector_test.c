@@ -0,0 +1,298 @@
+/**
+ * @file detector_test.c
+ * @brief Testes do filtro de presença (lib/detector) e do leitor do buffer do ADC (lib/adc_ring) no Linux.
+ *
+ * O filtro roda com os parâmetros do firmware (DETECTOR_CONFIG): calibração
+ * da linha de base, degrau acima e abaixo dela, histerese (um nível entre
+ * off_level e on_level mantém o estado, ligado ou desligado), ruído em torno
+ * do limiar sem liga-desliga e a máscara de presença de amostras
+ * intercaladas.
+ *
+ * O leitor do buffer circular roda contra um DMA falso que escreve amostras
+ * numeradas (número da amostra e canal no próprio valor) em lotes aleatórios,
+ * às vezes maiores que o buffer, enquanto o consumidor lê lotes de tamanho
+ * aleatório. Cada leitura tem de começar pelo canal 0, ter um número par de
+ * amostras, seguir a ordem do DMA e só pular amostras quando o consumidor
+ * atrasou, contando exatamente as puladas, e depois de um atraso voltar às
+ * mais novas.
+ *
+ * Compilação e uso (da raiz do repositório):
+ *
+ *     gcc -std=c11 -O2 -Ilib -o detector_test tools/sim/detector_test.c lib/detector.c lib/adc_ring.c
+ *     ./detector_test
+ *
+ * Sai com 0 se todos os casos passam.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+#include "adc_ring.h"
+#include "detector.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BASELINE     2048u     // Repouso do joystick (meio da escala de 12 bits)
+#define RING_SAMPLES 512u      // ADC_SAMPLER_RING_SAMPLES
+#define CHANNELS     2u        // ADC_SAMPLER_CHANNELS
+#define RING_ROUNDS  200000u   // Lotes do DMA falso
+
+/// Os parâmetros do firmware (DETECTOR_CONFIG em PicoFreeRTOS.c)
+static const detector_config_t CONFIG = {
+    .on_level = 600,
+    .off_level = 300,
+    .baseline_samples = 64,
+};
+
+static unsigned checks, failures;
+static uint32_t sim_seed = 1;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+
+static void check(bool ok, const char *what, int line)
+{
+    checks++;
+    if(ok) return;
+    failures++;
+    printf("  falhou (linha %d): %s\n", line, what);
+}
+
+/// Gerador congruencial, o mesmo em qualquer plataforma
+static uint32_t sim_random(void)
+{
+    sim_seed = sim_seed * 1103515245u + 12345u;
+    return sim_seed >> 8;
+}
+
+/**
+ * @brief Detector calibrado na linha de base, com ruído de ±3 contagens.
+ */
+static void calibrate(detector_t *det)
+{
+    detector_init(det, &CONFIG);
+    for(uint16_t i = 0; i < CONFIG.baseline_samples; i++)
+        CHECK(!detector_feed(det, (uint16_t) (BASELINE - 3u + sim_random() % 7u)));
+}
+
+/**
+ * @brief Alimenta o detector com @p count amostras iguais.
+ *
+ * @return Amostras até a presença mudar (@p count se não mudou).
+ */
+static unsigned feed_until_change(detector_t *det, uint16_t sample, unsigned count)
+{
+    bool before = det->present;
+
+    for(unsigned i = 0; i < count; i++)
+        if(detector_feed(det, sample) != before) return i + 1u;
+    return count;
+}
+
+static void test_calibration(void)
+{
+    detector_t det;
+
+    printf("calibracao\n");
+    calibrate(&det);
+    CHECK(det.baseline >= BASELINE - 3u && det.baseline <= BASELINE + 3u);
+    // Um desvio durante a calibração entra na linha de base, não na presença
+    detector_init(&det, &CONFIG);
+    for(uint16_t i = 0; i < CONFIG.baseline_samples; i++) CHECK(!detector_feed(&det, 4000));
+    CHECK(det.baseline == 4000 && det.activations == 0);
+    CHECK(feed_until_change(&det, 4000, 1000) == 1000);
+}
+
+static void test_hysteresis(void)
+{
+    detector_t det;
+    unsigned n;
+
+    printf("histerese\n");
+    calibrate(&det);
+    // Degrau de 1000: o IIR (1/8 por amostra) passa de 600 na 7a ou 8a amostra
+    n = feed_until_change(&det, BASELINE + 1000u, 100);
+    CHECK(n >= 7 && n <= 8);
+    CHECK(det.present && det.activations == 1);
+    // Entre off_level e on_level o estado se mantém
+    CHECK(feed_until_change(&det, BASELINE + 450u, 2000) == 2000);
+    CHECK(det.present);
+    // Abaixo de off_level desliga, depois que o nível filtrado cai
+    n = feed_until_change(&det, BASELINE, 100);
+    CHECK(n >= 2 && n <= 8);
+    CHECK(!det.present);
+    CHECK(feed_until_change(&det, BASELINE + 450u, 2000) == 2000);
+    CHECK(!det.present && det.activations == 1);
+    // O desvio é absoluto: abaixo da linha de base também liga
+    calibrate(&det);
+    n = feed_until_change(&det, BASELINE - 1000u, 100);
+    CHECK(n >= 7 && n <= 8 && det.present);
+    // Um pulso curto (2 amostras) não chega ao limiar
+    calibrate(&det);
+    for(unsigned i = 0; i < 100; i++)
+    {
+        detector_feed(&det, BASELINE + 1000u);
+        detector_feed(&det, BASELINE + 1000u);
+        for(unsigned j = 0; j < 30; j++) detector_feed(&det, BASELINE);
+    }
+    CHECK(!det.present && det.activations == 0);
+}
+
+static void test_noise(void)
+{
+    detector_t det;
+
+    printf("ruido em torno do limiar\n");
+    // Alternando 0 e 900 (média 450) o nível oscila perto de 450, longe dos dois limiares
+    calibrate(&det);
+    for(unsigned i = 0; i < 10000; i++) detector_feed(&det, (i & 1u) ? BASELINE + 900u : BASELINE);
+    CHECK(!det.present && det.activations == 0);
+    feed_until_change(&det, BASELINE + 1000u, 100);
+    CHECK(det.present);
+    for(unsigned i = 0; i < 10000; i++) detector_feed(&det, (i & 1u) ? BASELINE + 900u : BASELINE);
+    CHECK(det.present && det.activations == 1);
+    // Ruído aleatório de ±200 com o veículo em 450 também não troca o estado
+    for(unsigned i = 0; i < 10000; i++)
+        CHECK(detector_feed(&det, (uint16_t) (BASELINE + 250u + sim_random() % 401u)));
+}
+
+static void test_interleaved(void)
+{
+    detector_t dets[CHANNELS];
+    uint16_t samples[2 * 64];
+
+    printf("amostras intercaladas\n");
+    for(uint8_t c = 0; c < CHANNELS; c++) calibrate(&dets[c]);
+    // Canal 0 com veículo, canal 1 em repouso
+    for(unsigned i = 0; i < 64; i++)
+    {
+        samples[2 * i] = BASELINE + 1000u;
+        samples[2 * i + 1] = BASELINE;
+    }
+    CHECK(detector_feed_interleaved(dets, CHANNELS, samples, 2 * 64) == 1u);
+    // Os dois com veículo; depois só o canal 1
+    for(unsigned i = 0; i < 64; i++) samples[2 * i + 1] = BASELINE + 1000u;
+    CHECK(detector_feed_interleaved(dets, CHANNELS, samples, 2 * 64) == 3u);
+    for(unsigned i = 0; i < 64; i++) samples[2 * i] = BASELINE;
+    CHECK(detector_feed_interleaved(dets, CHANNELS, samples, 2 * 64) == 2u);
+    CHECK(dets[0].activations == 1 && dets[1].activations == 1);
+}
+
+// DMA falso: o buffer alinhado do firmware e o contador de transferências
+static uint16_t dma_buffer[RING_SAMPLES];
+static uint32_t dma_written;
+
+/**
+ * @brief Valor da amostra @p seq: o canal no bit 0 e o par no resto (12 bits).
+ */
+static uint16_t sample_value(uint32_t seq)
+{
+    return (uint16_t) ((((seq / CHANNELS) % 2048u) << 1) | (seq % CHANNELS));
+}
+
+static void dma_write(uint32_t count)
+{
+    for(uint32_t i = 0; i < count; i++, dma_written++)
+        dma_buffer[dma_written & (RING_SAMPLES - 1u)] = sample_value(dma_written);
+}
+
+/**
+ * @brief Lê e confere um lote: canal 0 primeiro, ordem do DMA, saltos só com perdas contadas.
+ */
+static uint32_t read_and_check(adc_ring_t *ring, uint32_t max)
+{
+    static uint16_t samples[RING_SAMPLES];
+    uint32_t tail = ring->tail, overruns = ring->overruns;
+    uint32_t count = adc_ring_read(ring, dma_written, samples, max);
+    uint32_t skipped = ring->overruns - overruns;
+
+    CHECK(count <= max && count % CHANNELS == 0);
+    // O par mais antigo do buffer é o próximo que o DMA sobrescreve: nunca sai
+    CHECK(dma_written - (tail + skipped) <= RING_SAMPLES - CHANNELS + 1u);
+    CHECK(skipped % CHANNELS == 0);
+    CHECK(ring->tail == tail + skipped + count);
+    CHECK(ring->tail <= dma_written);
+    // Perde amostras só quando o consumidor atrasou mais que o buffer
+    CHECK(!skipped || dma_written - tail > RING_SAMPLES - CHANNELS);
+    for(uint32_t i = 0; i < count; i++)
+    {
+        if(samples[i] == sample_value(tail + skipped + i)) continue;
+        CHECK(samples[i] == sample_value(tail + skipped + i));
+        break;
+    }
+    // Com espaço, o leitor alcança o DMA (até a última amostra de um par incompleto)
+    if(max >= RING_SAMPLES) CHECK(dma_written - ring->tail < CHANNELS);
+    return count;
+}
+
+static void test_ring(void)
+{
+    adc_ring_t ring;
+    uint16_t samples[RING_SAMPLES];
+    uint64_t delivered = 0, overrun_reads = 0;
+
+    printf("buffer circular do ADC\n");
+    dma_written = 0;
+    memset(dma_buffer, 0, sizeof(dma_buffer));
+    adc_ring_init(&ring, dma_buffer, RING_SAMPLES, CHANNELS);
+
+    // Nada escrito; uma amostra só (par incompleto) ainda não sai
+    CHECK(adc_ring_read(&ring, dma_written, samples, RING_SAMPLES) == 0);
+    dma_write(1);
+    CHECK(adc_ring_read(&ring, dma_written, samples, RING_SAMPLES) == 0);
+    dma_write(1);
+    CHECK(adc_ring_read(&ring, dma_written, samples, RING_SAMPLES) == 2);
+    CHECK(samples[0] == sample_value(0) && samples[1] == sample_value(1));
+    // Capacidade ímpar: sai o par completo que cabe
+    dma_write(10);
+    CHECK(adc_ring_read(&ring, dma_written, samples, 5) == 4);
+    CHECK(samples[0] == sample_value(2));
+
+    // Atraso de três buffers: entrega as mais novas (o buffer menos um par, que
+    // o DMA pode estar sobrescrevendo), começando no canal 0, e conta o resto
+    read_and_check(&ring, RING_SAMPLES);
+    dma_write(3 * RING_SAMPLES);
+    CHECK(read_and_check(&ring, RING_SAMPLES) == RING_SAMPLES - CHANNELS);
+    CHECK(ring.overruns == 2 * RING_SAMPLES + CHANNELS);
+    // Atraso com um par incompleto no fim: a última amostra fica para depois
+    dma_write(3 * RING_SAMPLES + 1);
+    CHECK(read_and_check(&ring, RING_SAMPLES) == RING_SAMPLES - 2 * CHANNELS);
+    CHECK(ring.overruns == 2 * (2 * RING_SAMPLES + CHANNELS) + CHANNELS);
+    // Logo depois, o leitor segue sem perdas
+    uint32_t before = ring.overruns;
+    dma_write(100);
+    read_and_check(&ring, RING_SAMPLES);
+    CHECK(ring.overruns == before);
+
+    // Lotes aleatórios dos dois lados, de vez em quando maiores que o buffer
+    for(uint32_t round = 0; round < RING_ROUNDS; round++)
+    {
+        uint32_t burst = sim_random() % 300u;
+        if(sim_random() % 50u == 0) burst += RING_SAMPLES;
+        dma_write(burst);
+        uint32_t overruns = ring.overruns;
+        uint32_t max = 1u + sim_random() % RING_SAMPLES;
+        delivered += read_and_check(&ring, (sim_random() % 4u == 0) ? RING_SAMPLES : max);
+        if(ring.overruns != overruns) overrun_reads++;
+    }
+    CHECK(overrun_reads > 0);
+
+    // DMA reiniciado: o leitor volta ao início do buffer e mantém as perdas
+    uint32_t overruns = ring.overruns;
+    dma_written = 0;
+    adc_ring_restart(&ring);
+    dma_write(20);
+    CHECK(read_and_check(&ring, RING_SAMPLES) == 20);  // Do início: sample_value(0) em diante
+    CHECK(ring.overruns == overruns);
+    printf("  %u lotes, %llu amostras entregues, %u descartadas em %llu leituras atrasadas\n", RING_ROUNDS,
+        (unsigned long long) delivered, ring.overruns, (unsigned long long) overrun_reads);
+}
+
+int main(void)
+{
+    test_calibration();
+    test_hysteresis();
+    test_noise();
+    test_interleaved();
+    test_ring();
+    printf("%u verificacoes, %u falhas\n", checks, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,320 @@
+#include <math.h>
+#include <string.h>
+#include "microsim.h"
+
+/// Fontes do próximo evento
+enum {
+    EVENT_END,
+    EVENT_CONTROLLER,
+    EVENT_PEDESTRIAN,
+    EVENT_ARRIVAL,
+    EVENT_DEPARTURE,
+};
+
+/**
+ * @brief Número uniforme em (0, 1] (xorshift64*)
+ */
+static double next_uniform(microsim_t *sim)
+{
+    sim->rng ^= sim->rng >> 12;
+    sim->rng ^= sim->rng << 25;
+    sim->rng ^= sim->rng >> 27;
+    return (double) (((sim->rng * 0x2545F4914F6CDD1DULL) >> 11) + 1u) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief Próximo instante de um processo de Poisson com intervalo médio @p mean_ms
+ */
+static uint64_t next_poisson(microsim_t *sim, double mean_ms)
+{
+    if(mean_ms <= 0.0) return MICROSIM_NEVER;
+    return sim->now_ms + (uint64_t) llround(-mean_ms * log(next_uniform(sim)));
+}
+
+static void seed_rng(microsim_t *sim, uint64_t seed)
+{
+    // splitmix64: sementes próximas dão sequências independentes, e nunca zero
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    sim->rng = (z ^ (z >> 31)) | 1u;
+}
+
+/**
+ * @brief Acumula a fila desde a última mudança
+ */
+static void account_queue(microsim_approach_t *approach, uint64_t now_ms)
+{
+    approach->stats.queue_ms += (uint64_t) approach->count * (now_ms - approach->changed_ms);
+    approach->changed_ms = now_ms;
+}
+
+/**
+ * @brief Sinal que o controlador mostra à aproximação @p index
+ */
+static uint8_t approach_signal(const microsim_t *sim, uint8_t index)
+{
+    if(sim->intersection) return sim->rb.signals[sim->rb.plan->heads[index].phase];
+
+    const phase_def_t *phase = phase_engine_current(&sim->engine);
+    if(index == 0) return phase->signal;
+    // Transversal: passa com o foco vermelho e sem pedestre atravessando
+    return (phase->signal == PHASE_SIGNAL_RED && phase->ped == PHASE_PED_DONT_WALK)
+        ? PHASE_SIGNAL_GREEN : PHASE_SIGNAL_RED;
+}
+
+/**
+ * @brief Atualiza a janela de descarga das aproximações cujo sinal mudou
+ */
+static void update_signals(microsim_t *sim)
+{
+    for(uint8_t i = 0; i < sim->count; i++)
+    {
+        microsim_approach_t *approach = &sim->approaches[i];
+        uint8_t signal = approach_signal(sim, i);
+        if(signal == approach->signal) continue;
+
+        if(signal == PHASE_SIGNAL_GREEN)
+        {
+            uint64_t start_ms = sim->now_ms + (uint64_t) llround(sim->params.startup_lost_s * 1000.0);
+            if(approach->ready_ms < start_ms) approach->ready_ms = start_ms;
+            approach->service_end_ms = MICROSIM_NEVER;
+        }
+        else if(signal == PHASE_SIGNAL_YELLOW)
+        {
+            uint64_t end_ms = sim->now_ms + (uint64_t) llround(sim->params.yellow_used_s * 1000.0);
+            if(end_ms < approach->service_end_ms) approach->service_end_ms = end_ms;
+        }
+        else if(sim->now_ms < approach->service_end_ms) approach->service_end_ms = sim->now_ms;
+        approach->signal = signal;
+    }
+}
+
+/**
+ * @brief Próxima mudança do controlador, ou MICROSIM_NEVER em repouso
+ */
+static uint64_t controller_next(const microsim_t *sim)
+{
+    uint32_t now_ms = (uint32_t) sim->now_ms;
+    uint64_t next_ms = MICROSIM_NEVER;
+
+    if(!sim->intersection)
+    {
+        uint32_t elapsed = now_ms - sim->engine.start_ms;
+        return sim->now_ms + ((elapsed < sim->engine.duration_ms) ? sim->engine.duration_ms - elapsed : 0u);
+    }
+    for(uint8_t r = 0; r < RB_RINGS; r++)
+    {
+        const rb_ring_t *ring = &sim->rb.rings[r];
+        uint32_t elapsed = now_ms - ring->start_ms;
+        if(ring->interval == RB_INTERVAL_BARRIER) continue;
+        uint64_t end_ms = sim->now_ms + ((elapsed < ring->duration_ms) ? ring->duration_ms - elapsed : 0u);
+        if(end_ms < next_ms) next_ms = end_ms;
+    }
+    return next_ms;
+}
+
+/**
+ * @brief Instante em que o primeiro da fila passa, ou MICROSIM_NEVER
+ */
+static uint64_t departure_time(const microsim_approach_t *approach)
+{
+    uint64_t time_ms;
+
+    if(approach->count == 0) return MICROSIM_NEVER;
+    time_ms = approach->queue[approach->head];
+    if(time_ms < approach->ready_ms) time_ms = approach->ready_ms;
+    return (time_ms < approach->service_end_ms) ? time_ms : MICROSIM_NEVER;
+}
+
+/**
+ * @brief Detectores com presença: o pulso deste evento e as filas paradas
+ */
+static uint32_t presence_mask(const microsim_t *sim, uint8_t pulse)
+{
+    uint32_t mask = (pulse != MICROSIM_NO_DETECTOR) ? 1u << pulse : 0u;
+
+    for(uint8_t i = 0; i < sim->count; i++)
+    {
+        const microsim_approach_t *approach = &sim->approaches[i];
+        if(approach->count && approach->detector != MICROSIM_NO_DETECTOR) mask |= 1u << approach->detector;
+    }
+    return mask;
+}
+
+static void place_ped_call(microsim_t *sim)
+{
+    if(sim->intersection)
+    {
+        if(sim->rb.plan->ped_phase != RB_NO_PHASE) rb_controller_call(&sim->rb, sim->rb.plan->ped_phase);
+    }
+    else if(sim->engine.plan->pedestrian_call != PHASE_NO_CALL)
+        phase_engine_call(&sim->engine, sim->engine.plan->pedestrian_call);
+    sim->ped_calls++;
+}
+
+static void arrive(microsim_approach_t *approach, uint64_t now_ms)
+{
+    account_queue(approach, now_ms);
+    approach->stats.arrivals++;
+    if(approach->count == MICROSIM_QUEUE_SIZE)
+    {
+        approach->stats.overflow++;
+        return;
+    }
+    approach->queue[(approach->head + approach->count++) & (MICROSIM_QUEUE_SIZE - 1u)] = now_ms;
+    if(approach->count > approach->stats.max_queue) approach->stats.max_queue = approach->count;
+}
+
+static void depart(microsim_approach_t *approach, uint64_t now_ms, uint32_t headway_ms)
+{
+    account_queue(approach, now_ms);
+    approach->stats.delay_ms += now_ms - approach->queue[approach->head];
+    approach->stats.departures++;
+    approach->head = (approach->head + 1u) & (MICROSIM_QUEUE_SIZE - 1u);
+    approach->count--;
+    approach->ready_ms = now_ms + headway_ms;
+}
+
+/**
+ * @brief Parte comum das duas inicializações
+ */
+static void init_common(microsim_t *sim, const microsim_params_t *params)
+{
+    sim->params = *params;
+    seed_rng(sim, params->seed);
+    sim->now_ms = 0;
+    sim->ped_calls = 0;
+    sim->events = 0;
+    sim->stats_start_ms = 0;
+    sim->headway_ms = (uint32_t) llround(3600000.0 / params->saturation_vph);
+    sim->next_ped_ms = next_poisson(sim, (params->ped_per_hour > 0.0) ? 3600000.0 / params->ped_per_hour : 0.0);
+}
+
+/**
+ * @brief Prepara uma aproximação vazia, com o sinal lido do controlador já iniciado
+ */
+static void init_approach(microsim_t *sim, uint8_t index, const char *name, uint8_t detector, double flow_vph)
+{
+    microsim_approach_t *approach = &sim->approaches[index];
+
+    approach->name = name;
+    approach->detector = detector;
+    approach->signal = PHASE_SIGNAL_RED;
+    approach->mean_gap_ms = (flow_vph > 0.0) ? 3600000.0 / flow_vph : 0.0;
+    approach->next_arrival_ms = next_poisson(sim, approach->mean_gap_ms);
+    approach->ready_ms = 0;
+    approach->service_end_ms = 0;
+    approach->changed_ms = 0;
+    approach->head = 0;
+    approach->count = 0;
+    memset(&approach->stats, 0, sizeof(approach->stats));
+}
+
+void microsim_init_single(microsim_t *sim, const phase_plan_t *plan, const double flow_vph[2],
+    const microsim_params_t *params)
+{
+    static const char *const NAMES[2] = { "principal", "transversal" };
+
+    init_common(sim, params);
+    sim->intersection = false;
+    phase_engine_start(&sim->engine, plan, 0);
+    if(params->time_synced) phase_engine_set_time(&sim->engine, 0, 0);
+    sim->count = 2;
+    for(uint8_t i = 0; i < sim->count; i++) init_approach(sim, i, NAMES[i], i, flow_vph[i]);
+    update_signals(sim);
+}
+
+void microsim_init_intersection(microsim_t *sim, const rb_plan_t *plan, const double *flow_vph,
+    const microsim_params_t *params)
+{
+    init_common(sim, params);
+    sim->intersection = true;
+    rb_controller_start(&sim->rb, plan, 0);
+    if(params->time_synced) rb_controller_set_time(&sim->rb, 0, 0);
+    sim->count = plan->head_count;
+    for(uint8_t i = 0; i < sim->count; i++)
+        init_approach(sim, i, plan->heads[i].name, plan->phases[plan->heads[i].phase].detector, flow_vph[i]);
+    update_signals(sim);
+}
+
+void microsim_run(microsim_t *sim, uint64_t duration_ms)
+{
+    uint64_t end_ms = sim->now_ms + duration_ms;
+
+    while(1)
+    {
+        uint64_t next_ms = end_ms;
+        uint8_t source = EVENT_END;
+        uint8_t index = 0;
+        uint8_t pulse = MICROSIM_NO_DETECTOR;
+        uint64_t time_ms;
+
+        // Evento mais próximo; no empate, o controlador muda antes de os veículos andarem
+        if((time_ms = controller_next(sim)) <= next_ms) { next_ms = time_ms; source = EVENT_CONTROLLER; }
+        if(sim->next_ped_ms < next_ms) { next_ms = sim->next_ped_ms; source = EVENT_PEDESTRIAN; }
+        for(uint8_t i = 0; i < sim->count; i++)
+        {
+            const microsim_approach_t *approach = &sim->approaches[i];
+            if(approach->next_arrival_ms < next_ms) { next_ms = approach->next_arrival_ms; source = EVENT_ARRIVAL; index = i; }
+            if((time_ms = departure_time(approach)) < next_ms) { next_ms = time_ms; source = EVENT_DEPARTURE; index = i; }
+        }
+        if(source == EVENT_END || next_ms > end_ms) break;
+
+        sim->now_ms = next_ms;
+        sim->events++;
+        switch(source)
+        {
+            case EVENT_PEDESTRIAN:
+                place_ped_call(sim);
+                sim->next_ped_ms = next_poisson(sim, 3600000.0 / sim->params.ped_per_hour);
+                break;
+            case EVENT_ARRIVAL:
+                arrive(&sim->approaches[index], sim->now_ms);
+                sim->approaches[index].next_arrival_ms = next_poisson(sim, sim->approaches[index].mean_gap_ms);
+                pulse = sim->approaches[index].detector;
+                break;
+            case EVENT_DEPARTURE:
+                depart(&sim->approaches[index], sim->now_ms, sim->headway_ms);
+                pulse = sim->approaches[index].detector;
+                break;
+            default:
+                break;
+        }
+
+        // O controlador vê o tempo como o firmware: milissegundos de 32 bits, com volta
+        uint32_t now_ms = (uint32_t) sim->now_ms;
+        uint32_t detectors;
+        uint32_t changes;
+        if(sim->intersection)
+        {
+            changes = rb_controller_update(&sim->rb, now_ms);
+            if((detectors = presence_mask(sim, pulse)) != 0)
+            {
+                rb_controller_presence(&sim->rb, detectors, now_ms);
+                // Uma chamada nova tira os anéis do repouso na barreira já agora
+                if(controller_next(sim) == MICROSIM_NEVER) changes += rb_controller_update(&sim->rb, now_ms);
+            }
+        }
+        else
+        {
+            changes = phase_engine_update(&sim->engine, now_ms);
+            if((detectors = presence_mask(sim, pulse)) != 0) phase_engine_presence(&sim->engine, detectors, now_ms);
+        }
+        if(changes) update_signals(sim);
+    }
+    sim->now_ms = end_ms;
+    for(uint8_t i = 0; i < sim->count; i++) account_queue(&sim->approaches[i], end_ms);
+}
+
+void microsim_reset_stats(microsim_t *sim)
+{
+    sim->stats_start_ms = sim->now_ms;
+    sim->ped_calls = 0;
+    sim->events = 0;
+    for(uint8_t i = 0; i < sim->count; i++)
+    {
+        memset(&sim->approaches[i].stats, 0, sizeof(sim->approaches[i].stats));
+        sim->approaches[i].changed_ms = sim->now_ms;
+    }
+}
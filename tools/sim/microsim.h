@@ -0,0 +1,140 @@
+#ifndef MICROSIM_H
+#define MICROSIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "phase_engine.h"
+#include "ring_barrier.h"
+
+/**
+ * @file microsim.h
+ * @brief Microssimulador de filas acoplado ao controlador real (motor de
+ *        fases ou anéis e barreiras), para avaliar temporizações no Linux.
+ *
+ * Cada aproximação é uma fila vertical: os veículos chegam por um processo de
+ * Poisson e saem pela linha de retenção com o headway de saturação enquanto a
+ * aproximação tem direito de passagem. O verde começa a descarregar depois do
+ * tempo perdido de partida e a descarga continua nos primeiros segundos do
+ * amarelo (amarelo útil); o resto do amarelo e o vermelho de limpeza são o
+ * tempo perdido de fim. O atraso de um veículo é o tempo entre a chegada e a
+ * passagem pela linha de retenção.
+ *
+ * O controlador é o mesmo código do firmware, com o tempo da simulação em
+ * milissegundos (uint32, com volta). Cada chegada e cada partida é um pulso
+ * no detector da aproximação, e uma fila parada mantém a presença, como um
+ * laço na linha de retenção. O botão de pedestre é outro processo de Poisson.
+ *
+ * A simulação é por eventos: o relógio salta para a próxima chegada, partida,
+ * fim de intervalo do controlador ou chamada de pedestre, então milhares de
+ * horas simuladas rodam em um segundo.
+ *
+ * No plano de foco único há duas aproximações: "principal" (detector 0), no
+ * verde e no amarelo do foco, e "transversal" (detector 1), liberada nas
+ * fases vermelhas sem pedestre. O semáforo transversal não existe no plano,
+ * então a transversal não tem amarelo: a descarga para quando a principal
+ * fica verde. No cruzamento cada foco é uma aproximação, com o detector da
+ * sua fase.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define MICROSIM_MAX_APPROACHES  RB_MAX_HEADS   /**< Máximo de aproximações */
+#define MICROSIM_QUEUE_SIZE      1024u          /**< Veículos na fila de uma aproximação (potência de 2) */
+#define MICROSIM_NO_DETECTOR     0xFF           /**< Aproximação sem detector */
+#define MICROSIM_NEVER           UINT64_MAX     /**< Evento que não vai acontecer */
+
+/**
+ * @brief Parâmetros do tráfego.
+ */
+typedef struct {
+    double saturation_vph;        /**< Fluxo de saturação por aproximação, em veículos/h de verde */
+    double startup_lost_s;        /**< Tempo perdido no início do verde */
+    double yellow_used_s;         /**< Parte do amarelo usada pelos veículos */
+    double ped_per_hour;          /**< Chamadas de pedestre por hora (0: nenhuma) */
+    uint64_t seed;                /**< Semente do gerador (mesma semente, mesmas chegadas) */
+    bool time_synced;             /**< Controlador com a hora do host: planos com ciclo rodam coordenados */
+} microsim_params_t;
+
+/**
+ * @brief Resultados de uma aproximação.
+ */
+typedef struct {
+    uint64_t arrivals;            /**< Veículos que chegaram */
+    uint64_t departures;          /**< Veículos que passaram */
+    uint64_t overflow;            /**< Chegadas descartadas com a fila cheia */
+    uint64_t delay_ms;            /**< Soma dos atrasos dos veículos que passaram */
+    uint64_t queue_ms;            /**< Integral da fila no tempo (veículos x ms) */
+    uint32_t max_queue;           /**< Maior fila */
+} microsim_stats_t;
+
+/**
+ * @brief Estado de uma aproximação.
+ */
+typedef struct {
+    const char *name;                         /**< Nome (foco ou via) */
+    uint8_t detector;                         /**< Detector, ou MICROSIM_NO_DETECTOR */
+    uint8_t signal;                           /**< phase_signal_t mostrado à aproximação */
+    double mean_gap_ms;                       /**< Intervalo médio entre chegadas (0: sem tráfego) */
+    uint64_t next_arrival_ms;                 /**< Próxima chegada */
+    uint64_t ready_ms;                        /**< Quando o próximo veículo pode passar */
+    uint64_t service_end_ms;                  /**< Fim da descarga (MICROSIM_NEVER no verde) */
+    uint64_t changed_ms;                      /**< Última mudança da fila */
+    uint64_t queue[MICROSIM_QUEUE_SIZE];      /**< Instantes de chegada dos veículos na fila */
+    uint32_t head;                            /**< Primeiro da fila */
+    uint32_t count;                           /**< Veículos na fila */
+    microsim_stats_t stats;                   /**< Resultados */
+} microsim_approach_t;
+
+/**
+ * @brief Estado da simulação.
+ */
+typedef struct {
+    bool intersection;                                    /**< Controlador de anéis e barreiras */
+    phase_engine_t engine;                                /**< Motor de fases (foco único) */
+    rb_controller_t rb;                                   /**< Controlador do cruzamento */
+    microsim_params_t params;                             /**< Parâmetros do tráfego */
+    uint64_t rng;                                         /**< Estado do gerador xorshift64* */
+    uint64_t now_ms;                                      /**< Relógio da simulação */
+    uint64_t stats_start_ms;                              /**< Início dos resultados */
+    uint64_t next_ped_ms;                                 /**< Próxima chamada de pedestre */
+    uint64_t ped_calls;                                   /**< Chamadas de pedestre feitas */
+    uint64_t events;                                      /**< Eventos processados */
+    uint32_t headway_ms;                                  /**< Headway de saturação */
+    uint8_t count;                                        /**< Número de aproximações */
+    microsim_approach_t approaches[MICROSIM_MAX_APPROACHES];
+} microsim_t;
+
+/**
+ * @brief Prepara a simulação do plano de foco único.
+ *
+ * @param sim Estado.
+ * @param plan Plano (deve continuar válido durante a simulação).
+ * @param flow_vph Chegadas por hora na principal e na transversal.
+ * @param params Parâmetros do tráfego.
+ */
+void microsim_init_single(microsim_t *sim, const phase_plan_t *plan, const double flow_vph[2],
+    const microsim_params_t *params);
+
+/**
+ * @brief Prepara a simulação de um cruzamento, uma aproximação por foco.
+ *
+ * @param sim Estado.
+ * @param plan Plano (deve continuar válido durante a simulação).
+ * @param flow_vph Chegadas por hora em cada foco (head_count posições).
+ * @param params Parâmetros do tráfego.
+ */
+void microsim_init_intersection(microsim_t *sim, const rb_plan_t *plan, const double *flow_vph,
+    const microsim_params_t *params);
+
+/**
+ * @brief Simula mais @p duration_ms milissegundos.
+ */
+void microsim_run(microsim_t *sim, uint64_t duration_ms);
+
+/**
+ * @brief Zera os resultados (por exemplo, no fim do aquecimento), mantendo as filas.
+ */
+void microsim_reset_stats(microsim_t *sim);
+
+#endif // MICROSIM_H
@@ -0,0 +1,838 @@
+/**
+ * @file optimize_plan.c
+ * @brief Otimiza o ciclo e a divisão dos verdes do plano do firmware a partir
+ *        das chegadas gravadas no log de eventos.
+ *
+ * Os fluxos saem do CSV de tools/event_log.py --arrivals (presenças nos
+ * detectores e chamadas de pedestre), pela média do período gravado ou pela
+ * hora mais carregada. O ponto de partida é o plano de Webster (ciclo
+ * (1,5 L + 5) / (1 - Y), verdes proporcionais às razões de fluxo críticas);
+ * depois uma busca por padrões no microssimulador ajusta o verde padrão e o
+ * máximo de cada fase, passo a passo, com o passo caindo pela metade quando
+ * nenhum vizinho melhora. Os vizinhos de cada passo são simulados em paralelo,
+ * um por núcleo, todos com as mesmas chegadas (mesma semente).
+ *
+ * O critério é o atraso médio por veículo que chegou, pela lei de Little (a
+ * integral da fila dividida pelas chegadas), então uma fila que cresce sem
+ * parar pesa mesmo sem os veículos passarem; cada chegada descartada com a
+ * fila cheia conta como uma hora de atraso. Mínimos, amarelos e vermelhos de
+ * limpeza não mudam. No foco único coordenado o ciclo acompanha a soma das
+ * fases; no cruzamento, em que as fases sem chamada ficam fora do ciclo e a
+ * coordenação ajusta os verdes entre o mínimo e o máximo, o ciclo é mais uma
+ * variável da busca.
+ * O resultado é conferido em uma simulação mais longa, com outra semente.
+ *
+ * A saída é a tabela de fases no formato de lib/phase_plans.c, com o ciclo, e
+ * os comandos duracao do shell.
+ *
+ * Compilação (da raiz do repositório):
+ *
+ *     gcc -std=c11 -O2 -pthread -Ilib -Itools/sim -o optimize_plan tools/sim/optimize_plan.c \
+ *         tools/sim/sim_plan.c tools/sim/microsim.c lib/phase_engine.c lib/phase_plans.c \
+ *         lib/ring_barrier.c lib/coordination.c -lm
+ *
+ * Uso:
+ *
+ *     ./optimize_plan --arrivals chegadas.csv
+ *     ./optimize_plan --arrivals chegadas.csv --peak --intersection
+ *     ./optimize_plan --flow 800,200
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sim_plan.h"
+
+#define DEFAULT_HOURS        200.0
+#define DEFAULT_CHECK_HOURS  2000.0
+#define DEFAULT_WARMUP_MIN   15.0
+#define DEFAULT_TURN_VPH     60.0
+#define MAX_DETECTORS        32
+#define MAX_THREADS          64
+#define MAX_VARIABLES        (2 * PHASE_ENGINE_MAX_PHASES)
+#define MAX_ITERATIONS       200
+#define WEBSTER_MAX_CYCLE_S  180.0
+#define WEBSTER_MAX_Y        0.95
+#define RB_MAX_GREEN_DS      600     // Limite da busca no cruzamento (60 s)
+#define RB_MAX_CYCLE_DS      1800
+#define VARIABLE_MAX         1       // Índices de durations[]
+#define VARIABLE_DEFAULT     2
+#define VARIABLE_CYCLE       3       // Ciclo do cruzamento coordenado
+#define OVERFLOW_DELAY_MS    3600000.0
+
+/**
+ * @brief Variável da busca: o máximo ou o padrão de uma fase, ou o ciclo
+ */
+typedef struct {
+    uint8_t phase;
+    uint8_t which;
+} variable_t;
+
+/**
+ * @brief Uma avaliação: plano e resultado
+ */
+typedef struct {
+    sim_plan_t plan;
+    double objective_s;     // Atraso médio por chegada (Little), com a penalidade de descartes
+    double delay_s;         // Atraso médio dos veículos que passaram
+} candidate_t;
+
+/**
+ * @brief Lote de avaliações repartido entre as threads
+ */
+typedef struct {
+    candidate_t *candidates;
+    int count;
+    atomic_int next;
+    const double *flow_vph;
+    const microsim_params_t *params;
+    double hours;
+    double warmup_min;
+} batch_t;
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+        "uso: %s (--arrivals CSV | --flow V1,V2,...) [opcoes]\n"
+        "  --arrivals CSV          chegadas de tools/event_log.py --arrivals\n"
+        "  --peak                  usa a hora com mais chegadas (padrao: media do periodo)\n"
+        "  --flow V1,V2,...        chegadas por hora de cada aproximacao, sem CSV\n"
+        "  --intersection          cruzamento de 8 fases (padrao: foco unico 9/3/6)\n"
+        "  --turn-flow V           chegadas por hora dos focos sem detector (padrao %.0f)\n"
+        "  --peds N                chamadas de pedestre por hora (padrao: as do CSV)\n"
+        "  --free                  sem coordenacao (ciclo livre)\n"
+        "  --hours H               horas simuladas por avaliacao (padrao %.0f)\n"
+        "  --check-hours H         horas da conferencia final (padrao %.0f)\n"
+        "  --warmup M              minutos de aquecimento descartados (padrao %.0f)\n"
+        "  --saturation V          fluxo de saturacao, veiculos/h de verde (padrao 1800)\n"
+        "  --lost S                tempo perdido no inicio do verde (padrao 2)\n"
+        "  --yellow-used S         parte do amarelo usada (padrao 2)\n"
+        "  --seed N                semente das chegadas (padrao 1)\n"
+        "  --threads N             threads da busca (padrao: todos os nucleos)\n",
+        program, DEFAULT_TURN_VPH, DEFAULT_HOURS, DEFAULT_CHECK_HOURS, DEFAULT_WARMUP_MIN);
+    exit(2);
+}
+
+static double parse_number(const char *text, const char *program)
+{
+    char *end;
+    double value = strtod(text, &end);
+
+    if(end == text || *end != '\0' || value < 0.0) usage(program);
+    return value;
+}
+
+/**
+ * @brief Lê uma lista de números separados por vírgula
+ *
+ * @return Quantidade lida.
+ */
+static int parse_list(const char *text, double *values, int max, const char *program)
+{
+    char buffer[256];
+    int count = 0;
+
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    for(char *item = strtok(buffer, ","); item; item = strtok(NULL, ","))
+    {
+        if(count == max) usage(program);
+        values[count++] = parse_number(item, program);
+    }
+    return count;
+}
+
+/**
+ * @brief Chegadas do CSV: contagens por detector e de pedestres no período usado
+ */
+typedef struct {
+    uint64_t detector[MAX_DETECTORS];
+    uint64_t pedestrians;
+    double span_ms;        // Tempo coberto pelo log (soma dos boots) ou 1 h com --peak
+} arrival_counts_t;
+
+/**
+ * @brief Uma linha do CSV
+ */
+typedef struct {
+    uint32_t boot;
+    uint32_t time_ms;
+    uint8_t input;         // Detector, ou MAX_DETECTORS para o pedestre
+} arrival_t;
+
+/**
+ * @brief Lê o CSV "boot,tempo_ms,entrada" (na ordem do log) e conta as chegadas
+ *
+ * @param peak Conta só a hora, dentro de um boot, com mais chegadas.
+ * @return false se o arquivo não abre ou não tem chegadas.
+ */
+static bool read_arrivals(const char *path, bool peak, arrival_counts_t *counts)
+{
+    FILE *file = fopen(path, "r");
+    arrival_t *arrivals = NULL;
+    size_t count = 0, capacity = 0;
+    char line[128];
+
+    memset(counts, 0, sizeof(*counts));
+    if(!file) return false;
+    while(fgets(line, sizeof(line), file))
+    {
+        unsigned long boot, time_ms;
+        char input[32];
+        if(sscanf(line, "%lu,%lu,%31s", &boot, &time_ms, input) != 3) continue;  // Cabeçalho
+        if(count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 4096;
+            arrival_t *grown = realloc(arrivals, capacity * sizeof(arrival_t));
+            if(!grown) break;
+            arrivals = grown;
+        }
+        uint8_t which = (strcmp(input, "pedestre") == 0) ? MAX_DETECTORS : (uint8_t) atoi(input);
+        if(which > MAX_DETECTORS) continue;
+        arrivals[count++] = (arrival_t) { (uint32_t) boot, (uint32_t) time_ms, which };
+    }
+    fclose(file);
+
+    // Janela [first, last) com as chegadas contadas; no modo médio, cada boot inteiro
+    size_t first = 0, last = count;
+    if(peak)
+    {
+        size_t best = 0;
+        for(size_t start = 0, end = 0; start < count; start++)
+        {
+            if(end < start) end = start;
+            while(end < count && arrivals[end].boot == arrivals[start].boot &&
+                arrivals[end].time_ms - arrivals[start].time_ms < 3600000u) end++;
+            if(end - start > best)
+            {
+                best = end - start;
+                first = start;
+                last = end;
+            }
+        }
+        counts->span_ms = 3600000.0;
+    }
+    for(size_t i = first; i < last; i++)
+    {
+        if(arrivals[i].input == MAX_DETECTORS) counts->pedestrians++;
+        else counts->detector[arrivals[i].input]++;
+        // Período coberto: do primeiro ao último registro de cada boot
+        if(!peak && (i + 1 == last || arrivals[i + 1].boot != arrivals[i].boot))
+        {
+            size_t boot_start = i;
+            while(boot_start > first && arrivals[boot_start - 1].boot == arrivals[i].boot) boot_start--;
+            counts->span_ms += (double) (arrivals[i].time_ms - arrivals[boot_start].time_ms);
+        }
+    }
+    free(arrivals);
+    return last > first && counts->span_ms > 0.0;
+}
+
+/**
+ * @brief Fluxo de cada aproximação: o detector da aproximação dividido entre
+ *        as aproximações que o compartilham; sem detector, @p turn_vph
+ */
+static void flows_from_counts(const sim_plan_t *sim_plan, const arrival_counts_t *counts, double turn_vph,
+    double *flow_vph)
+{
+    uint8_t approaches = sim_plan_approaches(sim_plan);
+    uint8_t sharing[MAX_DETECTORS] = { 0 };
+
+    for(uint8_t i = 0; i < approaches; i++)
+    {
+        uint8_t detector = sim_plan_approach_detector(sim_plan, i);
+        if(detector < MAX_DETECTORS) sharing[detector]++;
+    }
+    for(uint8_t i = 0; i < approaches; i++)
+    {
+        uint8_t detector = sim_plan_approach_detector(sim_plan, i);
+        flow_vph[i] = (detector < MAX_DETECTORS)
+            ? (double) counts->detector[detector] * 3600000.0 / counts->span_ms / sharing[detector] : turn_vph;
+    }
+}
+
+/**
+ * @brief Fases do plano de foco único no caminho sem chamadas: o verde, o
+ *        amarelo e o vermelho da transversal
+ *
+ * @return false se o plano não tem essas três fases.
+ */
+static bool single_stages(const sim_plan_t *sim_plan, uint8_t *green, uint8_t *yellow, uint8_t *red)
+{
+    uint8_t phase = sim_plan->plan.initial;
+
+    *green = *yellow = *red = PHASE_NO_DETECTOR;
+    for(uint8_t i = 0; i < sim_plan->plan.count; i++, phase = sim_plan->phases[phase].next)
+    {
+        const phase_def_t *def = &sim_plan->phases[phase];
+        if(def->signal == PHASE_SIGNAL_GREEN && *green == PHASE_NO_DETECTOR) *green = phase;
+        else if(def->signal == PHASE_SIGNAL_YELLOW && *yellow == PHASE_NO_DETECTOR) *yellow = phase;
+        else if(def->signal == PHASE_SIGNAL_RED && def->ped == PHASE_PED_DONT_WALK && *red == PHASE_NO_DETECTOR)
+            *red = phase;
+    }
+    return *green != PHASE_NO_DETECTOR && *yellow != PHASE_NO_DETECTOR && *red != PHASE_NO_DETECTOR;
+}
+
+/**
+ * @brief Soma das fases do ciclo: verde, amarelo e vermelho no foco único; no
+ *        cruzamento, o anel mais longo de cada grupo com todas as fases atendidas
+ *
+ * @param minimum No cruzamento, com os verdes mínimos.
+ */
+static uint16_t plan_cycle_length(const sim_plan_t *sim_plan, bool minimum)
+{
+    if(!sim_plan->intersection)
+    {
+        uint8_t green, yellow, red;
+        if(!single_stages(sim_plan, &green, &yellow, &red)) return sim_plan->plan.cycle_s;
+        return (uint16_t) (sim_plan->phases[green].default_s + sim_plan->phases[yellow].default_s +
+            sim_plan->phases[red].default_s);
+    }
+    uint32_t cycle_ds = 0;
+    for(uint8_t g = 0; g < RB_GROUPS; g++)
+    {
+        uint32_t longest = 0;
+        for(uint8_t r = 0; r < RB_RINGS; r++)
+        {
+            uint32_t ring_ds = 0;
+            for(uint8_t s = 0; s < RB_GROUP_SLOTS; s++)
+            {
+                uint8_t phase = sim_plan->rb_plan.sequence[r][g][s];
+                if(phase == RB_NO_PHASE) continue;
+                const rb_phase_def_t *def = &sim_plan->rb_phases[phase];
+                ring_ds += (minimum ? def->min_green_ds : def->green_ds) + def->yellow_ds + def->red_clear_ds;
+            }
+            if(ring_ds > longest) longest = ring_ds;
+        }
+        cycle_ds += longest;
+    }
+    return (uint16_t) cycle_ds;
+}
+
+/**
+ * @brief Em planos coordenados, o ciclo passa a ser a soma das fases
+ */
+static void fit_cycle(sim_plan_t *sim_plan)
+{
+    if(sim_plan_cycle(sim_plan)) sim_plan_set_cycle(sim_plan, plan_cycle_length(sim_plan, false));
+}
+
+/**
+ * @brief Maior valor que a busca dá ao padrão e ao máximo de uma fase
+ */
+static uint16_t duration_bound(const sim_plan_t *sim_plan)
+{
+    return sim_plan->intersection ? RB_MAX_GREEN_DS : SIM_PLAN_DISPLAY_MAX_S;
+}
+
+static uint16_t clamp_duration(double value, uint16_t low, uint16_t high)
+{
+    if(value < low) return low;
+    if(value > high) return high;
+    return (uint16_t) lround(value);
+}
+
+/**
+ * @brief Aplica verde padrão @p value à fase, com o máximo igual ao padrão
+ *        nas fases atuadas (o verde cresce com a presença até o padrão)
+ */
+static void set_green(sim_plan_t *sim_plan, uint8_t phase, double value)
+{
+    uint16_t durations[3];
+
+    sim_plan_get_durations(sim_plan, phase, durations);
+    durations[2] = clamp_duration(value, durations[0], duration_bound(sim_plan));
+    if(durations[1] < durations[2]) durations[1] = durations[2];
+    bool actuated = sim_plan->intersection ? sim_plan->rb_phases[phase].detector != RB_NO_DETECTOR
+                                           : sim_plan->phases[phase].detector != PHASE_NO_DETECTOR;
+    if(actuated) durations[1] = durations[2];
+    sim_plan_set_durations(sim_plan, phase, durations);
+}
+
+/**
+ * @brief Ciclo de Webster: (1,5 L + 5) / (1 - Y), limitado a WEBSTER_MAX_CYCLE_S
+ */
+static double webster_cycle(double lost_s, double y)
+{
+    if(y >= WEBSTER_MAX_Y)
+    {
+        fprintf(stderr, "aviso: razao de fluxo Y = %.2f, demanda perto ou acima da capacidade\n", y);
+        return WEBSTER_MAX_CYCLE_S;
+    }
+    double cycle_s = (1.5 * lost_s + 5.0) / (1.0 - y);
+    return (cycle_s > WEBSTER_MAX_CYCLE_S) ? WEBSTER_MAX_CYCLE_S : cycle_s;
+}
+
+/**
+ * @brief Plano de Webster do foco único: dois estágios, a principal no verde
+ *        e no amarelo e a transversal no vermelho
+ */
+static bool webster_single(sim_plan_t *sim_plan, const double *flow_vph, const microsim_params_t *params)
+{
+    uint8_t green, yellow, red;
+
+    if(!single_stages(sim_plan, &green, &yellow, &red)) return false;
+    double yellow_s = sim_plan->phases[yellow].default_s;
+    double used_s = (params->yellow_used_s < yellow_s) ? params->yellow_used_s : yellow_s;
+    double lost_main_s = params->startup_lost_s + yellow_s - used_s;
+    double lost_side_s = params->startup_lost_s;
+    double y_main = flow_vph[0] / params->saturation_vph, y_side = flow_vph[1] / params->saturation_vph;
+    double y = y_main + y_side;
+    double cycle_s = webster_cycle(lost_main_s + lost_side_s, y);
+    double effective_s = cycle_s - lost_main_s - lost_side_s;
+    double share = (y > 0.0) ? y_main / y : 0.5;
+
+    // Verde efetivo = verde - perdido no início + amarelo usado. Se uma fase
+    // passa do limite do display, o ciclo encolhe até ela caber, com a mesma divisão
+    double bound_s = duration_bound(sim_plan);
+    if(share > 0.0 && effective_s * share > bound_s - params->startup_lost_s + used_s)
+        effective_s = (bound_s - params->startup_lost_s + used_s) / share;
+    if(share < 1.0 && effective_s * (1.0 - share) > bound_s - params->startup_lost_s)
+        effective_s = (bound_s - params->startup_lost_s) / (1.0 - share);
+    set_green(sim_plan, green, effective_s * share + params->startup_lost_s - used_s);
+    set_green(sim_plan, red, effective_s * (1.0 - share) + params->startup_lost_s);
+    fit_cycle(sim_plan);
+    return true;
+}
+
+/**
+ * @brief Plano de Webster do cruzamento: o anel crítico de cada grupo define
+ *        o ciclo; dentro do grupo, cada anel divide o tempo do grupo pelas
+ *        razões de fluxo das suas fases
+ */
+static bool webster_intersection(sim_plan_t *sim_plan, const double *flow_vph, const microsim_params_t *params)
+{
+    const rb_plan_t *plan = &sim_plan->rb_plan;
+    double phase_y[RB_MAX_PHASES] = { 0 }, phase_lost[RB_MAX_PHASES] = { 0 };
+    double ring_y[RB_GROUPS][RB_RINGS] = { { 0 } }, ring_lost[RB_GROUPS][RB_RINGS] = { { 0 } };
+    double critical_y[RB_GROUPS] = { 0 }, critical_lost[RB_GROUPS] = { 0 };
+    double y = 0.0, lost_s = 0.0;
+
+    for(uint8_t i = 0; i < plan->head_count; i++)
+    {
+        double head_y = flow_vph[i] / params->saturation_vph;
+        if(head_y > phase_y[plan->heads[i].phase]) phase_y[plan->heads[i].phase] = head_y;
+    }
+    for(uint8_t i = 0; i < plan->phase_count; i++)
+    {
+        double yellow_s = sim_plan->rb_phases[i].yellow_ds / 10.0;
+        double used_s = (params->yellow_used_s < yellow_s) ? params->yellow_used_s : yellow_s;
+        phase_lost[i] = params->startup_lost_s + yellow_s - used_s + sim_plan->rb_phases[i].red_clear_ds / 10.0;
+    }
+    for(uint8_t g = 0; g < RB_GROUPS; g++)
+    {
+        for(uint8_t r = 0; r < RB_RINGS; r++)
+        {
+            for(uint8_t s = 0; s < RB_GROUP_SLOTS; s++)
+            {
+                uint8_t phase = plan->sequence[r][g][s];
+                if(phase == RB_NO_PHASE) continue;
+                ring_y[g][r] += phase_y[phase];
+                ring_lost[g][r] += phase_lost[phase];
+            }
+            if(ring_y[g][r] > critical_y[g] || (ring_y[g][r] == critical_y[g] && ring_lost[g][r] > critical_lost[g]))
+            {
+                critical_y[g] = ring_y[g][r];
+                critical_lost[g] = ring_lost[g][r];
+            }
+        }
+        y += critical_y[g];
+        lost_s += critical_lost[g];
+    }
+
+    double effective_s = webster_cycle(lost_s, y) - lost_s;
+    for(uint8_t g = 0; g < RB_GROUPS; g++)
+    {
+        double group_s = critical_lost[g] + effective_s * ((y > 0.0) ? critical_y[g] / y : 1.0 / RB_GROUPS);
+        for(uint8_t r = 0; r < RB_RINGS; r++)
+        {
+            uint8_t phases = 0;
+            for(uint8_t s = 0; s < RB_GROUP_SLOTS; s++) phases += (plan->sequence[r][g][s] != RB_NO_PHASE);
+            for(uint8_t s = 0; s < RB_GROUP_SLOTS; s++)
+            {
+                uint8_t phase = plan->sequence[r][g][s];
+                if(phase == RB_NO_PHASE) continue;
+                double share = (ring_y[g][r] > 0.0) ? phase_y[phase] / ring_y[g][r] : 1.0 / phases;
+                double green_s = (group_s - ring_lost[g][r]) * share + phase_lost[phase] -
+                    sim_plan->rb_phases[phase].yellow_ds / 10.0 - sim_plan->rb_phases[phase].red_clear_ds / 10.0;
+                set_green(sim_plan, phase, green_s * 10.0);
+            }
+        }
+    }
+    fit_cycle(sim_plan);
+    return true;
+}
+
+/**
+ * @brief Simula um plano e calcula o critério
+ */
+static void evaluate(microsim_t *sim, candidate_t *candidate, const double *flow_vph, const microsim_params_t *params,
+    double hours, double warmup_min)
+{
+    uint64_t queue_ms = 0, overflow = 0, arrivals = 0, delay_ms = 0, departures = 0;
+
+    sim_plan_init_sim(sim, &candidate->plan, flow_vph, params);
+    microsim_run(sim, (uint64_t) (warmup_min * 60000.0));
+    microsim_reset_stats(sim);
+    microsim_run(sim, (uint64_t) (hours * 3600000.0));
+    for(uint8_t i = 0; i < sim->count; i++)
+    {
+        const microsim_stats_t *stats = &sim->approaches[i].stats;
+        queue_ms += stats->queue_ms;
+        overflow += stats->overflow;
+        arrivals += stats->arrivals;
+        delay_ms += stats->delay_ms;
+        departures += stats->departures;
+    }
+    candidate->objective_s = arrivals
+        ? ((double) queue_ms + (double) overflow * OVERFLOW_DELAY_MS) / 1000.0 / (double) arrivals : 0.0;
+    candidate->delay_s = departures ? (double) delay_ms / 1000.0 / (double) departures : 0.0;
+}
+
+static void *batch_worker(void *arg)
+{
+    batch_t *batch = arg;
+    microsim_t *sim = malloc(sizeof(microsim_t));
+
+    if(!sim) return NULL;
+    for(int i; (i = atomic_fetch_add(&batch->next, 1)) < batch->count; )
+        evaluate(sim, &batch->candidates[i], batch->flow_vph, batch->params, batch->hours, batch->warmup_min);
+    free(sim);
+    return NULL;
+}
+
+/**
+ * @brief Avalia os candidatos em paralelo
+ */
+static void evaluate_batch(candidate_t *candidates, int count, int threads, const double *flow_vph,
+    const microsim_params_t *params, double hours, double warmup_min)
+{
+    batch_t batch = { candidates, count, 0, flow_vph, params, hours, warmup_min };
+    pthread_t workers[MAX_THREADS];
+    int started = 0;
+
+    if(threads > count) threads = count;
+    for(; started < threads; started++)
+        if(pthread_create(&workers[started], NULL, batch_worker, &batch) != 0) break;
+    if(started == 0) batch_worker(&batch);
+    for(int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+    if(atomic_load(&batch.next) < count) batch_worker(&batch);  // Sem memória nas threads
+}
+
+/**
+ * @brief Variáveis da busca: o padrão de cada fase atendida, o máximo das
+ *        atuadas e, no cruzamento coordenado, o ciclo
+ *
+ * @return Quantidade.
+ */
+static int search_variables(const sim_plan_t *sim_plan, variable_t *variables)
+{
+    int count = 0;
+
+    if(!sim_plan->intersection)
+    {
+        uint8_t stages[3];
+        single_stages(sim_plan, &stages[0], &stages[1], &stages[2]);
+        for(int i = 0; i < 3; i += 2)
+        {
+            variables[count++] = (variable_t) { stages[i], VARIABLE_DEFAULT };
+            if(sim_plan->phases[stages[i]].detector != PHASE_NO_DETECTOR)
+                variables[count++] = (variable_t) { stages[i], VARIABLE_MAX };
+        }
+        return count;
+    }
+    for(uint8_t i = 0; i < sim_plan->rb_plan.phase_count; i++)
+    {
+        variables[count++] = (variable_t) { i, VARIABLE_DEFAULT };
+        if(sim_plan->rb_phases[i].detector != RB_NO_DETECTOR) variables[count++] = (variable_t) { i, VARIABLE_MAX };
+    }
+    if(sim_plan->rb_plan.cycle_ds) variables[count++] = (variable_t) { 0, VARIABLE_CYCLE };
+    return count;
+}
+
+/**
+ * @brief Vizinho: a variável mais @p delta, mantendo mínimo <= padrão <= máximo
+ *
+ * @return false se o valor não muda ou o plano fica inválido.
+ */
+static bool neighbour(const sim_plan_t *center, const variable_t *variable, int delta, sim_plan_t *out)
+{
+    uint16_t durations[3];
+
+    sim_plan_copy(out, center);
+    if(variable->which == VARIABLE_CYCLE)
+    {
+        // O ciclo cabe ao menos os verdes mínimos de todas as fases
+        int cycle = out->rb_plan.cycle_ds + delta, low = plan_cycle_length(out, true);
+        if(cycle < low) cycle = low;
+        if(cycle > RB_MAX_CYCLE_DS) cycle = RB_MAX_CYCLE_DS;
+        if(cycle == out->rb_plan.cycle_ds) return false;
+        sim_plan_set_cycle(out, (uint16_t) cycle);
+        return sim_plan_is_valid(out);
+    }
+    sim_plan_get_durations(out, variable->phase, durations);
+    int value = durations[variable->which] + delta;
+    // O padrão fica entre o mínimo e o limite; o máximo, entre o padrão e o limite
+    int low = (variable->which == VARIABLE_DEFAULT) ? durations[0] : durations[2];
+    if(value < low) value = low;
+    if(value > duration_bound(out)) value = duration_bound(out);
+    if(value == durations[variable->which]) return false;
+    durations[variable->which] = (uint16_t) value;
+    if(durations[1] < durations[2]) durations[1] = durations[2];
+    sim_plan_set_durations(out, variable->phase, durations);
+    if(!out->intersection) fit_cycle(out);
+    return sim_plan_is_valid(out);
+}
+
+/**
+ * @brief Busca por padrões a partir de @p best, que termina com o melhor plano
+ */
+static void pattern_search(candidate_t *best, int threads, const double *flow_vph, const microsim_params_t *params,
+    double hours, double warmup_min)
+{
+    static candidate_t candidates[2 * MAX_VARIABLES];
+    variable_t variables[MAX_VARIABLES];
+    int variable_count = search_variables(&best->plan, variables);
+    int step = best->plan.intersection ? 40 : 2;
+    int min_step = best->plan.intersection ? 5 : 1;
+
+    for(int iteration = 0; iteration < MAX_ITERATIONS && step >= min_step; iteration++)
+    {
+        int count = 0;
+        for(int i = 0; i < variable_count; i++)
+            for(int sign = -1; sign <= 1; sign += 2)
+                if(neighbour(&best->plan, &variables[i], sign * step, &candidates[count].plan)) count++;
+        evaluate_batch(candidates, count, threads, flow_vph, params, hours, warmup_min);
+
+        int chosen = -1;
+        for(int i = 0; i < count; i++)
+            if(candidates[i].objective_s < best->objective_s - 1e-9 &&
+                (chosen < 0 || candidates[i].objective_s < candidates[chosen].objective_s)) chosen = i;
+        printf("  passo %d: %d vizinhos, %s %.2f s/veic\n", step, count,
+            (chosen >= 0) ? "melhor" : "sem melhora,", (chosen >= 0) ? candidates[chosen].objective_s : best->objective_s);
+        if(chosen < 0)
+        {
+            step /= 2;
+            continue;
+        }
+        best->objective_s = candidates[chosen].objective_s;
+        best->delay_s = candidates[chosen].delay_s;
+        sim_plan_copy(&best->plan, &candidates[chosen].plan);
+    }
+}
+
+static const char *signal_name(uint8_t signal)
+{
+    static const char *const NAMES[] = { "PHASE_SIGNAL_YELLOW", "PHASE_SIGNAL_GREEN", "PHASE_SIGNAL_RED" };
+    return (signal < 3) ? NAMES[signal] : "?";
+}
+
+static const char *ped_name(uint8_t ped)
+{
+    static const char *const NAMES[] = { "PHASE_PED_DONT_WALK", "PHASE_PED_WALK", "PHASE_PED_CLEARANCE" };
+    return (ped < 3) ? NAMES[ped] : "?";
+}
+
+/**
+ * @brief Tabela de fases e ciclo no formato de lib/phase_plans.c
+ */
+static void print_table(const sim_plan_t *sim_plan)
+{
+    char name[32], detector[20];
+
+    if(sim_plan->intersection)
+    {
+        printf("    //          name                min   max  green yellow red  passage detector          recall\n");
+        for(uint8_t i = 0; i < sim_plan->rb_plan.phase_count; i++)
+        {
+            const rb_phase_def_t *phase = &sim_plan->rb_phases[i];
+            snprintf(name, sizeof(name), "\"%s\",", phase->name);
+            if(phase->detector == RB_NO_DETECTOR) snprintf(detector, sizeof(detector), "RB_NO_DETECTOR,");
+            else snprintf(detector, sizeof(detector), "%u,", phase->detector);
+            printf("    [%u] = { %-18s %4u, %4u, %4u, %4u, %4u, %4u,  %-17s %-5s },\n", i, name,
+                phase->min_green_ds, phase->max_green_ds, phase->green_ds, phase->yellow_ds, phase->red_clear_ds,
+                phase->passage_ds, detector, phase->recall ? "true" : "false");
+        }
+        printf("    .cycle_ds = %u,\n", sim_plan->rb_plan.cycle_ds);
+        return;
+    }
+    for(uint8_t i = 0; i < sim_plan->plan.count; i++)
+    {
+        const phase_def_t *phase = &sim_plan->phases[i];
+        char call[16];
+        snprintf(name, sizeof(name), "\"%s\",", phase->name);
+        if(phase->call == PHASE_NO_CALL) snprintf(call, sizeof(call), "PHASE_NO_CALL");
+        else snprintf(call, sizeof(call), "%u", phase->call);
+        if(phase->detector == PHASE_NO_DETECTOR) snprintf(detector, sizeof(detector), "PHASE_NO_DETECTOR");
+        else snprintf(detector, sizeof(detector), "%u", phase->detector);
+        printf("    [%u] = { %-12s %s, %s, %u, %s, %u, %s, %2u, %2u, %2u, %u },\n", i, name,
+            signal_name(phase->signal), ped_name(phase->ped), phase->next, call, phase->call_next, detector,
+            phase->min_s, phase->max_s, phase->default_s, phase->passage_s);
+    }
+    printf("    .cycle_s = %u,\n", sim_plan->plan.cycle_s);
+}
+
+/**
+ * @brief Comandos duracao das fases que mudaram
+ */
+static void print_commands(const sim_plan_t *current, const sim_plan_t *optimized)
+{
+    for(uint8_t i = 0; i < sim_plan_phase_count(optimized); i++)
+    {
+        uint16_t before[3], after[3];
+        sim_plan_get_durations(current, i, before);
+        sim_plan_get_durations(optimized, i, after);
+        if(memcmp(before, after, sizeof(before)) != 0) printf("duracao %u %u %u %u\n", i, after[0], after[1], after[2]);
+    }
+    if(sim_plan_cycle(current) != sim_plan_cycle(optimized))
+        printf("# o ciclo (%u -> %u) so muda na tabela do firmware; com o ciclo antigo a coordenacao\n"
+            "# estica ou encurta as fases para caber nele\n", sim_plan_cycle(current), sim_plan_cycle(optimized));
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option OPTIONS[] = {
+        { "arrivals",     required_argument, NULL, 'a' },
+        { "peak",         no_argument,       NULL, 'k' },
+        { "flow",         required_argument, NULL, 'f' },
+        { "intersection", no_argument,       NULL, 'i' },
+        { "turn-flow",    required_argument, NULL, 't' },
+        { "peds",         required_argument, NULL, 'p' },
+        { "free",         no_argument,       NULL, 'c' },
+        { "hours",        required_argument, NULL, 'h' },
+        { "check-hours",  required_argument, NULL, 'v' },
+        { "warmup",       required_argument, NULL, 'w' },
+        { "saturation",   required_argument, NULL, 's' },
+        { "lost",         required_argument, NULL, 'l' },
+        { "yellow-used",  required_argument, NULL, 'y' },
+        { "seed",         required_argument, NULL, 'r' },
+        { "threads",      required_argument, NULL, 'j' },
+        { NULL, 0, NULL, 0 },
+    };
+    microsim_params_t params = {
+        .saturation_vph = 1800.0,
+        .startup_lost_s = 2.0,
+        .yellow_used_s = 2.0,
+        .ped_per_hour = 0.0,
+        .seed = 1,
+        .time_synced = true,  // Os ciclos otimizados são os coordenados, com a hora do host
+    };
+    double flow_vph[MICROSIM_MAX_APPROACHES];
+    double hours = DEFAULT_HOURS, check_hours = DEFAULT_CHECK_HOURS, warmup_min = DEFAULT_WARMUP_MIN;
+    double turn_vph = DEFAULT_TURN_VPH, peds = -1.0;
+    const char *arrivals_path = NULL;
+    int flow_count = 0;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    bool intersection = false, peak = false, free_cycle = false;
+    int option;
+
+    while((option = getopt_long(argc, argv, "", OPTIONS, NULL)) != -1)
+    {
+        switch(option)
+        {
+            case 'a': arrivals_path = optarg; break;
+            case 'k': peak = true; break;
+            case 'f': flow_count = parse_list(optarg, flow_vph, MICROSIM_MAX_APPROACHES, argv[0]); break;
+            case 'i': intersection = true; break;
+            case 't': turn_vph = parse_number(optarg, argv[0]); break;
+            case 'p': peds = parse_number(optarg, argv[0]); break;
+            case 'c': free_cycle = true; break;
+            case 'h': hours = parse_number(optarg, argv[0]); break;
+            case 'v': check_hours = parse_number(optarg, argv[0]); break;
+            case 'w': warmup_min = parse_number(optarg, argv[0]); break;
+            case 's': params.saturation_vph = parse_number(optarg, argv[0]); break;
+            case 'l': params.startup_lost_s = parse_number(optarg, argv[0]); break;
+            case 'y': params.yellow_used_s = parse_number(optarg, argv[0]); break;
+            case 'r': params.seed = (uint64_t) parse_number(optarg, argv[0]); break;
+            case 'j': threads = (long) parse_number(optarg, argv[0]); break;
+            default: usage(argv[0]);
+        }
+    }
+    if(optind != argc || (!arrivals_path == !flow_count) || hours <= 0.0 || check_hours <= 0.0 ||
+        params.saturation_vph <= 0.0) usage(argv[0]);
+    if(threads < 1) threads = 1;
+    if(threads > MAX_THREADS) threads = MAX_THREADS;
+
+    static candidate_t current, webster, optimized;
+    sim_plan_load(&current.plan, intersection);
+    if(free_cycle) sim_plan_make_free(&current.plan);
+    uint8_t approaches = sim_plan_approaches(&current.plan);
+    if(arrivals_path)
+    {
+        arrival_counts_t counts;
+        if(!read_arrivals(arrivals_path, peak, &counts))
+        {
+            fprintf(stderr, "erro: sem chegadas em %s\n", arrivals_path);
+            return 1;
+        }
+        flows_from_counts(&current.plan, &counts, turn_vph, flow_vph);
+        if(peds < 0.0) peds = (double) counts.pedestrians * 3600000.0 / counts.span_ms;
+        printf("chegadas de %s: %.1f h%s\n", arrivals_path, counts.span_ms / 3600000.0,
+            peak ? " (hora mais carregada)" : "");
+        if(counts.span_ms < 900000.0) fprintf(stderr, "aviso: menos de 15 minutos gravados, fluxos imprecisos\n");
+    }
+    else if(flow_count != approaches)
+    {
+        fprintf(stderr, "erro: o plano tem %u aproximacoes\n", approaches);
+        return 2;
+    }
+    params.ped_per_hour = (peds > 0.0) ? peds : 0.0;
+
+    static microsim_t sim;
+    sim_plan_init_sim(&sim, &current.plan, flow_vph, &params);
+    printf("fluxos (veiculos/h):");
+    for(uint8_t i = 0; i < approaches; i++) printf("%s %s %.0f", i ? "," : "", sim.approaches[i].name, flow_vph[i]);
+    printf("; pedestres %.1f/h\n", params.ped_per_hour);
+
+    sim_plan_copy(&webster.plan, &current.plan);
+    if(!(intersection ? webster_intersection : webster_single)(&webster.plan, flow_vph, &params) ||
+        !sim_plan_is_valid(&webster.plan))
+    {
+        fprintf(stderr, "erro: o plano nao tem os estagios esperados\n");
+        return 1;
+    }
+    candidate_t starts[2];
+    starts[0] = current;
+    starts[1] = webster;
+    sim_plan_copy(&starts[0].plan, &current.plan);
+    sim_plan_copy(&starts[1].plan, &webster.plan);
+    evaluate_batch(starts, 2, (int) threads, flow_vph, &params, hours, warmup_min);
+    printf("atual:   %.2f s/veic\n", starts[0].objective_s);
+    printf("webster: %.2f s/veic\n", starts[1].objective_s);
+    sim_plan_print(&webster.plan);
+
+    // A busca parte do melhor dos dois
+    optimized = starts[(starts[1].objective_s <= starts[0].objective_s) ? 1 : 0];
+    sim_plan_copy(&optimized.plan, &starts[(starts[1].objective_s <= starts[0].objective_s) ? 1 : 0].plan);
+    printf("busca (%.0f h por plano, %ld threads):\n", hours, threads);
+    pattern_search(&optimized, (int) threads, flow_vph, &params, hours, warmup_min);
+
+    // Conferência com outras chegadas
+    candidate_t check[3];
+    sim_plan_copy(&check[0].plan, &current.plan);
+    sim_plan_copy(&check[1].plan, &webster.plan);
+    sim_plan_copy(&check[2].plan, &optimized.plan);
+    params.seed++;
+    evaluate_batch(check, 3, (int) threads, flow_vph, &params, check_hours, warmup_min);
+    printf("\nconferencia (%.0f h, semente %llu), atraso por chegada / por veiculo atendido:\n", check_hours,
+        (unsigned long long) params.seed);
+    printf("  atual      %.2f / %.2f s\n", check[0].objective_s, check[0].delay_s);
+    printf("  webster    %.2f / %.2f s\n", check[1].objective_s, check[1].delay_s);
+    printf("  otimizado  %.2f / %.2f s (%+.1f%% sobre o atual)\n", check[2].objective_s, check[2].delay_s,
+        check[0].objective_s > 0.0 ? (check[2].objective_s - check[0].objective_s) / check[0].objective_s * 100.0 : 0.0);
+    sim_plan_print(&optimized.plan);
+
+    printf("\ntabela de fases (lib/phase_plans.c, %s):\n", intersection ? "RB_DEFAULT_PHASES e RB_PLAN_DEFAULT"
+                                                                         : "DEFAULT_PHASES e PHASE_PLAN_DEFAULT");
+    print_table(&optimized.plan);
+    printf("\ncomandos do shell:\n");
+    print_commands(&current.plan, &optimized.plan);
+    return 0;
+}
@@ -0,0 +1,253 @@
+/**
+ * @file phase_engine_test.c
+ * @brief Testes do motor de fases (lib/phase_engine) com relógio virtual, no Linux.
+ *
+ * O relógio é só o argumento em ms passado ao motor, então cada caso roda
+ * na hora: a sequência 9/3/6 do plano padrão em tempo fixo, a volta do
+ * relógio de 32 bits, chamadas atrasadas (várias fases expiradas num update,
+ * sem acumular o atraso), a limitação da duração a [min_s, max_s], a retomada
+ * após um reset, a travessia de pedestre com o ciclo ancorado na hora, o plano
+ * padrão livre e atuado até a hora chegar e a extensão por detector.
+ *
+ * Compilação e uso (da raiz do repositório):
+ *
+ *     gcc -std=c11 -O2 -Ilib -o phase_engine_test tools/sim/phase_engine_test.c lib/phase_engine.c \
+ *         lib/phase_plans.c lib/coordination.c
+ *     ./phase_engine_test
+ *
+ * Sai com 0 se todos os casos passam.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+#include "phase_engine.h"
+#include "phase_plans.h"
+#include <stdio.h>
+
+// Índices das fases do plano padrão (lib/phase_plans.c)
+enum { GREEN, YELLOW, RED, WALK, PED_CLEAR };
+
+static unsigned checks, failures;
+static phase_def_t fixed_phases[PHASE_ENGINE_MAX_PHASES];
+static phase_plan_t fixed_plan;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+
+static void check(bool ok, const char *what, int line)
+{
+    checks++;
+    if(ok) return;
+    failures++;
+    printf("  falhou (linha %d): %s\n", line, what);
+}
+
+/**
+ * @brief Avança em passos de @p step_ms até @p until_ms e confere cada transição.
+ *
+ * @param expected Fases esperadas, a partir da seguinte à atual.
+ * @param at_ms Início esperado de cada uma (relativo a @p base_ms).
+ * @return Transições vistas.
+ */
+static unsigned run_sequence(phase_engine_t *engine, uint32_t base_ms, uint32_t until_ms, uint32_t step_ms,
+    const uint8_t *expected, const uint32_t *at_ms, unsigned count)
+{
+    unsigned seen = 0;
+    for(uint32_t t = 0; t <= until_ms; t += step_ms)
+    {
+        uint32_t n = phase_engine_update(engine, base_ms + t);
+        CHECK(n <= 1);
+        if(!n) continue;
+        if(seen < count)
+        {
+            CHECK(engine->phase == expected[seen]);
+            CHECK(engine->start_ms == base_ms + at_ms[seen]);
+        }
+        seen++;
+    }
+    return seen;
+}
+
+/**
+ * @brief O plano padrão em tempo fixo: sem detectores, cada fase na duração padrão.
+ */
+static const phase_plan_t *fixed_time_plan(void)
+{
+    fixed_plan = PHASE_PLAN_DEFAULT;
+    for(uint8_t i = 0; i < fixed_plan.count; i++)
+    {
+        fixed_phases[i] = PHASE_PLAN_DEFAULT.phases[i];
+        fixed_phases[i].detector = PHASE_NO_DETECTOR;
+    }
+    fixed_plan.phases = fixed_phases;
+    return &fixed_plan;
+}
+
+static void test_fixed_sequence(void)
+{
+    static const uint8_t phases[] = { YELLOW, RED, GREEN, YELLOW, RED, GREEN };
+    static const uint32_t at_ms[] = { 9000, 12000, 18000, 27000, 30000, 36000 };
+    phase_engine_t engine;
+
+    printf("sequencia 9/3/6\n");
+    phase_engine_start(&engine, fixed_time_plan(), 0);
+    CHECK(engine.phase == GREEN);
+    CHECK(phase_engine_remaining_s(&engine, 0) == 9);
+    CHECK(phase_engine_remaining_s(&engine, 8001) == 1);
+    CHECK(run_sequence(&engine, 0, 36000, 100, phases, at_ms, 6) == 6);
+    CHECK(engine.transitions == 6);
+}
+
+static void test_clock_wrap(void)
+{
+    static const uint8_t phases[] = { YELLOW, RED, GREEN, YELLOW };
+    static const uint32_t at_ms[] = { 9000, 12000, 18000, 27000 };
+    uint32_t base_ms = UINT32_MAX - 10000u;  // O amarelo começa antes da volta, o vermelho depois
+    phase_engine_t engine;
+
+    printf("volta do relogio de 32 bits\n");
+    phase_engine_start(&engine, fixed_time_plan(), base_ms);
+    CHECK(run_sequence(&engine, base_ms, 27000, 250, phases, at_ms, 4) == 4);
+    CHECK(engine.start_ms < base_ms);  // Já deu a volta
+}
+
+static void test_late_update(void)
+{
+    phase_engine_t engine;
+
+    printf("update atrasado\n");
+    phase_engine_start(&engine, fixed_time_plan(), 1000);
+    // 25 s sem update: amarelo, vermelho e verde expiram de uma vez
+    CHECK(phase_engine_update(&engine, 1000 + 25000) == 3);
+    CHECK(engine.phase == GREEN);
+    CHECK(engine.start_ms == 1000 + 18000);  // Início exato, sem o atraso de quem chama
+    CHECK(phase_engine_remaining_s(&engine, 1000 + 25000) == 2);
+    // Um update 1 ms antes do fim não troca; no fim, troca
+    CHECK(phase_engine_update(&engine, 1000 + 26999) == 0);
+    CHECK(phase_engine_update(&engine, 1000 + 27000) == 1);
+    CHECK(engine.phase == YELLOW);
+}
+
+static void test_clamping(void)
+{
+    phase_engine_t engine;
+
+    printf("limites da duracao\n");
+    phase_engine_start(&engine, &PHASE_PLAN_DEFAULT, 0);
+    phase_engine_set_duration(&engine, 100);
+    CHECK(engine.duration_ms == 9000);  // max_s do verde
+    phase_engine_set_duration(&engine, 0);
+    CHECK(engine.duration_ms == 4000);  // min_s do verde
+    phase_engine_set_duration(&engine, 6);
+    CHECK(engine.duration_ms == 6000);
+    CHECK(phase_engine_update(&engine, 6000) == 1);
+    CHECK(engine.phase == YELLOW);
+    phase_engine_set_duration(&engine, 9);
+    CHECK(engine.duration_ms == 3000);  // Amarelo fixo em 3 s
+}
+
+static void test_resume(void)
+{
+    phase_engine_t engine;
+
+    printf("retomada\n");
+    CHECK(phase_engine_resume(&engine, &PHASE_PLAN_DEFAULT, RED, 2, 5000));
+    CHECK(engine.phase == RED);
+    CHECK(phase_engine_remaining_s(&engine, 5000) == 2);
+    CHECK(phase_engine_update(&engine, 6999) == 0);
+    CHECK(phase_engine_update(&engine, 7000) == 1);
+    CHECK(engine.phase == GREEN);
+    CHECK(engine.start_ms == 7000);
+    // Mais que a duração padrão, até max_s
+    CHECK(phase_engine_resume(&engine, &PHASE_PLAN_DEFAULT, RED, 8, 0));
+    CHECK(phase_engine_remaining_s(&engine, 0) == 8);
+    // Inválidos
+    CHECK(!phase_engine_resume(&engine, &PHASE_PLAN_DEFAULT, RED, 0, 0));
+    CHECK(!phase_engine_resume(&engine, &PHASE_PLAN_DEFAULT, RED, 10, 0));
+    CHECK(!phase_engine_resume(&engine, &PHASE_PLAN_DEFAULT, PHASE_PLAN_DEFAULT.count, 1, 0));
+}
+
+static void test_pedestrian(void)
+{
+    // O ciclo com a travessia tem 24 s; a coordenação (ciclo de 18 s) encurta
+    // as fases seguintes dentro de [min_s, max_s] e volta à grade em 36 s
+    static const uint8_t phases[] = { YELLOW, WALK, PED_CLEAR, GREEN, YELLOW, RED, GREEN, YELLOW, RED, GREEN };
+    static const uint32_t at_ms[] = { 9000, 12000, 17000, 24000, 28000, 31000, 36000, 45000, 48000, 54000 };
+    phase_engine_t engine;
+
+    printf("travessia de pedestre\n");
+    phase_engine_start(&engine, fixed_time_plan(), 0);
+    phase_engine_set_time(&engine, 0, 0);  // Ciclo ancorado na hora: coordenado
+    phase_engine_call(&engine, PHASE_PLAN_DEFAULT.pedestrian_call);
+    CHECK(run_sequence(&engine, 0, 54000, 100, phases, at_ms, 10) == 10);
+    CHECK(engine.calls == 0);  // A chamada foi atendida uma vez só
+    CHECK(engine.start_ms % (PHASE_PLAN_DEFAULT.cycle_s * 1000u) == 0);
+}
+
+static void test_free_until_synced(void)
+{
+    // Sem tráfego e sem hora, o plano padrão roda livre: 4/3/3 (gap-out no mínimo)
+    static const uint8_t free_phases[] = { YELLOW, RED, GREEN, YELLOW, RED, GREEN };
+    static const uint32_t free_at_ms[] = { 4000, 7000, 10000, 14000, 17000, 20000 };
+    // A hora chega no início de um verde livre (4 s): o vermelho já é
+    // coordenado, o verde seguinte fica 5 s atrasado e a correção estica o
+    // vermelho até o máximo (o verde já está no máximo) em dois ciclos
+    static const uint8_t synced_phases[] = { YELLOW, RED, GREEN, YELLOW, RED, GREEN, YELLOW, RED, GREEN,
+        YELLOW, RED, GREEN };
+    static const uint32_t synced_at_ms[] = { 4000, 7000, 13000, 22000, 25000, 34000, 43000, 46000, 54000,
+        63000, 66000, 72000 };
+    phase_engine_t engine;
+
+    printf("plano livre ate a hora chegar\n");
+    phase_engine_start(&engine, &PHASE_PLAN_DEFAULT, 0);
+    CHECK(!coord_active(&engine.coord));
+    CHECK(engine.duration_ms == 4000);
+    CHECK(run_sequence(&engine, 0, 20000, 100, free_phases, free_at_ms, 6) == 6);
+    CHECK(engine.gap_outs == 4 && engine.max_outs == 0);
+    phase_engine_start(&engine, &PHASE_PLAN_DEFAULT, 100000);
+    phase_engine_set_time(&engine, 0, 100000);
+    CHECK(coord_active(&engine.coord));
+    CHECK(engine.duration_ms == 4000);  // A fase em curso não muda
+    CHECK(run_sequence(&engine, 100000, 72000, 100, synced_phases, synced_at_ms, 12) == 12);
+    CHECK(engine.coord.last_error_ms == 0);
+}
+
+static void test_actuated(void)
+{
+    phase_plan_t plan = PHASE_PLAN_DEFAULT;
+    phase_engine_t engine;
+
+    printf("extensao por detector (plano livre)\n");
+    plan.cycle_s = 0;
+    phase_engine_start(&engine, &plan, 0);
+    CHECK(engine.duration_ms == 4000);  // Verde atuado começa no mínimo
+    // Presença aos 3 s: termina aos 3 + 2 = 5 s (gap-out)
+    phase_engine_presence(&engine, 1u << 0, 3000);
+    CHECK(engine.duration_ms == 5000);
+    // Presença do outro detector não estende o verde
+    phase_engine_presence(&engine, 1u << 1, 4500);
+    CHECK(engine.duration_ms == 5000);
+    CHECK(phase_engine_update(&engine, 5000) == 1);
+    CHECK(engine.gap_outs == 1 && engine.max_outs == 0);
+    CHECK(phase_engine_update(&engine, 8000) == 1);
+    CHECK(engine.phase == RED);
+    // Presença contínua no vermelho: vai até max_s (9 s, max-out)
+    for(uint32_t t = 8000; t < 8000 + 9000; t += 500) phase_engine_presence(&engine, 1u << 1, t);
+    CHECK(engine.duration_ms == 9000);
+    CHECK(phase_engine_update(&engine, 17000) == 1);
+    CHECK(engine.max_outs == 1);
+}
+
+int main(void)
+{
+    CHECK(phase_plan_is_valid(&PHASE_PLAN_DEFAULT));
+    test_fixed_sequence();
+    test_clock_wrap();
+    test_late_update();
+    test_clamping();
+    test_resume();
+    test_pedestrian();
+    test_free_until_synced();
+    test_actuated();
+    printf("%u verificacoes, %u falhas\n", checks, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,343 @@
+/**
+ * @file replay_inputs.c
+ * @brief Reproduz o log de entradas do controlador (lib/input_log.h) no Linux.
+ *
+ * Restaura o plano e o controlador do ponto de verificação do bloco mais
+ * antigo e refaz, com o mesmo código do firmware (lib/phase_engine.c ou
+ * lib/ring_barrier.c), cada chamada gravada: avanços, presença, chamadas,
+ * preempção, hora do host, troca de plano e durações. Cada saída calculada é comparada com a
+ * gravada pelo firmware e o estado, com o ponto de verificação de cada bloco
+ * seguinte. O relógio é só o dos registros, então a reprodução roda o mais
+ * rápido possível.
+ *
+ * Compilação (da raiz do repositório):
+ *
+ *     gcc -std=c11 -O2 -Ilib -Itools/sim -o replay_inputs tools/sim/replay_inputs.c tools/sim/sim_plan.c \
+ *         tools/sim/microsim.c lib/input_log.c lib/phase_engine.c lib/phase_plans.c lib/ring_barrier.c \
+ *         lib/coordination.c -lm
+ *
+ * Uso:
+ *
+ *     python3 tools/input_log.py /dev/ttyACM0 --save entradas.bin
+ *     ./replay_inputs entradas.bin
+ *     ./replay_inputs --trace entradas.bin > saidas.txt
+ *
+ * Com --trace, cada entrada e cada saída sai numa linha, com o relógio do
+ * controlador (e o µs das entradas externas). Termina com 1 se alguma saída
+ * ou ponto de verificação diverge.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sim_plan.h"
+#include "input_log.h"
+
+#define MAX_BLOCKS 256
+
+static const char *const KIND_NAMES[INPUT_LOG_KIND_COUNT] = {
+    [INPUT_LOG_UPDATE] = "avanco",
+    [INPUT_LOG_PRESENCE] = "presenca",
+    [INPUT_LOG_CALL] = "chamada",
+    [INPUT_LOG_START] = "partida",
+    [INPUT_LOG_RESUME] = "retomada",
+    [INPUT_LOG_SET_TIME] = "hora",
+    [INPUT_LOG_DURATIONS] = "duracao",
+    [INPUT_LOG_PREEMPT] = "preempcao",
+    [INPUT_LOG_EXPIRE] = "expira",
+    [INPUT_LOG_OUTPUT] = "saida",
+    [INPUT_LOG_PLAN] = "plano",
+};
+
+/**
+ * @brief Controlador reproduzido e contadores da conferência.
+ */
+typedef struct {
+    sim_plan_t plan;
+    phase_engine_t engine;
+    rb_controller_t ctrl;
+    bool trace;
+    bool output_pending;        // A última transição ainda não teve o registro de saída
+    uint8_t output_arg;
+    uint32_t output_value;
+    uint64_t records;
+    uint64_t updates;
+    uint64_t inputs;
+    uint64_t outputs;
+    uint64_t output_errors;
+    uint32_t checkpoints;
+    uint32_t checkpoint_errors;
+    uint32_t gaps;
+} replay_t;
+
+static replay_t g_replay;
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+        "uso: %s [--trace] entradas.bin\n"
+        "  --trace   mostra cada entrada e cada saida, com o relogio do controlador\n",
+        program);
+    exit(2);
+}
+
+static double elapsed_s(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - start->tv_sec) + (double) (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static bool restore(replay_t *replay, const input_log_reader_t *reader)
+{
+    sim_plan_select(&replay->plan, reader->plan_id);
+    if(replay->plan.intersection)
+        return input_log_restore_rb(reader, &replay->plan.rb_plan, replay->plan.rb_phases, &replay->ctrl);
+    return input_log_restore_engine(reader, &replay->plan.plan, replay->plan.phases, &replay->engine);
+}
+
+static bool check(const replay_t *replay, const input_log_reader_t *reader)
+{
+    if(replay->plan.intersection) return input_log_check_rb(reader, &replay->plan.rb_plan, &replay->ctrl);
+    return input_log_check_engine(reader, &replay->plan.plan, &replay->engine);
+}
+
+/**
+ * @brief Acusa a transição reproduzida que o firmware não teve.
+ */
+static void check_no_output(replay_t *replay, uint32_t now_ms)
+{
+    if(!replay->output_pending) return;
+    printf("%10lu ms  DIVERGE: transicao sem saida gravada\n", (unsigned long) now_ms);
+    replay->output_errors++;
+    replay->output_pending = false;
+}
+
+/**
+ * @brief Um avanço do controlador; guarda a saída se houve transição.
+ */
+static void update(replay_t *replay, uint32_t now_ms)
+{
+    uint32_t transitions;
+
+    check_no_output(replay, now_ms);
+    replay->updates++;
+    if(replay->plan.intersection)
+    {
+        transitions = rb_controller_update(&replay->ctrl, now_ms);
+        if(transitions) replay->output_value = input_log_rb_output(&replay->ctrl, &replay->output_arg);
+    }
+    else
+    {
+        transitions = phase_engine_update(&replay->engine, now_ms);
+        if(transitions) replay->output_value = input_log_engine_output(&replay->engine, &replay->output_arg);
+    }
+    replay->output_pending = transitions != 0;
+}
+
+/**
+ * @brief Compara a saída gravada com a calculada.
+ */
+static void output(replay_t *replay, const input_log_record_t *record)
+{
+    replay->outputs++;
+    if(replay->trace)
+        printf("%10lu ms  saida     %u %08lx\n", (unsigned long) record->time_ms, record->arg,
+            (unsigned long) record->value);
+    if(!replay->output_pending)
+    {
+        printf("%10lu ms  DIVERGE: saida gravada sem transicao\n", (unsigned long) record->time_ms);
+        replay->output_errors++;
+    }
+    else if(record->arg != replay->output_arg || record->value != replay->output_value)
+    {
+        printf("%10lu ms  DIVERGE: saida gravada %u %08lx, reproduzida %u %08lx\n", (unsigned long) record->time_ms,
+            record->arg, (unsigned long) record->value, replay->output_arg, (unsigned long) replay->output_value);
+        replay->output_errors++;
+    }
+    replay->output_pending = false;
+}
+
+/**
+ * @brief Refaz uma entrada gravada (a mesma chamada que o firmware fez).
+ */
+static void input(replay_t *replay, const input_log_record_t *record)
+{
+    sim_plan_t *plan = &replay->plan;
+    uint32_t now_ms = record->time_ms;
+
+    check_no_output(replay, now_ms);
+    replay->inputs++;
+    if(replay->trace)
+    {
+        printf("%10lu ms  %-9s", (unsigned long) now_ms, KIND_NAMES[record->kind]);
+        if(record->kind != INPUT_LOG_EXPIRE) printf(" %llu us", (unsigned long long) record->time_us);
+        if(record->kind == INPUT_LOG_DURATIONS)
+            printf(" %u %u %u %u", record->arg, record->durations[0], record->durations[1], record->durations[2]);
+        else if(record->kind != INPUT_LOG_START && record->kind != INPUT_LOG_EXPIRE)
+            printf(" %u %llu", record->arg, (unsigned long long) record->value);
+        printf("\n");
+    }
+    switch(record->kind)
+    {
+        case INPUT_LOG_PRESENCE:
+            if(plan->intersection) rb_controller_presence(&replay->ctrl, (uint32_t) record->value, now_ms);
+            else phase_engine_presence(&replay->engine, (uint32_t) record->value, now_ms);
+            break;
+        case INPUT_LOG_CALL:
+            if(plan->intersection) rb_controller_call(&replay->ctrl, record->arg);
+            else phase_engine_call(&replay->engine, record->arg);
+            break;
+        case INPUT_LOG_START:
+            if(plan->intersection) rb_controller_start(&replay->ctrl, &plan->rb_plan, now_ms);
+            else phase_engine_start(&replay->engine, &plan->plan, now_ms);
+            break;
+        case INPUT_LOG_RESUME:
+            // Uma retomada recusada é seguida de uma partida, também gravada
+            if(!plan->intersection)
+                phase_engine_resume(&replay->engine, &plan->plan, record->arg, (uint16_t) record->value, now_ms);
+            break;
+        case INPUT_LOG_SET_TIME:
+            if(plan->intersection) rb_controller_set_time(&replay->ctrl, record->value, now_ms);
+            else phase_engine_set_time(&replay->engine, record->value, now_ms);
+            break;
+        case INPUT_LOG_DURATIONS:
+            if(record->arg < sim_plan_phase_count(plan)) sim_plan_set_durations(plan, record->arg, record->durations);
+            break;
+        case INPUT_LOG_PLAN:
+            // As durações alteradas desse plano vêm nos registros seguintes
+            sim_plan_select(plan, record->arg);
+            if(plan->intersection) rb_controller_change_plan(&replay->ctrl, &plan->rb_plan, now_ms);
+            else phase_engine_change_plan(&replay->engine, &plan->plan, now_ms);
+            break;
+        case INPUT_LOG_PREEMPT:
+            if(plan->intersection)
+            {
+                if(record->arg == PHASE_NO_PHASE) rb_controller_preempt_release(&replay->ctrl, now_ms);
+                else rb_controller_preempt(&replay->ctrl, record->arg, now_ms);
+            }
+            else
+            {
+                if(record->arg == PHASE_NO_PHASE) phase_engine_preempt_release(&replay->engine, now_ms);
+                else phase_engine_preempt(&replay->engine, record->arg, now_ms);
+            }
+            break;
+        case INPUT_LOG_EXPIRE:
+            if(!plan->intersection) phase_engine_expire(&replay->engine, now_ms);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Reproduz os registros de um bloco.
+ */
+static void replay_block(replay_t *replay, input_log_reader_t *reader)
+{
+    input_log_record_t record;
+
+    while(input_log_next(reader, &record))
+    {
+        replay->records++;
+        if(record.kind == INPUT_LOG_UPDATE)
+        {
+            uint32_t first_ms = record.time_ms - record.delta_ms * (record.count - 1u);
+            for(uint32_t i = 0; i < record.count; i++) update(replay, first_ms + record.delta_ms * i);
+        }
+        else if(record.kind == INPUT_LOG_OUTPUT) output(replay, &record);
+        else input(replay, &record);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option OPTIONS[] = {
+        { "trace", no_argument, NULL, 't' },
+        { NULL, 0, NULL, 0 },
+    };
+    static uint8_t blocks[MAX_BLOCKS][INPUT_LOG_BLOCK_SIZE];
+    replay_t *replay = &g_replay;
+    input_log_reader_t reader;
+    struct timespec start;
+    uint32_t sequence = 0, first_ms = 0;
+    size_t count;
+    int option;
+
+    while((option = getopt_long(argc, argv, "", OPTIONS, NULL)) != -1)
+    {
+        if(option == 't') replay->trace = true;
+        else usage(argv[0]);
+    }
+    if(optind != argc - 1) usage(argv[0]);
+
+    FILE *file = fopen(argv[optind], "rb");
+    if(!file)
+    {
+        perror(argv[optind]);
+        return 2;
+    }
+    count = fread(blocks, INPUT_LOG_BLOCK_SIZE, MAX_BLOCKS, file);
+    fclose(file);
+    if(count == 0 || !input_log_reader_init(&reader, blocks[0]))
+    {
+        fprintf(stderr, "erro: %s nao comeca com um bloco do log de entradas\n", argv[optind]);
+        return 2;
+    }
+    sim_plan_load(&replay->plan, reader.controller == INPUT_LOG_RING_BARRIER);
+    if(!restore(replay, &reader))
+    {
+        fprintf(stderr, "erro: o log nao e do plano padrao do firmware (lib/phase_plans.c)\n");
+        return 2;
+    }
+    first_ms = reader.time_ms;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(size_t b = 0; b < count; b++)
+    {
+        if(b && !input_log_reader_init(&reader, blocks[b]))
+        {
+            fprintf(stderr, "erro: bloco %zu invalido\n", b);
+            return 2;
+        }
+        if(b && reader.sequence != sequence + 1u)
+        {
+            // Bloco sobrescrito durante o dump: recomeça do ponto de verificação
+            printf("%10lu ms  blocos %lu a %lu perdidos, estado restaurado\n", (unsigned long) reader.time_ms,
+                (unsigned long) (sequence + 1u), (unsigned long) (reader.sequence - 1u));
+            replay->gaps++;
+            replay->output_pending = false;
+            restore(replay, &reader);
+        }
+        else if(b)
+        {
+            replay->checkpoints++;
+            if(!check(replay, &reader))
+            {
+                printf("%10lu ms  DIVERGE: estado diferente do ponto de verificacao do bloco %lu\n",
+                    (unsigned long) reader.time_ms, (unsigned long) reader.sequence);
+                replay->checkpoint_errors++;
+                restore(replay, &reader);
+            }
+        }
+        sequence = reader.sequence;
+        replay_block(replay, &reader);
+    }
+    double wall_s = elapsed_s(&start);
+    double span_s = (double) (reader.time_ms - first_ms) / 1000.0;
+
+    printf("%zu blocos, %llu registros: %llu avancos, %llu entradas\n", count, (unsigned long long) replay->records,
+        (unsigned long long) replay->updates, (unsigned long long) replay->inputs);
+    printf("saidas %llu, divergentes %llu; pontos de verificacao %u, divergentes %u; lacunas %u\n",
+        (unsigned long long) replay->outputs, (unsigned long long) replay->output_errors, replay->checkpoints,
+        replay->checkpoint_errors, replay->gaps);
+    printf("%.1f s de operacao em %.3f ms (%.0fx o tempo real)\n", span_s, wall_s * 1000.0,
+        wall_s > 0.0 ? span_s / wall_s : 0.0);
+    return (replay->output_errors || replay->checkpoint_errors) ? 1 : 0;
+}
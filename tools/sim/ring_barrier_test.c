@@ -0,0 +1,423 @@
+/**
+ * @file ring_barrier_test.c
+ * @brief Testes do controlador de cruzamento (lib/ring_barrier) com relógio virtual, no Linux.
+ *
+ * Em cada tick conferem-se as regras de segurança de anéis e barreiras: no
+ * máximo uma fase liberada (verde ou amarelo) por anel, só fases do grupo
+ * atual liberadas e, entre anéis, só pares compatíveis
+ * (rb_plan_phases_compatible()). Nas trocas de intervalo, o verde fica em
+ * [mínimo, máximo] (o alvo de uma preempção pode passar do máximo) e o
+ * amarelo e o vermelho de limpeza duram o que o plano manda.
+ *
+ * Os casos: 80 s de cada plano com detectores, chamadas de pedestre e
+ * preempções aleatórias; o cruzamento da barreira, com um anel esperando o
+ * outro e os dois entrando juntos no grupo seguinte; o repouso em vermelho
+ * geral sem demanda e o cruzamento quando chega uma chamada; e a preempção
+ * para uma fase anterior à atual no mesmo grupo, que só é alcançada dando a
+ * volta pela barreira. No fim, o custo de um tick no PC (no RP2040 ele não
+ * foi medido; veja o README).
+ *
+ * Compilação e uso (da raiz do repositório):
+ *
+ *     gcc -std=c11 -O2 -Ilib -o ring_barrier_test tools/sim/ring_barrier_test.c lib/ring_barrier.c \
+ *         lib/phase_plans.c lib/coordination.c lib/phase_engine.c
+ *     ./ring_barrier_test
+ *
+ * Sai com 0 se todos os casos passam.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "phase_plans.h"
+#include "ring_barrier.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// Fases do cruzamento (lib/phase_plans.c) e seus detectores
+enum { F1, F2, F3, F4, F5, F6, F7, F8 };
+enum { DETECTOR_MAIN, DETECTOR_SIDE };
+
+#define TICK_MS      50u       // Passo do relógio virtual (o timer Detector)
+#define RUN_MS       80000u    // Duração de cada corrida aleatória
+#define RUN_SEEDS    8u        // Corridas por plano
+#define BENCH_TICKS  10000000u // Ticks medidos no PC
+
+static unsigned checks, failures;
+static uint32_t sim_seed = 1;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+
+static void check(bool ok, const char *what, int line)
+{
+    checks++;
+    if(ok) return;
+    failures++;
+    printf("  falhou (linha %d): %s\n", line, what);
+}
+
+/// Gerador congruencial, o mesmo em qualquer plataforma
+static uint32_t sim_random(void)
+{
+    sim_seed = sim_seed * 1103515245u + 12345u;
+    return sim_seed >> 8;
+}
+
+/**
+ * @brief Intervalo observado de um anel.
+ */
+typedef struct {
+    uint8_t interval;        // rb_interval_t
+    uint8_t phase;           // Fase do intervalo, ou RB_NO_PHASE
+    uint8_t group;           // Grupo em que o intervalo começou
+    bool held;               // Verde do alvo de uma preempção (pode passar do máximo)
+    uint32_t start_ms;       // Início
+} ring_seen_t;
+
+/**
+ * @brief Violações vistas numa corrida.
+ */
+typedef struct {
+    unsigned same_ring;      // Duas fases de um anel liberadas juntas
+    unsigned cross_group;    // Fase de outro grupo liberada, ou par incompatível
+    unsigned timing;         // Intervalo com duração fora do plano
+    unsigned ticks;          // Ticks conferidos
+} violations_t;
+
+static bool released(const rb_controller_t *ctrl, uint8_t phase)
+{
+    return ctrl->signals[phase] != PHASE_SIGNAL_RED;
+}
+
+static uint8_t ring_phase(const rb_controller_t *ctrl, uint8_t ring)
+{
+    const rb_ring_t *state = &ctrl->rings[ring];
+    if(state->interval == RB_INTERVAL_BARRIER || state->slot >= RB_GROUP_SLOTS) return RB_NO_PHASE;
+    return ctrl->plan->sequence[ring][ctrl->group][state->slot];
+}
+
+static void observe_start(const rb_controller_t *ctrl, ring_seen_t *seen)
+{
+    for(uint8_t r = 0; r < RB_RINGS; r++)
+    {
+        seen[r].interval = ctrl->rings[r].interval;
+        seen[r].phase = ring_phase(ctrl, r);
+        seen[r].group = ctrl->group;
+        seen[r].held = false;
+        seen[r].start_ms = ctrl->rings[r].start_ms;
+    }
+}
+
+/**
+ * @brief Confere as regras de segurança no estado atual e a duração dos intervalos que terminaram.
+ */
+static void observe(const rb_controller_t *ctrl, ring_seen_t *seen, violations_t *v)
+{
+    const rb_plan_t *plan = ctrl->plan;
+
+    v->ticks++;
+    for(uint8_t r = 0; r < RB_RINGS; r++)
+    {
+        unsigned lit = 0;
+        for(uint8_t g = 0; g < RB_GROUPS; g++)
+            for(uint8_t s = 0; s < RB_GROUP_SLOTS; s++)
+            {
+                uint8_t phase = plan->sequence[r][g][s];
+                if(phase == RB_NO_PHASE || !released(ctrl, phase)) continue;
+                lit++;
+                if(g != ctrl->group) v->cross_group++;
+            }
+        if(lit > 1) v->same_ring++;
+    }
+    for(uint8_t a = 0; a < plan->phase_count; a++)
+        for(uint8_t b = (uint8_t) (a + 1u); b < plan->phase_count; b++)
+            if(released(ctrl, a) && released(ctrl, b) && !rb_plan_phases_compatible(plan, a, b)) v->cross_group++;
+
+    for(uint8_t r = 0; r < RB_RINGS; r++)
+    {
+        const rb_ring_t *state = &ctrl->rings[r];
+        uint8_t phase = ring_phase(ctrl, r);
+        if(state->interval == seen[r].interval && phase == seen[r].phase)
+        {
+            seen[r].held |= (phase != RB_NO_PHASE && phase == ctrl->preempt);
+            continue;
+        }
+
+        uint32_t length = state->start_ms - seen[r].start_ms;
+        if(seen[r].phase != RB_NO_PHASE)
+        {
+            const rb_phase_def_t *def = &plan->phases[seen[r].phase];
+            switch(seen[r].interval)
+            {
+                case RB_INTERVAL_GREEN:
+                    if(length < def->min_green_ds * 100u) v->timing++;
+                    if(length > def->max_green_ds * 100u && !seen[r].held) v->timing++;
+                    break;
+                case RB_INTERVAL_YELLOW:
+                    if(length != def->yellow_ds * 100u) v->timing++;
+                    break;
+                case RB_INTERVAL_RED_CLEAR:
+                    // Entrando direto em outro grupo, a espera na barreira vem junto
+                    if(length < def->red_clear_ds * 100u
+                        || (ctrl->group == seen[r].group && length != def->red_clear_ds * 100u))
+                        v->timing++;
+                    break;
+                default:
+                    break;
+            }
+        }
+        seen[r].interval = state->interval;
+        seen[r].phase = phase;
+        seen[r].group = ctrl->group;
+        seen[r].held = (phase != RB_NO_PHASE && phase == ctrl->preempt);
+        seen[r].start_ms = state->start_ms;
+    }
+}
+
+/**
+ * @brief Plano de teste: cópia do padrão com outra tabela de fases.
+ */
+static void copy_plan(rb_plan_t *plan, rb_phase_def_t *phases, const rb_plan_t *from)
+{
+    *plan = *from;
+    memcpy(phases, from->phases, from->phase_count * sizeof(phases[0]));
+    plan->phases = phases;
+}
+
+static void test_random_runs(const rb_plan_t *plan)
+{
+    violations_t v = { 0 };
+    unsigned preemptions = 0, crossings = 0;
+
+    printf("%s: %u corridas de %u s\n", plan->name, RUN_SEEDS, RUN_MS / 1000u);
+    CHECK(rb_plan_is_valid(plan));
+    for(uint32_t seed = 1; seed <= RUN_SEEDS; seed++)
+    {
+        rb_controller_t ctrl;
+        ring_seen_t seen[RB_RINGS];
+        uint32_t preempt_until = 0, next_preempt;
+        uint8_t group = RB_GROUPS;
+
+        sim_seed = seed;
+        next_preempt = 20000u + sim_random() % 20000u;
+        rb_controller_start(&ctrl, plan, 0);
+        observe_start(&ctrl, seen);
+        for(uint32_t now = 0; now <= RUN_MS; now += TICK_MS)
+        {
+            uint32_t presence = 0;
+            if(sim_random() % 4u == 0) presence |= 1u << DETECTOR_MAIN;
+            if(sim_random() % 8u == 0) presence |= 1u << DETECTOR_SIDE;
+            if(presence) rb_controller_presence(&ctrl, presence, now);
+            if(sim_random() % 400u == 0) rb_controller_call(&ctrl, plan->ped_phase);
+            if(!preempt_until && now >= next_preempt)
+            {
+                CHECK(rb_controller_preempt(&ctrl, (uint8_t) (sim_random() % plan->phase_count), now));
+                preempt_until = now + 5000u + sim_random() % 10000u;
+                preemptions++;
+            }
+            if(preempt_until && now >= preempt_until)
+            {
+                rb_controller_preempt_release(&ctrl, now);
+                preempt_until = 0;
+                next_preempt = now + 10000u + sim_random() % 20000u;
+            }
+            rb_controller_update(&ctrl, now);
+            if(ctrl.group != group) crossings++;
+            group = ctrl.group;
+            observe(&ctrl, seen, &v);
+        }
+    }
+    printf("  %u ticks, %u barreiras, %u preempcoes: %u no mesmo anel, %u entre grupos, %u de duracao\n",
+        v.ticks, crossings, preemptions, v.same_ring, v.cross_group, v.timing);
+    CHECK(v.same_ring == 0);
+    CHECK(v.cross_group == 0);
+    CHECK(v.timing == 0);
+    CHECK(crossings >= RUN_SEEDS * 2u);
+    CHECK(preemptions >= RUN_SEEDS);
+}
+
+static void test_barrier(void)
+{
+    static rb_phase_def_t phases[RB_MAX_PHASES];
+    rb_plan_t plan;
+    rb_controller_t ctrl;
+    ring_seen_t seen[RB_RINGS];
+    violations_t v = { 0 };
+    uint32_t ring1_at_barrier = 0, ring0_done = 0, crossed = 0;
+    bool started = false;
+
+    printf("cruzamento da barreira\n");
+    // F6 em tempo fixo (10 s) e F2 estendida até o máximo (30 s): o anel 2 espera na barreira
+    copy_plan(&plan, phases, &RB_PLAN_DEFAULT);
+    phases[F6].detector = RB_NO_DETECTOR;
+    phases[F6].green_ds = phases[F6].min_green_ds;
+    CHECK(rb_plan_is_valid(&plan));
+    rb_controller_start(&ctrl, &plan, 0);
+    observe_start(&ctrl, seen);
+    for(uint32_t now = 0; now <= 60000u && !crossed; now += TICK_MS)
+    {
+        if(ctrl.group == 0) rb_controller_presence(&ctrl, 1u << DETECTOR_MAIN, now);
+        rb_controller_update(&ctrl, now);
+        observe(&ctrl, seen, &v);
+        started |= (ctrl.group == 0);
+        if(ctrl.group == 0 && ctrl.rings[1].interval == RB_INTERVAL_BARRIER)
+        {
+            if(!ring1_at_barrier) ring1_at_barrier = ctrl.rings[1].start_ms;
+            // Esperando: o anel 2 todo em vermelho, o anel 1 ainda no grupo
+            CHECK(!released(&ctrl, F5) && !released(&ctrl, F6));
+        }
+        if(started && ctrl.group == 1)
+        {
+            crossed = now;
+            ring0_done = ctrl.rings[0].start_ms;
+        }
+    }
+    CHECK(crossed && ring1_at_barrier);
+    // Os dois anéis entram juntos no grupo 1, no fim do vermelho de limpeza de F2
+    CHECK(ctrl.rings[0].interval == RB_INTERVAL_GREEN && ctrl.rings[1].interval == RB_INTERVAL_GREEN);
+    CHECK(ctrl.rings[0].start_ms == ctrl.rings[1].start_ms);
+    CHECK(released(&ctrl, F3) && released(&ctrl, F7));
+    // F1 (9 s com entreverdes) + F2 no máximo (36 s), contados do fim do vermelho de partida
+    uint32_t ring0_ms = (uint32_t) (phases[F1].green_ds + phases[F1].yellow_ds + phases[F1].red_clear_ds
+        + phases[F2].max_green_ds + phases[F2].yellow_ds + phases[F2].red_clear_ds) * 100u;
+    uint32_t ring1_ms = (uint32_t) (phases[F5].green_ds + phases[F5].yellow_ds + phases[F5].red_clear_ds
+        + phases[F6].green_ds + phases[F6].yellow_ds + phases[F6].red_clear_ds) * 100u;
+    uint32_t startup_ms = plan.startup_red_ds * 100u;
+    CHECK(ring0_done == startup_ms + ring0_ms);
+    CHECK(ring1_at_barrier == startup_ms + ring1_ms);
+    CHECK(v.same_ring == 0 && v.cross_group == 0 && v.timing == 0);
+}
+
+static void test_rest_and_call(void)
+{
+    static rb_phase_def_t phases[RB_MAX_PHASES];
+    rb_plan_t plan;
+    rb_controller_t ctrl;
+    ring_seen_t seen[RB_RINGS];
+    violations_t v = { 0 };
+    uint32_t now, called;
+
+    printf("repouso em vermelho geral e cruzamento por chamada\n");
+    copy_plan(&plan, phases, &RB_PLAN_DEFAULT);
+    for(uint8_t i = 0; i < plan.phase_count; i++) phases[i].recall = false;
+    CHECK(rb_plan_is_valid(&plan));
+    rb_controller_start(&ctrl, &plan, 0);
+    observe_start(&ctrl, seen);
+    // Sem demanda: depois do vermelho de partida, tudo vermelho, sem transições
+    for(now = 0; now <= 20000u; now += TICK_MS)
+    {
+        CHECK(rb_controller_update(&ctrl, now) == 0);
+        observe(&ctrl, seen, &v);
+    }
+    for(uint8_t i = 0; i < plan.phase_count; i++) CHECK(!released(&ctrl, i));
+    CHECK(ctrl.transitions == 0);
+    CHECK(ctrl.rings[0].interval == RB_INTERVAL_BARRIER && ctrl.rings[1].interval == RB_INTERVAL_BARRIER);
+
+    // Chamada de F4 (pedestre): cruza para o grupo 1 no tick seguinte, só F4 verde
+    called = now;
+    rb_controller_call(&ctrl, F4);
+    CHECK(rb_controller_update(&ctrl, now) == 1);
+    observe(&ctrl, seen, &v);
+    CHECK(ctrl.group == 1 && released(&ctrl, F4));
+    CHECK(ctrl.rings[0].start_ms + TICK_MS >= called && ctrl.rings[0].start_ms <= called);
+    CHECK(ctrl.rings[1].interval == RB_INTERVAL_BARRIER && !released(&ctrl, F8));
+    CHECK(rb_controller_ped(&ctrl) == PHASE_PED_WALK);
+    // F4 termina no mínimo e o cruzamento volta a repousar
+    for(now += TICK_MS; now <= called + 20000u; now += TICK_MS)
+    {
+        rb_controller_update(&ctrl, now);
+        observe(&ctrl, seen, &v);
+    }
+    for(uint8_t i = 0; i < plan.phase_count; i++) CHECK(!released(&ctrl, i));
+    CHECK(ctrl.transitions == 3);
+
+    // Presença na via principal chama F2 e F6: os dois anéis cruzam para o grupo 0
+    rb_controller_presence(&ctrl, 1u << DETECTOR_MAIN, now);
+    rb_controller_update(&ctrl, now);
+    observe(&ctrl, seen, &v);
+    CHECK(ctrl.group == 0 && released(&ctrl, F2) && released(&ctrl, F6));
+    CHECK(!released(&ctrl, F1) && !released(&ctrl, F5));
+    CHECK(ctrl.rings[0].start_ms == ctrl.rings[1].start_ms);
+    CHECK(v.same_ring == 0 && v.cross_group == 0 && v.timing == 0);
+}
+
+static void test_preempt_earlier_phase(void)
+{
+    const rb_plan_t *plan = &RB_PLAN_DEFAULT;
+    rb_controller_t ctrl;
+    ring_seen_t seen[RB_RINGS];
+    violations_t v = { 0 };
+    uint32_t now, requested = 0, target_green = 0;
+
+    printf("preempcao para uma fase anterior do grupo atual\n");
+    rb_controller_start(&ctrl, plan, 0);
+    observe_start(&ctrl, seen);
+    // Até F2 ficar verde (F1 já passou no grupo 0)
+    for(now = 0; now <= 60000u && !requested; now += TICK_MS)
+    {
+        rb_controller_update(&ctrl, now);
+        observe(&ctrl, seen, &v);
+        if(released(&ctrl, F2) && ctrl.signals[F2] == PHASE_SIGNAL_GREEN) requested = now;
+    }
+    CHECK(requested && ctrl.group == 0);
+    CHECK(rb_controller_preempt(&ctrl, F1, requested));
+    // O caminho dá a volta pela barreira: o grupo 1 não é atendido e F1 volta a ficar verde
+    for(; now <= requested + 30000u && !target_green; now += TICK_MS)
+    {
+        rb_controller_update(&ctrl, now);
+        observe(&ctrl, seen, &v);
+        for(uint8_t p = F3; p <= F4; p++) CHECK(!released(&ctrl, p));
+        for(uint8_t p = F7; p <= F8; p++) CHECK(!released(&ctrl, p));
+        if(ctrl.signals[F1] == PHASE_SIGNAL_GREEN) target_green = ctrl.rings[0].start_ms;
+    }
+    CHECK(target_green);
+    CHECK(target_green - requested <= rb_controller_preempt_bound_ms(&ctrl));
+    CHECK(ctrl.group == 0);
+    // Alvo verde enquanto durar a preempção; o outro anel espera na barreira
+    for(; now <= target_green + 20000u; now += TICK_MS)
+    {
+        rb_controller_update(&ctrl, now);
+        observe(&ctrl, seen, &v);
+        CHECK(ctrl.signals[F1] == PHASE_SIGNAL_GREEN);
+        CHECK(!released(&ctrl, F5) && !released(&ctrl, F6) && !released(&ctrl, F2));
+    }
+    // Depois da preempção, a sequência normal segue até o grupo 1
+    rb_controller_preempt_release(&ctrl, now);
+    bool group1 = false;
+    for(uint32_t end = now + 60000u; now <= end; now += TICK_MS)
+    {
+        rb_controller_update(&ctrl, now);
+        observe(&ctrl, seen, &v);
+        group1 |= released(&ctrl, F3) || released(&ctrl, F7);
+    }
+    CHECK(group1);
+    CHECK(v.same_ring == 0 && v.cross_group == 0);
+}
+
+static void bench_tick(void)
+{
+    rb_controller_t ctrl;
+    struct timespec t0, t1;
+    uint32_t transitions = 0;
+
+    rb_controller_start(&ctrl, &RB_PLAN_DEFAULT, 0);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for(uint32_t i = 0; i < BENCH_TICKS; i++) transitions += rb_controller_update(&ctrl, i * 100u);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = (double) (t1.tv_sec - t0.tv_sec) * 1e9 + (double) (t1.tv_nsec - t0.tv_nsec);
+    printf("tick no PC: %.1f ns (%u ticks de 100 ms, %u transicoes)\n", ns / BENCH_TICKS, BENCH_TICKS,
+        transitions);
+}
+
+int main(void)
+{
+    test_random_runs(&RB_PLAN_DEFAULT);
+    test_random_runs(&RB_PLAN_PEAK);
+    test_barrier();
+    test_rest_and_call();
+    test_preempt_earlier_phase();
+    bench_tick();
+    printf("%u verificacoes, %u falhas\n", checks, failures);
+    return failures ? 1 : 0;
+}
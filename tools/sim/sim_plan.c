@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <string.h>
+#include "sim_plan.h"
+#include "phase_plans.h"
+
+void sim_plan_load(sim_plan_t *sim_plan, bool intersection)
+{
+    sim_plan->intersection = intersection;
+    sim_plan_select(sim_plan, PLAN_DAY);
+}
+
+void sim_plan_select(sim_plan_t *sim_plan, uint8_t plan)
+{
+    if(plan >= PLAN_COUNT) plan = PLAN_DAY;
+    sim_plan->plan = *PHASE_PLANS[plan];
+    memcpy(sim_plan->phases, PHASE_PLANS[plan]->phases, PHASE_PLANS[plan]->count * sizeof(phase_def_t));
+    sim_plan->plan.phases = sim_plan->phases;
+    sim_plan->rb_plan = *RB_PLANS[plan];
+    memcpy(sim_plan->rb_phases, RB_PLANS[plan]->phases, RB_PLANS[plan]->phase_count * sizeof(rb_phase_def_t));
+    sim_plan->rb_plan.phases = sim_plan->rb_phases;
+}
+
+void sim_plan_copy(sim_plan_t *dst, const sim_plan_t *src)
+{
+    *dst = *src;
+    dst->plan.phases = dst->phases;
+    dst->rb_plan.phases = dst->rb_phases;
+}
+
+uint8_t sim_plan_phase_count(const sim_plan_t *sim_plan)
+{
+    return sim_plan->intersection ? sim_plan->rb_plan.phase_count : sim_plan->plan.count;
+}
+
+uint8_t sim_plan_approaches(const sim_plan_t *sim_plan)
+{
+    return sim_plan->intersection ? sim_plan->rb_plan.head_count : 2;
+}
+
+uint8_t sim_plan_approach_detector(const sim_plan_t *sim_plan, uint8_t approach)
+{
+    if(!sim_plan->intersection) return approach;
+    uint8_t detector = sim_plan->rb_phases[sim_plan->rb_plan.heads[approach].phase].detector;
+    return (detector == RB_NO_DETECTOR) ? MICROSIM_NO_DETECTOR : detector;
+}
+
+bool sim_plan_is_valid(const sim_plan_t *sim_plan)
+{
+    return sim_plan->intersection ? rb_plan_is_valid(&sim_plan->rb_plan) : phase_plan_is_valid(&sim_plan->plan);
+}
+
+void sim_plan_get_durations(const sim_plan_t *sim_plan, uint8_t index, uint16_t durations[3])
+{
+    if(sim_plan->intersection)
+    {
+        const rb_phase_def_t *phase = &sim_plan->rb_phases[index];
+        durations[0] = phase->min_green_ds;
+        durations[1] = phase->max_green_ds;
+        durations[2] = phase->green_ds;
+    }
+    else
+    {
+        const phase_def_t *phase = &sim_plan->phases[index];
+        durations[0] = phase->min_s;
+        durations[1] = phase->max_s;
+        durations[2] = phase->default_s;
+    }
+}
+
+void sim_plan_set_durations(sim_plan_t *sim_plan, uint8_t index, const uint16_t durations[3])
+{
+    if(sim_plan->intersection)
+    {
+        rb_phase_def_t *phase = &sim_plan->rb_phases[index];
+        phase->min_green_ds = durations[0];
+        phase->max_green_ds = durations[1];
+        phase->green_ds = durations[2];
+    }
+    else
+    {
+        phase_def_t *phase = &sim_plan->phases[index];
+        phase->min_s = durations[0];
+        phase->max_s = durations[1];
+        phase->default_s = durations[2];
+    }
+}
+
+uint16_t sim_plan_cycle(const sim_plan_t *sim_plan)
+{
+    return sim_plan->intersection ? sim_plan->rb_plan.cycle_ds : sim_plan->plan.cycle_s;
+}
+
+void sim_plan_set_cycle(sim_plan_t *sim_plan, uint16_t cycle)
+{
+    if(sim_plan->intersection)
+    {
+        sim_plan->rb_plan.cycle_ds = cycle;
+        if(cycle) sim_plan->rb_plan.offset_ds %= cycle;
+    }
+    else
+    {
+        sim_plan->plan.cycle_s = cycle;
+        if(cycle) sim_plan->plan.offset_s %= cycle;
+    }
+}
+
+void sim_plan_make_fixed(sim_plan_t *sim_plan)
+{
+    for(uint8_t i = 0; i < sim_plan->plan.count; i++) sim_plan->phases[i].detector = PHASE_NO_DETECTOR;
+    for(uint8_t i = 0; i < sim_plan->rb_plan.phase_count; i++)
+    {
+        sim_plan->rb_phases[i].detector = RB_NO_DETECTOR;
+        sim_plan->rb_phases[i].recall = true;
+    }
+}
+
+void sim_plan_make_free(sim_plan_t *sim_plan)
+{
+    sim_plan->plan.cycle_s = 0;
+    sim_plan->plan.offset_s = 0;
+    sim_plan->rb_plan.cycle_ds = 0;
+    sim_plan->rb_plan.offset_ds = 0;
+}
+
+void sim_plan_print(const sim_plan_t *sim_plan)
+{
+    if(sim_plan->intersection)
+    {
+        printf("  ciclo %.1f s; verde min/max/padrao (s):", sim_plan->rb_plan.cycle_ds / 10.0);
+        for(uint8_t i = 0; i < sim_plan->rb_plan.phase_count; i++)
+        {
+            const rb_phase_def_t *phase = &sim_plan->rb_phases[i];
+            printf("%s %s %.1f/%.1f/%.1f%s", (i % 4 == 0) ? "\n   " : ",", phase->name,
+                phase->min_green_ds / 10.0, phase->max_green_ds / 10.0, phase->green_ds / 10.0,
+                (phase->detector == RB_NO_DETECTOR) ? "" : " atuada");
+        }
+        printf("\n");
+        return;
+    }
+    printf("  ciclo %u s; min/max/padrao (s):", sim_plan->plan.cycle_s);
+    for(uint8_t i = 0; i < sim_plan->plan.count; i++)
+    {
+        const phase_def_t *phase = &sim_plan->phases[i];
+        printf("%s %s %u/%u/%u%s", i ? "," : "", phase->name, phase->min_s, phase->max_s, phase->default_s,
+            (phase->detector == PHASE_NO_DETECTOR) ? "" : " atuada");
+    }
+    printf("\n");
+}
+
+void sim_plan_init_sim(microsim_t *sim, const sim_plan_t *sim_plan, const double *flow_vph,
+    const microsim_params_t *params)
+{
+    if(sim_plan->intersection) microsim_init_intersection(sim, &sim_plan->rb_plan, flow_vph, params);
+    else microsim_init_single(sim, &sim_plan->plan, flow_vph, params);
+}
@@ -0,0 +1,112 @@
+#ifndef SIM_PLAN_H
+#define SIM_PLAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "microsim.h"
+
+/**
+ * @file sim_plan.h
+ * @brief Cópia editável do plano do firmware para as ferramentas do simulador
+ *        (traffic_sim e optimize_plan), como a cópia em RAM do firmware.
+ *
+ * As durações seguem o comando duracao do shell: mínimo, máximo e padrão (o
+ * verde, no cruzamento), em segundos no foco único e em décimos de segundo
+ * no cruzamento.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+
+#define SIM_PLAN_DISPLAY_MAX_S  9   /**< O firmware de foco único mostra um só dígito */
+
+/**
+ * @brief Plano de foco único ou de cruzamento, com as fases em RAM.
+ */
+typedef struct {
+    bool intersection;                             /**< Plano de anéis e barreiras */
+    phase_plan_t plan;                             /**< Plano de foco único */
+    phase_def_t phases[PHASE_ENGINE_MAX_PHASES];   /**< Fases de plan */
+    rb_plan_t rb_plan;                             /**< Plano do cruzamento */
+    rb_phase_def_t rb_phases[RB_MAX_PHASES];       /**< Fases de rb_plan */
+} sim_plan_t;
+
+/**
+ * @brief Copia o plano padrão do firmware (lib/phase_plans.c).
+ */
+void sim_plan_load(sim_plan_t *sim_plan, bool intersection);
+
+/**
+ * @brief Troca para o plano @p plan (plan_id_t) do firmware, do mesmo tipo.
+ */
+void sim_plan_select(sim_plan_t *sim_plan, uint8_t plan);
+
+/**
+ * @brief Copia um plano, apontando a cópia para as próprias fases.
+ */
+void sim_plan_copy(sim_plan_t *dst, const sim_plan_t *src);
+
+/**
+ * @brief Número de fases do plano.
+ */
+uint8_t sim_plan_phase_count(const sim_plan_t *sim_plan);
+
+/**
+ * @brief Número de aproximações da simulação (2 no foco único, uma por foco no cruzamento).
+ */
+uint8_t sim_plan_approaches(const sim_plan_t *sim_plan);
+
+/**
+ * @brief Detector da aproximação @p approach, ou MICROSIM_NO_DETECTOR.
+ */
+uint8_t sim_plan_approach_detector(const sim_plan_t *sim_plan, uint8_t approach);
+
+/**
+ * @brief Verifica o plano como o firmware.
+ */
+bool sim_plan_is_valid(const sim_plan_t *sim_plan);
+
+/**
+ * @brief Lê o mínimo, o máximo e o padrão (ou verde) da fase @p index.
+ */
+void sim_plan_get_durations(const sim_plan_t *sim_plan, uint8_t index, uint16_t durations[3]);
+
+/**
+ * @brief Altera a fase @p index como o comando duracao (sem validar).
+ */
+void sim_plan_set_durations(sim_plan_t *sim_plan, uint8_t index, const uint16_t durations[3]);
+
+/**
+ * @brief Ciclo coordenado em unidades das durações (0: livre).
+ */
+uint16_t sim_plan_cycle(const sim_plan_t *sim_plan);
+
+/**
+ * @brief Altera o ciclo coordenado (a defasagem volta para dentro do ciclo).
+ */
+void sim_plan_set_cycle(sim_plan_t *sim_plan, uint16_t cycle);
+
+/**
+ * @brief Tempo fixo: nenhuma fase é atuada e as do cruzamento são atendidas em todo ciclo.
+ */
+void sim_plan_make_fixed(sim_plan_t *sim_plan);
+
+/**
+ * @brief Sem coordenação (ciclo livre).
+ */
+void sim_plan_make_free(sim_plan_t *sim_plan);
+
+/**
+ * @brief Mostra o ciclo e as durações das fases.
+ */
+void sim_plan_print(const sim_plan_t *sim_plan);
+
+/**
+ * @brief Prepara a simulação do plano (microsim_init_single ou microsim_init_intersection).
+ *
+ * @param flow_vph Chegadas por hora de cada aproximação.
+ */
+void sim_plan_init_sim(microsim_t *sim, const sim_plan_t *sim_plan, const double *flow_vph,
+    const microsim_params_t *params);
+
+#endif // SIM_PLAN_H
@@ -0,0 +1,153 @@
+/**
+ * @file spsc_ring_test.c
+ * @brief Teste de estresse do lib/spsc_ring no Linux, com produtor e consumidor em threads.
+ *
+ * O produtor escreve lotes de tamanho aleatório (inclusive maiores que o espaço
+ * livre) de elementos numerados com soma de verificação; o consumidor lê lotes
+ * de outro tamanho aleatório e confere que cada elemento chega uma vez, na
+ * ordem e inteiro. O buffer é pequeno, para dar a volta a cada poucos
+ * elementos, e os índices começam perto de UINT32_MAX, para cruzar também a
+ * volta dos contadores de 32 bits.
+ *
+ * Com o buffer vazio, o consumidor ora volta a consultá-lo (disputando cada
+ * publicação do head), ora espera num semáforo, como a tarefa do firmware
+ * espera a notificação: o produtor o acorda quando spsc_ring_push_wakes() diz que o push
+ * cruzou o limiar. Um timeout com o buffer no limiar ou acima, sem despertar
+ * pendente, é um despertar perdido. As sobras abaixo do limiar são recolhidas
+ * pelo timeout, como no firmware.
+ *
+ * Compilação e uso (da raiz do repositório):
+ *
+ *     gcc -std=c11 -O2 -pthread -Ilib -o spsc_ring_test tools/sim/spsc_ring_test.c lib/spsc_ring.c
+ *     ./spsc_ring_test [elementos]
+ *
+ * Sai com 0 se tudo confere.
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "spsc_ring.h"
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+
+#define CAPACITY        16u
+#define MAX_BATCH       (CAPACITY + 5u)   // Maior que o buffer: força push parcial
+#define THRESHOLD       6u
+#define WAIT_MS         20                // Timeout do consumidor (recolhe as sobras)
+#define DEFAULT_ITEMS   5000000u
+
+typedef struct {
+    uint32_t seq;
+    uint32_t check;
+} item_t;
+
+static spsc_ring_t ring;
+SPSC_RING_STORAGE(storage, item_t, CAPACITY);
+static sem_t wakeup;
+static uint32_t items_total;
+static uint32_t wakeups, missed_wakeups, errors;
+
+static uint32_t item_check(uint32_t seq)
+{
+    return seq * 2654435761u ^ 0x5A5A5A5Au;
+}
+
+static void *producer(void *arg)
+{
+    item_t batch[MAX_BATCH];
+    uint32_t next = 0;
+    unsigned seed = 1;
+
+    (void) arg;
+    while(next < items_total)
+    {
+        uint32_t count = 1u + (uint32_t) rand_r(&seed) % MAX_BATCH;
+        if(count > items_total - next) count = items_total - next;
+        for(uint32_t i = 0; i < count; i++)
+            batch[i] = (item_t) { .seq = next + i, .check = item_check(next + i) };
+        uint32_t pushed = spsc_ring_push(&ring, batch, count);
+        if(spsc_ring_push_wakes(&ring, pushed)) sem_post(&wakeup);
+        next += pushed;  // O que não coube é escrito de novo no próximo lote
+        if(rand_r(&seed) % 64 == 0) sched_yield();
+    }
+    return NULL;
+}
+
+/**
+ * @brief Espera o despertar, como ulTaskNotifyTake com timeout.
+ * @return false no timeout.
+ */
+static bool wait_wakeup(int timeout_ms)
+{
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_nsec += (long) timeout_ms * 1000000L;
+    until.tv_sec += until.tv_nsec / 1000000000L;
+    until.tv_nsec %= 1000000000L;
+    while(sem_timedwait(&wakeup, &until) != 0)
+        if(errno == ETIMEDOUT) return false;
+    return true;
+}
+
+static void *consumer(void *arg)
+{
+    item_t batch[MAX_BATCH];
+    uint32_t expected = 0;
+    unsigned seed = 2;
+
+    (void) arg;
+    while(expected < items_total)
+    {
+        uint32_t max = 1u + (uint32_t) rand_r(&seed) % MAX_BATCH;
+        uint32_t count = spsc_ring_pop(&ring, batch, max);
+        for(uint32_t i = 0; i < count; i++, expected++)
+            if(batch[i].seq != expected || batch[i].check != item_check(batch[i].seq))
+            {
+                if(errors++ < 10)
+                    fprintf(stderr, "elemento %u: lido seq %u check %08x\n", expected, batch[i].seq, batch[i].check);
+                expected = batch[i].seq;
+            }
+        if(count) continue;  // Esvazia o buffer antes de esperar
+        if(rand_r(&seed) % 4 != 0) continue;  // Na maior parte do tempo consulta sem esperar, disputando o head
+        if(wait_wakeup(WAIT_MS))
+        {
+            wakeups++;
+            continue;
+        }
+        // Timeout no limiar: o produtor pode estar entre o push e o sem_post
+        if(spsc_ring_count(&ring) >= THRESHOLD && !wait_wakeup(WAIT_MS)) missed_wakeups++;
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t threads[2];
+
+    items_total = (argc > 1) ? (uint32_t) strtoul(argv[1], NULL, 0) : DEFAULT_ITEMS;
+    spsc_ring_init(&ring, storage, sizeof(item_t), CAPACITY);
+    ring.head = ring.tail = UINT32_MAX - 1000u;  // Cruza a volta dos índices logo no início
+    sem_init(&wakeup, 0, 0);
+    spsc_ring_set_consumer(&ring, &wakeup, THRESHOLD);
+
+    pthread_create(&threads[1], NULL, consumer, NULL);
+    pthread_create(&threads[0], NULL, producer, NULL);
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+
+    if(spsc_ring_count(&ring) != 0) errors++;
+    printf("elementos %u, recusados no push %u, despertares %u, despertares perdidos %u, erros %u\n",
+        items_total, ring.dropped, wakeups, missed_wakeups, errors);
+    if(errors || missed_wakeups)
+    {
+        printf("FALHOU\n");
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,259 @@
+/**
+ * @file traffic_sim.c
+ * @brief Avalia um plano de fases no microssimulador (tools/sim/microsim.h).
+ *
+ * Roda o plano do firmware (o padrão 9/3/6 ou o cruzamento) e, se alguma
+ * duração for alterada, também a alternativa, com as mesmas chegadas, e
+ * mostra por aproximação o fluxo atendido, o atraso médio e a fila.
+ *
+ * Compilação (da raiz do repositório):
+ *
+ *     gcc -std=c11 -O2 -Ilib -Itools/sim -o traffic_sim tools/sim/traffic_sim.c tools/sim/sim_plan.c \
+ *         tools/sim/microsim.c lib/phase_engine.c lib/phase_plans.c lib/ring_barrier.c lib/coordination.c -lm
+ *
+ * Uso:
+ *
+ *     ./traffic_sim --flow 600,300 --hours 10000
+ *     ./traffic_sim --flow 600,300 --duration 0,4,12,12 --duration 2,3,9,4
+ *     ./traffic_sim --intersection --peds 30 --fixed
+ *     ./traffic_sim --flow 600,300 --sync --free
+ *
+ * @author Carlos Valadao
+ * @date 17/10/2026
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sim_plan.h"
+
+#define MAX_OVERRIDES     16
+#define DEFAULT_HOURS     1000.0
+#define DEFAULT_WARMUP_MIN 15.0
+
+/// Fluxos padrão do cruzamento por detector da fase do foco (veículos/h)
+#define FLOW_MAIN_VPH     600.0
+#define FLOW_SIDE_VPH     300.0
+#define FLOW_TURN_VPH     60.0
+
+/**
+ * @brief Alteração de uma fase: índice, mínimo, máximo e padrão (unidades do comando duracao)
+ */
+typedef struct {
+    uint8_t index;
+    uint16_t durations[3];
+} duration_override_t;
+
+static microsim_t g_sim;
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+        "uso: %s [opcoes]\n"
+        "  --intersection          cruzamento de 8 fases (padrao: foco unico 9/3/6)\n"
+        "  --flow V1,V2,...        chegadas por hora de cada aproximacao\n"
+        "  --hours H               horas simuladas (padrao %.0f)\n"
+        "  --warmup M              minutos de aquecimento descartados (padrao %.0f)\n"
+        "  --saturation V          fluxo de saturacao, veiculos/h de verde (padrao 1800)\n"
+        "  --lost S                tempo perdido no inicio do verde (padrao 2)\n"
+        "  --yellow-used S         parte do amarelo usada (padrao 2)\n"
+        "  --peds N                chamadas de pedestre por hora (padrao 0)\n"
+        "  --seed N                semente das chegadas (padrao 1)\n"
+        "  --sync                  controlador com a hora do host (padrao: sem hora, planos livres)\n"
+        "alternativa (comparada com o plano atual):\n"
+        "  --duration F,MIN,MAX,PADRAO  altera a fase F, como o comando duracao do shell\n"
+        "  --fixed                 tempo fixo: fases sem detector, nas duracoes padrao\n"
+        "  --free                  sem coordenacao (ciclo livre)\n",
+        program, DEFAULT_HOURS, DEFAULT_WARMUP_MIN);
+    exit(2);
+}
+
+static double parse_number(const char *text, const char *program)
+{
+    char *end;
+    double value = strtod(text, &end);
+
+    if(end == text || *end != '\0' || value < 0.0) usage(program);
+    return value;
+}
+
+/**
+ * @brief Lê uma lista de números separados por vírgula
+ *
+ * @return Quantidade lida.
+ */
+static int parse_list(const char *text, double *values, int max, const char *program)
+{
+    char buffer[256];
+    int count = 0;
+
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    for(char *item = strtok(buffer, ","); item; item = strtok(NULL, ","))
+    {
+        if(count == max) usage(program);
+        values[count++] = parse_number(item, program);
+    }
+    return count;
+}
+
+static double elapsed_s(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - start->tv_sec) + (double) (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+/**
+ * @brief Simula um plano e mostra os resultados
+ *
+ * @return Atraso médio de todos os veículos atendidos, em segundos.
+ */
+static double run_plan(const char *title, const sim_plan_t *sim_plan, const double *flow_vph,
+    const microsim_params_t *params, double hours, double warmup_min)
+{
+    microsim_t *sim = &g_sim;
+    struct timespec start;
+    uint64_t delay_ms = 0, departures = 0;
+
+    sim_plan_init_sim(sim, sim_plan, flow_vph, params);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    microsim_run(sim, (uint64_t) (warmup_min * 60000.0));
+    microsim_reset_stats(sim);
+    microsim_run(sim, (uint64_t) (hours * 3600000.0));
+    double wall_s = elapsed_s(&start);
+
+    printf("%s (%s)\n", title, sim_plan->intersection ? sim_plan->rb_plan.name : sim_plan->plan.name);
+    sim_plan_print(sim_plan);
+    printf("  %-16s %9s %9s %9s %9s %9s %9s\n",
+        "aproximacao", "cheg/h", "veic/h", "atraso s", "fila med", "fila max", "descartes");
+    for(uint8_t i = 0; i < sim->count; i++)
+    {
+        const microsim_approach_t *approach = &sim->approaches[i];
+        const microsim_stats_t *stats = &approach->stats;
+        double sim_ms = (double) (sim->now_ms - sim->stats_start_ms);
+        printf("  %-16s %9.1f %9.1f %9.2f %9.2f %9u %9llu\n", approach->name,
+            (double) stats->arrivals * 3600000.0 / sim_ms, (double) stats->departures * 3600000.0 / sim_ms,
+            stats->departures ? (double) stats->delay_ms / 1000.0 / (double) stats->departures : 0.0,
+            (double) stats->queue_ms / sim_ms, stats->max_queue, (unsigned long long) stats->overflow);
+        delay_ms += stats->delay_ms;
+        departures += stats->departures;
+    }
+    double delay_s = departures ? (double) delay_ms / 1000.0 / (double) departures : 0.0;
+    printf("  atraso medio %.2f s/veic, %llu chamadas de pedestre; %.0f h em %.2f s (%.0f h/s, %.1f M eventos/s)\n\n",
+        delay_s, (unsigned long long) sim->ped_calls, hours, wall_s, hours / wall_s,
+        (double) sim->events / wall_s * 1e-6);
+    return delay_s;
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option OPTIONS[] = {
+        { "intersection", no_argument,       NULL, 'i' },
+        { "flow",         required_argument, NULL, 'f' },
+        { "hours",        required_argument, NULL, 'h' },
+        { "warmup",       required_argument, NULL, 'w' },
+        { "saturation",   required_argument, NULL, 's' },
+        { "lost",         required_argument, NULL, 'l' },
+        { "yellow-used",  required_argument, NULL, 'y' },
+        { "peds",         required_argument, NULL, 'p' },
+        { "seed",         required_argument, NULL, 'r' },
+        { "duration",     required_argument, NULL, 'd' },
+        { "fixed",        no_argument,       NULL, 'x' },
+        { "free",         no_argument,       NULL, 'c' },
+        { "sync",         no_argument,       NULL, 't' },
+        { NULL, 0, NULL, 0 },
+    };
+    microsim_params_t params = {
+        .saturation_vph = 1800.0,
+        .startup_lost_s = 2.0,
+        .yellow_used_s = 2.0,
+        .ped_per_hour = 0.0,
+        .seed = 1,
+    };
+    duration_override_t overrides[MAX_OVERRIDES];
+    double flow_vph[MICROSIM_MAX_APPROACHES];
+    double hours = DEFAULT_HOURS, warmup_min = DEFAULT_WARMUP_MIN;
+    int flow_count = 0, override_count = 0;
+    bool intersection = false, fixed = false, free_cycle = false;
+    int option;
+
+    while((option = getopt_long(argc, argv, "", OPTIONS, NULL)) != -1)
+    {
+        double values[4];
+        switch(option)
+        {
+            case 'i': intersection = true; break;
+            case 'f': flow_count = parse_list(optarg, flow_vph, MICROSIM_MAX_APPROACHES, argv[0]); break;
+            case 'h': hours = parse_number(optarg, argv[0]); break;
+            case 'w': warmup_min = parse_number(optarg, argv[0]); break;
+            case 's': params.saturation_vph = parse_number(optarg, argv[0]); break;
+            case 'l': params.startup_lost_s = parse_number(optarg, argv[0]); break;
+            case 'y': params.yellow_used_s = parse_number(optarg, argv[0]); break;
+            case 'p': params.ped_per_hour = parse_number(optarg, argv[0]); break;
+            case 'r': params.seed = (uint64_t) parse_number(optarg, argv[0]); break;
+            case 'x': fixed = true; break;
+            case 'c': free_cycle = true; break;
+            case 't': params.time_synced = true; break;
+            case 'd':
+                if(override_count == MAX_OVERRIDES || parse_list(optarg, values, 4, argv[0]) != 4) usage(argv[0]);
+                for(int i = 0; i < 4; i++) if(values[i] > UINT16_MAX) usage(argv[0]);
+                overrides[override_count].index = (uint8_t) values[0];
+                for(int i = 0; i < 3; i++) overrides[override_count].durations[i] = (uint16_t) values[i + 1];
+                override_count++;
+                break;
+            default: usage(argv[0]);
+        }
+    }
+    if(optind != argc || hours <= 0.0 || params.saturation_vph <= 0.0) usage(argv[0]);
+
+    static sim_plan_t current, alternative;
+    sim_plan_load(&current, intersection);
+    uint8_t approaches = sim_plan_approaches(&current);
+    if(flow_count == 0)
+    {
+        for(uint8_t i = 0; i < approaches; i++)
+        {
+            uint8_t detector = sim_plan_approach_detector(&current, i);
+            flow_vph[i] = (detector == 0) ? FLOW_MAIN_VPH : (detector == 1) ? FLOW_SIDE_VPH : FLOW_TURN_VPH;
+        }
+    }
+    else if(flow_count != approaches)
+    {
+        fprintf(stderr, "erro: o plano tem %u aproximacoes\n", approaches);
+        return 2;
+    }
+
+    sim_plan_copy(&alternative, &current);
+    for(int i = 0; i < override_count; i++)
+    {
+        if(overrides[i].index >= sim_plan_phase_count(&alternative))
+        {
+            fprintf(stderr, "erro: fase %u nao existe\n", overrides[i].index);
+            return 2;
+        }
+        sim_plan_set_durations(&alternative, overrides[i].index, overrides[i].durations);
+        if(!intersection && overrides[i].durations[1] > SIM_PLAN_DISPLAY_MAX_S)
+            fprintf(stderr, "aviso: fase %u passa de %u s; o firmware de foco unico nao aceita\n",
+                overrides[i].index, SIM_PLAN_DISPLAY_MAX_S);
+    }
+    if(fixed) sim_plan_make_fixed(&alternative);
+    if(free_cycle) sim_plan_make_free(&alternative);
+    if(!sim_plan_is_valid(&alternative))
+    {
+        fprintf(stderr, "erro: duracoes invalidas para o plano\n");
+        return 2;
+    }
+
+    double current_delay = run_plan("atual", &current, flow_vph, &params, hours, warmup_min);
+    if(override_count || fixed || free_cycle)
+    {
+        double alternative_delay = run_plan("alternativo", &alternative, flow_vph, &params, hours, warmup_min);
+        printf("atraso medio: atual %.2f s, alternativo %.2f s (%+.1f%%)\n", current_delay, alternative_delay,
+            current_delay > 0.0 ? (alternative_delay - current_delay) / current_delay * 100.0 : 0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+#!/usr/bin/env python3
+"""Extrai generated/task_stacks.h da saída serial do build TRAFFIC_STACK_PROFILE.
+
+Uso:
+    python3 tools/stack_header.py /dev/ttyACM0            # porta USB CDC da placa
+    python3 tools/stack_header.py captura.txt -o out.h    # log já salvo
+
+Lê linhas até encontrar o bloco delimitado pelos marcadores impressos por
+stack_profile_emit_header() e grava o conteúdo no arquivo de saída.
+"""
+import argparse
+import pathlib
+import sys
+
+BEGIN = "---8<--- task_stacks.h begin"
+END = "---8<--- task_stacks.h end"
+DEFAULT_OUT = pathlib.Path(__file__).resolve().parent.parent / "generated" / "task_stacks.h"
+
+
+def extract(lines):
+    block = None
+    for raw in lines:
+        line = raw.rstrip("\r\n")
+        if line == BEGIN:
+            block = []
+        elif line == END and block is not None:
+            return "\n".join(block) + "\n"
+        elif block is not None:
+            block.append(line)
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="porta serial ou arquivo com a saída do perfil")
+    parser.add_argument("-o", "--output", type=pathlib.Path, default=DEFAULT_OUT)
+    args = parser.parse_args()
+
+    with open(args.source, "r", encoding="utf-8", errors="replace") as stream:
+        header = extract(stream)
+    if header is None:
+        sys.exit("cabeçalho não encontrado em %s" % args.source)
+    args.output.parent.mkdir(parents=True, exist_ok=True)
+    args.output.write_text(header)
+    print("gravado %s" % args.output)
+
+
+if __name__ == "__main__":
+    main()
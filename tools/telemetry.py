@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""Decodifica os quadros binários de telemetria enviados pela placa (lib/telemetry.h).
+
+Uso:
+    python3 tools/telemetry.py /dev/ttyACM0     # porta USB CDC da placa
+    python3 tools/telemetry.py captura.bin      # captura bruta salva
+
+Linhas de texto do printf que chegam entre os quadros são repassadas com o
+prefixo "| ".
+"""
+import argparse
+import struct
+import sys
+
+SYNC = b"\xa5\x5a"
+
+TYPE_CPU_STATS = 0x01
+TYPE_TASK_NAMES = 0x02
+TYPE_LATENCY = 0x03
+TYPE_TRACE = 0x04
+TYPE_WCET = 0x05
+TYPE_ACTUATION = 0x06
+TYPE_PEDESTRIAN = 0x07
+TYPE_COORDINATION = 0x08
+TYPE_EVENT_LOG = 0x09
+TYPE_INPUT_LOG = 0x0A
+
+TRACE_HEADER = struct.Struct("<BBQ")
+TRACE_RECORD = struct.Struct("<IBxH")
+
+EVENT_LOG_PART = 128
+EVENT_LOG_END = 0xFFFF
+INPUT_LOG_BLOCK_SIZE = 2048
+INPUT_LOG_PART = 128
+INPUT_LOG_END = 0xFFFF
+
+ISR_NAMES = {0: "gpio", 1: "monitor", 2: "flash"}
+JOB_NAMES = {0: "phase", 1: "buzzer", 2: "button", 3: "display", 4: "log", 5: "detector", 6: "shell"}
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+class Decoder:
+    """Separa quadros válidos do fluxo de bytes e mantém o estado entre eles."""
+
+    def __init__(self, out=sys.stdout):
+        self.buf = bytearray()
+        self.text = bytearray()
+        self.task_names = {}
+        self.wcet = {}
+        self.event_pages = {}
+        self.event_dump_done = False
+        self.input_blocks = {}
+        self.input_dump_done = False
+        self.out = out
+        self.handlers = {
+            TYPE_CPU_STATS: self.on_cpu_stats,
+            TYPE_TASK_NAMES: self.on_task_names,
+            TYPE_LATENCY: self.on_latency,
+            TYPE_TRACE: self.on_trace,
+            TYPE_WCET: self.on_wcet,
+            TYPE_ACTUATION: self.on_actuation,
+            TYPE_PEDESTRIAN: self.on_pedestrian,
+            TYPE_COORDINATION: self.on_coordination,
+            TYPE_EVENT_LOG: self.on_event_log,
+            TYPE_INPUT_LOG: self.on_input_log,
+        }
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            idx = self.buf.find(SYNC)
+            if idx < 0:
+                keep = 1 if self.buf.endswith(SYNC[:1]) else 0
+                self.emit_text(self.buf[:len(self.buf) - keep])
+                del self.buf[:len(self.buf) - keep]
+                return
+            self.emit_text(self.buf[:idx])
+            del self.buf[:idx]
+            if len(self.buf) < 4:
+                return
+            ftype, length = self.buf[2], self.buf[3]
+            if len(self.buf) < 6 + length:
+                return
+            body = bytes(self.buf[2:4 + length])
+            (crc,) = struct.unpack_from("<H", self.buf, 4 + length)
+            if crc16_ccitt(body) != crc:
+                # Falso marcador: trata o primeiro byte como texto e continua
+                self.emit_text(self.buf[:1])
+                del self.buf[:1]
+                continue
+            del self.buf[:6 + length]
+            handler = self.handlers.get(ftype)
+            if handler:
+                handler(body[2:])
+            else:
+                self.print("tipo desconhecido 0x%02x (%d bytes)" % (ftype, length))
+
+    def emit_text(self, data):
+        self.text += data
+        while b"\n" in self.text:
+            line, _, rest = bytes(self.text).partition(b"\n")
+            self.text = bytearray(rest)
+            self.print("| " + line.decode("utf-8", "replace").rstrip("\r"))
+
+    def print(self, line):
+        print(line, file=self.out, flush=True)
+
+    def name(self, number):
+        return self.task_names.get(number, "#%d" % number)
+
+    def on_task_names(self, payload):
+        i = 0
+        while i + 2 <= len(payload):
+            number, length = payload[i], payload[i + 1]
+            self.task_names[number] = payload[i + 2:i + 2 + length].decode("ascii", "replace")
+            i += 2 + length
+
+    def on_cpu_stats(self, payload):
+        window_us, cores, task_count, isr_count = struct.unpack_from("<IBBB", payload)
+        idle = struct.unpack_from("<2H", payload, 7)
+        switches = struct.unpack_from("<2I", payload, 11)
+        offset = 19
+        parts = []
+        for _ in range(task_count):
+            number, permille = struct.unpack_from("<BH", payload, offset)
+            offset += 3
+            parts.append("%s=%.1f%%" % (self.name(number), permille / 10))
+        for _ in range(isr_count):
+            isr, permille = struct.unpack_from("<BH", payload, offset)
+            offset += 3
+            parts.append("isr:%s=%.1f%%" % (ISR_NAMES.get(isr, isr), permille / 10))
+        idle_text = " ".join("core%d=%.1f%%" % (c, idle[c] / 10) for c in range(cores))
+        rate_text = " ".join("core%d=%.0f/s" % (c, switches[c] * 1e6 / window_us) for c in range(cores))
+        self.print("[cpu] janela=%d ms idle %s trocas %s | %s"
+                   % (window_us // 1000, idle_text, rate_text, " ".join(parts)))
+
+    def on_trace(self, payload):
+        core, count, _ = TRACE_HEADER.unpack_from(payload)
+        self.print("[trace] core%d %d registros" % (core, count))
+
+    def on_wcet(self, payload):
+        job_count, isr_count = struct.unpack_from("<BB", payload)
+        values = struct.unpack_from("<%dI" % (job_count + isr_count), payload, 2)
+        for job in range(job_count):
+            self.wcet[JOB_NAMES.get(job, "job%d" % job)] = values[job]
+        for isr in range(isr_count):
+            self.wcet["isr:%s" % ISR_NAMES.get(isr, isr)] = values[job_count + isr]
+        self.print("[wcet] " + " ".join("%s=%d us" % item for item in self.wcet.items()))
+
+    def on_latency(self, payload):
+        cores, transitions, latency = struct.unpack_from("<BII", payload)
+        self.print("[lat] cores=%d transicoes=%d max=%d us" % (cores, transitions, latency))
+
+    def on_actuation(self, payload):
+        presence, gap_outs, max_outs, det0, det1, overruns = struct.unpack_from("<BIIIII", payload)
+        self.print("[atuado] presenca=%s gap-out=%d max-out=%d ativacoes=%d/%d perdidas=%d"
+                   % (format(presence, "02b"), gap_outs, max_outs, det0, det1, overruns))
+
+    def on_pedestrian(self, payload):
+        waiting, requests, served, last_ms, max_ms = struct.unpack_from("<BIIII", payload)
+        self.print("[pedestre] aguardando=%d chamadas=%d atendidas=%d espera=%d ms max=%d ms"
+                   % (waiting, requests, served, last_ms, max_ms))
+
+    def on_coordination(self, payload):
+        synced, cycle_ms, offset_ms, error_ms, syncs = struct.unpack_from("<BIIiI", payload)
+        self.print("[coord] ciclo=%d ms defasagem=%d ms erro=%+d ms %s ajustes=%d"
+                   % (cycle_ms, offset_ms, error_ms, "sincronizado" if synced else "livre", syncs))
+
+    def on_event_log(self, payload):
+        page, part = struct.unpack_from("<HB", payload)
+        if page == EVENT_LOG_END:
+            self.event_dump_done = True
+            self.print("[eventos] %d paginas (decodifique com tools/event_log.py)" % len(self.event_pages))
+            return
+        data = self.event_pages.setdefault(page, bytearray(2 * EVENT_LOG_PART))
+        data[part * EVENT_LOG_PART:(part + 1) * EVENT_LOG_PART] = payload[3:3 + EVENT_LOG_PART]
+
+    def on_input_log(self, payload):
+        block, part = struct.unpack_from("<HB", payload)
+        if block == INPUT_LOG_END:
+            self.input_dump_done = True
+            self.print("[entradas] %d blocos (salve com tools/input_log.py)" % len(self.input_blocks))
+            return
+        data = self.input_blocks.setdefault(block, bytearray(INPUT_LOG_BLOCK_SIZE))
+        data[part * INPUT_LOG_PART:(part + 1) * INPUT_LOG_PART] = payload[3:3 + INPUT_LOG_PART]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="porta serial ou arquivo com a captura bruta")
+    args = parser.parse_args()
+
+    decoder = Decoder()
+    with open(args.source, "rb", buffering=0) as stream:
+        while True:
+            data = stream.read(256)
+            if not data:
+                break
+            decoder.feed(data)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,35 @@
+#!/usr/bin/env python3
+"""Envia a hora do host para a placa, base de tempo da coordenação (lib/coordination.h).
+
+Uso:
+    python3 tools/timesync.py /dev/ttyACM0              # uma vez
+    python3 tools/timesync.py /dev/ttyACM0 --every 60   # a cada 60 s
+
+A placa recebe o comando "hora <ms desde 1970>" no shell do USB CDC e ancora
+nele o ciclo do plano. Cruzamentos sincronizados pelo mesmo relógio (NTP no
+host) mantêm as defasagens entre si. O shell acorda com a chegada dos
+caracteres, então o erro do ajuste é basicamente a latência do USB.
+"""
+import argparse
+import time
+
+
+def send_time(port):
+    with open(port, "wb", buffering=0) as stream:
+        stream.write(b"hora %d\n" % int(time.time() * 1000))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port", help="porta serial da placa")
+    parser.add_argument("--every", type=float, default=0, help="repete a cada N segundos")
+    args = parser.parse_args()
+
+    send_time(args.port)
+    while args.every > 0:
+        time.sleep(args.every)
+        send_time(args.port)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""Converte dumps do trace do kernel (build TRAFFIC_TRACE) para JSON do Chrome/Perfetto.
+
+Uso:
+    python3 tools/trace2perfetto.py captura.bin -o trace.json
+    # abra trace.json em https://ui.perfetto.dev ou chrome://tracing
+
+A captura é o fluxo bruto da porta USB CDC (por exemplo, `cat /dev/ttyACM0 >
+captura.bin`). Cada núcleo vira uma linha com as fatias de execução das
+tarefas; ISRs aparecem em uma linha própria por núcleo e operações de fila
+como eventos instantâneos. Somente o dump mais recente de cada núcleo é usado.
+"""
+import argparse
+import json
+import pathlib
+import sys
+
+sys.path.insert(0, str(pathlib.Path(__file__).resolve().parent))
+import telemetry  # noqa: E402
+
+EVT_TASK_IN = 1
+EVT_TASK_OUT = 2
+EVT_QUEUE = {3: "queue_send", 4: "queue_send_isr", 5: "queue_receive", 6: "queue_receive_isr"}
+EVT_ISR_ENTER = 7
+EVT_ISR_EXIT = 8
+ISR_NAMES = {0: "kernel", 1: "gpio", 2: "monitor", 3: "flash"}
+
+
+class TraceCollector(telemetry.Decoder):
+    """Acumula os registros de trace; um dump novo substitui o anterior do mesmo núcleo."""
+
+    def __init__(self):
+        super().__init__(out=sys.stderr)
+        self.records = {}
+        self.dump_time = {}
+
+    def on_trace(self, payload):
+        core, count, dump_time_us = telemetry.TRACE_HEADER.unpack_from(payload)
+        if self.dump_time.get(core) != dump_time_us:
+            self.dump_time[core] = dump_time_us
+            self.records[core] = []
+        offset = telemetry.TRACE_HEADER.size
+        for _ in range(count):
+            self.records[core].append(telemetry.TRACE_RECORD.unpack_from(payload, offset))
+            offset += telemetry.TRACE_RECORD.size
+
+    def on_cpu_stats(self, payload):
+        pass
+
+    def on_latency(self, payload):
+        pass
+
+    def emit_text(self, data):
+        pass
+
+
+def unwrap(timestamp32, dump_time_us):
+    """Reconstrói o instante de 64 bits a partir dos 32 bits baixos e do instante do dump."""
+    return dump_time_us - ((dump_time_us - timestamp32) & 0xFFFFFFFF)
+
+
+def to_chrome_trace(collector):
+    events = [{"ph": "M", "pid": 0, "name": "process_name", "args": {"name": "PicoTrafficRTOS"}}]
+    for core, records in sorted(collector.records.items()):
+        task_tid, isr_tid = core * 2, core * 2 + 1
+        events.append({"ph": "M", "pid": 0, "tid": task_tid, "name": "thread_name",
+                       "args": {"name": "core%d tarefas" % core}})
+        events.append({"ph": "M", "pid": 0, "tid": isr_tid, "name": "thread_name",
+                       "args": {"name": "core%d ISRs" % core}})
+        running = None
+        for timestamp32, event, arg in records:
+            ts = unwrap(timestamp32, collector.dump_time[core])
+            if event == EVT_TASK_IN:
+                running = (arg, ts)
+            elif event == EVT_TASK_OUT and running and running[0] == arg:
+                events.append({"ph": "X", "pid": 0, "tid": task_tid, "name": collector.name(arg),
+                               "ts": running[1], "dur": max(ts - running[1], 0)})
+                running = None
+            elif event in EVT_QUEUE:
+                events.append({"ph": "i", "s": "t", "pid": 0, "tid": task_tid, "ts": ts,
+                               "name": "%s q%d" % (EVT_QUEUE[event], arg)})
+            elif event in (EVT_ISR_ENTER, EVT_ISR_EXIT):
+                events.append({"ph": "B" if event == EVT_ISR_ENTER else "E", "pid": 0, "tid": isr_tid,
+                               "ts": ts, "name": "isr:%s" % ISR_NAMES.get(arg, arg)})
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", help="captura bruta da porta USB CDC")
+    parser.add_argument("-o", "--output", type=pathlib.Path, default=pathlib.Path("trace.json"))
+    args = parser.parse_args()
+
+    collector = TraceCollector()
+    with open(args.capture, "rb") as stream:
+        collector.feed(stream.read())
+    if not collector.records:
+        sys.exit("nenhum dump de trace encontrado em %s" % args.capture)
+    args.output.write_text(json.dumps(to_chrome_trace(collector)))
+    total = sum(len(r) for r in collector.records.values())
+    print("%d registros de %d núcleo(s) -> %s" % (total, len(collector.records), args.output))
+
+
+if __name__ == "__main__":
+    main()